@@ -0,0 +1,8 @@
+TEMPLATE = lib
+TARGET = allocshim
+CONFIG -= qt
+CONFIG += plugin
+LIBS += -ldl
+
+# Input
+SOURCES += src/Benchmarks/AllocationShim.cpp
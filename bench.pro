@@ -0,0 +1,33 @@
+include(dissent.pro)
+TEMPLATE = app
+TARGET = bench
+DEPENDPATH += ext/googletest/src \
+              ext/googletest/include/gtest \
+              ext/googletest/include/gtest/internal
+INCLUDEPATH += src \
+               src/Tests \
+               ext/googletest \
+               ext/googletest/include
+DEFINES += QT_NO_DEBUG_OUTPUT
+DEFINES += QT_NO_WARNING_OUTPUT
+
+# Input
+HEADERS += src/Tests/DissentTest.hpp \
+           src/Tests/Mock.hpp \
+           src/Tests/RpcTest.hpp \
+           src/Tests/TestNode.hpp \
+           src/Benchmarks/Benchmarks.hpp
+
+SOURCES += ext/googletest/src/gtest-all.cc \
+           src/Tests/Mock.cpp \
+           src/Tests/TestNode.cpp \
+           src/Benchmarks/BlameBenchmark.cpp \
+           src/Benchmarks/BulkXorBenchmark.cpp \
+           src/Benchmarks/CryptoBenchmark.cpp \
+           src/Benchmarks/DescriptorBenchmark.cpp \
+           src/Benchmarks/HistoryBenchmark.cpp \
+           src/Benchmarks/LogBenchmark.cpp \
+           src/Benchmarks/LoggingBenchmark.cpp \
+           src/Benchmarks/RoundBenchmark.cpp \
+           src/Benchmarks/ShuffleBlameBenchmark.cpp \
+           src/Benchmarks/TimerBenchmark.cpp
@@ -11,17 +11,22 @@ QT = core network
 
 # Input
 LIBS += -lcryptopp 
+unix:LIBS += -ldl
 HEADERS += ext/joyent-http-parser/http_parser.h \
            ext/qt-json/json.h \
            src/Dissent.hpp \
+           src/Anonymity/AggregatedBulkRound.hpp \
+           src/Anonymity/ArrivalLatency.hpp \
            src/Anonymity/BulkRound.hpp \
            src/Anonymity/Credentials.hpp \
+           src/Anonymity/EarlyArrivalQueue.hpp \
            src/Anonymity/Group.hpp \
            src/Anonymity/Log.hpp \
            src/Anonymity/MessageRandomizer.hpp \
            src/Anonymity/NullRound.hpp \
            src/Anonymity/RepeatingBulkRound.hpp \
            src/Anonymity/Round.hpp \
+           src/Anonymity/RoundMetrics.hpp \
            src/Anonymity/Session.hpp \
            src/Anonymity/SessionManager.hpp \
            src/Anonymity/ShuffleBlamer.hpp \
@@ -42,6 +47,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Applications/SessionFactory.hpp \
            src/Applications/Settings.hpp \
            src/Crypto/AsymmetricKey.hpp \
+           src/Crypto/CppDhGroup.hpp \
            src/Crypto/CppDiffieHellman.hpp \
            src/Crypto/CppHash.hpp \
            src/Crypto/CppIntegerData.hpp \
@@ -49,6 +55,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Crypto/CppPrivateKey.hpp \
            src/Crypto/CppPublicKey.hpp \
            src/Crypto/CppRandom.hpp \
+           src/Crypto/CryptoCost.hpp \
            src/Crypto/CryptoFactory.hpp \
            src/Crypto/DiffieHellman.hpp \
            src/Crypto/NullDiffieHellman.hpp \
@@ -63,6 +70,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Crypto/OnionEncryptor.hpp \
            src/Crypto/ThreadedOnionEncryptor.hpp \
            src/Crypto/Serialization.hpp \
+           src/Crypto/SharedSecretCache.hpp \
            src/Connections/Bootstrapper.hpp \
            src/Connections/Connection.hpp \
            src/Connections/ConnectionAcquirer.hpp \
@@ -101,9 +109,17 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Transports/EdgeFactory.hpp \
            src/Transports/EdgeListener.hpp \
            src/Transports/EdgeListenerFactory.hpp \
+           src/Transports/SimEdge.hpp \
+           src/Transports/SimEdgeListener.hpp \
+           src/Transports/SimNetwork.hpp \
+           src/Transports/SimTopology.hpp \
            src/Transports/TcpAddress.hpp \
            src/Transports/TcpEdge.hpp \
            src/Transports/TcpEdgeListener.hpp \
+           src/Utils/AllocationCounter.hpp \
+           src/Utils/AsyncLogWriter.hpp \
+           src/Utils/BufferedRandom.hpp \
+           src/Utils/BufferPool.hpp \
            src/Utils/Logging.hpp \
            src/Utils/Random.hpp \
            src/Utils/QRunTimeError.hpp \
@@ -116,6 +132,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Utils/Timer.hpp \
            src/Utils/TimerCallback.hpp \
            src/Utils/TimerEvent.hpp \
+           src/Utils/TimerWheel.hpp \
            src/Utils/Triggerable.hpp \
            src/Utils/Triple.hpp \
            src/Web/HttpRequest.hpp \
@@ -128,6 +145,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Web/Services/GetMessagesService.hpp \
            src/Web/Services/MessageWebService.hpp \
            src/Web/Services/RoundIdService.hpp \
+           src/Web/Services/RoundMetricsService.hpp \
            src/Web/Services/SendMessageService.hpp \
            src/Web/Services/SessionIdService.hpp \
            src/Web/Services/SessionWebService.hpp \
@@ -136,13 +154,16 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
 
 SOURCES += ext/joyent-http-parser/http_parser.c \
            ext/qt-json/json.cpp \
+           src/Anonymity/ArrivalLatency.cpp \
            src/Anonymity/BulkRound.cpp \
+           src/Anonymity/EarlyArrivalQueue.cpp \
            src/Anonymity/Group.cpp \
            src/Anonymity/Log.cpp \
            src/Anonymity/MessageRandomizer.cpp \
            src/Anonymity/NullRound.cpp \
            src/Anonymity/RepeatingBulkRound.cpp \
            src/Anonymity/Round.cpp \
+           src/Anonymity/RoundMetrics.cpp \
            src/Anonymity/Session.cpp \
            src/Anonymity/SessionManager.cpp \
            src/Anonymity/ShuffleBlamer.cpp \
@@ -162,18 +183,22 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Applications/SessionFactory.cpp \
            src/Applications/Settings.cpp \
            src/Crypto/AsymmetricKey.cpp \
+           src/Crypto/CppDhGroup.cpp \
            src/Crypto/CppDiffieHellman.cpp \
            src/Crypto/CppHash.cpp \
            src/Crypto/CppPrivateKey.cpp \
            src/Crypto/CppPublicKey.cpp \
            src/Crypto/CppRandom.cpp \
+           src/Crypto/CryptoCost.cpp \
            src/Crypto/CryptoFactory.cpp \
            src/Crypto/DiffieHellman.cpp \
+           src/Crypto/Hash.cpp \
            src/Crypto/NullDiffieHellman.cpp \
            src/Crypto/NullHash.cpp \
            src/Crypto/NullPublicKey.cpp \
            src/Crypto/NullPrivateKey.cpp \
            src/Crypto/OnionEncryptor.cpp \
+           src/Crypto/SharedSecretCache.cpp \
            src/Crypto/ThreadedOnionEncryptor.cpp \
            src/Connections/Bootstrapper.cpp \
            src/Connections/Connection.cpp \
@@ -200,9 +225,16 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Transports/EdgeFactory.cpp \
            src/Transports/EdgeListener.cpp \
            src/Transports/EdgeListenerFactory.cpp \
+           src/Transports/SimEdge.cpp \
+           src/Transports/SimEdgeListener.cpp \
+           src/Transports/SimNetwork.cpp \
            src/Transports/TcpAddress.cpp \
            src/Transports/TcpEdge.cpp \
            src/Transports/TcpEdgeListener.cpp \
+           src/Utils/AllocationCounter.cpp \
+           src/Utils/AsyncLogWriter.cpp \
+           src/Utils/BufferedRandom.cpp \
+           src/Utils/BufferPool.cpp \
            src/Utils/Logging.cpp \
            src/Utils/Random.cpp \
            src/Utils/Sleeper.cpp \
@@ -210,6 +242,7 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Utils/Time.cpp \
            src/Utils/Timer.cpp \
            src/Utils/TimerEvent.cpp \
+           src/Utils/TimerWheel.cpp \
            src/Web/HttpRequest.cpp \
            src/Web/HttpResponse.cpp \
            src/Web/WebRequest.cpp \
@@ -218,6 +251,7 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Web/Services/GetFileService.cpp \
            src/Web/Services/GetMessagesService.cpp \
            src/Web/Services/RoundIdService.cpp \
+           src/Web/Services/RoundMetricsService.cpp \
            src/Web/Services/SendMessageService.cpp \
            src/Web/Services/SessionIdService.cpp \
            src/Web/Services/WebService.cpp
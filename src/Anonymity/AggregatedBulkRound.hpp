@@ -0,0 +1,42 @@
+#ifndef DISSENT_ANONYMITY_AGGREGATED_BULK_ROUND_H_GUARD
+#define DISSENT_ANONYMITY_AGGREGATED_BULK_ROUND_H_GUARD
+
+#include "RepeatingBulkRound.hpp"
+
+namespace Dissent {
+namespace Anonymity {
+
+  /**
+   * A "V2" bulk round in which the leader aggregates the xor messages of
+   * each phase.  See RepeatingBulkRound for more information.
+   */
+  class AggregatedBulkRound : public RepeatingBulkRound {
+    public:
+      /**
+       * Constructor
+       * @param group Group used during this round
+       * @param creds the local nodes credentials
+       * @param round_id Unique round id (nonce)
+       * @param network handles message sending
+       * @param get_data requests data to share during this session
+       * @param create_shuffle optional parameter specifying a shuffle round
+       * to create, currently used for testing
+       */
+      explicit AggregatedBulkRound(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> network, GetDataCallback &get_data,
+          CreateRound create_shuffle = &TCreateRound<ShuffleRound>) :
+        RepeatingBulkRound(group, creds, round_id, network, get_data,
+            create_shuffle, true)
+      {
+      }
+
+      /**
+       * Destructor
+       */
+      virtual ~AggregatedBulkRound() {}
+  };
+}
+}
+
+#endif
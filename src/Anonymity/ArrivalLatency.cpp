@@ -0,0 +1,87 @@
+#include "Utils/Time.hpp"
+
+#include "ArrivalLatency.hpp"
+
+using Dissent::Utils::Time;
+
+namespace Dissent {
+namespace Anonymity {
+  ArrivalLatency::ArrivalLatency(int members) :
+    _phase_start(Time::GetInstance().MSecsSinceEpoch()),
+    _arrived(members, false),
+    _histograms(members, QVector<uint>(Buckets, 0)),
+    _counts(members, 0),
+    _max(members, 0),
+    _last(members, -1)
+  {
+  }
+
+  void ArrivalLatency::StartPhase()
+  {
+    _phase_start = Time::GetInstance().MSecsSinceEpoch();
+    _arrived.fill(false);
+  }
+
+  void ArrivalLatency::Arrived(int member_idx)
+  {
+    if(member_idx < 0 || member_idx >= _counts.count() ||
+        _arrived.testBit(member_idx))
+    {
+      return;
+    }
+
+    _arrived.setBit(member_idx);
+    qint64 latency = Time::GetInstance().MSecsSinceEpoch() - _phase_start;
+    _histograms[member_idx][Bucket(latency)]++;
+    _counts[member_idx]++;
+    _last[member_idx] = latency;
+    if(latency > _max[member_idx]) {
+      _max[member_idx] = latency;
+    }
+  }
+
+  QVector<int> ArrivalLatency::GetOutstanding() const
+  {
+    QVector<int> outstanding;
+    for(int idx = 0; idx < _arrived.size(); idx++) {
+      if(!_arrived.testBit(idx)) {
+        outstanding.append(idx);
+      }
+    }
+    return outstanding;
+  }
+
+  qint64 ArrivalLatency::GetQuantile(int member_idx, double quantile) const
+  {
+    uint count = _counts[member_idx];
+    if(count == 0) {
+      return -1;
+    }
+
+    const QVector<uint> &histogram = _histograms[member_idx];
+    uint target = static_cast<uint>(quantile * count);
+    uint seen = 0;
+    for(int idx = 0; idx < Buckets; idx++) {
+      seen += histogram[idx];
+      if(seen > target || seen == count) {
+        return qMin(BucketUpperBound(idx), _max[member_idx]);
+      }
+    }
+    return _max[member_idx];
+  }
+
+  qint64 ArrivalLatency::BucketUpperBound(int bucket)
+  {
+    return Q_INT64_C(1) << bucket;
+  }
+
+  int ArrivalLatency::Bucket(qint64 latency)
+  {
+    int bucket = 0;
+    while(bucket < Buckets - 1 && latency >= BucketUpperBound(bucket)) {
+      bucket++;
+    }
+    return bucket;
+  }
+}
+}
@@ -0,0 +1,106 @@
+#ifndef DISSENT_ANONYMITY_ARRIVAL_LATENCY_H_GUARD
+#define DISSENT_ANONYMITY_ARRIVAL_LATENCY_H_GUARD
+
+#include <QBitArray>
+#include <QVector>
+
+namespace Dissent {
+namespace Anonymity {
+  /**
+   * Tracks, per group member, how long after the start of a phase that
+   * member's message arrived.  Latencies are kept in power-of-two
+   * millisecond histograms so that stragglers can be identified from the
+   * tail of the distribution rather than from a single slow phase.
+   */
+  class ArrivalLatency {
+    public:
+      /**
+       * Number of histogram buckets, bucket i holds latencies in
+       * [2^(i-1), 2^i) ms, bucket 0 holds sub-millisecond latencies and the
+       * last bucket everything larger
+       */
+      static const int Buckets = 18;
+
+      /**
+       * Constructor
+       * @param members the number of members tracked
+       */
+      explicit ArrivalLatency(int members = 0);
+
+      /**
+       * Marks the start of a new phase, all members are outstanding
+       */
+      void StartPhase();
+
+      /**
+       * Records the arrival of a member's message for the current phase,
+       * repeated arrivals within a phase are ignored
+       * @param member_idx the member's index in the group
+       */
+      void Arrived(int member_idx);
+
+      /**
+       * Returns the members that have not arrived in the current phase
+       */
+      QVector<int> GetOutstanding() const;
+
+      /**
+       * Returns the latency histogram for a member
+       * @param member_idx the member's index in the group
+       */
+      inline const QVector<uint> &GetHistogram(int member_idx) const
+      {
+        return _histograms[member_idx];
+      }
+
+      /**
+       * Returns the number of arrivals recorded for a member
+       * @param member_idx the member's index in the group
+       */
+      inline uint GetCount(int member_idx) const { return _counts[member_idx]; }
+
+      /**
+       * Returns the largest latency recorded for a member in ms
+       * @param member_idx the member's index in the group
+       */
+      inline qint64 GetMax(int member_idx) const { return _max[member_idx]; }
+
+      /**
+       * Returns the latency of the member's last arrival in ms, -1 if none
+       * @param member_idx the member's index in the group
+       */
+      inline qint64 GetLast(int member_idx) const { return _last[member_idx]; }
+
+      /**
+       * Returns an upper bound in ms on the given quantile of a member's
+       * latencies, taken from the histogram
+       * @param member_idx the member's index in the group
+       * @param quantile between 0 and 1
+       */
+      qint64 GetQuantile(int member_idx, double quantile) const;
+
+      /**
+       * Returns the upper bound in ms of a histogram bucket
+       * @param bucket the bucket index
+       */
+      static qint64 BucketUpperBound(int bucket);
+
+      /**
+       * Returns the number of members tracked
+       */
+      inline int Count() const { return _counts.count(); }
+
+    private:
+      static int Bucket(qint64 latency);
+
+      qint64 _phase_start;
+      QBitArray _arrived;
+      QVector<QVector<uint> > _histograms;
+      QVector<uint> _counts;
+      QVector<qint64> _max;
+      QVector<qint64> _last;
+  };
+}
+}
+
+#endif
@@ -1,3 +1,9 @@
+#include <cstring>
+
+#include <QFuture>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
 #include "Connections/Connection.hpp"
 #include "Connections/Network.hpp"
 #include "Crypto/DiffieHellman.hpp"
@@ -23,6 +29,55 @@ using Dissent::Utils::Serialization;
 
 namespace Dissent {
 namespace Anonymity {
+  namespace {
+    /**
+     * Computes the DH shared secret with a member, the seed of the pad
+     * exchanged with them
+     */
+    class SharedSecret {
+      public:
+        typedef QByteArray result_type;
+
+        explicit SharedSecret(const QSharedPointer<DiffieHellman> &dh) :
+          _dh(dh)
+        {
+        }
+
+        QByteArray operator()(const GroupContainer &gc) const
+        {
+          return _dh->GetSharedSecret(gc.third);
+        }
+
+      private:
+        // Shared so a job outliving the round keeps the key alive
+        QSharedPointer<DiffieHellman> _dh;
+    };
+
+    /**
+     * Expands a shared secret into a pad
+     */
+    class MemberPad {
+      public:
+        typedef QByteArray result_type;
+
+        explicit MemberPad(int length) : _length(length)
+        {
+        }
+
+        result_type operator()(const QByteArray &seed) const
+        {
+          Library *lib = CryptoFactory::GetInstance().GetLibrary();
+          QScopedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+          QByteArray pad(_length, 0);
+          rng->GenerateBlock(pad);
+          return pad;
+        }
+
+      private:
+        int _length;
+    };
+  }
+
   BulkRound::BulkRound(const Group &group, const Credentials &creds,
       const Id &round_id, QSharedPointer<Network> network,
       GetDataCallback &get_data, CreateRound create_shuffle) :
@@ -49,8 +104,8 @@ namespace Anonymity {
     net->SetHeaders(headers);
 
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-    Id sr_id(hashalgo->ComputeHash(GetRoundId().GetByteArray()));
+    _hash_algo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    Id sr_id(_hash_algo->ComputeHash(GetRoundId().GetByteArray()));
 
     Round *pr = _create_shuffle(GetGroup(), GetCredentials(), sr_id, net,
         _get_bulk_data);
@@ -64,22 +119,66 @@ namespace Anonymity {
 
   void Xor(QByteArray &dst, const QByteArray &t1, const QByteArray &t2)
   {
-    /// @todo use qint64 or qint32 depending on architecture
     int count = std::min(dst.size(), t1.size());
     count = std::min(count, t2.size());
 
-    for(int idx = 0; idx < count; idx++) {
+    // Taken before dst detaches, the data stays alive in whoever shared it
+    const char *lhs = t1.constData();
+    const char *rhs = t2.constData();
+    Xor(dst.data(), lhs, rhs, count);
+  }
+
+  void Xor(char *dst, const char *t1, const char *t2, int length)
+  {
+    // A word at a time, memcpy keeps unaligned slices safe and compiles
+    // down to plain loads and stores
+    int idx = 0;
+    for(; idx + 8 <= length; idx += 8) {
+      quint64 lhs, rhs;
+      memcpy(&lhs, t1 + idx, 8);
+      memcpy(&rhs, t2 + idx, 8);
+      lhs ^= rhs;
+      memcpy(dst + idx, &lhs, 8);
+    }
+
+    for(; idx < length; idx++) {
       dst[idx] = t1[idx] ^ t2[idx];
     }
   }
 
+  QVector<QByteArray> HashXor(Hash *hash, char *dst,
+      const QVector<const char *> &regions, int length)
+  {
+    QVector<QByteArray> hashes(regions.count());
+    for(int idx = 0; idx < regions.count(); idx++) {
+      const char *region = regions[idx];
+      hash->Restart();
+      for(int offset = 0; offset < length; offset += HashXorBlockSize) {
+        int block = qMin(HashXorBlockSize, length - offset);
+        hash->Update(QByteArray::fromRawData(region + offset, block));
+        Xor(dst + offset, dst + offset, region + offset, block);
+      }
+      hashes[idx] = hash->ComputeHash();
+    }
+    return hashes;
+  }
+
   bool BulkRound::Start()
   {
     if(!Round::Start()) {
       return false;
     }
 
-    _state = Shuffling;
+    // The shared secrets do not depend on the data, so they are computed
+    // while the shuffle exchanges keys rather than when it asks for data
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      _shared_secrets = QtConcurrent::mapped(GetGroup().GetRoster(),
+          SharedSecret(_anon_dh));
+    }
+
+    SetState(Shuffling);
     _shuffle_round->Start();
 
     return true;
@@ -102,7 +201,9 @@ namespace Anonymity {
 
     bool bulk = notification.GetMessage()["bulk"].toBool();
     if(bulk) {
-      ProcessData(notification.GetMessage()["data"].toByteArray(), id);
+      QByteArray data = notification.GetMessage()["data"].toByteArray();
+      RecordReceive(data);
+      ProcessData(data, id);
     } else {
       _shuffle_round->IncomingData(notification);
     }
@@ -123,13 +224,34 @@ namespace Anonymity {
     }
   }
 
+  void BulkRound::ProcessEarlyArrivals()
+  {
+    foreach(const EarlyArrivalQueue::Entry &entry, _early_arrivals.TakeAll()) {
+      _log.Append(entry.data, entry.from);
+      try {
+        ProcessPayload(entry.data, entry.GetPayload(), entry.from);
+      } catch (QRunTimeError &err) {
+        qWarning() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+          "received a message from" << GetGroup().GetIndex(entry.from) << entry.from.ToString() <<
+          "in session / round" << GetRoundId().ToString() << "in state" <<
+          StateToString(_state) << "causing the following exception: " << err.What();
+        _log.Pop();
+      }
+    }
+  }
+
   void BulkRound::ProcessDataBase(const QByteArray &data, const Id &from)
   {
     QByteArray payload;
     if(!Verify(data, payload, from)) {
       throw QRunTimeError("Invalid signature or data");
     }
+    ProcessPayload(data, payload, from);
+  }
 
+  void BulkRound::ProcessPayload(const QByteArray &data, const QByteArray &payload,
+      const Id &from)
+  {
     if(_state == Offline) {
       throw QRunTimeError("Should never receive a message in the bulk"
           " round while offline.");
@@ -150,8 +272,10 @@ namespace Anonymity {
     }
 
     if(_state == Shuffling) {
+      if(!_early_arrivals.Push(data, payload.size(), from, 0, mtype)) {
+        throw QRunTimeError("Dropped an early message");
+      }
       _log.Pop();
-      _offline_log.Append(data, from);
       return;
     }
 
@@ -196,7 +320,7 @@ namespace Anonymity {
       throw QRunTimeError("Incorrect number of log messages.");
     }
 
-    _state = ProcessingLeaderData;
+    SetState(ProcessingLeaderData);
     for(int idx = 0; idx < log.Count(); idx++) {
       const QPair<QByteArray, Id> &res = log.At(idx);
       try {
@@ -243,12 +367,9 @@ namespace Anonymity {
           QString::number(des.count()));
     }
 
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-
     for(int idx = 0; idx < cleartexts.count(); idx++) {
       QByteArray cleartext = cleartexts[idx];
-      QByteArray hash = hashalgo->ComputeHash(cleartext);
+      QByteArray hash = _hash_algo->ComputeHash(cleartext);
       if(hash != des[idx].CleartextHash()) {
         throw QRunTimeError("Cleartext hash does not match descriptor hash.");
       }
@@ -302,7 +423,7 @@ namespace Anonymity {
         stream << AggregatedBulkData << GetRoundId() << _cleartexts;
         VerifiableBroadcast(msg);
       }
-      _state = Finished;
+      SetState(Finished);
       SetSuccessful(true);
       Stop("Round successfully finished");
     } else {
@@ -318,48 +439,76 @@ namespace Anonymity {
 
   void BulkRound::ProcessMessages()
   {
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
     int size = _descriptors.size();
-    int index = 0;
+    QVector<QByteArray> cleartexts(size);
+    QVector<QVector<int> > bad(size);
+
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded && size > 1)
+    {
+      // Descriptors are independent, each is opened on its own thread with
+      // its own hash
+      QList<Hash *> hashes;
+      QList<QFuture<QByteArray> > futures;
+      int index = 0;
+      for(int idx = 0; idx < size; idx++) {
+        Hash *hash = _hash_algo->Clone();
+        hashes.append(hash);
+        futures.append(QtConcurrent::run(this, &BulkRound::ProcessMessage,
+              idx, index, hash, &bad[idx]));
+        index += _descriptors[idx].Length();
+      }
+
+      for(int idx = 0; idx < size; idx++) {
+        cleartexts[idx] = futures[idx].result();
+      }
+      qDeleteAll(hashes);
+    } else {
+      int index = 0;
+      for(int idx = 0; idx < size; idx++) {
+        cleartexts[idx] = ProcessMessage(idx, index, _hash_algo.data(),
+            &bad[idx]);
+        index += _descriptors[idx].Length();
+      }
+    }
 
+    // Results are applied in descriptor order, as they would be serially
     for(int idx = 0; idx < size; idx++) {
-      QByteArray cleartext = ProcessMessage(idx, index);
-      _cleartexts.append(cleartext);
-      if(!cleartext.isEmpty()) {
-        PushData(cleartext, this);
+      foreach(int member, bad[idx]) {
+        _bad_message_hash.append(BadHash(idx, member));
+      }
+
+      _cleartexts.append(cleartexts[idx]);
+      if(!cleartexts[idx].isEmpty()) {
+        PushData(cleartexts[idx], this);
       }
-      index += _descriptors[idx].Length();
     }
   }
 
-  QByteArray BulkRound::ProcessMessage(int des_idx, int msg_index)
+  QByteArray BulkRound::ProcessMessage(int des_idx, int msg_index,
+      Hash *hash, QVector<int> *bad) const
   {
     int count = _messages.size();
-    const Descriptor &des = GetDescriptors()[des_idx];
-    int length = des.Length();
-    QByteArray msg(length, 0);
-
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-    bool good = true;
+    const Descriptor &des = _descriptors[des_idx];
+    QByteArray msg(des.Length(), 0);
 
+    QVector<const char *> xor_msgs(count);
     for(int idx = 0; idx < count; idx++) {
-      const char *tmsg = _messages[idx].constData() + msg_index;
-      QByteArray xor_msg(QByteArray::fromRawData(tmsg, length));
+      xor_msgs[idx] = _messages[idx].constData() + msg_index;
+    }
 
-      if(des.XorMessageHashes()[idx] != hashalgo->ComputeHash(xor_msg)) {
-        qWarning() << "Xor message does not hash properly";
-        _bad_message_hash.append(BadHash(des_idx, idx));
-        good = false;
-      }
+    // Each member's slice is hashed and xored in the same pass
+    QVector<QByteArray> hashes = HashXor(hash, msg.data(), xor_msgs,
+        des.Length());
 
-      if(good) {
-        Xor(msg, msg, xor_msg);
+    for(int idx = 0; idx < count; idx++) {
+      if(des.XorMessageHashes()[idx] != hashes[idx]) {
+        qWarning() << "Xor message does not hash properly";
+        bad->append(idx);
       }
     }
 
-    if(good) {
+    if(bad->isEmpty()) {
       return msg;
     } else {
       return QByteArray();
@@ -386,36 +535,53 @@ namespace Anonymity {
   void BulkRound::CreateDescriptor(const QByteArray &data)
   {
     int length = data.size();
-
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-
-    QByteArray xor_message(length, 0);
-    QVector<QByteArray> hashes;
-
     int my_idx = GetGroup().GetIndex(GetLocalId());
+    const QVector<GroupContainer> &roster = GetGroup().GetRoster();
+    bool threaded = CryptoFactory::GetInstance().GetThreadingType() ==
+      CryptoFactory::MultiThreaded;
+
+    // Usually finished by now, a default future has no results
+    _shared_secrets.waitForFinished();
+    QVector<QByteArray> seeds;
+    if(_shared_secrets.resultCount() == roster.count()) {
+      seeds = _shared_secrets.results().toVector();
+    } else if(threaded) {
+      seeds = QtConcurrent::blockingMapped<QVector<QByteArray> >(roster,
+          SharedSecret(_anon_dh));
+    } else {
+      SharedSecret secret(_anon_dh);
+      foreach(const GroupContainer &gc, roster) {
+        seeds.append(secret(gc));
+      }
+    }
+    seeds.remove(my_idx);
 
-    foreach(const GroupContainer &gc, GetGroup().GetRoster()) {
-      QByteArray seed = _anon_dh->GetSharedSecret(gc.third);
-
-      if(hashes.size() == my_idx) {
-        hashes.append(QByteArray());
-        continue;
+    // Each member's pad is generated independently
+    QVector<QByteArray> pads;
+    MemberPad member_pad(length);
+    if(threaded) {
+      pads = QtConcurrent::blockingMapped<QVector<QByteArray> >(seeds,
+          member_pad);
+    } else {
+      foreach(const QByteArray &seed, seeds) {
+        pads.append(member_pad(seed));
       }
+    }
 
-      QByteArray msg(length, 0);
-      QScopedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
-      rng->GenerateBlock(msg);
-      hashes.append(hashalgo->ComputeHash(msg));
-      Xor(xor_message, xor_message, msg);
+    QByteArray xor_message(length, 0);
+    foreach(const QByteArray &pad, pads) {
+      Xor(xor_message, xor_message, pad);
     }
 
     QByteArray my_xor_message = QByteArray(length, 0);
     Xor(my_xor_message, xor_message, data);
     SetMyXorMessage(my_xor_message);
-    hashes[my_idx] = hashalgo->ComputeHash(my_xor_message);
 
-    QByteArray hash = hashalgo->ComputeHash(data);
+    // The pads and our own xor message are hashed as one batch
+    pads.insert(my_idx, my_xor_message);
+    QVector<QByteArray> hashes = _hash_algo->ComputeHashes(pads, threaded);
+
+    QByteArray hash = _hash_algo->ComputeHash(data);
 
     Descriptor descriptor(length, _anon_dh->GetPublicComponent(), hashes, hash);
     SetMyDescriptor(descriptor);
@@ -425,13 +591,13 @@ namespace Anonymity {
   {
     if(!_shuffle_round->Successful()) {
       _bad_members = _shuffle_round->GetBadMembers();
-      _state = Finished;
+      SetState(Finished);
       Stop("ShuffleRound failed");
       return;
     }
 
     if(0 == _shuffle_sink.Count()) {
-      _state = Finished;
+      SetState(Finished);
       SetSuccessful(true);
       Stop("Round successfully finished -- no bulk messages");
       return;
@@ -442,17 +608,12 @@ namespace Anonymity {
     GenerateXorMessages();
 
     if(_app_broadcast && !IsLeader()) {
-      _state = ReceivingLeaderData;
+      SetState(ReceivingLeaderData);
     } else {
-      _state = DataSharing;
-    }
-
-    for(int idx = 0; idx < _offline_log.Count(); idx++) {
-      QPair<QByteArray, Id> entry = _offline_log.At(idx);
-      ProcessData(entry.first, entry.second);
+      SetState(DataSharing);
     }
 
-    _offline_log.Clear();
+    ProcessEarlyArrivals();
   }
 
   void BulkRound::GenerateXorMessages()
@@ -498,12 +659,11 @@ namespace Anonymity {
     QByteArray seed = GetDhKey()->GetSharedSecret(descriptor.PublicDh());
 
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
     QScopedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
 
     QByteArray msg(descriptor.Length(), 0);
     rng->GenerateBlock(msg);
-    QByteArray hash = hashalgo->ComputeHash(msg);
+    QByteArray hash = _hash_algo->ComputeHash(msg);
 
     if(descriptor.XorMessageHashes()[GetGroup().GetIndex(GetLocalId())] != hash) {
       qWarning() << "Invalid hash";
@@ -575,7 +735,7 @@ namespace Anonymity {
         ProcessBlame(blame_vector);
       }
     }
-    _state = Finished;
+    SetState(Finished);
     SetSuccessful(false);
     Stop("Round finished with blame");
   }
@@ -595,8 +755,7 @@ namespace Anonymity {
       QScopedPointer<Random> rng(lib->GetRandomNumberGenerator(be.third));
       rng->GenerateBlock(msg);
 
-      QScopedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-      QByteArray hash = hashalgo->ComputeHash(msg);
+      QByteArray hash = _hash_algo->ComputeHash(msg);
       if(hash == des.XorMessageHashes()[be.second] && !_bad_members.contains(be.second)) {
         qDebug() << "Blame verified for" << be.first << be.second;
         _bad_members.append(be.second);
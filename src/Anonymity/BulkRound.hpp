@@ -1,6 +1,7 @@
 #ifndef DISSENT_ANONYMITY_BULK_ROUND_H_GUARD
 #define DISSENT_ANONYMITY_BULK_ROUND_H_GUARD
 
+#include <QFuture>
 #include <QMetaEnum>
 #include <QSharedPointer>
 
@@ -8,12 +9,14 @@
 #include "Messaging/GetDataCallback.hpp"
 #include "Utils/Triple.hpp"
 
+#include "EarlyArrivalQueue.hpp"
 #include "Log.hpp"
 #include "Round.hpp"
 
 namespace Dissent {
 namespace Crypto {
   class DiffieHellman;
+  class Hash;
 }
 
 namespace Anonymity {
@@ -194,6 +197,15 @@ namespace Anonymity {
       QSharedPointer<Round> GetShuffleRound() { return _shuffle_round; }
 
     protected:
+      /**
+       * Sets the internal state of the bulk round
+       */
+      inline void SetState(State state)
+      {
+        _state = state;
+        RecordState(StateToString(state));
+      }
+
       /**
        * GetDataCallback into bulk data
        * @param mam the maximum amount of data to return
@@ -203,7 +215,9 @@ namespace Anonymity {
       virtual QPair<QByteArray, bool> GetBulkData(int max);
 
       /**
-       * Creates and sets the descriptor given the data
+       * Creates and sets the descriptor given the data, the shared secret,
+       * pad and hash for each member are computed across threads when the
+       * CryptoFactory is multithreaded
        * @param cleartext data to create a descriptor for
        */
       void CreateDescriptor(const QByteArray &data);
@@ -222,6 +236,22 @@ namespace Anonymity {
        */
       void ProcessDataBase(const QByteArray &data, const Id &from);
 
+      /**
+       * Processes a message whose signature has already been verified,
+       * throws exceptions for invalid data packets
+       * @param data Incoming data
+       * @param payload data without its signature
+       * @param from sending peer
+       */
+      void ProcessPayload(const QByteArray &data, const QByteArray &payload,
+          const Id &from);
+
+      /**
+       * Processes the messages held in the early arrival queue, those still
+       * early are queued again
+       */
+      void ProcessEarlyArrivals();
+
       /**
        * Parses through all the descriptors to generate a single transmission
        * for the bulk round, which is sent via broadcast.
@@ -326,12 +356,16 @@ namespace Anonymity {
       void Finish();
       
       /**
-       * Parse the deecriptor and retrieve the cleartext bulk data
+       * Parse the deecriptor and retrieve the cleartext bulk data, safe to
+       * call for different descriptors from many threads at once
        * @param des_index index for the provided descriptor
        * @param msg_index an index into the message array
-       * @returns the cleartext message
+       * @param hash used to hash the xor messages, one per thread
+       * @param bad returns the members whose xor message hashed improperly
+       * @returns the cleartext message or empty if any member was bad
        */
-      QByteArray ProcessMessage(int des_index, int msg_index);
+      QByteArray ProcessMessage(int des_index, int msg_index,
+          Dissent::Crypto::Hash *hash, QVector<int> *bad) const;
 
       /**
        * Descriptor shuffle has finished and bulk has begun, prepare this
@@ -386,9 +420,10 @@ namespace Anonymity {
       State _state;
 
       /**
-       * Stores all validated messages that arrived before start was called
+       * Stores verified messages that arrived before the round was ready
+       * for them
        */
-      Log _offline_log;
+      EarlyArrivalQueue _early_arrivals;
 
       /**
        * Stores all validated incoming messages
@@ -400,6 +435,17 @@ namespace Anonymity {
        */
       QSharedPointer<DiffieHellman> _anon_dh;
 
+      /**
+       * Shared secrets with each member, begun on Start so they are ready by
+       * the time the shuffle asks for a descriptor
+       */
+      QFuture<QByteArray> _shared_secrets;
+
+      /**
+       * Reused for every xor message hash
+       */
+      QSharedPointer<Dissent::Crypto::Hash> _hash_algo;
+
       /**
        * Stores the output of the shuffle
        */
@@ -475,6 +521,34 @@ namespace Anonymity {
    */
   void Xor(QByteArray &dst, const QByteArray &t1, const QByteArray &t2);
 
+  /**
+   * Xor operator for regions of memory, such as slots within a larger
+   * message, the regions may be the same but must not otherwise overlap
+   * @param dst the destination
+   * @param t1 lhs of the xor operation
+   * @param t2 rhs of the xor operation
+   * @param length the number of bytes
+   */
+  void Xor(char *dst, const char *t1, const char *t2, int length);
+
+  /**
+   * Bytes HashXor hashes and xors at a time, small enough that a block is
+   * still in cache for the xor after the hash has read it
+   */
+  const int HashXorBlockSize = 8 * 1024;
+
+  /**
+   * Hashes each region and xors it into dst in a single pass, a block at
+   * a time, rather than reading every region once to hash and again to xor
+   * @param hash the hash algorithm, restarted for each region
+   * @param dst the accumulator, length bytes not overlapping any region
+   * @param regions the start of each region
+   * @param length the length of each region
+   * @returns the hash of each region, as ComputeHash would return
+   */
+  QVector<QByteArray> HashXor(Dissent::Crypto::Hash *hash, char *dst,
+      const QVector<const char *> &regions, int length);
+
   bool operator==(const BulkRound::Descriptor &lhs,
       const BulkRound::Descriptor &rhs);
 
@@ -0,0 +1,55 @@
+#include <QDebug>
+
+#include "EarlyArrivalQueue.hpp"
+
+namespace Dissent {
+namespace Anonymity {
+  EarlyArrivalQueue::EarlyArrivalQueue(int max_entries, int max_bytes) :
+    _max_entries(max_entries),
+    _max_bytes(max_bytes),
+    _dropped(0)
+  {
+  }
+
+  bool EarlyArrivalQueue::Push(const QByteArray &data, int payload_size,
+      const Id &from, uint phase, int type)
+  {
+    QPair<int, int> &usage = _usage[from];
+    if(usage.first >= _max_entries || _max_bytes - usage.second < data.size()) {
+      qDebug() << "Dropping early message from" << from.ToString() <<
+        "holding" << usage.first << "messages and" << usage.second << "bytes";
+      _dropped++;
+      return false;
+    }
+
+    // The queue is bounded and small, a scan is cheaper than an index
+    foreach(const Entry &entry, _entries) {
+      if(entry.phase == phase && entry.type == type && entry.from == from &&
+          entry.data == data)
+      {
+        _dropped++;
+        return false;
+      }
+    }
+
+    _entries.append(Entry(data, payload_size, from, phase, type));
+
+    usage.first++;
+    usage.second += data.size();
+    return true;
+  }
+
+  QList<EarlyArrivalQueue::Entry> EarlyArrivalQueue::TakeAll()
+  {
+    QList<Entry> entries = _entries;
+    Clear();
+    return entries;
+  }
+
+  void EarlyArrivalQueue::Clear()
+  {
+    _entries.clear();
+    _usage.clear();
+  }
+}
+}
@@ -0,0 +1,144 @@
+#ifndef DISSENT_ANONYMITY_EARLY_ARRIVAL_QUEUE_H_GUARD
+#define DISSENT_ANONYMITY_EARLY_ARRIVAL_QUEUE_H_GUARD
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+#include "Connections/Id.hpp"
+
+namespace Dissent {
+namespace Anonymity {
+  /**
+   * Holds messages that arrived before a round was ready for them.  Entries
+   * have already had their signatures verified and their headers parsed, so
+   * replaying them skips both.  Each sender may only hold a bounded number
+   * of entries and bytes and an entry identical to one already held for the
+   * same phase and sender is dropped, so a flooding peer cannot grow the
+   * queue without bound.
+   */
+  class EarlyArrivalQueue {
+    public:
+      typedef Dissent::Connections::Id Id;
+
+      /**
+       * An early message
+       */
+      class Entry {
+        public:
+          Entry(const QByteArray &data, int payload_size, const Id &from,
+              uint phase, int type) :
+            data(data), payload_size(payload_size), from(from),
+            phase(phase), type(type)
+          {
+          }
+
+          /**
+           * The signed message as received
+           */
+          QByteArray data;
+
+          /**
+           * The length of the message without its signature
+           */
+          int payload_size;
+
+          /**
+           * The sender
+           */
+          Id from;
+
+          /**
+           * The phase given in the message header
+           */
+          uint phase;
+
+          /**
+           * The message type given in the message header
+           */
+          int type;
+
+          /**
+           * Returns the message without its signature, referencing data
+           */
+          inline QByteArray GetPayload() const
+          {
+            return QByteArray::fromRawData(data.constData(), payload_size);
+          }
+      };
+
+      /**
+       * Default number of entries a single sender may hold
+       */
+      static const int DefaultMaxEntries = 32;
+
+      /**
+       * Default number of bytes a single sender may hold
+       */
+      static const int DefaultMaxBytes = 16 * 1024 * 1024;
+
+      /**
+       * Constructor
+       * @param max_entries entries a single sender may hold
+       * @param max_bytes bytes a single sender may hold
+       */
+      explicit EarlyArrivalQueue(int max_entries = DefaultMaxEntries,
+          int max_bytes = DefaultMaxBytes);
+
+      /**
+       * Queues a verified message, returns false if it was dropped as a
+       * duplicate or because the sender is over its limits
+       * @param data the signed message as received
+       * @param payload_size the length of the message without its signature
+       * @param from the sender
+       * @param phase the phase given in the message header
+       * @param type the message type given in the message header
+       */
+      bool Push(const QByteArray &data, int payload_size, const Id &from,
+          uint phase = 0, int type = 0);
+
+      /**
+       * Removes and returns all entries in the order they arrived
+       */
+      QList<Entry> TakeAll();
+
+      /**
+       * Removes all entries
+       */
+      void Clear();
+
+      /**
+       * Returns the number of entries held
+       */
+      inline int Count() const { return _entries.count(); }
+
+      /**
+       * Returns the number of bytes held for a sender
+       * @param from the sender
+       */
+      inline int GetBytes(const Id &from) const
+      {
+        return _usage.value(from).second;
+      }
+
+      /**
+       * Returns the number of messages dropped since construction
+       */
+      inline int GetDropped() const { return _dropped; }
+
+    private:
+      const int _max_entries;
+      const int _max_bytes;
+      QList<Entry> _entries;
+
+      /**
+       * Entries and bytes held per sender
+       */
+      QHash<Id, QPair<int, int> > _usage;
+      int _dropped;
+  };
+}
+}
+
+#endif
@@ -1,8 +1,19 @@
-#include <QDataStream>
-#include "Log.hpp"
+#include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QScopedPointer>
+#include <QtEndian>
+
 #include "Connections/Id.hpp"
+#include "Crypto/CryptoFactory.hpp"
+#include "Utils/Serialization.hpp"
+
+#include "Log.hpp"
 
 using Dissent::Connections::Id;
+using Dissent::Crypto::CryptoFactory;
+using Dissent::Crypto::Hash;
+using Dissent::Utils::Serialization;
 
 namespace Dissent {
 namespace Anonymity {
@@ -14,8 +25,10 @@ namespace Anonymity {
 
   Log::Log(const QByteArray &logdata) : _enabled(true)
   {
-    QDataStream stream(logdata);
-    stream >> _entries;
+    if(!Parse(logdata)) {
+      qWarning() << "Received a malformed log";
+      Clear();
+    }
   }
 
   bool Log::ToggleEnabled()
@@ -26,34 +39,324 @@ namespace Anonymity {
   void Log::Pop()
   {
     _entries.pop_back();
+    if(!_present.isEmpty()) {
+      _present.resize(_entries.count());
+    }
   }
 
   void Log::Append(const QByteArray &entry, const Id &remote)
   {
     if(_enabled) {
       _entries.append(QPair<QByteArray, Id>(entry, remote));
+      if(!_present.isEmpty()) {
+        _present.resize(_entries.count());
+        _present.setBit(_entries.count() - 1);
+      }
     }
   }
 
   const QPair<QByteArray, Id> &Log::At(int idx) const
   {
-    if(_entries.count() < idx || idx < 0) {
+    if(_entries.count() <= idx || idx < 0) {
       return _empty;
     }
     return _entries[idx];
   }
 
-  QByteArray Log::Serialize() const
+  bool Log::Contains(int idx) const
+  {
+    if(_entries.count() <= idx || idx < 0) {
+      return false;
+    }
+    return _present.isEmpty() || _present.testBit(idx);
+  }
+
+  QByteArray Log::Serialize(bool compress) const
   {
-    QByteArray logdata;
-    QDataStream stream(&logdata, QIODevice::WriteOnly);
-    stream << _entries;
+    return Serialize(QBitArray(), false, compress);
+  }
+
+  QByteArray Log::Serialize(const QVector<int> &indices, bool compress) const
+  {
+    QBitArray include(_entries.count(), false);
+    foreach(int idx, indices) {
+      if(Contains(idx)) {
+        include.setBit(idx);
+      }
+    }
+    return Serialize(include, true, compress);
+  }
+
+  QByteArray Log::Serialize(const QBitArray &include, bool partial,
+      bool compress) const
+  {
+    const int count = _entries.count();
+
+    QVector<QByteArray> hashes;
+    if(partial) {
+      for(int idx = 0; idx < count; idx++) {
+        hashes.append(GetEntryHash(idx));
+      }
+    }
+    const int digest_size = hashes.isEmpty() ? 0 : hashes[0].size();
+
+    // Each distinct sender is written once and entries refer to it by index
+    QHash<Id, int> sender_idx;
+    QVector<const Id *> senders;
+    QVector<int> entry_sender(count, -1);
+    int sender_bytes = 0;
+    for(int idx = 0; idx < count; idx++) {
+      const Id &sender = _entries[idx].second;
+      int sidx = sender_idx.value(sender, -1);
+      if(sidx == -1) {
+        sidx = senders.count();
+        sender_idx[sender] = sidx;
+        senders.append(&sender);
+        sender_bytes += 4 + sender.GetByteArray().size();
+      }
+      entry_sender[idx] = sidx;
+    }
+
+    // Entries appended from the same buffer share one copy of the payload
+    QHash<const char *, int> shared;
+    QVector<QByteArray> payloads;
+    QVector<int> offsets(count, -1);
+    QVector<int> lengths(count, 0);
+    QBitArray compressed(count, false);
+    int payload_bytes = 0;
+    qint64 inflated_bytes = 0;
+    for(int idx = 0; idx < count; idx++) {
+      if(partial && !include.testBit(idx)) {
+        continue;
+      }
+
+      const QByteArray &data = _entries[idx].first;
+      int previous = shared.value(data.constData(), -1);
+      if(previous != -1 && lengths[previous] == data.size() &&
+          !compressed.testBit(previous))
+      {
+        offsets[idx] = offsets[previous];
+        lengths[idx] = lengths[previous];
+        continue;
+      }
+
+      QByteArray payload = data;
+      // Stays within what Parse accepts, the rest is stored as is
+      if(compress && data.size() <= MaxCompressedEntrySize &&
+          inflated_bytes + data.size() <= MaxInflatedLogSize)
+      {
+        QByteArray packed = qCompress(data);
+        if(packed.size() < data.size()) {
+          payload = packed;
+          compressed.setBit(idx);
+          inflated_bytes += data.size();
+        }
+      }
+
+      if(!compressed.testBit(idx)) {
+        shared[data.constData()] = idx;
+      }
+      offsets[idx] = payload_bytes;
+      lengths[idx] = payload.size();
+      payload_bytes += payload.size();
+      payloads.append(payload);
+    }
+
+    int flags = (compress ? Compressed : 0) | (partial ? Partial : 0);
+    int size = HeaderSize + sender_bytes + count * digest_size +
+      count * IndexEntrySize + payload_bytes;
+
+    QByteArray logdata(size, 0);
+    Serialization::WriteInt(Magic, logdata, 0);
+    Serialization::WriteInt(flags, logdata, 4);
+    Serialization::WriteInt(count, logdata, 8);
+    Serialization::WriteInt(senders.count(), logdata, 12);
+    Serialization::WriteInt(digest_size, logdata, 16);
+
+    char *out = logdata.data();
+    int offset = HeaderSize;
+    foreach(const Id *sender, senders) {
+      const QByteArray &id = sender->GetByteArray();
+      Serialization::WriteInt(id.size(), logdata, offset);
+      memcpy(out + offset + 4, id.constData(), id.size());
+      offset += 4 + id.size();
+    }
+
+    foreach(const QByteArray &hash, hashes) {
+      memcpy(out + offset, hash.constData(), digest_size);
+      offset += digest_size;
+    }
+
+    for(int idx = 0; idx < count; idx++) {
+      Serialization::WriteInt(entry_sender[idx], logdata, offset);
+      Serialization::WriteInt(offsets[idx], logdata, offset + 4);
+      Serialization::WriteInt(lengths[idx], logdata, offset + 8);
+      Serialization::WriteInt(compressed.testBit(idx) ? 1 : 0, logdata, offset + 12);
+      offset += IndexEntrySize;
+    }
+
+    foreach(const QByteArray &payload, payloads) {
+      memcpy(out + offset, payload.constData(), payload.size());
+      offset += payload.size();
+    }
+
     return logdata;
   }
 
+  bool Log::Parse(const QByteArray &logdata)
+  {
+    if(logdata.size() < HeaderSize ||
+        Serialization::ReadInt(logdata, 0) != Magic)
+    {
+      return false;
+    }
+
+    int flags = Serialization::ReadInt(logdata, 4);
+    int count = Serialization::ReadInt(logdata, 8);
+    int sender_count = Serialization::ReadInt(logdata, 12);
+    int digest_size = Serialization::ReadInt(logdata, 16);
+    bool partial = flags & Partial;
+
+    if(count < 0 || sender_count < 0 || sender_count > count ||
+        digest_size < 0 || (partial && count > 0 && digest_size == 0))
+    {
+      return false;
+    }
+
+    _buffer = logdata;
+    const char *in = _buffer.constData();
+    int offset = HeaderSize;
+
+    QVector<Id> senders;
+    for(int idx = 0; idx < sender_count; idx++) {
+      if(_buffer.size() - offset < 4) {
+        return false;
+      }
+      int length = Serialization::ReadInt(_buffer, offset);
+      offset += 4;
+      if(length < 0 || _buffer.size() - offset < length) {
+        return false;
+      }
+      senders.append(Id(QByteArray(in + offset, length)));
+      offset += length;
+    }
+
+    if(partial && count > 0) {
+      if((_buffer.size() - offset) / digest_size < count) {
+        return false;
+      }
+      for(int idx = 0; idx < count; idx++) {
+        _hashes.append(QByteArray(in + offset, digest_size));
+        offset += digest_size;
+      }
+      _present = QBitArray(count, false);
+    }
+
+    if((_buffer.size() - offset) / IndexEntrySize < count) {
+      return false;
+    }
+
+    int index = offset;
+    int payload_start = offset + count * IndexEntrySize;
+    int payload_bytes = _buffer.size() - payload_start;
+
+    // Compressed entries never share a payload and inflate to a bounded
+    // total, so a small log cannot expand into many large entries
+    QSet<int> compressed_offsets;
+    qint64 inflate_budget = MaxInflatedLogSize +
+      qint64(InflationRatio) * logdata.size();
+
+    _entries.reserve(count);
+    for(int idx = 0; idx < count; idx++, index += IndexEntrySize) {
+      int sender = Serialization::ReadInt(_buffer, index);
+      int entry_offset = Serialization::ReadInt(_buffer, index + 4);
+      int length = Serialization::ReadInt(_buffer, index + 8);
+      bool entry_compressed = Serialization::ReadInt(_buffer, index + 12) != 0;
+
+      if(sender < 0 || sender >= sender_count) {
+        return false;
+      }
+
+      if(entry_offset == -1) {
+        // Left out of a partial log
+        if(!partial) {
+          return false;
+        }
+        _entries.append(QPair<QByteArray, Id>(QByteArray(), senders[sender]));
+        continue;
+      }
+
+      if(entry_offset < 0 || length < 0 || entry_offset > payload_bytes ||
+          payload_bytes - entry_offset < length)
+      {
+        return false;
+      }
+
+      const char *payload = in + payload_start + entry_offset;
+      QByteArray data;
+      if(entry_compressed) {
+        if(length < 4 || compressed_offsets.contains(entry_offset)) {
+          return false;
+        }
+        compressed_offsets.insert(entry_offset);
+
+        // qUncompress allocates the size claimed by the entry's big-endian
+        // header before inflating anything, so check that claim first
+        quint32 claimed = qFromBigEndian<quint32>(
+            reinterpret_cast<const uchar *>(payload));
+        if(claimed > quint32(MaxCompressedEntrySize) ||
+            qint64(claimed) > inflate_budget)
+        {
+          return false;
+        }
+        inflate_budget -= claimed;
+
+        data = qUncompress(reinterpret_cast<const uchar *>(payload), length);
+        if(data.isEmpty() || quint32(data.size()) != claimed) {
+          return false;
+        }
+      } else {
+        // References _buffer, which lives as long as any copy of this log
+        data = QByteArray::fromRawData(payload, length);
+      }
+      _entries.append(QPair<QByteArray, Id>(data, senders[sender]));
+
+      if(partial) {
+        _present.setBit(idx);
+      }
+    }
+
+    return true;
+  }
+
+  QByteArray Log::GetEntryHash(int idx) const
+  {
+    if(!Contains(idx)) {
+      return idx >= 0 && idx < _hashes.count() ? _hashes[idx] : QByteArray();
+    }
+
+    const QPair<QByteArray, Id> &entry = _entries[idx];
+    QScopedPointer<Hash> hash(CryptoFactory::GetInstance().GetLibrary()->GetHashAlgorithm());
+    hash->Update(entry.second.GetByteArray());
+    hash->Update(entry.first);
+    return hash->ComputeHash();
+  }
+
+  QByteArray Log::GetDigest() const
+  {
+    QScopedPointer<Hash> hash(CryptoFactory::GetInstance().GetLibrary()->GetHashAlgorithm());
+    for(int idx = 0; idx < _entries.count(); idx++) {
+      hash->Update(GetEntryHash(idx));
+    }
+    return hash->ComputeHash();
+  }
+
   void Log::Clear()
   {
     _entries.clear();
+    _present.clear();
+    _hashes.clear();
+    _buffer.clear();
   }
 }
 }
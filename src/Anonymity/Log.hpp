@@ -1,6 +1,7 @@
 #ifndef DISSENT_ANONYMITY_LOG_H_GUARD
 #define DISSENT_ANONYMITY_LOG_H_GUARD
 
+#include <QBitArray>
 #include <QByteArray>
 #include <QPair>
 #include <QVector>
@@ -12,19 +13,68 @@ namespace Connections {
 
 namespace Anonymity {
   /**
-   * Maintains a historical mapping of a packet to an Id
+   * Maintains a historical mapping of a packet to an Id.  A serialized log
+   * starts with a header, the table of distinct senders and an index holding
+   * each entry's sender, offset and length, followed by the payloads, so a
+   * reader can reach any entry without walking the ones before it.  Entries
+   * parsed from a serialized log reference its buffer rather than copying
+   * it, and payloads may optionally be compressed.  A log may also be
+   * serialized with only some of its entries, carrying the hashes of the
+   * others so that the result can still be checked against GetDigest.
    */
   class Log {
     public:
       typedef Dissent::Connections::Id Id;
 
+      /**
+       * Identifies a serialized log, "DLOG"
+       */
+      static const int Magic = 0x474f4c44;
+
+      /**
+       * Magic, flags, entry count, sender count, digest size
+       */
+      static const int HeaderSize = 20;
+
+      /**
+       * Sender, offset, length, compressed per entry
+       */
+      static const int IndexEntrySize = 16;
+
+      /**
+       * Largest entry stored compressed, bounds the buffer parsing a
+       * compressed entry may allocate
+       */
+      static const int MaxCompressedEntrySize = 16 * 1024 * 1024;
+
+      /**
+       * Inflated bytes of compressed entries every log may hold, a parsed
+       * log may additionally inflate InflationRatio times its own size
+       */
+      static const int MaxInflatedLogSize = 64 * 1024 * 1024;
+
+      /**
+       * Inflated bytes a parsed log may hold per byte of serialized log on
+       * top of MaxInflatedLogSize
+       */
+      static const int InflationRatio = 16;
+
+      /**
+       * Flags describing a serialized log
+       */
+      enum Flags {
+        Compressed = 1,
+        Partial = 2
+      };
+
       /**
        * Default constructor
        */
       explicit Log();
 
       /**
-       * Construct using a serialized log
+       * Construct using a serialized log, the log is empty if logdata is
+       * malformed
        * @param logdata serialized log
        */
       explicit Log(const QByteArray &logdata);
@@ -42,21 +92,50 @@ namespace Anonymity {
       void Pop();
 
       /**
-       * Returns the log entry at the specified index, true if it returns
-       * valid data, false otherwise
+       * Returns the log entry at the specified index or an empty entry if
+       * the index is out of range or the entry was left out of a partial log
        * @param idx index
        */
       const QPair<QByteArray, Id> &At(int idx) const;
 
+      /**
+       * Returns true if the log holds the entry at the specified index, a
+       * partial log holds only the entries it was serialized with
+       * @param idx index
+       */
+      bool Contains(int idx) const;
+
       /**
        * Returns a serialized Log
+       * @param compress compress each payload that shrinks as a result
+       */
+      QByteArray Serialize(bool compress = false) const;
+
+      /**
+       * Returns a serialized Log holding only the specified entries and the
+       * hashes of the rest
+       * @param indices the entries to include
+       * @param compress compress each payload that shrinks as a result
+       */
+      QByteArray Serialize(const QVector<int> &indices, bool compress = false) const;
+
+      /**
+       * Returns the hash of the sender and payload of the entry at the
+       * specified index
+       * @param idx index
        */
-      QByteArray Serialize() const;
+      QByteArray GetEntryHash(int idx) const;
+
+      /**
+       * Returns the hash of all entry hashes in order, a partial log has the
+       * same digest as the log it came from unless an entry was altered
+       */
+      QByteArray GetDigest() const;
 
       /**
        * Returns the amount of entries in the log
        */
-      inline int Count() { return _entries.count(); }
+      inline int Count() const { return _entries.count(); }
 
       /**
        * Clears the log
@@ -73,7 +152,22 @@ namespace Anonymity {
        */
       inline bool Enabled() { return _enabled; }
     private:
+      /**
+       * Serializes the log, leaving out entries not set in include when
+       * partial is true
+       */
+      QByteArray Serialize(const QBitArray &include, bool partial,
+          bool compress) const;
+
+      /**
+       * Parses a serialized log into this log
+       */
+      bool Parse(const QByteArray &logdata);
+
       QVector<QPair<QByteArray, Id> > _entries;
+      QBitArray _present;
+      QVector<QByteArray> _hashes;
+      QByteArray _buffer;
       bool _enabled;
       static const QPair<QByteArray, Id> _empty;
   };
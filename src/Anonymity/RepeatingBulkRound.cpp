@@ -5,9 +5,12 @@
 #include "Crypto/Library.hpp"
 #include "Crypto/Serialization.hpp"
 #include "Messaging/RpcRequest.hpp"
+#include "Utils/BufferedRandom.hpp"
+#include "Utils/Logging.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/Serialization.hpp"
+#include "Utils/Timer.hpp"
 
 #include "RepeatingBulkRound.hpp"
 #include "BulkRound.hpp"
@@ -19,21 +22,30 @@ using Dissent::Crypto::DiffieHellman;
 using Dissent::Crypto::Hash;
 using Dissent::Crypto::Library;
 using Dissent::Messaging::RpcRequest;
+using Dissent::Utils::BufferedRandom;
 using Dissent::Utils::QRunTimeError;
 using Dissent::Utils::Random;
 using Dissent::Utils::Serialization;
+using Dissent::Utils::Timer;
+using Dissent::Utils::TimerCallback;
+using Dissent::Utils::TimerMethod;
 
 namespace Dissent {
 namespace Anonymity {
+  int RepeatingBulkRound::DefaultPhaseDeadline = 0;
+
   RepeatingBulkRound::RepeatingBulkRound(const Group &group,
       const Credentials &creds, const Id &round_id,
       QSharedPointer<Network> network, GetDataCallback &get_data,
-      CreateRound create_shuffle) :
+      CreateRound create_shuffle, bool aggregate) :
     Round(group, creds, round_id, network, get_data),
     _get_shuffle_data(this, &RepeatingBulkRound::GetShuffleData),
     _state(Offline),
     _phase(0),
-    _stop_next(false)
+    _aggregate(aggregate),
+    _stop_next(false),
+    _phase_deadline(DefaultPhaseDeadline),
+    _arrival_latency(GetGroup().Count())
   {
     QVariantMap headers = GetNetwork()->GetHeaders();
     headers["bulk"] = true;
@@ -42,6 +54,7 @@ namespace Anonymity {
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     _anon_dh = QSharedPointer<DiffieHellman>(lib->CreateDiffieHellman());
     _anon_key = QSharedPointer<AsymmetricKey>(lib->CreatePrivateKey());
+    _hash_algo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
 
     QSharedPointer<Network> net(GetNetwork()->Clone());
     headers["bulk"] = false;
@@ -71,7 +84,7 @@ namespace Anonymity {
 
     foreach(GroupContainer gc, GetGroup().GetRoster()) {
       QByteArray seed = _anon_dh->GetSharedSecret(gc.third);
-      QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+      QSharedPointer<Random> rng(new BufferedRandom(lib->GetRandomNumberGenerator(seed)));
       anon_rngs.append(rng);
     }
 
@@ -100,7 +113,9 @@ namespace Anonymity {
 
     bool bulk = notification.GetMessage()["bulk"].toBool();
     if(bulk) {
-      ProcessData(notification.GetMessage()["data"].toByteArray(), id);
+      QByteArray data = notification.GetMessage()["data"].toByteArray();
+      RecordReceive(data);
+      ProcessData(data, id);
     } else {
       _shuffle_round->IncomingData(notification);
     }
@@ -121,13 +136,34 @@ namespace Anonymity {
     }
   }
 
+  void RepeatingBulkRound::ProcessEarlyArrivals()
+  {
+    foreach(const EarlyArrivalQueue::Entry &entry, _early_arrivals.TakeAll()) {
+      _log.Append(entry.data, entry.from);
+      try {
+        ProcessPayload(entry.data, entry.GetPayload(), entry.from);
+      } catch (QRunTimeError &err) {
+        qWarning() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+          "received a message from" << GetGroup().GetIndex(entry.from) << entry.from.ToString() <<
+          "in session / round" << GetRoundId().ToString() << "in state" <<
+          StateToString(_state) << "causing the following exception: " << err.What();
+        _log.Pop();
+      }
+    }
+  }
+
   void RepeatingBulkRound::ProcessDataBase(const QByteArray &data, const Id &from)
   {
     QByteArray payload;
     if(!Verify(data, payload, from)) {
       throw QRunTimeError("Invalid signature or data");
     }
+    ProcessPayload(data, payload, from);
+  }
 
+  void RepeatingBulkRound::ProcessPayload(const QByteArray &data, const QByteArray &payload,
+      const Id &from)
+  {
     if(_state == Offline) {
       throw QRunTimeError("Should never receive a message in the bulk"
           " round while offline.");
@@ -148,16 +184,31 @@ namespace Anonymity {
           GetRoundId().ToString());
     }
 
+    if(msg_type == AggregateAccusation) {
+      // May refer to a phase that only the accuser did not finish
+      HandleAggregateAccusation(stream, from, phase);
+      return;
+    }
+
+    if(msg_type == AggregatedBulkData && from == GetLocalId()) {
+      // The leader processed the phase when it sent the aggregate
+      return;
+    }
+
     if(_state == Shuffling) {
+      if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+        throw QRunTimeError("Dropped an early message");
+      }
       _log.Pop();
-      _offline_log.Append(data, from);
       return;
     }
 
     if(_phase != phase) {
       if(_phase == phase - 1 && _state == DataSharing) {
+        if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+          throw QRunTimeError("Dropped an early message");
+        }
         _log.Pop();
-        _offline_log.Append(data, from);
         return;
       } else {
         throw QRunTimeError("Received a message for phase: " + 
@@ -165,8 +216,10 @@ namespace Anonymity {
             QString::number(_phase));
       }
     } else if(_state == PhasePreparation) {
+      if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+        throw QRunTimeError("Dropped an early message");
+      }
       _log.Pop();
-      _offline_log.Append(data, from);
       return;
     }
 
@@ -174,6 +227,9 @@ namespace Anonymity {
       case BulkData:
         HandleBulkData(stream, from);
         break;
+      case AggregatedBulkData:
+        HandleAggregatedBulkData(stream, data, from);
+        break;
       default:
         throw QRunTimeError("Unknown message type");
     }
@@ -181,15 +237,19 @@ namespace Anonymity {
 
   void RepeatingBulkRound::HandleBulkData(QDataStream &stream, const Id &from)
   {
-    qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+    DISSENT_DEBUG("round.bulk") << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received bulk data from " << GetGroup().GetIndex(from) << from.ToString();
 
     if(_state != DataSharing) {
       throw QRunTimeError("Received a misordered BulkData message");
     }
 
+    if(_aggregate && GetGroup().GetLeader() != GetLocalId()) {
+      throw QRunTimeError("Received BulkData while not the aggregator");
+    }
+
     uint idx = GetGroup().GetIndex(from);
-    if(!_messages[idx].isEmpty()) {
+    if(_received.testBit(idx)) {
       throw QRunTimeError("Already have bulk data.");
     }
 
@@ -202,46 +262,173 @@ namespace Anonymity {
           QString::number(_expected_bulk_size));
     }
 
-    _messages[idx] = payload;
+    _received.setBit(idx);
+    _arrival_latency.Arrived(idx);
+    Xor(_cleartext, _cleartext, payload);
 
-    if(++_received_messages == static_cast<uint>(GetGroup().Count())) {
-      ProcessMessages();
+    if(_aggregate) {
+      _input_hashes[idx] = _hash_algo->ComputeHash(payload);
+    }
 
-      SetState(PhasePreparation);
-      qDebug() << "In" << ToString() << "ending phase.";
-      _phase++;
-      if(!PrepForNextPhase()) {
-        return;
+    if(++_received_messages == static_cast<uint>(GetGroup().Count())) {
+      if(_aggregate) {
+        SendAggregatedBulkData();
       }
+      FinishPhase();
+    }
+  }
 
-      SetState(DataSharing);
+  void RepeatingBulkRound::HandleAggregatedBulkData(QDataStream &stream,
+      const QByteArray &data, const Id &from)
+  {
+    DISSENT_DEBUG("round.bulk") << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+      ": received aggregated bulk data from " << GetGroup().GetIndex(from) <<
+      from.ToString();
 
-      uint count = static_cast<uint>(_offline_log.Count());
-      for(uint idx = 0; idx < count; idx++) {
-        QPair<QByteArray, Id> entry = _offline_log.At(idx);
-        ProcessData(entry.first, entry.second);
-      }
+    if(!_aggregate) {
+      throw QRunTimeError("Received AggregatedBulkData while not aggregating");
+    }
+
+    if(GetGroup().GetLeader() != from) {
+      throw QRunTimeError("Received aggregated bulk data from non-leader.");
+    }
+
+    if(_state != DataSharing) {
+      throw QRunTimeError("Received a misordered AggregatedBulkData message");
+    }
 
-      _offline_log.Clear();
+    QByteArray cleartext;
+    QVector<QByteArray> input_hashes;
+    stream >> cleartext >> input_hashes;
 
-      NextPhase();
+    if(static_cast<uint>(cleartext.size()) != _expected_bulk_size) {
+      throw QRunTimeError("Incorrect aggregated message length, got " +
+          QString::number(cleartext.size()) + " expected " +
+          QString::number(_expected_bulk_size));
     }
+
+    uint my_idx = GetGroup().GetIndex(GetLocalId());
+    if(input_hashes.count() != GetGroup().Count() ||
+        input_hashes[my_idx] != _my_xor_hash)
+    {
+      QByteArray packet;
+      QDataStream accusation(&packet, QIODevice::WriteOnly);
+      accusation << AggregateAccusation << GetRoundId() << _phase << data <<
+        _my_bulk_data;
+      VerifiableBroadcast(packet);
+      BlameLeader("Leader did not commit to our xor message");
+      return;
+    }
+
+    _cleartext = cleartext;
+    FinishPhase();
   }
 
-  void RepeatingBulkRound::ProcessMessages()
+  void RepeatingBulkRound::HandleAggregateAccusation(QDataStream &stream,
+      const Id &from, uint phase)
   {
-    uint size = GetGroup().Count();
+    qWarning() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+      ": received an accusation against the leader from" <<
+      GetGroup().GetIndex(from) << from.ToString();
+
+    if(!_aggregate) {
+      throw QRunTimeError("Received an accusation while not aggregating");
+    }
+
+    if(phase > _phase) {
+      throw QRunTimeError("Received an accusation for a future phase");
+    }
+
+    QByteArray aggregate_data, bulk_data;
+    stream >> aggregate_data >> bulk_data;
+
+    QByteArray aggregate_payload, bulk_payload;
+    if(!Verify(aggregate_data, aggregate_payload, GetGroup().GetLeader()) ||
+        !Verify(bulk_data, bulk_payload, from))
+    {
+      throw QRunTimeError("Accusation carries an invalid signature");
+    }
+
+    QDataStream aggregate_stream(aggregate_payload);
+    int aggregate_type;
+    QByteArray aggregate_round;
+    uint aggregate_phase;
+    QByteArray cleartext;
+    QVector<QByteArray> input_hashes;
+    aggregate_stream >> aggregate_type >> aggregate_round >> aggregate_phase >>
+      cleartext >> input_hashes;
+
+    QDataStream bulk_stream(bulk_payload);
+    int bulk_type;
+    QByteArray bulk_round;
+    uint bulk_phase;
+    QByteArray xor_msg;
+    bulk_stream >> bulk_type >> bulk_round >> bulk_phase >> xor_msg;
+
+    if(aggregate_type != AggregatedBulkData || bulk_type != BulkData ||
+        Id(aggregate_round) != GetRoundId() || Id(bulk_round) != GetRoundId() ||
+        aggregate_phase != phase || bulk_phase != phase)
+    {
+      throw QRunTimeError("Accusation does not refer to this phase");
+    }
+
+    int idx = GetGroup().GetIndex(from);
+    if(input_hashes.count() == GetGroup().Count() &&
+        input_hashes[idx] == _hash_algo->ComputeHash(xor_msg))
+    {
+      throw QRunTimeError("Accusation is contradicted by the leader's commitment");
+    }
+
+    BlameLeader("Leader did not commit to a member's xor message");
+  }
+
+  void RepeatingBulkRound::BlameLeader(const QString &reason)
+  {
+    _bad_members.clear();
+    _bad_members.append(GetGroup().GetIndex(GetGroup().GetLeader()));
+    qWarning() << "In" << ToString() << reason;
+
+    SetState(Finished);
+    SetInterrupted();
+    Stop(reason);
+  }
+
+  void RepeatingBulkRound::SendAggregatedBulkData()
+  {
+    QByteArray packet;
+    QDataStream stream(&packet, QIODevice::WriteOnly);
+    stream << AggregatedBulkData << GetRoundId() << _phase << _cleartext <<
+      _input_hashes;
+    VerifiableBroadcast(packet);
+  }
+
+  void RepeatingBulkRound::FinishPhase()
+  {
+    _phase_deadline_event.Stop();
+    ProcessMessages();
 
-    QByteArray cleartext(_expected_bulk_size, 0);
-    foreach(QByteArray ciphertext, _messages) {
-      Xor(cleartext, cleartext, ciphertext);
+    SetState(PhasePreparation);
+    qDebug() << "In" << ToString() << "ending phase.";
+    _phase++;
+    if(!PrepForNextPhase()) {
+      return;
     }
 
-    uint msg_idx = 0;
+    SetState(DataSharing);
+
+    ProcessEarlyArrivals();
+
+    NextPhase();
+  }
+
+  void RepeatingBulkRound::ProcessMessages()
+  {
+    uint size = GetGroup().Count();
+
     for(uint member_idx = 0; member_idx < size; member_idx++) {
       int length = _message_lengths[member_idx] + _header_lengths[member_idx];
-      QByteArray tcleartext = QByteArray::fromRawData(cleartext.constData() + msg_idx, length);
-      msg_idx += length;
+      QByteArray tcleartext = QByteArray::fromRawData(_cleartext.constData() +
+          _slot_offsets[member_idx], length);
       QByteArray msg = ProcessMessage(tcleartext, member_idx);
 
       if(!msg.isEmpty()) {
@@ -283,41 +470,114 @@ namespace Anonymity {
     }
 
     _log.Clear();
+    _buffers.Reset();
     uint group_size = static_cast<uint>(GetGroup().Count());
-    _messages = QVector<QByteArray>(group_size);
+    _received.fill(false, group_size);
     _received_messages = 0;
+    if(_aggregate) {
+      _input_hashes.fill(QByteArray(), group_size);
+    }
 
+    _slot_offsets.resize(group_size);
     _expected_bulk_size = 0;
     for(uint idx = 0; idx < group_size; idx++) {
+      _slot_offsets[idx] = _expected_bulk_size;
       _expected_bulk_size += _header_lengths[idx] + _message_lengths[idx];
     }
 
+    _cleartext.resize(_expected_bulk_size);
+    _cleartext.fill(0);
+
+    _arrival_latency.StartPhase();
+    if(_phase_deadline > 0 && GetGroup().GetLeader() == GetLocalId()) {
+      TimerCallback *cb = new TimerMethod<RepeatingBulkRound, uint>(this,
+          &RepeatingBulkRound::PhaseDeadline, _phase);
+      _phase_deadline_event = Timer::GetInstance().QueueCallback(cb,
+          _phase_deadline);
+    }
+
     return true;
   }
 
+  void RepeatingBulkRound::PhaseDeadline(const uint &phase)
+  {
+    if(Stopped() || phase != _phase || _state != DataSharing) {
+      return;
+    }
+
+    _bad_members.clear();
+    for(int idx = 0; idx < _received.size(); idx++) {
+      if(!_received.testBit(idx)) {
+        _bad_members.append(idx);
+      }
+    }
+
+    qWarning() << "In" << ToString() << "phase deadline exceeded, waiting on" <<
+      _bad_members;
+
+    SetState(Finished);
+    SetInterrupted();
+    Stop("Phase deadline exceeded");
+  }
+
   void RepeatingBulkRound::NextPhase()
   {
     qDebug() << "In" << ToString() << "starting phase.";
     QByteArray xor_msg = GenerateXorMessage();
     QByteArray packet;
+    // Room for the header and the length prefix, the stream never regrows it
+    packet.reserve(xor_msg.size() + 64);
     QDataStream stream(&packet, QIODevice::WriteOnly);
     stream << BulkData << GetRoundId() << _phase << xor_msg;
-    VerifiableBroadcast(packet);
+
+    if(_aggregate) {
+      _my_xor_hash = _hash_algo->ComputeHash(xor_msg);
+      // Kept signed, as evidence should the leader leave it out
+      _my_bulk_data = packet + GetSigningKey()->Sign(packet);
+      GetNetwork()->Send(_my_bulk_data, GetGroup().GetLeader());
+    } else {
+      VerifiableBroadcast(packet);
+    }
+
+    PrefetchNextPhase();
+  }
+
+  void RepeatingBulkRound::PrefetchNextPhase()
+  {
+    // Other members' slots are assumed to keep their current length
+    uint size = static_cast<uint>(_descriptors.size());
+    for(uint idx = 0; idx < size; idx++) {
+      if(idx == _my_idx) {
+        continue;
+      }
+      _descriptors[idx].third->Prefetch(_message_lengths[idx] + _header_lengths[idx]);
+    }
+
+    uint my_length = _header_lengths[_my_idx] + _next_msg.size();
+    uint my_idx = GetGroup().GetIndex(GetLocalId());
+    for(int idx = 0; idx < _anon_rngs.count(); idx++) {
+      if(static_cast<uint>(idx) != my_idx) {
+        _anon_rngs[idx]->Prefetch(my_length);
+      }
+    }
   }
 
   QByteArray RepeatingBulkRound::GenerateXorMessage()
   {
-    QByteArray msg;
+    // Every pad is generated straight into its slot, only the local slot,
+    // which is kept in _expected_msgs, is copied in
+    QByteArray &msg = _buffers.Acquire(_expected_bulk_size);
+    char *out = msg.data();
     uint size = static_cast<uint>(_descriptors.size());
     for(uint idx = 0; idx < size; idx++) {
       if(idx == _my_idx) {
-        msg.append(GenerateMyXorMessage());
+        QByteArray my_msg = GenerateMyXorMessage();
+        memcpy(out + _slot_offsets[idx], my_msg.constData(), my_msg.size());
+        BytesCopied += my_msg.size();
         continue;
       }
       uint length = _message_lengths[idx] + _header_lengths[idx];
-      QByteArray tmsg(length, 0);
-      _descriptors[idx].third->GenerateBlock(tmsg);
-      msg.append(tmsg);
+      _descriptors[idx].third->GenerateBlock(out + _slot_offsets[idx], length);
     }
 
     return msg;
@@ -329,23 +589,31 @@ namespace Anonymity {
 
     uint length = cleartext.size();
     uint my_idx = GetGroup().GetIndex(GetLocalId());
-    QByteArray xor_msg(length, 0);
-    _expected_msgs.clear();
     uint count = static_cast<uint>(GetGroup().Count());
+
+    // The pads are generated in place into last phase's buffers, the xor
+    // message takes the place of the pad at the anonymous index
+    _expected_msgs.resize(count);
+    QByteArray &xor_msg = _expected_msgs[_my_idx];
+    xor_msg.resize(length);
+    memcpy(xor_msg.data(), cleartext.constData(), length);
+    BytesCopied += length;
+
     for(uint idx = 0; idx < count; idx++) {
       if(idx == my_idx) {
-        Xor(xor_msg, xor_msg, cleartext);
-        _expected_msgs.append(QByteArray());
+        if(idx != _my_idx) {
+          _expected_msgs[idx].clear();
+        }
         continue;
       }
 
-      QByteArray tmsg(length, 0);
+      QByteArray &tmsg = (idx == _my_idx) ? _buffers.Acquire(length) :
+        _expected_msgs[idx];
+      tmsg.resize(length);
       _anon_rngs[idx]->GenerateBlock(tmsg);
-      _expected_msgs.append(tmsg);
       Xor(xor_msg, xor_msg, tmsg);
     }
 
-    _expected_msgs[_my_idx] = xor_msg;
     return xor_msg;
   }
 
@@ -355,12 +623,23 @@ namespace Anonymity {
     const QByteArray cur_msg = _next_msg;
     _next_msg = pair.first;
 
-    QByteArray cleartext(8, 0);
+    // Sized for the signature up front, so nothing is appended
+    int base_length = 8 + cur_msg.size();
+    int sig_length = _header_lengths[_my_idx] - 8;
+    QByteArray &cleartext = _buffers.Acquire(base_length + sig_length);
     Serialization::WriteInt(_phase, cleartext, 0);
     Serialization::WriteInt(_next_msg.size(), cleartext, 4);
-    cleartext.append(cur_msg);
-    QByteArray sig = _anon_key->Sign(cleartext);
-    cleartext.append(sig);
+    memcpy(cleartext.data() + 8, cur_msg.constData(), cur_msg.size());
+    BytesCopied += cur_msg.size();
+
+    QByteArray sig = _anon_key->Sign(QByteArray::fromRawData(
+          cleartext.constData(), base_length));
+    if(sig.size() != sig_length) {
+      cleartext.resize(base_length);
+      cleartext.append(sig);
+    } else {
+      memcpy(cleartext.data() + base_length, sig.constData(), sig_length);
+    }
 
     return cleartext;
   }
@@ -379,7 +658,7 @@ namespace Anonymity {
   {
     if(!_shuffle_round->Successful()) {
       _bad_members = _shuffle_round->GetBadMembers();
-      _state = Finished;
+      SetState(Finished);
       Stop("ShuffleRound failed");
       return;
     }
@@ -407,13 +686,7 @@ namespace Anonymity {
     SetState(DataSharing);
     NextPhase();
 
-    count = static_cast<uint>(_offline_log.Count());
-    for(uint idx = 0; idx < count; idx++) {
-      QPair<QByteArray, Id> entry = _offline_log.At(idx);
-      ProcessData(entry.first, entry.second);
-    }
-
-    _offline_log.Clear();
+    ProcessEarlyArrivals();
   }
 
   RepeatingBulkRound::Descriptor RepeatingBulkRound::ParseDescriptor(const QByteArray &bdes)
@@ -429,7 +702,7 @@ namespace Anonymity {
 
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     QByteArray seed = GetDhKey()->GetSharedSecret(dh_pub);
-    QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+    QSharedPointer<Random> rng(new BufferedRandom(lib->GetRandomNumberGenerator(seed)));
     return Descriptor(dh_pub, key_pub, rng);
   }
 }
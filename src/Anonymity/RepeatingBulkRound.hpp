@@ -1,20 +1,26 @@
 #ifndef DISSENT_ANONYMITY_CONTINUOUS_BULK_ROUND_H_GUARD
 #define DISSENT_ANONYMITY_CONTINUOUS_BULK_ROUND_H_GUARD
 
+#include <QBitArray>
 #include <QMetaEnum>
 #include <QSharedPointer>
 
 #include "Messaging/BufferSink.hpp"
 #include "Messaging/GetDataCallback.hpp"
+#include "Utils/BufferPool.hpp"
 #include "Utils/Triple.hpp"
 #include "Utils/Random.hpp"
+#include "Utils/TimerEvent.hpp"
 
+#include "ArrivalLatency.hpp"
+#include "EarlyArrivalQueue.hpp"
 #include "Log.hpp"
 #include "Round.hpp"
 
 namespace Dissent {
 namespace Crypto {
   class DiffieHellman;
+  class Hash;
 }
 
 namespace Utils {
@@ -34,6 +40,17 @@ namespace Anonymity {
    * phase's message, a message, and a signature.  The xor mask generation,
    * distribution, and resolution  are the same as "V1".  See BulkRound
    * comments for more information.
+   *
+   * When aggregating, members send their xor message only to the leader
+   * rather than to every other member.  The leader combines the xor messages
+   * and broadcasts the resulting cleartext along with the hashes of each
+   * member's xor message.  As that broadcast is signed by the leader, it
+   * commits the leader to the inputs used, so that each member can confirm
+   * its own xor message was included.  A member whose xor message was left
+   * out broadcasts the leader's signed commitment together with its own
+   * signed xor message, every member checks the pair and reports the leader
+   * as a bad member.  Each member then transmits a single phase sized
+   * message per phase rather than one to every member.
    */
   class RepeatingBulkRound : public Round {
     Q_OBJECT
@@ -75,6 +92,8 @@ namespace Anonymity {
        */
       enum MessageType {
         BulkData = 0,
+        AggregatedBulkData = 1,
+        AggregateAccusation = 2,
       };
 
       /**
@@ -96,16 +115,26 @@ namespace Anonymity {
        * @param get_data requests data to share during this session
        * @param create_shuffle optional parameter specifying a shuffle round
        * to create, currently used for testing
+       * @param aggregate send xor messages to the leader for aggregation
+       * rather than broadcasting them
        */
       explicit RepeatingBulkRound(const Group &group, const Credentials &creds,
           const Id &round_id, QSharedPointer<Network> network,
           GetDataCallback &get_data,
-          CreateRound create_shuffle = &TCreateRound<ShuffleRound>);
+          CreateRound create_shuffle = &TCreateRound<ShuffleRound>,
+          bool aggregate = false);
 
       /**
        * Destructor
        */
-      virtual ~RepeatingBulkRound() {}
+      virtual ~RepeatingBulkRound() { _phase_deadline_event.Stop(); }
+
+      /**
+       * Time in ms the leader waits for all bulk messages of a phase before
+       * stopping the round and reporting the missing members as bad, 0
+       * disables the deadline.  Used to initialize new rounds.
+       */
+      static int DefaultPhaseDeadline;
 
       /**
        * Start the bulk round
@@ -153,6 +182,28 @@ namespace Anonymity {
        */
       virtual uint GetPhase() { return _phase; }
 
+      /**
+       * Returns true if xor messages are aggregated by the leader
+       */
+      inline bool IsAggregating() const { return _aggregate; }
+
+      /**
+       * Sets the phase deadline in ms, 0 disables it, takes effect at the
+       * start of the next phase
+       */
+      inline void SetPhaseDeadline(int msecs) { _phase_deadline = msecs; }
+
+      /**
+       * Returns the phase deadline in ms, 0 if disabled
+       */
+      inline int GetPhaseDeadline() const { return _phase_deadline; }
+
+      /**
+       * Returns the per-member bulk message arrival latencies observed
+       * locally, relative to the start of each phase
+       */
+      inline const ArrivalLatency &GetArrivalLatency() const { return _arrival_latency; }
+
     protected:
       /**
        * If data is from a legitimate group member, it is processed
@@ -169,6 +220,22 @@ namespace Anonymity {
        */
       void ProcessDataBase(const QByteArray &data, const Id &from);
 
+      /**
+       * Processes a message whose signature has already been verified,
+       * throws exceptions for invalid data packets
+       * @param data Incoming data
+       * @param payload data without its signature
+       * @param from sending peer
+       */
+      void ProcessPayload(const QByteArray &data, const QByteArray &payload,
+          const Id &from);
+
+      /**
+       * Processes the messages held in the early arrival queue, those still
+       * early are queued again
+       */
+      void ProcessEarlyArrivals();
+
       /**
        * Returns the ShuffleSink to access serialized descriptors
        */
@@ -186,6 +253,38 @@ namespace Anonymity {
        */
       void HandleBulkData(QDataStream &stream, const Id &from);
 
+      /**
+       * Parses and handles the leader's aggregated bulk data messages
+       * @param stream serialized message
+       * @param data the signed message, evidence should the leader have
+       * left out the local xor message
+       * @param from the sender
+       */
+      void HandleAggregatedBulkData(QDataStream &stream, const QByteArray &data,
+          const Id &from);
+
+      /**
+       * Parses and checks a member's claim that the leader's signed
+       * commitment left out its signed xor message, if it holds the leader
+       * is reported as a bad member and the round stopped
+       * @param stream serialized message
+       * @param from the accuser
+       * @param phase the phase the accusation refers to
+       */
+      void HandleAggregateAccusation(QDataStream &stream, const Id &from,
+          uint phase);
+
+      /**
+       * Called by the leader when aggregating to send the cleartext and
+       * the input commitments to all members
+       */
+      virtual void SendAggregatedBulkData();
+
+      /**
+       * Returns the hashes of the xor messages the leader received this phase
+       */
+      QVector<QByteArray> &GetInputHashes() { return _input_hashes; }
+
       /**
        * Returns this phases expected message size
        */
@@ -204,7 +303,11 @@ namespace Anonymity {
       /**
        * Sets the internal state of the bulk round
        */
-      void SetState(State state) { _state = state; }
+      void SetState(State state)
+      {
+        _state = state;
+        RecordState(StateToString(state));
+      }
 
       /**
        * Prepares the local members cleartext message
@@ -239,11 +342,39 @@ namespace Anonymity {
        */
       virtual bool PrepForNextPhase();
 
+      /**
+       * Called after the local member sends its xor message, starts
+       * generating the pads for the next phase
+       */
+      virtual void PrefetchNextPhase();
+
     private:
       /**
-       * Once all bulk data messages have been received, parse them
+       * Once all bulk data messages have been received and folded into the
+       * cleartext accumulator, parse them
        */
       void ProcessMessages();
+
+      /**
+       * Processes the cleartext of the phase and starts the next phase
+       */
+      void FinishPhase();
+
+      /**
+       * Reports the leader as the round's only bad member and stops the round
+       * @param reason the reason for stopping
+       */
+      void BlameLeader(const QString &reason);
+
+      /**
+       * Called by the leader when a phase has exceeded its deadline.  The
+       * missing members' pads cannot be removed from the cleartext, so
+       * rather than reveal a partial xor the round is stopped, like on a
+       * join, with the stragglers reported as bad members so that the
+       * session excludes them from the next round
+       * @param phase the phase the deadline was set for
+       */
+      void PhaseDeadline(const uint &phase);
       
       /**
        * Parse the clear text message returning back the entry if the contents
@@ -297,9 +428,10 @@ namespace Anonymity {
       State _state;
 
       /**
-       * Stores all validated messages that arrived before start was called
+       * Stores verified messages that arrived before the round was ready
+       * for them
        */
-      Log _offline_log;
+      EarlyArrivalQueue _early_arrivals;
 
       /**
        * Stores all validated incoming messages
@@ -346,15 +478,50 @@ namespace Anonymity {
        */
       QVector<uint> _message_lengths;
 
+      /**
+       * Offset of each slot within the bulk message for this phase
+       */
+      QVector<uint> _slot_offsets;
+
       /**
        * The continuous bulk round is made up of many bulk phases
        */
       uint _phase;
 
       /**
-       * received bulk messages
+       * XOR of all bulk messages received so far in this phase
+       */
+      QByteArray _cleartext;
+
+      /**
+       * Members whose bulk message has been received this phase
+       */
+      QBitArray _received;
+
+      /**
+       * Whether or not the leader aggregates the xor messages
+       */
+      bool _aggregate;
+
+      /**
+       * Hashes of the xor messages received by the leader this phase
        */
-      QVector<QByteArray> _messages;
+      QVector<QByteArray> _input_hashes;
+
+      /**
+       * Hash of the local xor message for this phase
+       */
+      QByteArray _my_xor_hash;
+
+      /**
+       * The local signed bulk data message sent to the leader this phase
+       */
+      QByteArray _my_bulk_data;
+
+      /**
+       * Used to commit to the xor messages when aggregating
+       */
+      QSharedPointer<Dissent::Crypto::Hash> _hash_algo;
 
       /**
        * List of messages that should be in the local nodes slot
@@ -396,6 +563,27 @@ namespace Anonymity {
        */
       bool _stop_next;
 
+      /**
+       * Phase deadline in ms, 0 if disabled
+       */
+      int _phase_deadline;
+
+      /**
+       * Fires when the current phase exceeds its deadline
+       */
+      Dissent::Utils::TimerEvent _phase_deadline_event;
+
+      /**
+       * Per-member bulk message arrival latencies
+       */
+      ArrivalLatency _arrival_latency;
+
+      /**
+       * Scratch buffers for building the local messages of a phase, reused
+       * from phase to phase
+       */
+      Dissent::Utils::BufferPool _buffers;
+
     private slots:
       /**
        * Called when the descriptor shuffle ends
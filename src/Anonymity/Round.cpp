@@ -5,6 +5,8 @@
 
 namespace Dissent {
 namespace Anonymity {
+  quint64 Round::BytesCopied = 0;
+
   Round::Round(const Group &group, const Credentials &creds, const Id &round_id,
       QSharedPointer<Network> network, GetDataCallback &get_data) :
     _group(group),
@@ -13,7 +15,8 @@ namespace Anonymity {
     _network(network),
     _get_data_cb(get_data),
     _successful(false),
-    _interrupted(false)
+    _interrupted(false),
+    _record_metrics(true)
   {
   }
 
@@ -29,6 +32,9 @@ namespace Anonymity {
     }
 
     _stopped_reason = reason;
+    if(MetricsEnabled()) {
+      RoundMetrics::GetInstance().Finish(GetMetricsId());
+    }
     emit Finished();
     return true;
   }
@@ -48,7 +54,9 @@ namespace Anonymity {
       return;
     }
 
-    ProcessData(notification.GetMessage()["data"].toByteArray(), id);
+    QByteArray data = notification.GetMessage()["data"].toByteArray();
+    RecordReceive(data);
+    ProcessData(data, id);
   }
 
   bool Round::Verify(const QByteArray &data, QByteArray &msg, const Id &from)
@@ -66,8 +74,11 @@ namespace Anonymity {
       return false;
     }
 
-    msg = data.left(data.size() - sig_size);
-    QByteArray sig = QByteArray::fromRawData(data.data() + msg.size(), sig_size);
+    msg = QByteArray::fromRawData(data.constData(), data.size() - sig_size);
+    QByteArray sig = QByteArray::fromRawData(data.constData() + msg.size(), sig_size);
+    if(MetricsEnabled()) {
+      RoundMetrics::GetInstance().AddCryptoOperations(GetMetricsId());
+    }
     return key->Verify(msg, sig);
   }
 
@@ -79,6 +90,13 @@ namespace Anonymity {
     }
   }
 
+  void Round::RecordSend(qint64 bytes)
+  {
+    QString round = GetMetricsId();
+    RoundMetrics::GetInstance().AddBytesSent(round, bytes);
+    RoundMetrics::GetInstance().AddCryptoOperations(round);
+  }
+
   void Round::Send(const QByteArray &)
   {
     throw std::logic_error("Not implemented");
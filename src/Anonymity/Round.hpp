@@ -14,6 +14,7 @@
 
 #include "Credentials.hpp"
 #include "Group.hpp"
+#include "RoundMetrics.hpp"
 
 namespace Dissent {
 namespace Connections {
@@ -46,6 +47,12 @@ namespace Anonymity {
       typedef Dissent::Messaging::GetDataCallback GetDataCallback;
       typedef Dissent::Messaging::RpcRequest RpcRequest;
 
+      /**
+       * Total bytes copied by rounds in this process while assembling their
+       * outgoing xor messages, used by the benchmarks
+       */
+      static quint64 BytesCopied;
+
       /**
        * Constructor
        * @param group Group used during this round
@@ -164,7 +171,8 @@ namespace Anonymity {
        * Verifies that the provided data has a signature block and is properly
        * signed, returning the data block via msg
        * @param data the data + signature blocks
-       * @param msg the data block
+       * @param msg the data block, which refers to the memory of data and
+       * must not outlive it
        * @param from the signing peers id
        */
       bool Verify(const QByteArray &data, QByteArray &msg, const Id &from);
@@ -177,6 +185,9 @@ namespace Anonymity {
       {
         QByteArray msg = data + GetSigningKey()->Sign(data);
         GetNetwork()->Broadcast(msg);
+        if(MetricsEnabled()) {
+          RecordSend(msg.size() * (GetGroup().Count() - 1));
+        }
       }
 
       /**
@@ -188,6 +199,9 @@ namespace Anonymity {
       {
         QByteArray msg = data + GetSigningKey()->Sign(data);
         GetNetwork()->Send(msg, to);
+        if(MetricsEnabled()) {
+          RecordSend(msg.size());
+        }
       }
 
       /**
@@ -212,12 +226,68 @@ namespace Anonymity {
 
       void SetSuccessful(bool successful) { _successful = successful; }
 
+      /**
+       * Records entering a new state in the RoundMetrics, a no-op unless
+       * metrics are enabled
+       * @param state the name of the new state
+       */
+      inline void RecordState(const QString &state)
+      {
+        if(MetricsEnabled()) {
+          RoundMetrics::GetInstance().EnterState(GetMetricsId(),
+              ToString().section(' ', 0, 0).remove(':'), state);
+        }
+      }
+
+      /**
+       * Records an incoming message in the RoundMetrics, a no-op unless
+       * metrics are enabled
+       * @param data the incoming message
+       */
+      inline void RecordReceive(const QByteArray &data)
+      {
+        if(MetricsEnabled()) {
+          RoundMetrics::GetInstance().AddMessageReceived(GetMetricsId(),
+              data.size());
+        }
+      }
+
       /**
        * Returns the underlyign network
        */
       QSharedPointer<Network> &GetNetwork() { return _network; }
 
+      /**
+       * Keeps this round out of the RoundMetrics, used by rounds that only
+       * replay another member's messages
+       */
+      inline void DisableMetrics() { _record_metrics = false; }
+
+      /**
+       * Returns true if this round records into the RoundMetrics
+       */
+      inline bool MetricsEnabled() const
+      {
+        return _record_metrics && RoundMetrics::Enabled();
+      }
+
     private:
+      /**
+       * Returns the key for this round in the RoundMetrics, the round id as
+       * seen by the local member, so that many members in one process do
+       * not share an entry
+       */
+      inline QString GetMetricsId() const
+      {
+        return GetRoundId().ToString() + "/" + GetLocalId().ToString();
+      }
+
+      /**
+       * Records a signed outgoing message in the RoundMetrics
+       * @param bytes the total bytes put on the wire
+       */
+      void RecordSend(qint64 bytes);
+
       const Group _group;
       const Credentials _creds;
       const Id _round_id;
@@ -227,6 +297,7 @@ namespace Anonymity {
       QString _stopped_reason;
       QVector<int> _empty_list;
       bool _interrupted;
+      bool _record_metrics;
   };
 
   typedef Round *(*CreateRound)(const Group &,
@@ -0,0 +1,198 @@
+#include <QStringList>
+
+#include "Utils/AllocationCounter.hpp"
+#include "Utils/Time.hpp"
+
+#include "RoundMetrics.hpp"
+
+using Dissent::Utils::AllocationCounter;
+using Dissent::Utils::Time;
+
+namespace Dissent {
+namespace Anonymity {
+  bool RoundMetrics::_enabled = false;
+
+  RoundMetrics &RoundMetrics::GetInstance()
+  {
+    static RoundMetrics metrics;
+    return metrics;
+  }
+
+  void RoundMetrics::EnterState(const QString &round, const QString &name,
+      const QString &state)
+  {
+    RoundData &data = GetRoundData(round);
+    if(data.name.isEmpty()) {
+      data.name = name;
+    }
+
+    CloseState(data);
+    data.current = state;
+    data.entered = Time::GetInstance().MSecsSinceEpoch();
+    data.entered_allocations = AllocationCounter::Count();
+    data.finished = false;
+    GetCurrentState(data).entries++;
+  }
+
+  void RoundMetrics::AddBytesSent(const QString &round, qint64 bytes)
+  {
+    RoundData &data = GetRoundData(round);
+    GetCurrentState(data).bytes_sent += bytes;
+  }
+
+  void RoundMetrics::AddMessageReceived(const QString &round, qint64 bytes)
+  {
+    RoundData &data = GetRoundData(round);
+    StateMetrics &state = GetCurrentState(data);
+    state.bytes_received += bytes;
+    state.messages_received++;
+
+    qint64 now = Time::GetInstance().MSecsSinceEpoch();
+    if(data.first_received == -1) {
+      data.first_received = now;
+    }
+    data.last_received = now;
+  }
+
+  void RoundMetrics::AddCryptoOperations(const QString &round, int count)
+  {
+    RoundData &data = GetRoundData(round);
+    GetCurrentState(data).crypto_ops += count;
+  }
+
+  void RoundMetrics::Finish(const QString &round)
+  {
+    if(!_rounds.contains(round)) {
+      return;
+    }
+
+    RoundData &data = _rounds[round];
+    CloseState(data);
+    data.current = QString();
+    data.finished = true;
+  }
+
+  void RoundMetrics::Clear()
+  {
+    _rounds.clear();
+    _round_order.clear();
+  }
+
+  RoundMetrics::RoundData &RoundMetrics::GetRoundData(const QString &round)
+  {
+    if(!_rounds.contains(round)) {
+      _round_order.append(round);
+      while(_round_order.count() > MaxRounds) {
+        _rounds.remove(_round_order.takeFirst());
+      }
+    }
+    return _rounds[round];
+  }
+
+  RoundMetrics::StateMetrics &RoundMetrics::GetCurrentState(RoundData &data)
+  {
+    if(!data.states.contains(data.current)) {
+      data.order.append(data.current);
+    }
+    return data.states[data.current];
+  }
+
+  void RoundMetrics::CloseState(RoundData &data)
+  {
+    if(data.finished || !data.states.contains(data.current)) {
+      return;
+    }
+
+    StateMetrics &state = data.states[data.current];
+    if(!data.current.isEmpty()) {
+      state.msecs += Time::GetInstance().MSecsSinceEpoch() - data.entered;
+      state.allocations += AllocationCounter::Count() -
+        data.entered_allocations;
+    }
+
+    if(data.first_received != -1) {
+      state.wait_msecs += data.last_received - data.first_received;
+    }
+
+    data.first_received = -1;
+    data.last_received = -1;
+  }
+
+  QVariantList RoundMetrics::ToVariant() const
+  {
+    QVariantList rounds;
+    foreach(const QString &round, _round_order) {
+      const RoundData &data = _rounds[round];
+
+      QVariantList states;
+      foreach(const QString &name, data.order) {
+        const StateMetrics &state = data.states[name];
+        QVariantMap smap;
+        smap["state"] = name.isEmpty() ? QString("Offline") : name;
+        smap["entries"] = state.entries;
+        smap["msecs"] = state.msecs;
+        smap["bytes_sent"] = state.bytes_sent;
+        smap["bytes_received"] = state.bytes_received;
+        smap["messages_received"] = state.messages_received;
+        smap["crypto_ops"] = state.crypto_ops;
+        smap["wait_msecs"] = state.wait_msecs;
+        smap["allocations"] = state.allocations;
+        states.append(smap);
+      }
+
+      QVariantMap rmap;
+      rmap["id"] = round;
+      rmap["round"] = data.name;
+      rmap["current"] = data.current;
+      rmap["finished"] = data.finished;
+      rmap["states"] = states;
+      rounds.append(rmap);
+    }
+    return rounds;
+  }
+
+  QString RoundMetrics::ToPrometheus() const
+  {
+    static const char *names[] = {
+      "dissent_round_state_entries",
+      "dissent_round_state_msecs",
+      "dissent_round_bytes_sent",
+      "dissent_round_bytes_received",
+      "dissent_round_messages_received",
+      "dissent_round_crypto_ops",
+      "dissent_round_wait_msecs",
+      "dissent_round_allocations"
+    };
+    static const int count = sizeof(names) / sizeof(names[0]);
+
+    QStringList lines[count];
+    foreach(const QString &round, _round_order) {
+      const RoundData &data = _rounds[round];
+      foreach(const QString &name, data.order) {
+        const StateMetrics &state = data.states[name];
+        QString labels = QString("{round=\"%1\",type=\"%2\",state=\"%3\"}").
+          arg(round).arg(data.name).
+          arg(name.isEmpty() ? QString("Offline") : name);
+
+        qint64 values[count] = {state.entries, state.msecs, state.bytes_sent,
+          state.bytes_received, state.messages_received, state.crypto_ops,
+          state.wait_msecs, state.allocations};
+
+        for(int idx = 0; idx < count; idx++) {
+          lines[idx].append(names[idx] + labels + " " +
+              QString::number(values[idx]));
+        }
+      }
+    }
+
+    QString output;
+    for(int idx = 0; idx < count; idx++) {
+      output += QString("# TYPE %1 counter\n").arg(names[idx]);
+      foreach(const QString &line, lines[idx]) {
+        output += line + "\n";
+      }
+    }
+    return output;
+  }
+}
+}
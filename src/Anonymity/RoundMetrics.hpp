@@ -0,0 +1,155 @@
+#ifndef DISSENT_ANONYMITY_ROUND_METRICS_H_GUARD
+#define DISSENT_ANONYMITY_ROUND_METRICS_H_GUARD
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+namespace Dissent {
+namespace Anonymity {
+  /**
+   * Process-wide registry of per-round, per-state instrumentation: time
+   * spent in each state, bytes sent and received, crypto operations
+   * performed, and the spread between the first and last message received
+   * in a state (the time spent waiting on the slowest member), and heap
+   * allocations made while in a state when the allocation shim is loaded
+   * (see Utils::AllocationCounter).  Allocations are counted process wide, so
+   * with many members in one process each state also sees the allocations
+   * of the other members' work interleaved with it.  Rounds feed
+   * it through the helpers in Round; when disabled every hook reduces to a
+   * single static boolean test.  Rounds are keyed by round id and local
+   * member id, so that members sharing a process are kept apart.
+   */
+  class RoundMetrics {
+    public:
+      /**
+       * Number of rounds retained, older rounds are discarded
+       */
+      static const int MaxRounds = 32;
+
+      /**
+       * Returns the RoundMetrics singleton
+       */
+      static RoundMetrics &GetInstance();
+
+      /**
+       * Returns true if metrics are being collected
+       */
+      inline static bool Enabled() { return _enabled; }
+
+      /**
+       * Enables or disables collection, disabling clears nothing
+       */
+      inline static void SetEnabled(bool enabled) { _enabled = enabled; }
+
+      /**
+       * Records that a round has entered a new state, closing the time
+       * spent in the previous one
+       * @param round the round's key
+       * @param name the round's type
+       * @param state the new state
+       */
+      void EnterState(const QString &round, const QString &name,
+          const QString &state);
+
+      /**
+       * Records bytes sent in the current state
+       * @param round the round's key
+       * @param bytes the number of bytes
+       */
+      void AddBytesSent(const QString &round, qint64 bytes);
+
+      /**
+       * Records a message received in the current state
+       * @param round the round's key
+       * @param bytes the size of the message
+       */
+      void AddMessageReceived(const QString &round, qint64 bytes);
+
+      /**
+       * Records crypto operations (signatures, verifications) performed
+       * in the current state
+       * @param round the round's key
+       * @param count the number of operations
+       */
+      void AddCryptoOperations(const QString &round, int count = 1);
+
+      /**
+       * Closes the current state of a round
+       * @param round the round's key
+       */
+      void Finish(const QString &round);
+
+      /**
+       * Removes all collected data
+       */
+      void Clear();
+
+      /**
+       * Returns a list of rounds, each a map containing a list of states
+       */
+      QVariantList ToVariant() const;
+
+      /**
+       * Returns the metrics in the Prometheus text exposition format
+       */
+      QString ToPrometheus() const;
+
+    private:
+      explicit RoundMetrics() {}
+
+      struct StateMetrics {
+        StateMetrics() : entries(0), msecs(0), bytes_sent(0),
+          bytes_received(0), messages_received(0), crypto_ops(0),
+          wait_msecs(0), allocations(0) {}
+
+        int entries;
+        qint64 msecs;
+        qint64 bytes_sent;
+        qint64 bytes_received;
+        qint64 messages_received;
+        qint64 crypto_ops;
+        qint64 wait_msecs;
+        qint64 allocations;
+      };
+
+      struct RoundData {
+        RoundData() : entered(0), entered_allocations(0), first_received(-1),
+          last_received(-1), finished(false) {}
+
+        QString name;
+        QList<QString> order;
+        QHash<QString, StateMetrics> states;
+        QString current;
+        qint64 entered;
+        int entered_allocations;
+        qint64 first_received;
+        qint64 last_received;
+        bool finished;
+      };
+
+      /**
+       * Returns the data for a round, creating it if it does not exist
+       */
+      RoundData &GetRoundData(const QString &round);
+
+      /**
+       * Returns the metrics of the round's current state
+       */
+      StateMetrics &GetCurrentState(RoundData &data);
+
+      /**
+       * Closes the round's current state, accounting elapsed and wait time
+       * and allocations
+       */
+      void CloseState(RoundData &data);
+
+      static bool _enabled;
+      QHash<QString, RoundData> _rounds;
+      QList<QString> _round_order;
+  };
+}
+}
+
+#endif
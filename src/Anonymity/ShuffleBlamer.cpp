@@ -1,4 +1,7 @@
 #include <QDebug>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include "Utils/QRunTimeError.hpp"
 #include "Crypto/CryptoFactory.hpp"
@@ -6,19 +9,114 @@
 #include "ShuffleBlamer.hpp"
 
 using Dissent::Utils::QRunTimeError;
+using Dissent::Crypto::AsymmetricKey;
 using Dissent::Crypto::CryptoFactory;
-using Dissent::Crypto::OnionEncryptor;
 
 namespace Dissent {
 namespace Anonymity {
+  namespace {
+    /**
+     * Replays a single member's log, collecting the errors rather than
+     * reporting them so that many logs can be replayed at once.  Shares
+     * with the other replays the lowest index of a log that failed, a
+     * replay stops early only if a lower indexed log has failed, so the
+     * outcome does not depend on how the replays were scheduled.
+     */
+    class LogReplay : public QRunnable {
+      public:
+        LogReplay(const Group &group, const Log &log, ShuffleRoundBlame *round,
+            int idx, QAtomicInt &first_failed) :
+          _group(group), _log(log), _round(round), _idx(idx),
+          _first_failed(first_failed)
+        {
+          setAutoDelete(false);
+        }
+
+        virtual void run()
+        {
+          _round->Start();
+
+          for(int jdx = 0; jdx < _log.Count(); jdx++) {
+            // A lower indexed member has been found faulty, this replay is moot
+            if(_first_failed.fetchAndAddAcquire(0) < _idx) {
+              return;
+            }
+
+            QPair<QByteArray, Connections::Id> entry = _log.At(jdx);
+
+            try {
+              _round->ProcessData(entry.first, entry.second);
+            } catch (QRunTimeError &err) {
+              qWarning() << _idx << "received a message from" <<
+                _group.GetIndex(entry.second) << "in state" <<
+                ShuffleRound::StateToString(_round->GetState()) <<
+                "causing the following exception: " << err.What();
+              _errors.append(err.What());
+              Failed();
+            }
+          }
+        }
+
+        inline const QVector<QString> &GetErrors() const { return _errors; }
+
+      private:
+        /**
+         * Lowers the shared first failed index to this replay's index
+         */
+        void Failed()
+        {
+          int current = _first_failed.fetchAndAddAcquire(0);
+          while(_idx < current &&
+              !_first_failed.testAndSetOrdered(current, _idx))
+          {
+            current = _first_failed.fetchAndAddAcquire(0);
+          }
+        }
+
+        const Group &_group;
+        const Log &_log;
+        ShuffleRoundBlame *_round;
+        const int _idx;
+        QAtomicInt &_first_failed;
+        QVector<QString> _errors;
+    };
+
+    /**
+     * Removes every layer of the onion from a single ciphertext, useful for
+     * QtConcurrent, returns an empty array if any layer fails
+     */
+    struct OnionPeeler {
+      OnionPeeler(const QVector<AsymmetricKey *> &keys) : _keys(keys) {}
+
+      typedef QByteArray result_type;
+
+      QByteArray operator()(const QByteArray &ciphertext) const
+      {
+        QByteArray data = ciphertext;
+        foreach(const AsymmetricKey *key, _keys) {
+          data = key->Decrypt(data);
+          if(data.isEmpty()) {
+            break;
+          }
+        }
+        return data;
+      }
+
+      const QVector<AsymmetricKey *> _keys;
+    };
+  }
+
   ShuffleBlamer::ShuffleBlamer(const Group &group, const Id &round_id,
-      const QVector<Log> &logs, const QVector<AsymmetricKey *> private_keys) :
+      const QVector<Log> &logs, const QVector<AsymmetricKey *> private_keys,
+      int cell_size, int cells) :
     _group(group),
     _shufflers(group.GetSubgroup()),
     _logs(logs),
     _private_keys(private_keys),
     _bad_nodes(_group.Count(), false),
     _reasons(_group.Count()),
+    _cell_size(cell_size),
+    _cells(cells),
     _set(false)
   {
     for(int idx = 0; idx < _group.Count(); idx++) {
@@ -28,7 +126,7 @@ namespace Anonymity {
         key = _private_keys[sidx];
       }
       _rounds.append(new ShuffleRoundBlame(_group, _group.GetId(idx),
-            round_id, key));
+            round_id, key, _cell_size, _cells));
     }
   }
 
@@ -56,6 +154,11 @@ namespace Anonymity {
   {
     qDebug() << "Blame: Parsing logs";
     ParseLogs();
+    if(_set) {
+      qDebug() << "Blame: Done, faulty replay";
+      return;
+    }
+
     qDebug() << "Blame: Checking public keys";
     CheckPublicKeys();
     if(!_set) {
@@ -77,29 +180,38 @@ namespace Anonymity {
 
   void ShuffleBlamer::ParseLogs()
   {
+    QAtomicInt first_failed(_logs.count());
+    QVector<LogReplay *> replays;
     for(int idx = 0; idx < _logs.count(); idx++) {
-      ParseLog(idx);
+      replays.append(new LogReplay(_group, _logs[idx], _rounds[idx], idx,
+            first_failed));
     }
-  }
 
-  void ShuffleBlamer::ParseLog(int idx)
-  {
-    Log &clog = _logs[idx];
-    ShuffleRoundBlame *round = _rounds[idx];
-    round->Start();
-
-    for(int jdx = 0; jdx < clog.Count(); jdx++) {
-      QPair<QByteArray, Id> entry = clog.At(jdx);
-
-      try {
-        round->ProcessData(entry.first, entry.second);
-      } catch (QRunTimeError &err) {
-        qWarning() << idx << "received a message from" <<
-          _group.GetIndex(entry.second) << "in state" <<
-          ShuffleRound::StateToString(round->GetState()) <<
-          "causing the following exception: " << err.What();
-        Set(idx, err.What());
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      // A private pool, replayed rounds may use the global one themselves
+      QThreadPool pool;
+      foreach(LogReplay *replay, replays) {
+        pool.start(replay);
+      }
+      pool.waitForDone();
+    } else {
+      foreach(LogReplay *replay, replays) {
+        replay->run();
+      }
+    }
+
+    // Every log up to the first faulty one was replayed in full, anything
+    // after it may have been cut short and is ignored
+    int last = first_failed.fetchAndAddAcquire(0);
+    for(int idx = 0; idx < replays.count(); idx++) {
+      if(idx <= last) {
+        foreach(const QString &reason, replays[idx]->GetErrors()) {
+          Set(idx, reason);
+        }
       }
+      delete replays[idx];
     }
   }
 
@@ -222,17 +334,23 @@ namespace Anonymity {
 
     _inner_data = _rounds[_group.GetIndex(_shufflers.GetId(0))]->GetShuffleCipherText();
 
-    OnionEncryptor *oe = CryptoFactory::GetInstance().GetOnionEncryptor();
-    for(int idx = 0; idx < _private_keys.count(); idx++) {
-      QVector<QByteArray> outdata;
-      QVector<int> bad;
-      oe->Decrypt(_private_keys[idx], _inner_data, outdata, &bad);
-      _inner_data = outdata;
-      if(bad.count() == 0) {
-        continue;
+    // Each ciphertext is peeled through every layer independently
+    OnionPeeler peeler(_private_keys);
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      _inner_data = QtConcurrent::blockingMapped<QVector<QByteArray> >(
+          _inner_data, peeler);
+    } else {
+      for(int idx = 0; idx < _inner_data.count(); idx++) {
+        _inner_data[idx] = peeler(_inner_data[idx]);
       }
-      foreach(int bidx, bad) {
-        Set(bidx, "Invalid crypto data");
+    }
+
+    // The first shuffler holds each member's cells together
+    for(int idx = 0; idx < _inner_data.count(); idx++) {
+      if(_inner_data[idx].isEmpty()) {
+        Set(idx / _cells, "Invalid crypto data");
       }
     }
 
@@ -244,7 +362,7 @@ namespace Anonymity {
       const QVector<QByteArray> outdata = _rounds[pidx]->GetShuffleClearText();
       const QVector<QByteArray> indata = _rounds[nidx]->GetShuffleCipherText();
       
-      if(CountMatches(outdata, indata) != _rounds.count()) {
+      if(CountMatches(outdata, indata) != _rounds.count() * _cells) {
         qDebug() << "Checking" << pidx << "output against" << nidx << "input: fail";
         Set(pidx, "Changed data");
         return;
@@ -263,7 +381,7 @@ namespace Anonymity {
       return;
     }
 
-    if(CountMatches(outdata, _inner_data) != _rounds.count()) {
+    if(CountMatches(outdata, _inner_data) != _rounds.count() * _cells) {
       Set(last_shuffle, "Changed final data");
       return;
     }
@@ -273,7 +391,7 @@ namespace Anonymity {
       if(indata.count() == 0) {
         continue;
       }
-      if(CountMatches(outdata, indata) != _rounds.count()) {
+      if(CountMatches(outdata, indata) != _rounds.count() * _cells) {
         Set(last_shuffle, "Changed final data");
         return;
       }
@@ -320,7 +438,10 @@ namespace Anonymity {
     QVector<QByteArray> cleartext = _rounds[last]->GetShuffleClearText();
 
     for(int idx = 0; idx < _rounds.count(); idx++) {
-      bool good = cleartext.contains(_inner_data[idx]);
+      bool good = true;
+      for(int cell = 0; cell < _cells; cell++) {
+        good = good && cleartext.contains(_inner_data[idx * _cells + cell]);
+      }
       if(!go_found[idx] || (!good && !go[idx]) || (good && go[idx])) {
         continue;
       }
@@ -16,7 +16,10 @@ namespace Crypto {
 
 namespace Anonymity {
   /**
-   * Runs through the blame data to find faulty nodes
+   * Runs through the blame data to find faulty nodes.  Each member's log is
+   * replayed on its own thread and the onion is peeled one ciphertext per
+   * task.  Once a replay identifies a faulty member, pending replays are
+   * abandoned and the later checks are skipped.
    */
   class ShuffleBlamer {
     public:
@@ -29,9 +32,12 @@ namespace Anonymity {
        * @param round_id Unique round id (nonce)
        * @param logs all the incoming logs for nodes in the group
        * @param private_keys the outer private keys for nodes in the group
+       * @param cell_size the size of each cell in the round
+       * @param cells the number of cells each member submitted
        */
       explicit ShuffleBlamer(const Group &group, const Id &round_id,
-          const QVector<Log> &logs, const QVector<AsymmetricKey *> private_keys);
+          const QVector<Log> &logs, const QVector<AsymmetricKey *> private_keys,
+          int cell_size = ShuffleRound::BlockSize, int cells = 1);
 
       /**
        * Deconstructor
@@ -70,16 +76,12 @@ namespace Anonymity {
       void Set(int idx, const QString &reason);
       
       /**
-       * Creates Shuffle rounds using the ShuffleRoundBlame for each given log
+       * Replays each given log into its ShuffleRoundBlame concurrently and
+       * blames the lowest indexed member whose log fails to replay, the same
+       * member a replay in index order would stop at
        */
       void ParseLogs();
 
-      /**
-       * Creates a ShuffleRoundBlame for the given node idx
-       * @param idx the log to parse
-       */
-      void ParseLog(int idx);
-
       /**
        * Verifies that each node has the correct public keys
        */
@@ -106,6 +108,8 @@ namespace Anonymity {
       QVector<QVector<QString> > _reasons;
       QVector<ShuffleRoundBlame *> _rounds;
       QVector<QByteArray> _inner_data;
+      const int _cell_size;
+      const int _cells;
       bool _set;
   };
 }
@@ -1,4 +1,7 @@
+#include <QHash>
+
 #include "Crypto/CryptoFactory.hpp"
+#include "Utils/Random.hpp"
 #include "Utils/Serialization.hpp"
 #include "Utils/QRunTimeError.hpp"
 
@@ -10,6 +13,8 @@ using Dissent::Crypto::Hash;
 using Dissent::Crypto::Library;
 using Dissent::Crypto::OnionEncryptor;
 using Dissent::Utils::QRunTimeError;
+using Dissent::Utils::Random;
+using Dissent::Utils::Serialization;
 
 namespace Dissent {
 namespace Anonymity {
@@ -17,8 +22,11 @@ namespace Anonymity {
 
   ShuffleRound::ShuffleRound(const Group &group,
       const Credentials &creds, const Id &round_id,
-      QSharedPointer<Network> network, GetDataCallback &get_data) :
+      QSharedPointer<Network> network, GetDataCallback &get_data,
+      int cell_size, int cells) :
     Round(group, creds, round_id, network, get_data),
+    _cell_size(cell_size),
+    _cells(cells),
     _shufflers(GetGroup().GetSubgroup()),
     _shuffler(_shufflers.Contains(GetLocalId())),
     _state(Offline),
@@ -54,26 +62,44 @@ namespace Anonymity {
     }
   }
 
-  QByteArray ShuffleRound::PrepareData()
+  QVector<QByteArray> ShuffleRound::PrepareData()
   {
-    QPair<QByteArray, bool> data = GetData(BlockSize);
+    const int header = GetCellHeaderSize();
+    QVector<QByteArray> cells(_cells, QByteArray(header + _cell_size, 0));
+
+    QPair<QByteArray, bool> data = GetData(GetMaximumDataSize());
     if(data.first.isEmpty()) {
-      return DefaultData;
-    } else if(data.first.size() > BlockSize) {
+      return cells;
+    } else if(data.first.size() > GetMaximumDataSize()) {
       qWarning() << "Attempted to send a data larger than the block size:" <<
-        data.first.size() << ":" << BlockSize;
+        data.first.size() << ":" << GetMaximumDataSize();
 
-      return DefaultData;
+      return cells;
     }
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       "Sending real data:" << data.first.size() << data.first.toBase64();
 
-    QByteArray msg(4, 0);
-    Dissent::Utils::Serialization::WriteInt(data.first.size(), msg, 0);
-    msg.append(data.first);
-    msg.resize(BlockSize + 4);
-    return msg;
+    int count = (data.first.size() + _cell_size - 1) / _cell_size;
+    QByteArray tag(CellTagSize, 0);
+    if(_cells > 1) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+      rand->GenerateBlock(tag);
+    }
+
+    for(int idx = 0; idx < count; idx++) {
+      QByteArray chunk = data.first.mid(idx * _cell_size, _cell_size);
+      QByteArray &cell = cells[idx];
+      Serialization::WriteInt(chunk.size(), cell, 0);
+      if(_cells > 1) {
+        Serialization::WriteInt(idx, cell, 4);
+        Serialization::WriteInt(count, cell, 8);
+        cell.replace(12, CellTagSize, tag);
+      }
+      cell.replace(header, chunk.size(), chunk);
+    }
+    return cells;
   }
 
   QByteArray ShuffleRound::ParseData(QByteArray data)
@@ -83,7 +109,7 @@ namespace Anonymity {
       return QByteArray();
     }
 
-    if(size > BlockSize || size > data.size() - 4) {
+    if(size > _cell_size || size > data.size() - 4) {
       qWarning() << "Received bad cleartext...";
       return QByteArray();
     }
@@ -91,6 +117,68 @@ namespace Anonymity {
     return QByteArray(data.data() + 4, size);
   }
 
+  void ShuffleRound::PushCells(const QVector<QByteArray> &cleartexts)
+  {
+    // Cells sharing a tag belong to one message, which is pushed in the
+    // position its first cell was shuffled to
+    QHash<QByteArray, QVector<QByteArray> > messages;
+    QVector<QByteArray> order;
+
+    foreach(const QByteArray &cleartext, cleartexts) {
+      if(cleartext.size() < MultiCellHeaderSize) {
+        qWarning() << "Received bad cleartext...";
+        continue;
+      }
+
+      int size = Serialization::ReadInt(cleartext, 0);
+      if(size == 0) {
+        continue;
+      }
+
+      int index = Serialization::ReadInt(cleartext, 4);
+      int count = Serialization::ReadInt(cleartext, 8);
+      if(size < 0 || size > _cell_size ||
+          size > cleartext.size() - MultiCellHeaderSize ||
+          count < 1 || count > _cells || index < 0 || index >= count)
+      {
+        qWarning() << "Received bad cleartext...";
+        continue;
+      }
+
+      QByteArray tag = cleartext.mid(12, CellTagSize);
+      QVector<QByteArray> &chunks = messages[tag];
+      if(chunks.isEmpty()) {
+        chunks.resize(count);
+        order.append(tag);
+      }
+
+      if(chunks.count() != count || !chunks[index].isEmpty()) {
+        qWarning() << "Received conflicting cells";
+        continue;
+      }
+      chunks[index] = cleartext.mid(MultiCellHeaderSize, size);
+    }
+
+    foreach(const QByteArray &tag, order) {
+      QByteArray msg;
+      bool complete = true;
+      foreach(const QByteArray &chunk, messages[tag]) {
+        if(chunk.isEmpty()) {
+          complete = false;
+          break;
+        }
+        msg.append(chunk);
+      }
+
+      if(!complete) {
+        qWarning() << "Dropping a message missing cells";
+        continue;
+      }
+      qDebug() << "Received a valid message: " << msg.size() << msg.toBase64();
+      PushData(msg, this);
+    }
+  }
+
   bool ShuffleRound::Start()
   {
     if(!Round::Start()) {
@@ -106,7 +194,7 @@ namespace Anonymity {
       _inner_key.reset(lib->CreatePrivateKey());
       _outer_key.reset(lib->CreatePrivateKey());
       if(_shufflers.GetIndex(GetLocalId()) == 0) {
-        _shuffle_ciphertext = QVector<QByteArray>(GetGroup().Count());
+        _shuffle_ciphertext = QVector<QByteArray>(GetGroup().Count() * _cells);
       }
     }
 
@@ -194,17 +282,24 @@ namespace Anonymity {
       throw QRunTimeError("Received a null data");
     }
 
-    if(!_shuffle_ciphertext[gidx].isEmpty()) {
-      if(_shuffle_ciphertext[gidx] != data) {
-        throw QRunTimeError("Received a unique second data message");
-      } else {
+    // A member's cells fill its slots in the order they arrive
+    int slot = -1;
+    for(int cell = 0; cell < _cells && slot == -1; cell++) {
+      const QByteArray &current = _shuffle_ciphertext[gidx * _cells + cell];
+      if(current.isEmpty()) {
+        slot = gidx * _cells + cell;
+      } else if(current == data) {
         throw QRunTimeError("Received multiples data messages from same identity");
       }
     }
 
-    _shuffle_ciphertext[gidx] = data;
+    if(slot == -1) {
+      throw QRunTimeError("Received a unique second data message");
+    }
+
+    _shuffle_ciphertext[slot] = data;
 
-    if(++_data_received == GetGroup().Count()) {
+    if(++_data_received == GetGroup().Count() * _cells) {
       _data_received = 0;
       Shuffle();
     }
@@ -495,7 +590,7 @@ namespace Anonymity {
   void ShuffleRound::BroadcastPublicKeys()
   {
     if(_state == Offline) {
-      _state = KeySharing;
+      SetState(KeySharing);
     }
 
     if(!_shuffler) {
@@ -521,32 +616,39 @@ namespace Anonymity {
 
   void ShuffleRound::SubmitData()
   {
-    _state = DataSubmission;
+    SetState(DataSubmission);
 
     OnionEncryptor *oe = CryptoFactory::GetInstance().GetOnionEncryptor();
-    oe->Encrypt(_public_inner_keys, PrepareData(), _inner_ciphertext, 0);
-    oe->Encrypt(_public_outer_keys, _inner_ciphertext, _outer_ciphertext, 0);
-
-
-    QByteArray msg;
-    QDataStream stream(&msg, QIODevice::WriteOnly);
-    stream << Data << GetRoundId().GetByteArray() << _outer_ciphertext;
+    QVector<QByteArray> cells = PrepareData();
+    _inner_ciphertexts = QVector<QByteArray>(cells.count());
+    _outer_ciphertexts = QVector<QByteArray>(cells.count());
+    for(int idx = 0; idx < cells.count(); idx++) {
+      oe->Encrypt(_public_inner_keys, cells[idx], _inner_ciphertexts[idx], 0);
+      oe->Encrypt(_public_outer_keys, _inner_ciphertexts[idx],
+          _outer_ciphertexts[idx], 0);
+    }
 
     if(_shuffler) {
-      _state = WaitingForShuffle;
+      SetState(WaitingForShuffle);
     } else {
-      _state = WaitingForEncryptedInnerData;
+      SetState(WaitingForEncryptedInnerData);
     }
 
     qDebug() << _shufflers.GetIndex(GetLocalId()) << GetGroup().GetIndex(GetLocalId())
       << ": data submitted now in state:" << StateToString(_state);
 
-    VerifiableSend(msg, _shufflers.GetId(0));
+    // One message per cell, so the first shuffler handles each as before
+    foreach(const QByteArray &ciphertext, _outer_ciphertexts) {
+      QByteArray msg;
+      QDataStream stream(&msg, QIODevice::WriteOnly);
+      stream << Data << GetRoundId().GetByteArray() << ciphertext;
+      VerifiableSend(msg, _shufflers.GetId(0));
+    }
   }
 
   void ShuffleRound::Shuffle()
   {
-    _state = Shuffling;
+    SetState(Shuffling);
     qDebug() << _shufflers.GetIndex(GetLocalId()) << GetGroup().GetIndex(GetLocalId())
       << ": shuffling";
 
@@ -583,7 +685,7 @@ namespace Anonymity {
     QDataStream out_stream(&msg, QIODevice::WriteOnly);
     out_stream << mtype << GetRoundId().GetByteArray() << _shuffle_cleartext;
 
-    _state = WaitingForEncryptedInnerData;
+    SetState(WaitingForEncryptedInnerData);
 
     qDebug() << _shufflers.GetIndex(GetLocalId()) << GetGroup().GetIndex(GetLocalId())
       << ": finished shuffling";
@@ -597,8 +699,11 @@ namespace Anonymity {
 
   void ShuffleRound::VerifyInnerCiphertext()
   {
-    _state = Verification;
-    bool found = _encrypted_data.contains(_inner_ciphertext);
+    SetState(Verification);
+    bool found = true;
+    foreach(const QByteArray &ciphertext, _inner_ciphertexts) {
+      found = found && _encrypted_data.contains(ciphertext);
+    }
 
     MessageType mtype = found ?  GoMessage : NoGoMessage;
     QByteArray msg;
@@ -631,7 +736,7 @@ namespace Anonymity {
 
   void ShuffleRound::BroadcastPrivateKey()
   {
-    _state = PrivateKeySharing;
+    SetState(PrivateKeySharing);
 
     if(!_shuffler) {
       qDebug() << _shufflers.GetIndex(GetLocalId()) <<
@@ -653,7 +758,7 @@ namespace Anonymity {
 
   void ShuffleRound::Decrypt()
   {
-    _state = Decryption;
+    SetState(Decryption);
 
     QVector<QByteArray> cleartexts = _encrypted_data;
 
@@ -666,7 +771,7 @@ namespace Anonymity {
       if(!oe->Decrypt(key, cleartexts, tmp, &bad)) {
         qWarning() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
           ": failed to decrypt final layers due to block at index" << bad;
-        _state = Finished;
+        SetState(Finished);
         Stop("Round unsuccessfully finished.");
         return;
       }
@@ -674,16 +779,20 @@ namespace Anonymity {
       cleartexts = tmp;
     }
 
-    foreach(QByteArray cleartext, cleartexts) {
-      QByteArray msg = ParseData(cleartext);
-      if(msg.isEmpty()) {
-        continue;
+    if(_cells > 1) {
+      PushCells(cleartexts);
+    } else {
+      foreach(QByteArray cleartext, cleartexts) {
+        QByteArray msg = ParseData(cleartext);
+        if(msg.isEmpty()) {
+          continue;
+        }
+        qDebug() << "Received a valid message: " << msg.size() << msg.toBase64();
+        PushData(msg, this);
       }
-      qDebug() << "Received a valid message: " << msg.size() << msg.toBase64();
-      PushData(msg, this);
     }
     SetSuccessful(true);
-    _state = Finished;
+    SetState(Finished);
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
         ": round finished successfully";
@@ -703,7 +812,7 @@ namespace Anonymity {
     _blame_verification_msgs = QVector<HashSig>(GetGroup().Count());
 
     _blame_state = _state;
-    _state = BlameInit;
+    SetState(BlameInit);
     _blame_verifications = 0;
 
     QByteArray log = _log.Serialize();
@@ -738,7 +847,7 @@ namespace Anonymity {
   {
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
         ": broadcasting blame state.";
-    _state = BlameShare;
+    SetState(BlameShare);
 
     QByteArray msg;
     QDataStream stream(&msg, QIODevice::WriteOnly);
@@ -780,7 +889,8 @@ namespace Anonymity {
       return;
     }
 
-    ShuffleBlamer sb(GetGroup(), GetRoundId(), _logs, _private_outer_keys);
+    ShuffleBlamer sb(GetGroup(), GetRoundId(), _logs, _private_outer_keys,
+        _cell_size, _cells);
     sb.Start();
     for(int idx = 0; idx < sb.GetBadNodes().count(); idx++) {
       if(sb.GetBadNodes()[idx]) {
@@ -788,7 +898,7 @@ namespace Anonymity {
         _bad_members.append(idx);
       }
     }
-    _state = Finished;
+    SetState(Finished);
     Stop("Round caused blame and finished unsuccessfully.");
   }
 }
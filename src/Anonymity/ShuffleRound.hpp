@@ -40,6 +40,13 @@ namespace Anonymity {
    * each other member can verify they are viewing the same state.  Each peer
    * will replay the round and determine the faulty peer.
    *
+   * By default each member submits one cell of BlockSize bytes.  A round may
+   * instead use a different cell size and have each member submit several
+   * cells, all shuffled together under the same permutation, so a payload
+   * larger than one cell is split across cells and reassembled after
+   * decryption.  Every member submits the same number of cells, padding with
+   * empty ones, so the cell count reveals nothing about who sent what.
+   *
    * The blame phase is still being evolved.
    */
 
@@ -114,6 +121,23 @@ namespace Anonymity {
        */
       static const QByteArray DefaultData;
 
+      /**
+       * Header of a cell in a single cell round: the data length
+       */
+      static const int CellHeaderSize = 4;
+
+      /**
+       * Header of a cell in a multiple cell round: the data length, the
+       * index of the cell, the number of cells in the message, and a tag
+       * shared by the cells of the message
+       */
+      static const int MultiCellHeaderSize = 20;
+
+      /**
+       * Length of the tag linking the cells of a message
+       */
+      static const int CellTagSize = 8;
+
       /**
        * Constructor
        * @param group Group used during this round
@@ -121,10 +145,13 @@ namespace Anonymity {
        * @param round_id Unique round id (nonce)
        * @param network handles message sending
        * @param get_data requests data to share during this session
+       * @param cell_size bytes of data carried by each cell
+       * @param cells number of cells each member submits
        */
       explicit ShuffleRound(const Group &group, 
           const Credentials &creds, const Id &round_id,
-          QSharedPointer<Network> network, GetDataCallback &get_data);
+          QSharedPointer<Network> network, GetDataCallback &get_data,
+          int cell_size = BlockSize, int cells = 1);
 
       /**
        * Deconstructor
@@ -164,6 +191,21 @@ namespace Anonymity {
        */
       const Group &GetShufflers() { return _shufflers; }
 
+      /**
+       * Returns the bytes of data carried by each cell
+       */
+      inline int GetCellSize() const { return _cell_size; }
+
+      /**
+       * Returns the number of cells each member submits
+       */
+      inline int GetCellCount() const { return _cells; }
+
+      /**
+       * Returns the largest message a member may submit
+       */
+      inline int GetMaximumDataSize() const { return _cell_size * _cells; }
+
       virtual bool Start();
 
       inline virtual QString ToString() const { return "ShuffleRound: " + GetRoundId().ToString(); }
@@ -171,6 +213,15 @@ namespace Anonymity {
     protected:
       virtual void ProcessData(const QByteArray &data, const Id &from);
 
+      /**
+       * Sets the internal state of the shuffle round
+       */
+      inline void SetState(State state)
+      {
+        _state = state;
+        RecordState(StateToString(state));
+      }
+
       /**
        * Allows direct access to the message parsing without a try / catch
        * surrounding it
@@ -290,10 +341,10 @@ namespace Anonymity {
       virtual void BlameRound();
 
       /**
-       * Takes a data block and makes it proper encoding for the shuffle
-       * @param data data input
+       * Retrieves data to send and splits it into cells, padding with empty
+       * cells up to the round's cell count
        */
-      QByteArray PrepareData();
+      QVector<QByteArray> PrepareData();
 
       /**
        * Retrieves from a data block from shuffle data
@@ -301,6 +352,34 @@ namespace Anonymity {
        */
       QByteArray ParseData(QByteArray data);
 
+      /**
+       * Reassembles the messages split across multiple cells and pushes
+       * them, dropping malformed cells and incomplete messages
+       * @param cleartexts the decrypted cells
+       */
+      void PushCells(const QVector<QByteArray> &cleartexts);
+
+      /**
+       * Returns the size of a cell's header for this round
+       */
+      inline int GetCellHeaderSize() const
+      {
+        if(_cells > 1) {
+          return MultiCellHeaderSize;
+        }
+        return CellHeaderSize;
+      }
+
+      /**
+       * Bytes of data carried by each cell
+       */
+      const int _cell_size;
+
+      /**
+       * Cells each member submits
+       */
+      const int _cells;
+
       /**
        * Group of members responsible for providing anonymity
        */
@@ -398,14 +477,14 @@ namespace Anonymity {
       QVector<QByteArray> _encrypted_data;
       
       /**
-       * Local nodes inner onion ciphertext
+       * Local nodes inner onion ciphertexts, one per cell
        */
-      QByteArray _inner_ciphertext;
+      QVector<QByteArray> _inner_ciphertexts;
 
       /**
-       * Local nodes outer onion ciphertext
+       * Local nodes outer onion ciphertexts, one per cell
        */
-      QByteArray _outer_ciphertext;
+      QVector<QByteArray> _outer_ciphertexts;
 
       /**
        * Stores all validated messages that arrived before start was called
@@ -464,6 +543,26 @@ namespace Anonymity {
        */
       QVector<int> _bad_members;
   };
+
+  /**
+   * A ShuffleRound whose members each submit Cells cells of CellSize bytes,
+   * for use with TCreateRound, e.g., small cells for short messages or many
+   * cells for messages larger than BlockSize
+   */
+  template <int CellSize, int Cells> class CellShuffleRound :
+      public ShuffleRound
+  {
+    public:
+      explicit CellShuffleRound(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> network, GetDataCallback &get_data) :
+        ShuffleRound(group, creds, round_id, network, get_data, CellSize,
+            Cells)
+      {
+      }
+
+      virtual ~CellShuffleRound() {}
+  };
 }
 }
 
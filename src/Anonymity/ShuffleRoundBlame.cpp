@@ -11,17 +11,20 @@ using Dissent::Crypto::OnionEncryptor;
 namespace Dissent {
 namespace Anonymity {
   ShuffleRoundBlame::ShuffleRoundBlame(const Group &group, const Id &local_id,
-      const Id &round_id, AsymmetricKey *outer_key) :
+      const Id &round_id, AsymmetricKey *outer_key, int cell_size,
+      int cells) :
     ShuffleRound(group, Credentials(local_id, QSharedPointer<AsymmetricKey>(),
           QSharedPointer<DiffieHellman>()),
         round_id, Dissent::Connections::EmptyNetwork::GetInstance(),
-        Dissent::Messaging::EmptyGetDataCallback::GetInstance())
+        Dissent::Messaging::EmptyGetDataCallback::GetInstance(), cell_size,
+        cells)
   {
     if(outer_key) {
       Library *lib = CryptoFactory::GetInstance().GetLibrary();
       _outer_key.reset(lib->LoadPrivateKeyFromByteArray(outer_key->GetByteArray()));
     }
     _log.ToggleEnabled();
+    DisableMetrics();
   }
 
   bool ShuffleRoundBlame::Start()
@@ -17,9 +17,12 @@ namespace Anonymity {
        * @param local_id The local peers id
        * @param round_id Unique round id (nonce)
        * @param outer_key the peers private outer key
+       * @param cell_size the size of each cell in the round being replayed
+       * @param cells the number of cells each member submitted
        */
       explicit ShuffleRoundBlame(const Group &group, const Id &local_id,
-          const Id &round_id, AsymmetricKey *outer_key);
+          const Id &round_id, AsymmetricKey *outer_key,
+          int cell_size = BlockSize, int cells = 1);
 
       /**
        * Destructor
@@ -65,9 +68,15 @@ namespace Anonymity {
 
       virtual bool Start();
 
+      /**
+       * Replays a logged message, unlike a live round any error is thrown back
+       * to the caller, as an honest member would never have logged it
+       * @param data the logged message
+       * @param from the sender of the message
+       */
       inline virtual void ProcessData(const QByteArray &data, const Id &from)
       {
-        ShuffleRound::ProcessData(data, from);
+        ProcessDataBase(data, from);
       }
 
     protected:
@@ -1,23 +1,54 @@
 
 #include <QDebug>
-#include <QString>
 
 #include "BlameMatrix.hpp"
 
 namespace Dissent {
 namespace Anonymity {
 namespace Tolerant {
+  namespace {
+    const uint WordBits = 64;
+
+    inline int PopCount(quint64 word)
+    {
+#if defined(__GNUC__)
+      return __builtin_popcountll(word);
+#else
+      word = word - ((word >> 1) & Q_UINT64_C(0x5555555555555555));
+      word = (word & Q_UINT64_C(0x3333333333333333)) +
+        ((word >> 2) & Q_UINT64_C(0x3333333333333333));
+      word = (word + (word >> 4)) & Q_UINT64_C(0x0f0f0f0f0f0f0f0f);
+      return static_cast<int>((word * Q_UINT64_C(0x0101010101010101)) >> 56);
+#endif
+    }
+
+    /**
+     * Returns the index of the lowest set bit, word must not be zero
+     */
+    inline uint LowestBit(quint64 word)
+    {
+#if defined(__GNUC__)
+      return __builtin_ctzll(word);
+#else
+      uint idx = 0;
+      while(!(word & 1)) {
+        word >>= 1;
+        idx++;
+      }
+      return idx;
+#endif
+    }
+  }
 
   BlameMatrix::BlameMatrix(uint num_users, uint num_servers) :
     _num_users(num_users),
     _num_servers(num_servers),
+    _row_words((num_servers + WordBits - 1) / WordBits),
+    _user_bits(num_users * _row_words, 0),
+    _server_bits(num_users * _row_words, 0),
     _user_output_bits(_num_users),
     _server_output_bits(_num_servers)
   {
-    _data.resize(_num_users);
-    for(uint user_idx=0; user_idx<_num_users; user_idx++) {
-      _data[user_idx].resize(_num_servers);
-    }
   }
 
   void BlameMatrix::AddUserAlibi(uint user_idx, const QBitArray &bits)
@@ -25,8 +56,17 @@ namespace Tolerant {
     Q_ASSERT(user_idx < _num_users);
     Q_ASSERT(_num_servers == static_cast<uint>(bits.count()));
 
-    for(uint server_idx=0; server_idx<_num_servers; server_idx++) {
-      _data[user_idx][server_idx].user_bit = bits[server_idx];
+    // A user's alibi is one row, fill it a word at a time
+    quint64 *row = _user_bits.data() + user_idx * _row_words;
+    for(uint word = 0; word < _row_words; word++) {
+      quint64 value = 0;
+      uint end = qMin(_num_servers, (word + 1) * WordBits);
+      for(uint server_idx = word * WordBits; server_idx < end; server_idx++) {
+        if(bits.testBit(server_idx)) {
+          value |= Q_UINT64_C(1) << (server_idx % WordBits);
+        }
+      }
+      row[word] = value;
     }
   }
 
@@ -35,8 +75,15 @@ namespace Tolerant {
     Q_ASSERT(server_idx < _num_servers);
     Q_ASSERT(_num_users == static_cast<uint>(bits.count()));
 
+    quint64 *column = _server_bits.data() + server_idx / WordBits;
+    quint64 mask = Q_UINT64_C(1) << (server_idx % WordBits);
     for(uint user_idx=0; user_idx<_num_users; user_idx++) {
-      _data[user_idx][server_idx].server_bit= bits[user_idx];
+      quint64 &word = column[user_idx * _row_words];
+      if(bits.testBit(user_idx)) {
+        word |= mask;
+      } else {
+        word &= ~mask;
+      }
     }
   }
 
@@ -53,38 +100,40 @@ namespace Tolerant {
   QVector<int> BlameMatrix::GetBadUsers() const
   {
     QVector<int> bad;
-    for(uint user_idx=0; user_idx<_num_users; user_idx++) {
-      bool out = false;
-      QString debug;
-      for(uint server_idx=0; server_idx<_num_servers; server_idx++) {
-        out ^= _data[user_idx][server_idx].user_bit;
-        debug += (QString("^") + (_data[user_idx][server_idx].user_bit ? "1" : "0"));
+    const quint64 *row = _user_bits.constData();
+    for(uint user_idx=0; user_idx<_num_users; user_idx++, row += _row_words) {
+      int ones = 0;
+      for(uint word = 0; word < _row_words; word++) {
+        ones += PopCount(row[word]);
       }
 
+      bool out = ones & 1;
       if(out != _user_output_bits[user_idx]) {
+        qDebug() << "BITS" << user_idx << ":" << _user_output_bits[user_idx] << "!=" << out;
         bad.append(user_idx);
       }
-      qDebug() << "BITS" << user_idx << ":" << _user_output_bits[user_idx] << " == " << debug;
     }
     return bad;
   }
 
   QVector<int> BlameMatrix::GetBadServers() const
   {
-    QVector<int> bad;
-    for(uint server_idx=0; server_idx<_num_servers; server_idx++) {
-      bool out = false;
-
-      QString debug;
-      for(uint user_idx=0; user_idx<_num_users; user_idx++) {
-        out ^= _data[user_idx][server_idx].server_bit;
-        debug += (QString("^") + (_data[user_idx][server_idx].server_bit ? "1" : "0"));
+    // The parity of every column at once, by xoring the rows together
+    QVector<quint64> parity(_row_words, 0);
+    const quint64 *row = _server_bits.constData();
+    for(uint user_idx=0; user_idx<_num_users; user_idx++, row += _row_words) {
+      for(uint word = 0; word < _row_words; word++) {
+        parity[word] ^= row[word];
       }
+    }
 
+    QVector<int> bad;
+    for(uint server_idx=0; server_idx<_num_servers; server_idx++) {
+      bool out = (parity[server_idx / WordBits] >> (server_idx % WordBits)) & 1;
       if(out != _server_output_bits[server_idx]) {
+        qDebug() << "BITS" << server_idx << ":" << _server_output_bits[server_idx] << "!=" << out;
         bad.append(server_idx);
       }
-      qDebug() << "BITS" << server_idx << ":" << _server_output_bits[server_idx] << " == " << debug;
     }
     return bad;
   }
@@ -92,20 +141,64 @@ namespace Tolerant {
   QList<Conflict> BlameMatrix::GetConflicts(uint slot_idx) const
   {
     QList<Conflict> conflicts;
+    const quint64 *user_row = _user_bits.constData();
+    const quint64 *server_row = _server_bits.constData();
     for(uint user_idx=0; user_idx<_num_users; user_idx++) {
-      for(uint server_idx=0; server_idx<_num_servers; server_idx++) {
-        struct bit_pair bits = _data[user_idx][server_idx];
-        if(bits.user_bit != bits.server_bit) {
-          Conflict c(slot_idx, user_idx, bits.user_bit, server_idx, bits.server_bit);
+      for(uint word = 0; word < _row_words; word++) {
+        quint64 diff = user_row[word] ^ server_row[word];
+        while(diff) {
+          uint bit = LowestBit(diff);
+          diff &= diff - 1;
+
+          uint server_idx = word * WordBits + bit;
+          bool user_bit = (user_row[word] >> bit) & 1;
+          Conflict c(slot_idx, user_idx, user_bit, server_idx, !user_bit);
           conflicts.append(c);
         }
       }
+      user_row += _row_words;
+      server_row += _row_words;
     }
 
     return conflicts;
   }
 
+  QVector<int> BlameMatrix::GetUserConflictCounts() const
+  {
+    QVector<int> counts(_num_users, 0);
+    const quint64 *user_row = _user_bits.constData();
+    const quint64 *server_row = _server_bits.constData();
+    for(uint user_idx=0; user_idx<_num_users; user_idx++) {
+      for(uint word = 0; word < _row_words; word++) {
+        counts[user_idx] += PopCount(user_row[word] ^ server_row[word]);
+      }
+      user_row += _row_words;
+      server_row += _row_words;
+    }
+    return counts;
+  }
+
+  QVector<int> BlameMatrix::GetServerConflictCounts() const
+  {
+    // Conflicts are rare, so visiting each set bit of the differences is
+    // cheaper than counting every column
+    QVector<int> counts(_num_servers, 0);
+    const quint64 *user_row = _user_bits.constData();
+    const quint64 *server_row = _server_bits.constData();
+    for(uint user_idx=0; user_idx<_num_users; user_idx++) {
+      for(uint word = 0; word < _row_words; word++) {
+        quint64 diff = user_row[word] ^ server_row[word];
+        while(diff) {
+          counts[word * WordBits + LowestBit(diff)]++;
+          diff &= diff - 1;
+        }
+      }
+      user_row += _row_words;
+      server_row += _row_words;
+    }
+    return counts;
+  }
+
 }
 }
 }
-
@@ -18,20 +18,15 @@ namespace Tolerant {
    * BlameMatrix uses a combination of alibi data (sent by other nodes)
    * and message history data (stored by this node) to determine which
    * nodes sent discordant random strings in a given bit position.
+   *
+   * The user and server bits are kept in two bit-packed matrices, one row
+   * per user and one bit per server, so that parities and conflicts are
+   * computed a 64-bit word at a time.
    */
   class BlameMatrix {
 
     public:
 
-      /**
-       * A struct holding two bits -- the bit that the user sent
-       * and the bit that the server sent
-       */
-      struct bit_pair {
-        bool user_bit;
-        bool server_bit;
-      };
-
       /** 
        * Constructor.
        * @param number of users
@@ -92,6 +87,18 @@ namespace Tolerant {
        */
       QList<Conflict> GetConflicts(uint slot_idx) const;
 
+      /**
+       * Return, for each user, the number of servers whose bit
+       * disagrees with the user's bit
+       */
+      QVector<int> GetUserConflictCounts() const;
+
+      /**
+       * Return, for each server, the number of users whose bit
+       * disagrees with the server's bit
+       */
+      QVector<int> GetServerConflictCounts() const;
+
     private:
 
       /** 
@@ -104,10 +111,18 @@ namespace Tolerant {
        */
       const uint _num_servers;
 
-      /** 
-       * Vector of data[user][server] => (user_bit, server_bit) 
+      /**
+       * Number of 64-bit words in a row
+       */
+      const uint _row_words;
+
+      /**
+       * Row-major bits: word [user * _row_words + server / 64] holds
+       * the bit for (user, server) at position server % 64, padding
+       * bits are always zero
        */
-      QVector<QVector<struct bit_pair> > _data;
+      QVector<quint64> _user_bits;
+      QVector<quint64> _server_bits;
 
       /**
        * Bits transmitted by the users for the corrupted bit position
@@ -1,59 +1,120 @@
-
 #include <QDebug>
 
+#include "Utils/QRunTimeError.hpp"
+
 #include "MessageHistory.hpp"
 
+using Dissent::Utils::QRunTimeError;
+
 namespace Dissent {
 namespace Anonymity {
 namespace Tolerant {
   
   MessageHistory::MessageHistory(uint num_users, uint num_servers) :
     _corrupted_slots(num_users, false),
-    _user_data(num_users),
-    _server_data(num_users),
     _num_users(num_users),
     _num_servers(num_servers) {}
 
-  void MessageHistory::AddUserMessage(uint phase, uint slot, uint member, const QByteArray &message)
+  void MessageHistory::AddPhase(uint phase, const QVector<uint> &slot_offsets,
+      const QVector<QByteArray> &user_messages,
+      const QVector<QByteArray> &server_messages)
   {
-    if(_user_data[slot][phase].isEmpty()) {
-      _user_data[slot][phase].resize(_num_users);
-    }
+    Q_ASSERT(static_cast<uint>(user_messages.count()) == _num_users);
+    Q_ASSERT(static_cast<uint>(server_messages.count()) == _num_servers);
 
-    //qDebug() << "User message phase" << phase << "slot" << slot << "user" << member;
-    _user_data[slot][phase][member] = message;
+    phase_data &data = _phases[phase];
+    data.slot_offsets = slot_offsets;
+    data.retained_slots = QBitArray(slot_offsets.count(), true);
+    data.user_messages = user_messages;
+    data.server_messages = server_messages;
   }
 
-  void MessageHistory::AddServerMessage(uint phase, uint slot, uint member, const QByteArray &message) {
-    if(_server_data[slot][phase].isEmpty()) {
-      _server_data[slot][phase].resize(_num_servers);
+  bool MessageHistory::HasEvidence(uint slot, const Accusation &acc) const
+  {
+    const phase_data *data = FindPhaseData(slot, acc);
+    if(!data) {
+      return false;
+    }
+
+    const uint byte_idx = data->slot_offsets[slot] + acc.GetByteIndex();
+    if(slot + 1 < static_cast<uint>(data->slot_offsets.count()) &&
+        byte_idx >= data->slot_offsets[slot + 1])
+    {
+      return false;
     }
 
-    //qDebug() << "Server message phase" << phase << "slot" << slot << "server" << member;
-    _server_data[slot][phase][member] = message;
+    foreach(const QByteArray &msg, data->user_messages) {
+      if(byte_idx >= static_cast<uint>(msg.count())) {
+        return false;
+      }
+    }
+
+    foreach(const QByteArray &msg, data->server_messages) {
+      if(byte_idx >= static_cast<uint>(msg.count())) {
+        return false;
+      }
+    }
+    return true;
   }
 
   bool MessageHistory::GetUserOutputBit(uint slot, uint user_idx, const Accusation &acc) const
   {
-    return (_user_data[slot][acc.GetPhase()][user_idx][acc.GetByteIndex()] & (1 << acc.GetBitIndex()));
+    const phase_data &data = GetPhaseData(slot, acc);
+    return GetOutputBit(data, data.user_messages[user_idx], slot, acc);
   }
 
   bool MessageHistory::GetServerOutputBit(uint slot, uint server_idx, const Accusation &acc) const
   {
-    return (_server_data[slot][acc.GetPhase()][server_idx][acc.GetByteIndex()] & (1 << acc.GetBitIndex()));
+    const phase_data &data = GetPhaseData(slot, acc);
+    return GetOutputBit(data, data.server_messages[server_idx], slot, acc);
   }
 
-  void MessageHistory::NextPhase() 
+  bool MessageHistory::GetOutputBit(const phase_data &data, const QByteArray &msg,
+      uint slot, const Accusation &acc) const
   {
-    for(uint i=0; i<_num_users; i++) {
-      if(!_corrupted_slots[i]) {
-        _user_data[i].clear();
-      }
+    const uint byte_idx = data.slot_offsets[slot] + acc.GetByteIndex();
+    if(byte_idx >= static_cast<uint>(msg.count())) {
+      throw QRunTimeError(QString("Accused byte %1 is past the end of the "
+            "message").arg(byte_idx));
     }
+    return (msg[byte_idx] & (1 << acc.GetBitIndex()));
+  }
+
+  const MessageHistory::phase_data *MessageHistory::FindPhaseData(uint slot,
+      const Accusation &acc) const
+  {
+    QHash<uint, phase_data>::const_iterator i = _phases.constFind(acc.GetPhase());
+    if(i == _phases.constEnd() ||
+        slot >= static_cast<uint>(i.value().retained_slots.size()) ||
+        !i.value().retained_slots.testBit(slot))
+    {
+      return 0;
+    }
+    return &i.value();
+  }
+
+  const MessageHistory::phase_data &MessageHistory::GetPhaseData(uint slot,
+      const Accusation &acc) const
+  {
+    const phase_data *data = FindPhaseData(slot, acc);
+    if(!data) {
+      throw QRunTimeError(QString("No history for slot %1 in phase %2").arg(
+            slot).arg(acc.GetPhase()));
+    }
+    return *data;
+  }
+
+  void MessageHistory::NextPhase() 
+  {
+    QHash<uint, phase_data>::iterator i = _phases.begin();
+    while(i != _phases.end()) {
+      QBitArray &retained = i.value().retained_slots;
+      retained &= _corrupted_slots;
 
-    for(uint i=0; i<_num_servers; i++) {
-      if(!_corrupted_slots[i]) {
-        _server_data[i].clear();
+      if(retained.count(true)) {
+        ++i;
+      } else {
+        i = _phases.erase(i);
       }
     }
   }
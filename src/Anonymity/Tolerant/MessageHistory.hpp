@@ -16,6 +16,12 @@ namespace Tolerant {
    * MessageHistory holds a record of data messages received
    * by a node. The history clears messages that are no longer
    * needed at the start of every phase.
+   *
+   * Rather than copying each slot out of every member's message,
+   * the history keeps (implicitly shared) references to the complete
+   * messages of a phase together with the offset of each slot. The
+   * bits needed as blame evidence are looked up only when an accusation
+   * is actually processed.
    */
   class MessageHistory {
 
@@ -29,26 +35,30 @@ namespace Tolerant {
       MessageHistory(uint num_users, uint num_servers);
 
       /**
-       * Add a user's message to the history
-       * @param phase in which the message was sent
-       * @param slot in which the message was sent
-       * @param index of the member who sent the message
-       * @param message bytes
+       * Add the messages received in a phase to the history. The messages
+       * are not copied.
+       * @param phase in which the messages were sent
+       * @param byte offset of each slot within a message
+       * @param user messages indexed by user
+       * @param server messages indexed by server
        */
-      void AddUserMessage(uint phase, uint slot, uint member, const QByteArray &message);
+      void AddPhase(uint phase, const QVector<uint> &slot_offsets,
+          const QVector<QByteArray> &user_messages,
+          const QVector<QByteArray> &server_messages);
 
       /**
-       * Add a servers's message to the history
-       * @param phase in which the message was sent
-       * @param slot in which the message was sent
-       * @param index of the member who sent the message
-       * @param message bytes
+       * Returns true if the messages an accusation points at are still
+       * retained and the accused bit lies within the slot in each of them.
+       * An accusation failing this cannot be investigated, so its maker is
+       * faulty.
+       * @param slot the accused slot
+       * @param accusation describing the location of the corrupted bit
        */
-      void AddServerMessage(uint phase, uint slot, uint member, const QByteArray &message);
+      bool HasEvidence(uint slot, const Accusation &acc) const;
 
       /**
        * Get the bit that a user sent in the position defined
-       * by an accusation
+       * by an accusation, throws a QRunTimeError if HasEvidence is false
        * @param slot for which to get the bit
        * @param index of the user whose bit should be returned
        * @param accusation describing the location of the corrupted bit
@@ -57,7 +67,7 @@ namespace Tolerant {
 
       /**
        * Get the bit that a server sent in the position defined
-       * by an accusation
+       * by an accusation, throws a QRunTimeError if HasEvidence is false
        * @param slot for which to get the bit
        * @param index of the user whose bit should be returned
        * @param accusation describing the location of the corrupted bit
@@ -84,19 +94,60 @@ namespace Tolerant {
        */
       void MarkSlotBlameFinished(uint slot);
 
+      /**
+       * Returns the number of phases for which messages are retained
+       */
+      inline int RetainedPhaseCount() const { return _phases.count(); }
+
     private:
 
+      /**
+       * Messages received in a single phase
+       */
+      struct phase_data {
+        /**
+         * Byte offset of each slot within a message
+         */
+        QVector<uint> slot_offsets;
+
+        /**
+         * Slots for which this phase is still kept as evidence
+         */
+        QBitArray retained_slots;
+
+        QVector<QByteArray> user_messages;
+        QVector<QByteArray> server_messages;
+      };
+
+      /**
+       * Returns the bit at the position described by the accusation
+       * within the slot of a message
+       */
+      bool GetOutputBit(const phase_data &data, const QByteArray &msg,
+          uint slot, const Accusation &acc) const;
+
+      /**
+       * Returns the messages of the phase described by the accusation, or 0
+       * if they are no longer retained for the slot
+       */
+      const phase_data *FindPhaseData(uint slot, const Accusation &acc) const;
+
+      /**
+       * Returns the messages of the phase described by the accusation,
+       * throws a QRunTimeError if they are no longer retained for the slot
+       */
+      const phase_data &GetPhaseData(uint slot, const Accusation &acc) const;
+
       /**
        * A bitmask describing which slots are corrupted
        */
       QBitArray _corrupted_slots;
 
       /**
-       * Data structures holding the messages
-       * _data[slot][phase][member] => message
+       * Data structure holding the messages
+       * _phases[phase] => messages
        */
-      QVector<QHash<uint,QVector<QByteArray> > > _user_data;
-      QVector<QHash<uint,QVector<QByteArray> > > _server_data;
+      QHash<uint, phase_data> _phases;
 
       /**
        * The number of users and servers
@@ -6,10 +6,14 @@
 #include "Crypto/Hash.hpp"
 #include "Crypto/Library.hpp"
 #include "Crypto/Serialization.hpp"
+#include "Crypto/SharedSecretCache.hpp"
 #include "Messaging/RpcRequest.hpp"
+#include "Utils/BufferedRandom.hpp"
+#include "Utils/Logging.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/Serialization.hpp"
+#include "Utils/Timer.hpp"
 
 #include "TolerantBulkRound.hpp"
 #include "BlameMatrix.hpp"
@@ -18,20 +22,29 @@ using Dissent::Connections::Connection;
 using Dissent::Crypto::CryptoFactory;
 using Dissent::Crypto::DiffieHellman;
 using Dissent::Crypto::Library;
+using Dissent::Crypto::SharedSecretCache;
 using Dissent::Messaging::RpcRequest;
+using Dissent::Utils::BufferedRandom;
 using Dissent::Utils::QRunTimeError;
 using Dissent::Utils::Random;
 using Dissent::Utils::Serialization;
+using Dissent::Utils::Timer;
+using Dissent::Utils::TimerCallback;
+using Dissent::Utils::TimerMethod;
 
 namespace Dissent {
 namespace Anonymity {
 namespace Tolerant {
+  int TolerantBulkRound::DefaultPhaseDeadline = 0;
+
   TolerantBulkRound::TolerantBulkRound(const Group &group,
       const Credentials &creds, const Id &round_id, QSharedPointer<Network> network,
       GetDataCallback &get_data, CreateRound create_shuffle) :
     Round(group, creds, round_id, network, get_data),
     _is_server(GetGroup().GetSubgroup().Contains(GetLocalId())),
     _stop_next(false),
+    _phase_deadline(DefaultPhaseDeadline),
+    _arrival_latency(GetGroup().Count()),
     _waiting_for_blame(false),
     _secrets_with_servers(GetGroup().GetSubgroup().Count()),
     _rngs_with_servers(GetGroup().GetSubgroup().Count()),
@@ -58,14 +71,19 @@ namespace Tolerant {
     headers["round"] = Header_Bulk;
     GetNetwork()->SetHeaders(headers);
 
-    // Get shared secrets with servers
+    // Get shared secrets with servers, the long-term secrets are cached
+    // across rounds and a per-round seed is derived from each
+    SharedSecretCache &secrets = SharedSecretCache::GetInstance();
     const Group servers = GetGroup().GetSubgroup();
     for(int server_idx=0; server_idx<servers.Count(); server_idx++) {
       QByteArray server_pk = servers.GetPublicDiffieHellman(server_idx);
-      QByteArray secret = creds.GetDhKey()->GetSharedSecret(server_pk);
+      QByteArray secret = SharedSecretCache::DeriveSeed(
+          secrets.GetSharedSecret(*creds.GetDhKey(), server_pk),
+          GetRoundId().GetByteArray());
 
       _secrets_with_servers[server_idx] = secret;
-      _rngs_with_servers[server_idx] = QSharedPointer<Random>(_crypto_lib->GetRandomNumberGenerator(secret));
+      _rngs_with_servers[server_idx] = QSharedPointer<Random>(
+          new BufferedRandom(_crypto_lib->GetRandomNumberGenerator(secret)));
     }
 
     // Set up shared secrets
@@ -78,10 +96,13 @@ namespace Tolerant {
       const Group users = GetGroup();
       for(int user_idx=0; user_idx<users.Count(); user_idx++) {
         QByteArray user_pk = users.GetPublicDiffieHellman(user_idx);
-        QByteArray secret = creds.GetDhKey()->GetSharedSecret(user_pk);
+        QByteArray secret = SharedSecretCache::DeriveSeed(
+            secrets.GetSharedSecret(*creds.GetDhKey(), user_pk),
+            GetRoundId().GetByteArray());
 
         _secrets_with_users[user_idx] = secret;
-        _rngs_with_users[user_idx] = QSharedPointer<Random>(_crypto_lib->GetRandomNumberGenerator(secret));
+        _rngs_with_users[user_idx] = QSharedPointer<Random>(
+            new BufferedRandom(_crypto_lib->GetRandomNumberGenerator(secret)));
       }
     }
 
@@ -154,7 +175,11 @@ namespace Tolerant {
     int round = notification.GetMessage()["round"].toInt();
     switch(round) {
       case Header_Bulk:
-        ProcessData(notification.GetMessage()["data"].toByteArray(), id);
+        {
+          QByteArray data = notification.GetMessage()["data"].toByteArray();
+          RecordReceive(data);
+          ProcessData(data, id);
+        }
         break;
       case Header_SigningKeyShuffle:
         qDebug() << "Signing key msg";
@@ -184,13 +209,34 @@ namespace Tolerant {
     }
   }
 
+  void TolerantBulkRound::ProcessEarlyArrivals()
+  {
+    foreach(const EarlyArrivalQueue::Entry &entry, _early_arrivals.TakeAll()) {
+      _log.Append(entry.data, entry.from);
+      try {
+        ProcessPayload(entry.data, entry.GetPayload(), entry.from);
+      } catch (QRunTimeError &err) {
+        qWarning() << _user_idx << GetLocalId().ToString() <<
+          "received a message from" << GetGroup().GetIndex(entry.from) << entry.from.ToString() <<
+          "in session / round" << GetRoundId().ToString() << "in state" <<
+          StateToString(_state) << "causing the following exception: " << err.What();
+        _log.Pop();
+      }
+    }
+  }
+
   void TolerantBulkRound::ProcessDataBase(const QByteArray &data, const Id &from)
   {
     QByteArray payload;
     if(!Verify(data, payload, from)) {
       throw QRunTimeError("Invalid signature or data");
     }
+    ProcessPayload(data, payload, from);
+  }
 
+  void TolerantBulkRound::ProcessPayload(const QByteArray &data, const QByteArray &payload,
+      const Id &from)
+  {
     if(_state == State_Offline) {
       throw QRunTimeError("Should never receive a message in the bulk"
           " round while offline.");
@@ -211,18 +257,22 @@ namespace Tolerant {
           GetRoundId().ToString());
     }
 
-    // Cache messages for future states in the offline log
+    // Hold verified messages for future states in the early arrival queue
     if(!ReadyForMessage(msg_type)) {
+      if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+        throw QRunTimeError("Dropped an early message");
+      }
       _log.Pop();
-      _offline_log.Append(data, from);
       return;
     }
 
     /*
     if(_phase != phase) {
       if(_phase == phase - 1 && (_state == State_DataSharing)) {
+        if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+          throw QRunTimeError("Dropped an early message");
+        }
         _log.Pop();
-        _offline_log.Append(data, from);
         return;
       } else {
         throw QRunTimeError("Received a message for phase: " + 
@@ -298,6 +348,15 @@ namespace Tolerant {
     qDebug() << "-- NEXT PHASE :" << _phase;
     qDebug() << "--";
 
+    _arrival_latency.StartPhase();
+    _phase_deadline_event.Stop();
+    if(_phase_deadline > 0 && GetGroup().GetLeader() == GetLocalId()) {
+      TimerCallback *cb = new TimerMethod<TolerantBulkRound, uint>(this,
+          &TolerantBulkRound::PhaseDeadline, _phase);
+      _phase_deadline_event = Timer::GetInstance().QueueCallback(cb,
+          _phase_deadline);
+    }
+
     // Get the next data packet
     QByteArray user_xor_msg = GenerateUserXorMessage();
     QDataStream user_data_stream(&_user_next_packet, QIODevice::WriteOnly);
@@ -323,11 +382,13 @@ namespace Tolerant {
       server_commit_stream << MessageType_ServerCommitData << GetRoundId() << _phase << server_digest;
       VerifiableBroadcast(server_commit_packet);
     }
+
+    PrefetchPads();
   }
 
   void TolerantBulkRound::HandleUserCommitData(QDataStream &stream, const Id &from)
   {
-    qDebug() << _user_idx << GetLocalId().ToString() <<
+    DISSENT_DEBUG("round.bulk") << _user_idx << GetLocalId().ToString() <<
       ": received user commit data from " << GetGroup().GetIndex(from) << from.ToString();
 
     if(_state != State_CommitSharing) {
@@ -360,7 +421,7 @@ namespace Tolerant {
 
   void TolerantBulkRound::HandleServerCommitData(QDataStream &stream, const Id &from)
   {
-    qDebug() << _user_idx << GetLocalId().ToString() <<
+    DISSENT_DEBUG("round.bulk") << _user_idx << GetLocalId().ToString() <<
       ": received server commit data from " << GetGroup().GetIndex(from) << from.ToString();
 
     if(_state != State_CommitSharing) {
@@ -409,7 +470,7 @@ namespace Tolerant {
 
   void TolerantBulkRound::HandleUserBulkData(const QByteArray &packet, QDataStream &stream, const Id &from)
   {
-    qDebug() << _user_idx << GetLocalId().ToString() <<
+    DISSENT_DEBUG("round.bulk") << _user_idx << GetLocalId().ToString() <<
       ": received bulk user data from " << GetGroup().GetIndex(from) << from.ToString();
 
     if(_state != State_DataSharing) {
@@ -432,6 +493,7 @@ namespace Tolerant {
 
     _user_messages[idx] = payload;
     _user_message_digests[idx] = _hash_algo->ComputeHash(packet);
+    _arrival_latency.Arrived(idx);
 
     _received_user_messages++;
     if(HasAllDataMessages()) {
@@ -441,7 +503,7 @@ namespace Tolerant {
 
   void TolerantBulkRound::HandleServerBulkData(const QByteArray &packet, QDataStream &stream, const Id &from)
   {
-    qDebug() << _user_idx << GetLocalId().ToString() <<
+    DISSENT_DEBUG("round.bulk") << _user_idx << GetLocalId().ToString() <<
       ": received bulk server data from " << GetGroup().GetSubgroup().GetIndex(from) << from.ToString();
 
     if(_state != State_DataSharing) {
@@ -465,7 +527,7 @@ namespace Tolerant {
     _server_messages[idx] = payload;
     _server_message_digests[idx] = _hash_algo->ComputeHash(packet);
 
-    qDebug() << "Received server" << _received_server_messages; 
+    DISSENT_DEBUG("round.bulk") << "Received server" << _received_server_messages; 
 
     _received_server_messages++;
     if(HasAllDataMessages()) {
@@ -513,10 +575,10 @@ namespace Tolerant {
 
     SaveMessagesToHistory();
 
-    uint msg_idx = 0;
     for(uint slot_idx = 0; slot_idx < size; slot_idx++) {
       int length = _message_lengths[slot_idx] + _header_lengths[slot_idx];
-      QByteArray tcleartext = cleartext.mid(msg_idx, length);
+      QByteArray tcleartext = QByteArray::fromRawData(cleartext.constData() +
+          _slot_offsets[slot_idx], length);
       if(_bad_slots.contains(slot_idx)) {
         qDebug() << "Skipping bad slot" << slot_idx;
       } else { 
@@ -525,7 +587,6 @@ namespace Tolerant {
           PushData(msg, this);
         }
       }
-      msg_idx += length;
     }
   }
 
@@ -645,6 +706,7 @@ namespace Tolerant {
       Serialization::WriteInt(_phase, cleartext, 0);
       Serialization::WriteInt(_next_msg.size(), cleartext, 4);
       cleartext.append(cur_msg);
+      BytesCopied += cur_msg.size();
 
       QByteArray sig = SignMessage(cleartext);
       
@@ -702,17 +764,32 @@ namespace Tolerant {
     return user_pad;
   }
 
+  void TolerantBulkRound::PrefetchPads()
+  {
+    // Slot lengths rarely change between phases, so start on the pads for
+    // the next phase while this one is collecting messages
+    foreach(const QSharedPointer<Random> &rng, _rngs_with_servers) {
+      rng->Prefetch(_expected_bulk_size);
+    }
+
+    foreach(const QSharedPointer<Random> &rng, _rngs_with_users) {
+      rng->Prefetch(_expected_bulk_size);
+    }
+  }
+
   QByteArray TolerantBulkRound::GenerateUserXorMessage()
   {
-    QByteArray msg;
+    // Pads are xored straight into their slot of the pre-sized message
+    QByteArray msg(_expected_bulk_size, 0);
+    char *out = msg.data();
     uint size = static_cast<uint>(_slot_signing_keys.size());
 
-    _server_alibi_data.StorePhaseRngByteIndex(_rngs_with_servers[0]->BytesGenerated());
+    _user_alibi_data.StorePhaseRngByteIndex(_rngs_with_servers[0]->BytesGenerated());
 
     /* For each slot */
     for(uint idx = 0; idx < size; idx++) {
       uint length = _message_lengths[idx] + _header_lengths[idx];
-      QByteArray slot_msg(length, 0);
+      char *slot_msg = out + _slot_offsets[idx];
       //qDebug() << "=> STORE BYTES Phase" << _phase << " Slot" << idx << "Bytes=" << _rngs_with_servers[0]->BytesGenerated();
 
       /* For each server, XOR that server's pad with the empty message */
@@ -721,18 +798,17 @@ namespace Tolerant {
        
         //qDebug() << "user ciphertext for slot" << idx;
         _user_alibi_data.StoreMessage(_phase, idx, server_idx, server_pad);
-        Xor(slot_msg, slot_msg, server_pad);
+        Xor(slot_msg, slot_msg, server_pad.constData(),
+            qMin(length, static_cast<uint>(server_pad.size())));
       }
-      qDebug() << "slot" << idx;
+      DISSENT_DEBUG("round.bulk") << "slot" << idx;
 
       /* This is my slot */
       if(idx == _my_idx) {
         QByteArray my_msg = GenerateMyCleartextMessage();
-        Xor(slot_msg, slot_msg, my_msg);
+        Xor(slot_msg, slot_msg, my_msg.constData(),
+            qMin(length, static_cast<uint>(my_msg.size())));
       }
-
-      msg.append(slot_msg);
-      //qDebug() << "XOR length" << msg.count();
     }
 
     return msg;
@@ -740,7 +816,8 @@ namespace Tolerant {
 
   QByteArray TolerantBulkRound::GenerateServerXorMessage()
   {
-    QByteArray msg;
+    QByteArray msg(_expected_bulk_size, 0);
+    char *out = msg.data();
     uint size = static_cast<uint>(_slot_signing_keys.size());
 
     _server_alibi_data.StorePhaseRngByteIndex(_rngs_with_users[0]->BytesGenerated());
@@ -748,18 +825,17 @@ namespace Tolerant {
     // For each slot 
     for(uint idx = 0; idx < size; idx++) {
       const uint length = _message_lengths[idx] + _header_lengths[idx];
-      
-      QByteArray slot_msg(length, 0);
+      char *slot_msg = out + _slot_offsets[idx];
+
       // For each user, XOR that users pad with the empty message
       for(int user_idx = 0; user_idx < _rngs_with_users.count(); user_idx++) {
         QByteArray user_pad = GeneratePadWithUser(user_idx, length);
 
         _server_alibi_data.StoreMessage(_phase, idx, user_idx, user_pad);
-        Xor(slot_msg, slot_msg, user_pad);
+        Xor(slot_msg, slot_msg, user_pad.constData(),
+            qMin(length, static_cast<uint>(user_pad.size())));
       }
-      
-      msg.append(slot_msg);
-      qDebug() << "XOR length" << msg.count();
+      DISSENT_DEBUG("round.bulk") << "slot" << idx;
     }
 
     return msg;
@@ -767,20 +843,7 @@ namespace Tolerant {
 
   void TolerantBulkRound::SaveMessagesToHistory()
   {
-    uint offset = 0;
-    for(int slot = 0; slot < GetGroup().Count(); slot++) {
-      int slot_length = _message_lengths[slot] + _header_lengths[slot];
-
-      for(int user_idx=0; user_idx<_user_messages.count(); user_idx++) {
-        _message_history.AddUserMessage(_phase, slot, user_idx, _user_messages[user_idx].mid(offset, slot_length));
-      }
-
-      for(int server_idx=0; server_idx<_server_messages.count(); server_idx++) {
-        _message_history.AddServerMessage(_phase, slot, server_idx, _server_messages[server_idx].mid(offset, slot_length));
-      }
-
-      offset += slot_length;
-    }
+    _message_history.AddPhase(_phase, _slot_offsets, _user_messages, _server_messages);
   }
 
   bool TolerantBulkRound::SearchForEvidence(const QByteArray& sent_msg, const QByteArray& recvd_msg)
@@ -792,7 +855,7 @@ namespace Tolerant {
     for(int i=0; i<sent_msg.count(); i++) {
       c = sent_msg[i];
       d = recvd_msg[i];
-      qDebug() << "Sent:" << (unsigned char)c << "Got:" << (unsigned char)d << (c == d ? "" : "<===");
+      DISSENT_DEBUG("round.blame") << "Sent:" << (unsigned char)c << "Got:" << (unsigned char)d << (c == d ? "" : "<===");
     }
 
     for(int i=0; i<sent_msg.count(); i++) {
@@ -986,29 +1049,37 @@ namespace Tolerant {
 
       BlameMatrix matrix(GetGroup().Count(), GetGroup().GetSubgroup().Count());
      
-      // For each user...
-      for(uint user_idx=0; user_idx<static_cast<uint>(GetGroup().Count()); user_idx++) {
-        // Add user alibi bitmasks
-        QByteArray alibi = _user_alibis[user_idx].mid(count*user_alibi_length, user_alibi_length);
-        qDebug() << "Alibi has length" << alibi.count();
-        QBitArray bits = AlibiData::AlibiBitsFromBytes(alibi, 0, GetGroup().GetSubgroup().Count());
-        matrix.AddUserAlibi(user_idx, bits);
-
-        // Add the bit that the user actually sent in the corrupted slot
-        bool user_bit = _message_history.GetUserOutputBit(slot_idx, user_idx, i.value());
-        matrix.AddUserOutputBit(user_idx, user_bit);
-      }
-  
-      // For each server...
-      for(uint server_idx=0; server_idx<static_cast<uint>(GetGroup().GetSubgroup().Count()); server_idx++) {
-        // Add server alibi bitmasks
-        QByteArray alibi = _server_alibis[server_idx].mid(count*server_alibi_length, server_alibi_length);
-        QBitArray bits = AlibiData::AlibiBitsFromBytes(alibi, 0, members);
-        matrix.AddServerAlibi(server_idx, bits);
-
-        // Add the bit that the server actually sent in the corrupted slot
-        bool server_bit = _message_history.GetServerOutputBit(slot_idx, server_idx, i.value());
-        matrix.AddServerOutputBit(server_idx, server_bit);
+      try {
+        // For each user...
+        for(uint user_idx=0; user_idx<static_cast<uint>(GetGroup().Count()); user_idx++) {
+          // Add user alibi bitmasks
+          QByteArray alibi = _user_alibis[user_idx].mid(count*user_alibi_length, user_alibi_length);
+          qDebug() << "Alibi has length" << alibi.count();
+          QBitArray bits = AlibiData::AlibiBitsFromBytes(alibi, 0, GetGroup().GetSubgroup().Count());
+          matrix.AddUserAlibi(user_idx, bits);
+
+          // Add the bit that the user actually sent in the corrupted slot
+          bool user_bit = _message_history.GetUserOutputBit(slot_idx, user_idx, i.value());
+          matrix.AddUserOutputBit(user_idx, user_bit);
+        }
+    
+        // For each server...
+        for(uint server_idx=0; server_idx<static_cast<uint>(GetGroup().GetSubgroup().Count()); server_idx++) {
+          // Add server alibi bitmasks
+          QByteArray alibi = _server_alibis[server_idx].mid(count*server_alibi_length, server_alibi_length);
+          QBitArray bits = AlibiData::AlibiBitsFromBytes(alibi, 0, members);
+          matrix.AddServerAlibi(server_idx, bits);
+
+          // Add the bit that the server actually sent in the corrupted slot
+          bool server_bit = _message_history.GetServerOutputBit(slot_idx, server_idx, i.value());
+          matrix.AddServerOutputBit(server_idx, server_bit);
+        }
+      } catch (QRunTimeError &err) {
+        qWarning() << "Blaming the owner of slot" << slot_idx <<
+          "for an accusation without evidence:" << err.What();
+        FoundBadSlot(slot_idx);
+        count++;
+        continue;
       }
 
       QVector<int> bad_users = matrix.GetBadUsers();
@@ -1181,6 +1252,22 @@ namespace Tolerant {
     const int old_bad_members = _bad_members.count();
 
     qDebug() << "Starting proof analysis. Conflicts:" << _conflicts.count();
+
+    // Check every proof at once, proofs 2i and 2i+1 are conflict i's user
+    // and server proofs
+    QVector<QByteArray> prover_pubs, remote_pubs, proofs;
+    for(int i=0; i<_conflicts.count(); i++) {
+      QByteArray user_pub_key = GetGroup().GetPublicDiffieHellman(_conflicts[i].GetUserIndex());
+      QByteArray server_pub_key = GetGroup().GetPublicDiffieHellman(_conflicts[i].GetServerIndex());
+
+      prover_pubs << user_pub_key << server_pub_key;
+      remote_pubs << server_pub_key << user_pub_key;
+      proofs << _user_proofs[i] << _server_proofs[i];
+    }
+
+    QVector<QByteArray> secrets = GetCredentials().GetDhKey()->VerifySharedSecrets(
+        prover_pubs, remote_pubs, proofs);
+
     for(int i=0; i<_conflicts.count(); i++) {
 
       uint slot_idx = _conflicts[i].GetSlotIndex();
@@ -1194,23 +1281,18 @@ namespace Tolerant {
         return;
       }
 
-      QByteArray user_pub_key = GetGroup().GetPublicDiffieHellman(user_idx);
-      QByteArray server_pub_key = GetGroup().GetPublicDiffieHellman(server_idx);
+      qDebug() << "Proof:" << _user_proofs[i].toHex().constData();
+      qDebug() << "Pub key:" << prover_pubs[2 * i].toHex().constData();
+      qDebug() << "Server key:" << remote_pubs[2 * i].toHex().constData();
 
-      QByteArray user_proof = _user_proofs[i];
-      qDebug() << "Proof:" << user_proof.toHex().constData();
-      qDebug() << "Pub key:" << user_pub_key.toHex().constData();
-      qDebug() << "Server key:" << server_pub_key.toHex().constData();
-
-      QByteArray user_valid = GetCredentials().GetDhKey()->VerifySharedSecret(user_pub_key, server_pub_key, user_proof);
+      const QByteArray &user_valid = secrets[2 * i];
       if(!user_valid.count()) {
         qWarning() << "User" << user_idx << "send bad proof";
         AddBadMember(user_idx);
         FoundBadMembers();
       }
 
-      QByteArray server_proof = _server_proofs[i];
-      QByteArray server_valid = GetCredentials().GetDhKey()->VerifySharedSecret(server_pub_key, user_pub_key, server_proof);
+      const QByteArray &server_valid = secrets[2 * i + 1];
       if(!server_valid.count()) {
         qWarning() << "Server" << server_idx << "send bad proof";
         AddBadMember(server_idx);
@@ -1229,7 +1311,9 @@ namespace Tolerant {
 
       // Check which bit was generated correctly
       qDebug() << "ACC" << _acc_data[slot_idx].ToString();
-      const bool expected_bit = GetExpectedBit(slot_idx, _acc_data[slot_idx], user_valid);
+      QByteArray seed = SharedSecretCache::DeriveSeed(user_valid,
+          GetRoundId().GetByteArray());
+      const bool expected_bit = GetExpectedBit(slot_idx, _acc_data[slot_idx], seed);
       const bool user_bit = _conflicts[i].GetUserBit();
       const bool server_bit = _conflicts[i].GetServerBit();
 
@@ -1341,8 +1425,10 @@ namespace Tolerant {
     _server_message_digests.resize(GetGroup().GetSubgroup().Count());
     _received_server_messages = 0;
 
+    _slot_offsets.resize(group_size);
     _expected_bulk_size = 0;
     for(uint idx = 0; idx < group_size; idx++) {
+      _slot_offsets[idx] = _expected_bulk_size;
       _expected_bulk_size += _header_lengths[idx] + _message_lengths[idx];
     }
 
@@ -1358,6 +1444,8 @@ namespace Tolerant {
 
   void TolerantBulkRound::FinishPhase() 
   {
+    _phase_deadline_event.Stop();
+
     if(_state == State_DataSharing && _waiting_for_blame) {
       qWarning("Entering blame shuffle");
       ChangeState(State_BlameShuffling);
@@ -1389,6 +1477,40 @@ namespace Tolerant {
     SendCommits();
   }
 
+  void TolerantBulkRound::PhaseDeadline(const uint &phase)
+  {
+    if(Stopped() || phase != _phase) {
+      return;
+    }
+
+    bool commits = (_state == State_CommitSharing);
+    if(!commits && _state != State_DataSharing) {
+      return;
+    }
+
+    const QVector<QByteArray> &users = commits ? _user_commits : _user_messages;
+    for(int idx = 0; idx < users.count(); idx++) {
+      if(users[idx].isEmpty()) {
+        AddBadMember(idx);
+      }
+    }
+
+    const Group &servers = GetGroup().GetSubgroup();
+    const QVector<QByteArray> &server_data = commits ? _server_commits : _server_messages;
+    for(int idx = 0; idx < server_data.count(); idx++) {
+      if(server_data[idx].isEmpty()) {
+        AddBadMember(GetGroup().GetIndex(servers.GetId(idx)));
+      }
+    }
+
+    qWarning() << "In" << ToString() << "phase deadline exceeded, waiting on" <<
+      GetBadMembers();
+
+    ChangeState(State_Finished);
+    SetInterrupted();
+    Stop("Phase deadline exceeded");
+  }
+
   void TolerantBulkRound::AddBadMember(int member_idx) {
     if(!_bad_members.contains(member_idx)) {
       _bad_members.append(member_idx);
@@ -1479,7 +1601,15 @@ namespace Tolerant {
 
       if(verified) {
         Accusation acc;
-        if(acc.FromByteArray(acc_bytes)) {
+        if(!acc.FromByteArray(acc_bytes)) {
+          qWarning() << "Ignoring invalid accusation of length" << acc_bytes.size() << 
+              "from owner of slot" << acc_owner;
+        } else if(!_message_history.HasEvidence(acc_owner, acc)) {
+          // The accuser points at messages no one can produce as evidence
+          qWarning() << "Blaming the owner of slot" << acc_owner <<
+            "for an accusation without evidence:" << acc.ToString();
+          FoundBadSlot(acc_owner);
+        } else {
           qDebug() << "Got accusation from slot owner" << acc_owner << ":" << acc.ToString();
 
           _message_history.MarkSlotBlameFinished(acc_owner);
@@ -1489,9 +1619,6 @@ namespace Tolerant {
           }
 
           _acc_data.insert(acc_owner, acc);
-        } else {
-          qWarning() << "Ignoring invalid accusation of length" << acc_bytes.size() << 
-              "from owner of slot" << acc_owner;
         }
       } else {
         qWarning("Ignoring accusation with bad signature");
@@ -1524,13 +1651,8 @@ namespace Tolerant {
   void TolerantBulkRound::ChangeState(State new_state) 
   {
     _state = new_state;
-    uint count = static_cast<uint>(_offline_log.Count());
-    for(uint idx = 0; idx < count; idx++) {
-      QPair<QByteArray, Id> entry = _offline_log.At(idx);
-      ProcessData(entry.first, entry.second);
-    }
-
-    _offline_log.Clear();
+    RecordState(StateToString(new_state));
+    ProcessEarlyArrivals();
   }
 
   void TolerantBulkRound::CreateBlameShuffle() 
@@ -4,6 +4,8 @@
 #include <QMetaEnum>
 #include <QSharedPointer>
 
+#include "Anonymity/ArrivalLatency.hpp"
+#include "Anonymity/EarlyArrivalQueue.hpp"
 #include "Anonymity/Log.hpp"
 #include "Anonymity/MessageRandomizer.hpp"
 #include "Anonymity/Round.hpp"
@@ -12,6 +14,7 @@
 #include "Messaging/RpcRequest.hpp"
 #include "Utils/Triple.hpp"
 #include "Utils/Random.hpp"
+#include "Utils/TimerEvent.hpp"
 
 #include "Accusation.hpp"
 #include "AlibiData.hpp"
@@ -140,7 +143,31 @@ namespace Tolerant {
       /**
        * Destructor
        */
-      virtual ~TolerantBulkRound() {}
+      virtual ~TolerantBulkRound() { _phase_deadline_event.Stop(); }
+
+      /**
+       * Time in ms the leader waits for all commits and bulk messages of a
+       * phase before stopping the round and reporting the missing members
+       * as bad, 0 disables the deadline.  Used to initialize new rounds.
+       */
+      static int DefaultPhaseDeadline;
+
+      /**
+       * Sets the phase deadline in ms, 0 disables it, takes effect at the
+       * start of the next phase
+       */
+      inline void SetPhaseDeadline(int msecs) { _phase_deadline = msecs; }
+
+      /**
+       * Returns the phase deadline in ms, 0 if disabled
+       */
+      inline int GetPhaseDeadline() const { return _phase_deadline; }
+
+      /**
+       * Returns the per-member user bulk message arrival latencies observed
+       * locally, relative to the start of each phase
+       */
+      inline const ArrivalLatency &GetArrivalLatency() const { return _arrival_latency; }
 
       /**
        * Start the bulk round
@@ -221,6 +248,22 @@ namespace Tolerant {
        */
       void ProcessDataBase(const QByteArray &data, const Id &from);
 
+      /**
+       * Processes a message whose signature has already been verified,
+       * throws exceptions for invalid data packets
+       * @param data Incoming data
+       * @param payload data without its signature
+       * @param from sending peer
+       */
+      void ProcessPayload(const QByteArray &data, const QByteArray &payload,
+          const Id &from);
+
+      /**
+       * Processes the messages held in the early arrival queue, those still
+       * early are queued again
+       */
+      void ProcessEarlyArrivals();
+
 
       /*******************************************
        * Anonymous Signing Key Shuffle Methods
@@ -337,6 +380,12 @@ namespace Tolerant {
        */
       virtual QByteArray GeneratePadWithUser(uint user_idx, uint length);
 
+      /**
+       * Starts generating the pads for the next phase, assuming that the
+       * slot lengths remain the same
+       */
+      void PrefetchPads();
+
       /**
        * Generates the user's entire xor message 
        */
@@ -348,7 +397,8 @@ namespace Tolerant {
       virtual QByteArray GenerateServerXorMessage();
 
       /**
-       * Copy all received messages to the message history data structure
+       * Record all received messages in the message history data structure.
+       * The messages are shared with the history rather than copied.
        */
       void SaveMessagesToHistory();
 
@@ -553,6 +603,15 @@ namespace Tolerant {
        */
       bool ReadyForMessage(MessageType mtype);
 
+      /**
+       * Called by the leader when a phase has exceeded its deadline, stops
+       * the round reporting the members whose commits or bulk messages are
+       * missing as bad, so that the session excludes them from the next
+       * round
+       * @param phase the phase the deadline was set for
+       */
+      void PhaseDeadline(const uint &phase);
+
       /** 
        * Whether or not node holds these special roles
        */
@@ -564,6 +623,21 @@ namespace Tolerant {
        */
       bool _stop_next;
 
+      /**
+       * Phase deadline in ms, 0 if disabled
+       */
+      int _phase_deadline;
+
+      /**
+       * Fires when the current phase exceeds its deadline
+       */
+      Dissent::Utils::TimerEvent _phase_deadline_event;
+
+      /**
+       * Per-member user bulk message arrival latencies
+       */
+      ArrivalLatency _arrival_latency;
+
       /**
        * Whether or not the node is waiting to enter a blame 
        * shuffle
@@ -571,13 +645,13 @@ namespace Tolerant {
       bool _waiting_for_blame;
 
       /**
-       * Secrets and RNGs that a user shares with servers
+       * Per-round seeds and RNGs that a user shares with servers
        */
       QVector<QByteArray> _secrets_with_servers;
       QVector<QSharedPointer<Random> > _rngs_with_servers;
 
       /**
-       * Secrets and RNGs that a server shares with users 
+       * Per-round seeds and RNGs that a server shares with users
        */
       QVector<QByteArray> _secrets_with_users;
       QVector<QSharedPointer<Random> > _rngs_with_users;
@@ -603,9 +677,10 @@ namespace Tolerant {
       State _state;
 
       /**
-       * Stores all validated messages that arrived before start was called
+       * Stores verified messages that arrived before the round was ready
+       * for them
        */
-      Log _offline_log;
+      EarlyArrivalQueue _early_arrivals;
 
       /**
        * Stores all validated incoming messages
@@ -657,6 +732,12 @@ namespace Tolerant {
        */
       uint _expected_bulk_size;
 
+      /**
+       * Offset of each slot within the bulk message, computed with
+       * _expected_bulk_size at the start of each phase
+       */
+      QVector<uint> _slot_offsets;
+
       /**
        * Fixed sized footer / header lengths
        */
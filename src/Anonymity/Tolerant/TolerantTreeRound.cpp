@@ -6,7 +6,9 @@
 #include "Crypto/Hash.hpp"
 #include "Crypto/Library.hpp"
 #include "Crypto/Serialization.hpp"
+#include "Crypto/SharedSecretCache.hpp"
 #include "Messaging/RpcRequest.hpp"
+#include "Utils/BufferedRandom.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/Serialization.hpp"
@@ -17,7 +19,9 @@ using Dissent::Connections::Connection;
 using Dissent::Crypto::CryptoFactory;
 using Dissent::Crypto::DiffieHellman;
 using Dissent::Crypto::Library;
+using Dissent::Crypto::SharedSecretCache;
 using Dissent::Messaging::RpcRequest;
+using Dissent::Utils::BufferedRandom;
 using Dissent::Utils::QRunTimeError;
 using Dissent::Utils::Random;
 using Dissent::Utils::Serialization;
@@ -27,7 +31,7 @@ namespace Anonymity {
 namespace Tolerant {
   TolerantTreeRound::TolerantTreeRound(const Group &group,
       const Credentials &creds, const Id &round_id, QSharedPointer<Network> network,
-      GetDataCallback &get_data, CreateRound create_shuffle) :
+      GetDataCallback &get_data, CreateRound create_shuffle, uint fanout) :
     Round(group, creds, round_id, network, get_data),
     _is_leader((GetGroup().GetLeader() == GetLocalId())),
     _is_server(GetGroup().GetSubgroup().Contains(GetLocalId())),
@@ -45,6 +49,7 @@ namespace Tolerant {
     _server_messages(GetGroup().GetSubgroup().Count()),
     _user_message_digests(GetGroup().Count()),
     _server_message_digests(GetGroup().GetSubgroup().Count()),
+    _fanout(fanout ? fanout : DefaultFanout),
     _message_randomizer(creds.GetDhKey()->GetPrivateComponent()),
     _user_idx(GetGroup().GetIndex(GetLocalId()))
   {
@@ -55,14 +60,19 @@ namespace Tolerant {
     headers["round"] = Header_Bulk;
     GetNetwork()->SetHeaders(headers);
 
-    // Get shared secrets with servers
+    // Get shared secrets with servers, the long-term secrets are cached
+    // across rounds and a per-round seed is derived from each
+    SharedSecretCache &secrets = SharedSecretCache::GetInstance();
     const Group servers = GetGroup().GetSubgroup();
     for(int server_idx=0; server_idx<servers.Count(); server_idx++) {
       QByteArray server_pk = servers.GetPublicDiffieHellman(server_idx);
-      QByteArray secret = creds.GetDhKey()->GetSharedSecret(server_pk);
+      QByteArray secret = SharedSecretCache::DeriveSeed(
+          secrets.GetSharedSecret(*creds.GetDhKey(), server_pk),
+          GetRoundId().GetByteArray());
 
       _secrets_with_servers[server_idx] = secret;
-      _rngs_with_servers[server_idx] = QSharedPointer<Random>(_crypto_lib->GetRandomNumberGenerator(secret));
+      _rngs_with_servers[server_idx] = QSharedPointer<Random>(
+          new BufferedRandom(_crypto_lib->GetRandomNumberGenerator(secret)));
     }
 
     // Set up shared secrets
@@ -75,10 +85,44 @@ namespace Tolerant {
       const Group users = GetGroup();
       for(int user_idx=0; user_idx<users.Count(); user_idx++) {
         QByteArray user_pk = users.GetPublicDiffieHellman(user_idx);
-        QByteArray secret = creds.GetDhKey()->GetSharedSecret(user_pk);
+        QByteArray secret = SharedSecretCache::DeriveSeed(
+            secrets.GetSharedSecret(*creds.GetDhKey(), user_pk),
+            GetRoundId().GetByteArray());
 
         _secrets_with_users[user_idx] = secret;
-        _rngs_with_users[user_idx] = QSharedPointer<Random>(_crypto_lib->GetRandomNumberGenerator(secret));
+        _rngs_with_users[user_idx] = QSharedPointer<Random>(
+            new BufferedRandom(_crypto_lib->GetRandomNumberGenerator(secret)));
+      }
+    }
+
+    // Set up the aggregation tree, leader at the root followed by the servers
+    if(fanout == 0) {
+      qWarning() << "Aggregation tree fanout must be positive, using" <<
+        DefaultFanout;
+    }
+
+    _tree.append(GetGroup().GetLeader());
+    foreach(const GroupContainer &gc, GetGroup().GetSubgroup().GetRoster()) {
+      if(gc.first != GetGroup().GetLeader()) {
+        _tree.append(gc.first);
+      }
+    }
+
+    _tree_idx = _tree.indexOf(GetLocalId());
+    _expected_user_messages = 0;
+    _expected_partials = 0;
+    if(IsAggregator()) {
+      for(int user_idx = 0; user_idx < GetGroup().Count(); user_idx++) {
+        if(GetAggregatorIndex(user_idx) == _tree_idx) {
+          _expected_user_messages++;
+        }
+      }
+
+      const uint first_child = _tree_idx * _fanout + 1;
+      for(uint child = first_child; child < first_child + _fanout; child++) {
+        if(child < static_cast<uint>(_tree.count())) {
+          _expected_partials++;
+        }
       }
     }
 
@@ -113,7 +157,7 @@ namespace Tolerant {
   void TolerantTreeRound::FoundBadMembers() 
   {
     SetSuccessful(false);
-    _offline_log.Clear();
+    _early_arrivals.Clear();
     ChangeState(State_Finished);
     Stop("Found bad group member");
     return;
@@ -137,7 +181,11 @@ namespace Tolerant {
     int round = notification.GetMessage()["round"].toInt();
     switch(round) {
       case Header_Bulk:
-        ProcessData(notification.GetMessage()["data"].toByteArray(), id);
+        {
+          QByteArray data = notification.GetMessage()["data"].toByteArray();
+          RecordReceive(data);
+          ProcessData(data, id);
+        }
         break;
       case Header_SigningKeyShuffle:
         qDebug() << "Signing key msg";
@@ -163,13 +211,34 @@ namespace Tolerant {
     }
   }
 
+  void TolerantTreeRound::ProcessEarlyArrivals()
+  {
+    foreach(const EarlyArrivalQueue::Entry &entry, _early_arrivals.TakeAll()) {
+      _log.Append(entry.data, entry.from);
+      try {
+        ProcessPayload(entry.data, entry.GetPayload(), entry.from);
+      } catch (QRunTimeError &err) {
+        qWarning() << _user_idx << GetLocalId().ToString() <<
+          "received a message from" << GetGroup().GetIndex(entry.from) << entry.from.ToString() <<
+          "in session / round" << GetRoundId().ToString() << "in state" <<
+          StateToString(_state) << "causing the following exception: " << err.What();
+        _log.Pop();
+      }
+    }
+  }
+
   void TolerantTreeRound::ProcessDataBase(const QByteArray &data, const Id &from)
   {
     QByteArray payload;
     if(!Verify(data, payload, from)) {
       throw QRunTimeError("Invalid signature or data");
     }
+    ProcessPayload(data, payload, from);
+  }
 
+  void TolerantTreeRound::ProcessPayload(const QByteArray &data, const QByteArray &payload,
+      const Id &from)
+  {
     if(_state == State_Offline) {
       throw QRunTimeError("Should never receive a message in the bulk"
           " round while offline.");
@@ -190,10 +259,12 @@ namespace Tolerant {
           GetRoundId().ToString());
     }
 
-    // Cache messages for future states in the offline log
+    // Hold verified messages for future states in the early arrival queue
     if(!ReadyForMessage(msg_type)) {
+      if(!_early_arrivals.Push(data, payload.size(), from, phase, mtype)) {
+        throw QRunTimeError("Dropped an early message");
+      }
       _log.Pop();
-      _offline_log.Append(data, from);
       return;
     }
 
@@ -222,6 +293,9 @@ namespace Tolerant {
       case MessageType_LeaderBulkData:
         HandleLeaderBulkData(stream, from);
         break;
+      case MessageType_PartialBulkData:
+        HandlePartialBulkData(stream, from);
+        break;
       default:
         throw QRunTimeError("Unknown message type");
     }
@@ -284,6 +358,8 @@ namespace Tolerant {
       server_commit_stream << MessageType_ServerCommitData << GetRoundId() << _phase << server_digest;
       VerifiableSendToLeader(server_commit_packet);
     }
+
+    PrefetchPads();
   }
 
   void TolerantTreeRound::HandleUserCommitData(QDataStream &stream, const Id &from)
@@ -416,11 +492,12 @@ namespace Tolerant {
     // Right now we have no way to verify the leader's commit message,
     // so we just continue to the data transmission phase once we
     // get the leader's commit message
-    ChangeState(_is_leader ? State_DataSharing : State_DataReceiving);
+    ChangeState(IsAggregator() ? State_DataSharing : State_DataReceiving);
 
-    VerifiableSendToLeader(_user_next_packet);
+    VerifiableSend(_user_next_packet, _tree[GetAggregatorIndex(_user_idx)]);
     if(_is_server) {
-      VerifiableSendToLeader(_server_next_packet);
+      // Servers are part of the tree and aggregate their own messages
+      VerifiableSend(_server_next_packet, GetLocalId());
     }
 
   }
@@ -434,11 +511,15 @@ namespace Tolerant {
       throw QRunTimeError("Received a misordered UserBulkData message");
     }
 
-    if(!_is_leader) {
-      throw QRunTimeError("Non-leader received a UserBulkData message");
+    if(!IsAggregator()) {
+      throw QRunTimeError("Non-aggregator received a UserBulkData message");
     }
 
     uint idx = GetGroup().GetIndex(from);
+    if(GetAggregatorIndex(idx) != _tree_idx) {
+      throw QRunTimeError("Received a UserBulkData message for another aggregator");
+    }
+
     if(!_user_messages[idx].isEmpty()) {
       throw QRunTimeError("Already have bulk user data.");
     }
@@ -457,7 +538,7 @@ namespace Tolerant {
 
     _received_user_messages++;
     if(HasAllDataMessages()) {
-      BroadcastXorMessages();
+      FinishAggregation();
     }
   }
 
@@ -470,8 +551,8 @@ namespace Tolerant {
       throw QRunTimeError("Received a misordered ServerBulkData message");
     }
 
-    if(!_is_leader) {
-      throw QRunTimeError("Non-leader received a ServerBulkData message");
+    if(from != GetLocalId()) {
+      throw QRunTimeError("Received another server's ServerBulkData message");
     }
 
     uint idx = GetGroup().GetSubgroup().GetIndex(from);
@@ -495,14 +576,215 @@ namespace Tolerant {
 
     _received_server_messages++;
     if(HasAllDataMessages()) {
-      BroadcastXorMessages();
+      FinishAggregation();
+    }
+  }
+
+  void TolerantTreeRound::HandlePartialBulkData(QDataStream &stream, const Id &from)
+  {
+    qDebug() << _user_idx << GetLocalId().ToString() <<
+      ": received partial bulk data from " << GetGroup().GetIndex(from) << from.ToString();
+
+    if(_state != State_DataSharing) {
+      throw QRunTimeError("Received a misordered PartialBulkData message");
+    }
+
+    if(!IsAggregator()) {
+      throw QRunTimeError("Non-aggregator received a PartialBulkData message");
+    }
+
+    int child = _tree.indexOf(from);
+    if(child <= 0 || (static_cast<uint>(child) - 1) / _fanout != static_cast<uint>(_tree_idx)) {
+      throw QRunTimeError("Received a PartialBulkData message from a non-child");
+    }
+
+    if(!_partial_messages[child].isEmpty()) {
+      throw QRunTimeError("Already have partial bulk data.");
+    }
+
+    QByteArray payload;
+    QVector<QByteArray> user_digests;
+    QVector<QByteArray> server_digests;
+    QByteArray signature;
+    QHash<int, QPair<QByteArray, QByteArray> > attestations;
+    stream >> payload >> user_digests >> server_digests >> signature >> attestations;
+
+    if(static_cast<uint>(payload.size()) != _expected_bulk_size) {
+      throw QRunTimeError("Incorrect partial bulk message length, got " +
+          QString::number(payload.size()) + " expected " +
+          QString::number(_expected_bulk_size));
+    }
+
+    if(user_digests.count() != _user_message_digests.count() ||
+        server_digests.count() != _server_message_digests.count())
+    {
+      throw QRunTimeError("Incorrect number of digests in partial bulk data");
+    }
+
+    // The child signs its payload together with the digests it covers, so a
+    // payload that does not match its digests is attributable to the child
+    QByteArray statement = PartialStatement(child, payload, user_digests,
+        server_digests);
+    if(!GetGroup().GetKey(from)->Verify(statement, signature)) {
+      throw QRunTimeError("Partial bulk data signature does not cover its payload");
+    }
+
+    QHash<int, QPair<QByteArray, QByteArray> >::const_iterator it;
+    for(it = attestations.constBegin(); it != attestations.constEnd(); ++it) {
+      if(it.key() == child || !IsDescendant(it.key(), child) ||
+          _partial_attestations.contains(it.key()))
+      {
+        throw QRunTimeError("Partial bulk data forwards a foreign attestation");
+      }
+
+      CheckDescendantStatement(it.value().first, it.key(), user_digests,
+          server_digests);
+      if(!GetGroup().GetKey(_tree[it.key()])->Verify(it.value().first, it.value().second)) {
+        throw QRunTimeError("Partial bulk data forwards an invalid attestation");
+      }
+    }
+
+    // The digests of each packet must be covered by exactly one aggregator
+    for(int idx = 0; idx < user_digests.count(); idx++) {
+      if(!user_digests[idx].isEmpty() && !_user_message_digests[idx].isEmpty()) {
+        throw QRunTimeError("Partial bulk data covers a user twice");
+      }
+    }
+
+    for(int idx = 0; idx < server_digests.count(); idx++) {
+      if(!server_digests[idx].isEmpty() && !_server_message_digests[idx].isEmpty()) {
+        throw QRunTimeError("Partial bulk data covers a server twice");
+      }
+    }
+
+    for(int idx = 0; idx < user_digests.count(); idx++) {
+      if(!user_digests[idx].isEmpty()) {
+        _user_message_digests[idx] = user_digests[idx];
+      }
+    }
+
+    for(int idx = 0; idx < server_digests.count(); idx++) {
+      if(!server_digests[idx].isEmpty()) {
+        _server_message_digests[idx] = server_digests[idx];
+      }
+    }
+
+    _partial_attestations.unite(attestations);
+    _partial_attestations[child] = QPair<QByteArray, QByteArray>(statement, signature);
+
+    _partial_messages[child] = payload;
+    _received_partials++;
+    if(HasAllDataMessages()) {
+      FinishAggregation();
     }
   }
 
   bool TolerantTreeRound::HasAllDataMessages() 
   {
-    return (_received_user_messages == static_cast<uint>(GetGroup().Count()) &&
-        _received_server_messages == static_cast<uint>(GetGroup().GetSubgroup().Count()));
+    return (_received_user_messages == _expected_user_messages &&
+        _received_server_messages == (_is_server ? 1u : 0u) &&
+        _received_partials == _expected_partials);
+  }
+
+  void TolerantTreeRound::FinishAggregation()
+  {
+    if(_tree_idx != 0) {
+      SendPartialXorMessage();
+      return;
+    }
+
+    // At the root every packet should now be covered by some aggregator
+    QVector<int> bad_users;
+    QVector<int> bad_servers;
+    CheckCommits(_user_commits, _user_message_digests, bad_users);
+    CheckCommits(_server_commits, _server_message_digests, bad_servers);
+
+    if(bad_users.count() || bad_servers.count()) {
+      qWarning() << "Aggregated data does not match commits, users:" <<
+        bad_users << "servers:" << bad_servers;
+      SetSuccessful(false);
+      ChangeState(State_Finished);
+      Stop("Aggregated data does not match commits");
+      return;
+    }
+
+    BroadcastXorMessages();
+  }
+
+  void TolerantTreeRound::SendPartialXorMessage()
+  {
+    ChangeState(State_DataReceiving);
+
+    QByteArray xor_data = XorMessages();
+    QByteArray signature = GetSigningKey()->Sign(PartialStatement(_tree_idx,
+          xor_data, _user_message_digests, _server_message_digests));
+
+    QByteArray partial_data_packet;
+    QDataStream partial_data_stream(&partial_data_packet, QIODevice::WriteOnly);
+    partial_data_stream << MessageType_PartialBulkData << GetRoundId() << _phase <<
+      xor_data << _user_message_digests << _server_message_digests <<
+      signature << _partial_attestations;
+    VerifiableSend(partial_data_packet, _tree[(_tree_idx - 1) / _fanout]);
+  }
+
+  QByteArray TolerantTreeRound::PartialStatement(int tree_idx,
+      const QByteArray &payload, const QVector<QByteArray> &user_digests,
+      const QVector<QByteArray> &server_digests)
+  {
+    QByteArray statement;
+    QDataStream stream(&statement, QIODevice::WriteOnly);
+    stream << GetRoundId() << _phase << tree_idx <<
+      _hash_algo->ComputeHash(payload) << user_digests << server_digests;
+    return statement;
+  }
+
+  void TolerantTreeRound::CheckDescendantStatement(const QByteArray &statement,
+      int tree_idx, const QVector<QByteArray> &user_digests,
+      const QVector<QByteArray> &server_digests)
+  {
+    QDataStream stream(statement);
+    Id round_id;
+    uint phase;
+    int idx;
+    QByteArray payload_hash;
+    QVector<QByteArray> sub_user_digests;
+    QVector<QByteArray> sub_server_digests;
+    stream >> round_id >> phase >> idx >> payload_hash >>
+      sub_user_digests >> sub_server_digests;
+
+    if(round_id != GetRoundId() || phase != _phase || idx != tree_idx) {
+      throw QRunTimeError("Attestation does not belong to this phase");
+    }
+
+    if(sub_user_digests.count() != user_digests.count() ||
+        sub_server_digests.count() != server_digests.count())
+    {
+      throw QRunTimeError("Incorrect number of digests in attestation");
+    }
+
+    for(int jdx = 0; jdx < sub_user_digests.count(); jdx++) {
+      if(!sub_user_digests[jdx].isEmpty() && sub_user_digests[jdx] != user_digests[jdx]) {
+        throw QRunTimeError("Attestation covers an unreported user digest");
+      }
+    }
+
+    for(int jdx = 0; jdx < sub_server_digests.count(); jdx++) {
+      if(!sub_server_digests[jdx].isEmpty() && sub_server_digests[jdx] != server_digests[jdx]) {
+        throw QRunTimeError("Attestation covers an unreported server digest");
+      }
+    }
+  }
+
+  bool TolerantTreeRound::IsDescendant(int idx, int ancestor) const
+  {
+    if(idx < 0 || idx >= _tree.count()) {
+      return false;
+    }
+
+    while(idx > ancestor) {
+      idx = (idx - 1) / _fanout;
+    }
+    return idx == ancestor;
   }
 
   void TolerantTreeRound::BroadcastXorMessages() 
@@ -529,6 +811,10 @@ namespace Tolerant {
       Xor(cleartext, cleartext, _server_messages[idx]);
     }
 
+    for(int idx=0; idx<_partial_messages.count(); idx++) {
+      Xor(cleartext, cleartext, _partial_messages[idx]);
+    }
+
     return cleartext;
   }
 
@@ -655,6 +941,19 @@ namespace Tolerant {
     return user_pad;
   }
 
+  void TolerantTreeRound::PrefetchPads()
+  {
+    // Slot lengths rarely change between phases, so start on the pads for
+    // the next phase while this one is collecting messages
+    foreach(const QSharedPointer<Random> &rng, _rngs_with_servers) {
+      rng->Prefetch(_expected_bulk_size);
+    }
+
+    foreach(const QSharedPointer<Random> &rng, _rngs_with_users) {
+      rng->Prefetch(_expected_bulk_size);
+    }
+  }
+
   QByteArray TolerantTreeRound::GenerateUserXorMessage()
   {
     QByteArray msg;
@@ -773,6 +1072,11 @@ namespace Tolerant {
     _server_message_digests.resize(GetGroup().GetSubgroup().Count());
     _received_server_messages = 0;
 
+    _partial_messages.clear();
+    _partial_messages.resize(_tree.count());
+    _received_partials = 0;
+    _partial_attestations.clear();
+
     _expected_bulk_size = 0;
     for(uint idx = 0; idx < group_size; idx++) {
       _expected_bulk_size += _header_lengths[idx] + _message_lengths[idx];
@@ -835,13 +1139,8 @@ namespace Tolerant {
   void TolerantTreeRound::ChangeState(State new_state) 
   {
     _state = new_state;
-    uint count = static_cast<uint>(_offline_log.Count());
-    for(uint idx = 0; idx < count; idx++) {
-      QPair<QByteArray, Id> entry = _offline_log.At(idx);
-      ProcessData(entry.first, entry.second);
-    }
-
-    _offline_log.Clear();
+    RecordState(StateToString(new_state));
+    ProcessEarlyArrivals();
   }
 
   bool TolerantTreeRound::ReadyForMessage(MessageType mtype)
@@ -858,7 +1157,8 @@ namespace Tolerant {
         return (mtype == MessageType_LeaderCommitData);
       case State_DataSharing:
         return (mtype == MessageType_UserBulkData) ||
-          (mtype == MessageType_ServerBulkData);
+          (mtype == MessageType_ServerBulkData) ||
+          (mtype == MessageType_PartialBulkData);
       case State_DataReceiving:
         return (mtype == MessageType_LeaderBulkData);
       case State_Finished:
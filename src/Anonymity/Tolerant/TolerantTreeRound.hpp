@@ -1,9 +1,12 @@
 #ifndef DISSENT_ANONYMITY_TOLERANT_TOLERANT_TREE_ROUND_H_GUARD
 #define DISSENT_ANONYMITY_TOLERANT_TOLERANT_TREE_ROUND_H_GUARD
 
+#include <QHash>
 #include <QMetaEnum>
+#include <QPair>
 #include <QSharedPointer>
 
+#include "Anonymity/EarlyArrivalQueue.hpp"
 #include "Anonymity/Log.hpp"
 #include "Anonymity/MessageRandomizer.hpp"
 #include "Anonymity/Round.hpp"
@@ -30,6 +33,15 @@ namespace Tolerant {
 
   /**
    * Dissent "v3" Bulk with XOR Tree
+   *
+   * The leader and the servers form a k-ary aggregation tree with the
+   * leader at the root.  Each user sends its xor message to one node in the
+   * tree and each server keeps its own xor message.  A node XORs the
+   * messages it receives with the partial aggregates of its children and
+   * forwards the result, along with the digests of every packet it covers,
+   * to its parent as a signed partial aggregate.  The root checks the
+   * digests against the commits and broadcasts the cleartext.  The root
+   * therefore only receives O(k) xor messages rather than one per member.
    */
   class TolerantTreeRound : public Dissent::Anonymity::Round {
     Q_OBJECT
@@ -90,9 +102,15 @@ namespace Tolerant {
         MessageType_LeaderCommitData = 2,
         MessageType_UserBulkData = 3,
         MessageType_ServerBulkData = 4,
-        MessageType_LeaderBulkData = 5
+        MessageType_LeaderBulkData = 5,
+        MessageType_PartialBulkData = 6
       };
 
+      /**
+       * Default number of children of each node in the aggregation tree
+       */
+      static const uint DefaultFanout = 4;
+
       /**
        * Converts a MessageType into a QString
        * @param mt value to convert
@@ -112,11 +130,13 @@ namespace Tolerant {
        * @param get_data requests data to share during this session
        * @param create_shuffle optional parameter specifying a shuffle round
        * to create, currently used for testing
+       * @param fanout number of children of each node in the aggregation tree
        */
       explicit TolerantTreeRound(const Group &group, 
           const Credentials &creds, const Id &round_id, 
           QSharedPointer<Network> network, GetDataCallback &get_data,
-          CreateRound create_shuffle = &TCreateRound<ShuffleRound>);
+          CreateRound create_shuffle = &TCreateRound<ShuffleRound>,
+          uint fanout = DefaultFanout);
 
       /**
        * Destructor
@@ -167,6 +187,37 @@ namespace Tolerant {
 
       inline void VerifiableSendToLeader(const QByteArray &msg) { VerifiableSend(msg, GetGroup().GetLeader()); }
 
+      /**
+       * Returns the number of children of each node in the aggregation tree
+       */
+      inline uint GetFanout() const { return _fanout; }
+
+      /**
+       * Returns the members of the aggregation tree, the root first
+       */
+      inline const QVector<Id> &GetAggregationTree() const { return _tree; }
+
+      /**
+       * Returns the tree index of the node aggregating a user's messages
+       * @param user_idx the group index of the user
+       */
+      inline int GetAggregatorIndex(uint user_idx) const { return user_idx % _tree.count(); }
+
+      /**
+       * True if the local node is a member of the aggregation tree
+       */
+      inline bool IsAggregator() const { return _tree_idx >= 0; }
+
+      /**
+       * Returns the signed partial aggregate statements collected from this
+       * node's subtree during the current phase, indexed by tree index, each
+       * a pair of the statement and its signature
+       */
+      inline const QHash<int, QPair<QByteArray, QByteArray> > &GetPartialAttestations() const
+      {
+        return _partial_attestations;
+      }
+
     protected:
 
       /*******************************************
@@ -188,6 +239,22 @@ namespace Tolerant {
        */
       void ProcessDataBase(const QByteArray &data, const Id &from);
 
+      /**
+       * Processes a message whose signature has already been verified,
+       * throws exceptions for invalid data packets
+       * @param data Incoming data
+       * @param payload data without its signature
+       * @param from sending peer
+       */
+      void ProcessPayload(const QByteArray &data, const QByteArray &payload,
+          const Id &from);
+
+      /**
+       * Processes the messages held in the early arrival queue, those still
+       * early are queued again
+       */
+      void ProcessEarlyArrivals();
+
 
       /*******************************************
        * Anonymous Signing Key Shuffle Methods
@@ -252,11 +319,54 @@ namespace Tolerant {
        */
       void HandleServerBulkData(const QByteArray &packet, QDataStream &stream, const Id &from);
 
+      /**
+       * Parses and handles partial aggregates from children in the
+       * aggregation tree
+       * @param stream serialized message
+       * @param from the sender
+       */
+      void HandlePartialBulkData(QDataStream &stream, const Id &from);
+
       /**
        * True when a node has all bulk data messages for a phase
        */
       bool HasAllDataMessages();
 
+      /**
+       * Called once an aggregator has all of its messages, either forwards
+       * them to its parent or, at the root, broadcasts the cleartext
+       */
+      void FinishAggregation();
+
+      /**
+       * Builds the statement an aggregator signs over its partial aggregate,
+       * binding the payload to the packet digests it claims to cover
+       * @param tree_idx the aggregator's tree index
+       * @param payload the partial aggregate
+       * @param user_digests the user packet digests covered by the payload
+       * @param server_digests the server packet digests covered by the payload
+       */
+      QByteArray PartialStatement(int tree_idx, const QByteArray &payload,
+          const QVector<QByteArray> &user_digests,
+          const QVector<QByteArray> &server_digests);
+
+      /**
+       * Throws unless a statement forwarded from a descendant aggregator
+       * belongs to this phase and covers only digests its ancestor reported
+       * @param statement the descendant's signed statement
+       * @param tree_idx the descendant's tree index
+       * @param user_digests the user digests reported by the ancestor child
+       * @param server_digests the server digests reported by the ancestor child
+       */
+      void CheckDescendantStatement(const QByteArray &statement, int tree_idx,
+          const QVector<QByteArray> &user_digests,
+          const QVector<QByteArray> &server_digests);
+
+      /**
+       * True if tree node idx lies in the subtree rooted at ancestor
+       */
+      bool IsDescendant(int idx, int ancestor) const;
+
       /**
        * XOR all user and server messages together and broadcast
        * them to the group members
@@ -264,7 +374,13 @@ namespace Tolerant {
       void BroadcastXorMessages();
 
       /**
-       * XOR user and server messages together
+       * XOR the messages received by this node and send them to the
+       * parent in the aggregation tree
+       */
+      void SendPartialXorMessage();
+
+      /**
+       * XOR user and server messages and partial aggregates together
        */
       QByteArray XorMessages();
 
@@ -324,6 +440,12 @@ namespace Tolerant {
        */
       virtual QByteArray GeneratePadWithUser(uint user_idx, uint length);
 
+      /**
+       * Starts generating the pads for the next phase, assuming that the
+       * slot lengths remain the same
+       */
+      void PrefetchPads();
+
       /**
        * Generates the user's entire xor message 
        */
@@ -407,13 +529,13 @@ namespace Tolerant {
       bool _stop_next;
 
       /**
-       * Secrets and RNGs that a user shares with servers
+       * Per-round seeds and RNGs that a user shares with servers
        */
       QVector<QByteArray> _secrets_with_servers;
       QVector<QSharedPointer<Random> > _rngs_with_servers;
 
       /**
-       * Secrets and RNGs that a server shares with users 
+       * Per-round seeds and RNGs that a server shares with users
        */
       QVector<QByteArray> _secrets_with_users;
       QVector<QSharedPointer<Random> > _rngs_with_users;
@@ -434,9 +556,10 @@ namespace Tolerant {
       State _state;
 
       /**
-       * Stores all validated messages that arrived before start was called
+       * Stores verified messages that arrived before the round was ready
+       * for them
        */
-      Log _offline_log;
+      EarlyArrivalQueue _early_arrivals;
 
       /**
        * Stores all validated incoming messages
@@ -535,6 +658,39 @@ namespace Tolerant {
       uint _received_user_messages;
       uint _received_server_messages;
 
+      /**
+       * Number of children of each node in the aggregation tree
+       */
+      const uint _fanout;
+
+      /**
+       * Members of the aggregation tree, the root first, where the
+       * parent of node i is node (i - 1) / fanout
+       */
+      QVector<Id> _tree;
+
+      /**
+       * The local node's index in the aggregation tree or -1
+       */
+      int _tree_idx;
+
+      /**
+       * Number of user messages and partial aggregates this node expects
+       */
+      uint _expected_user_messages;
+      uint _expected_partials;
+
+      /**
+       * Received partial aggregates indexed by tree index
+       */
+      QVector<QByteArray> _partial_messages;
+      uint _received_partials;
+
+      /**
+       * Signed partial aggregate statements from this node's subtree
+       */
+      QHash<int, QPair<QByteArray, QByteArray> > _partial_attestations;
+
       /**
        * Utils for randomizing cleartext messages
        */
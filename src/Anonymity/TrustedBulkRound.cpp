@@ -1,10 +1,14 @@
 #include "Crypto/Library.hpp"
+#include "Crypto/SharedSecretCache.hpp"
+#include "Utils/BufferedRandom.hpp"
 #include "BulkRound.hpp"
 #include "TrustedBulkRound.hpp"
 
 using Dissent::Crypto::CryptoFactory;
 using Dissent::Crypto::Library;
 using Dissent::Crypto::Integer;
+using Dissent::Crypto::SharedSecretCache;
+using Dissent::Utils::BufferedRandom;
 
 namespace Dissent {
 namespace Anonymity {
@@ -27,6 +31,7 @@ namespace Anonymity {
       roster = _trusted_group.GetRoster();
     }
 
+    SharedSecretCache &secrets = SharedSecretCache::GetInstance();
     foreach(GroupContainer gc, roster) {
       if(gc.first == GetLocalId()) {
         continue;
@@ -34,7 +39,9 @@ namespace Anonymity {
       if(_offline_peers.contains(gc.first)) {
         continue;
       }
-      QByteArray base_seed = GetCredentials().GetDhKey()->GetSharedSecret(gc.third);
+      QByteArray base_seed = SharedSecretCache::DeriveSeed(
+          secrets.GetSharedSecret(*GetCredentials().GetDhKey(), gc.third),
+          GetRoundId().GetByteArray());
       _base_seeds.append(Integer(base_seed));
     }
   }
@@ -64,22 +71,42 @@ namespace Anonymity {
     return xor_msg;
   }
 
-  bool TrustedBulkRound::PrepForNextPhase()
+  QVector<QSharedPointer<Random> > TrustedBulkRound::CreateRngs(uint phase)
   {
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     QVector<QSharedPointer<Random> > anon_rngs;
 
     foreach(const Integer &val, _base_seeds) {
-      QByteArray seed = (val + GetPhase()).GetByteArray();
-      QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+      QByteArray seed = (val + phase).GetByteArray();
+      QSharedPointer<Random> rng(new BufferedRandom(lib->GetRandomNumberGenerator(seed)));
       anon_rngs.append(rng);
     }
 
-    SetAnonymousRngs(anon_rngs);
+    return anon_rngs;
+  }
+
+  bool TrustedBulkRound::PrepForNextPhase()
+  {
+    if(_next_rngs.isEmpty()) {
+      SetAnonymousRngs(CreateRngs(GetPhase()));
+    } else {
+      SetAnonymousRngs(_next_rngs);
+      _next_rngs.clear();
+    }
 
     return RepeatingBulkRound::PrepForNextPhase();
   }
 
+  void TrustedBulkRound::PrefetchNextPhase()
+  {
+    // Each phase's rngs are fresh, so any bytes generated beyond the
+    // eventual message size are simply unused
+    _next_rngs = CreateRngs(GetPhase() + 1);
+    foreach(const QSharedPointer<Random> &rng, _next_rngs) {
+      rng->Prefetch(GetExpectedBulkMessageSize());
+    }
+  }
+
   void TrustedBulkRound::HandleDisconnect(const Id &id)
   {
     if(_trusted_group.Contains(id)) {
@@ -69,6 +69,12 @@ namespace Anonymity {
        */
       virtual bool PrepForNextPhase();
 
+      /**
+       * Creates the rngs for the next phase and starts generating their
+       * pads, assuming the message size remains the same
+       */
+      virtual void PrefetchNextPhase();
+
     private:
       /**
        * Generates the entire xor message with the local members message
@@ -81,6 +87,12 @@ namespace Anonymity {
        */
       void Init();
 
+      /**
+       * Creates the rngs used to generate the xor message of a phase
+       * @param phase the phase
+       */
+      QVector<QSharedPointer<Random> > CreateRngs(uint phase);
+
       /**
        * The group of trusted bulk nodes (i.e., generate xor text for all)
        */
@@ -91,8 +103,17 @@ namespace Anonymity {
        */
       bool _trusted;
 
+      /**
+       * Per-round seeds shared with each peer, offset by the phase to seed
+       * that phase's rngs
+       */
       QVector<Integer> _base_seeds;
 
+      /**
+       * Prefetched rngs for the next phase
+       */
+      QVector<QSharedPointer<Random> > _next_rngs;
+
       QHash<const Id, const Id> _offline_peers;
   };
 }
@@ -107,6 +107,10 @@ int main(int argc, char **argv)
     QSharedPointer<RoundIdService> round_id_sp(new RoundIdService(nodes[0]->sm));
     ws->AddRoute(HttpRequest::METHOD_HTTP_GET, "/round/id", round_id_sp);
 
+    RoundMetrics::SetEnabled(true);
+    QSharedPointer<RoundMetricsService> round_metrics_sp(new RoundMetricsService());
+    ws->AddRoute(HttpRequest::METHOD_HTTP_GET, "/round/metrics", round_metrics_sp);
+
     QSharedPointer<SessionIdService> session_id_sp(new SessionIdService(nodes[0]->sm));
     ws->AddRoute(HttpRequest::METHOD_HTTP_GET, "/session/id", session_id_sp);
 
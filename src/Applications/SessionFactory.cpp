@@ -1,3 +1,4 @@
+#include "Anonymity/AggregatedBulkRound.hpp"
 #include "Anonymity/BulkRound.hpp"
 #include "Anonymity/RepeatingBulkRound.hpp"
 #include "Anonymity/NullRound.hpp"
@@ -14,6 +15,7 @@
 
 #include "SessionFactory.hpp"
 
+using Dissent::Anonymity::AggregatedBulkRound;
 using Dissent::Anonymity::BulkRound;
 using Dissent::Anonymity::Group;
 using Dissent::Anonymity::NullRound;
@@ -47,6 +49,7 @@ namespace Applications {
     AddCreateCallback("shuffle", &CreateShuffleRoundSession);
     AddCreateCallback("bulk", &CreateBulkRoundSession);
     AddCreateCallback("repeatingbulk", &CreateRepeatingBulkRoundSession);
+    AddCreateCallback("aggregatedbulk", &CreateAggregatedBulkRoundSession);
     AddCreateCallback("trustedbulk", &CreateTrustedBulkRoundSession);
     AddCreateCallback("tolerantbulk", &CreateTolerantBulkRoundSession);
     AddCreateCallback("toleranttree", &CreateTolerantTreeRoundSession);
@@ -92,6 +95,12 @@ namespace Applications {
     Common(node, session_id, &TCreateRound<RepeatingBulkRound>, group);
   }
 
+  void SessionFactory::CreateAggregatedBulkRoundSession(Node *node,
+      const Id &session_id, const Group &group)
+  {
+    Common(node, session_id, &TCreateRound<AggregatedBulkRound>, group);
+  }
+
   void SessionFactory::CreateTrustedBulkRoundSession(Node *node,
       const Id &session_id, const Group &group)
   {
@@ -65,6 +65,12 @@ namespace Applications {
       static void CreateRepeatingBulkRoundSession(Node *node,
           const Id &session_id, const Group &group);
 
+      /**
+       * Create a Bulk "V2" with leader aggregation
+       */
+      static void CreateAggregatedBulkRoundSession(Node *node,
+          const Id &session_id, const Group &group);
+
       /**
        * Create a Bulk "V3"
        */
@@ -61,7 +61,7 @@ namespace Applications {
         } else if(Log.isEmpty()) {
           Logging::Disable();
         } else {
-          Logging::UseFile(Log);
+          Logging::UseAsyncFile(Log);
         }
       }
     }
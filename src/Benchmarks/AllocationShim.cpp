@@ -0,0 +1,197 @@
+/*
+ * An LD_PRELOAD shim that counts heap allocations for the benchmarks, see
+ * allocshim.pro.  It interposes every libc allocation entry point and
+ * forwards to the next definition found by the dynamic linker, so it also
+ * counts allocations made by Qt, CryptoPP and operator new.  It does not use
+ * Qt, which would itself allocate while the shim is being initialized.
+ * Utils::AllocationCounter reads the count through
+ * dissent_allocation_count when the shim is loaded.
+ */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace {
+  typedef void *(*MallocFunction)(size_t);
+  typedef void *(*CallocFunction)(size_t, size_t);
+  typedef void *(*ReallocFunction)(void *, size_t);
+  typedef void (*FreeFunction)(void *);
+  typedef int (*PosixMemalignFunction)(void **, size_t, size_t);
+  typedef void *(*MemalignFunction)(size_t, size_t);
+
+  MallocFunction real_malloc = 0;
+  CallocFunction real_calloc = 0;
+  ReallocFunction real_realloc = 0;
+  FreeFunction real_free = 0;
+  PosixMemalignFunction real_posix_memalign = 0;
+  MemalignFunction real_memalign = 0;
+  MemalignFunction real_aligned_alloc = 0;
+  MallocFunction real_valloc = 0;
+
+  volatile int allocations = 0;
+  bool initializing = false;
+
+  /**
+   * dlsym may allocate before the real allocator has been found, those
+   * requests are served from this zeroed arena and never freed
+   */
+  char bootstrap[8192] __attribute__((aligned(16)));
+  size_t bootstrap_used = 0;
+
+  void *BootstrapAlloc(size_t size)
+  {
+    size = (size + 15) & ~static_cast<size_t>(15);
+    if(size > sizeof(bootstrap) - bootstrap_used) {
+      return 0;
+    }
+
+    void *ptr = bootstrap + bootstrap_used;
+    bootstrap_used += size;
+    return ptr;
+  }
+
+  inline bool IsBootstrap(const void *ptr)
+  {
+    return ptr >= bootstrap && ptr < bootstrap + sizeof(bootstrap);
+  }
+
+  template<typename T> T Lookup(const char *name)
+  {
+    return reinterpret_cast<T>(dlsym(RTLD_NEXT, name));
+  }
+
+  void Initialize()
+  {
+    if(real_malloc || initializing) {
+      return;
+    }
+
+    initializing = true;
+    real_calloc = Lookup<CallocFunction>("calloc");
+    real_realloc = Lookup<ReallocFunction>("realloc");
+    real_free = Lookup<FreeFunction>("free");
+    real_posix_memalign = Lookup<PosixMemalignFunction>("posix_memalign");
+    real_memalign = Lookup<MemalignFunction>("memalign");
+    real_aligned_alloc = Lookup<MemalignFunction>("aligned_alloc");
+    real_valloc = Lookup<MallocFunction>("valloc");
+    real_malloc = Lookup<MallocFunction>("malloc");
+    initializing = false;
+  }
+
+  inline void Count()
+  {
+    __sync_fetch_and_add(&allocations, 1);
+  }
+}
+
+extern "C" {
+  int dissent_allocation_count()
+  {
+    return __sync_fetch_and_add(&allocations, 0);
+  }
+
+  void *malloc(size_t size) __THROW
+  {
+    Initialize();
+    if(!real_malloc) {
+      return BootstrapAlloc(size);
+    }
+
+    Count();
+    return real_malloc(size);
+  }
+
+  void *calloc(size_t count, size_t size) __THROW
+  {
+    Initialize();
+    if(!real_calloc) {
+      if(size && count > static_cast<size_t>(-1) / size) {
+        return 0;
+      }
+      return BootstrapAlloc(count * size);
+    }
+
+    Count();
+    return real_calloc(count, size);
+  }
+
+  void *realloc(void *ptr, size_t size) __THROW
+  {
+    Initialize();
+    if(IsBootstrap(ptr)) {
+      void *moved = malloc(size);
+      if(moved) {
+        size_t available = bootstrap + sizeof(bootstrap) -
+          static_cast<char *>(ptr);
+        memcpy(moved, ptr, size < available ? size : available);
+      }
+      return moved;
+    }
+
+    if(!real_realloc) {
+      return 0;
+    }
+
+    Count();
+    return real_realloc(ptr, size);
+  }
+
+  void free(void *ptr) __THROW
+  {
+    if(!ptr || IsBootstrap(ptr)) {
+      return;
+    }
+
+    Initialize();
+    if(real_free) {
+      real_free(ptr);
+    }
+  }
+
+  int posix_memalign(void **ptr, size_t alignment, size_t size) __THROW
+  {
+    Initialize();
+    if(!real_posix_memalign) {
+      return ENOMEM;
+    }
+
+    Count();
+    return real_posix_memalign(ptr, alignment, size);
+  }
+
+  void *memalign(size_t alignment, size_t size) __THROW
+  {
+    Initialize();
+    if(!real_memalign) {
+      return 0;
+    }
+
+    Count();
+    return real_memalign(alignment, size);
+  }
+
+  void *aligned_alloc(size_t alignment, size_t size) __THROW
+  {
+    Initialize();
+    MemalignFunction real = real_aligned_alloc ? real_aligned_alloc : real_memalign;
+    if(!real) {
+      return 0;
+    }
+
+    Count();
+    return real(alignment, size);
+  }
+
+  void *valloc(size_t size) __THROW
+  {
+    Initialize();
+    if(!real_valloc) {
+      return 0;
+    }
+
+    Count();
+    return real_valloc(size);
+  }
+}
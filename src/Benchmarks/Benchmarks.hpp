@@ -0,0 +1,134 @@
+#ifndef DISSENT_BENCHMARKS_BENCHMARKS_H_GUARD
+#define DISSENT_BENCHMARKS_BENCHMARKS_H_GUARD
+
+#include <QStringList>
+#include <QVariant>
+
+namespace Dissent {
+namespace Benchmarks {
+  /**
+   * Queues count timers due uniformly within span ms on virtual time, stops
+   * every other one, then runs the rest to expiry, timing each step
+   * @param count number of timers
+   * @param span the due times are spread over this many ms
+   */
+  QVariantMap RunTimerBenchmark(int count, int span);
+
+  /**
+   * Measures the throughput of each crypto primitive in each library: sign,
+   * verify, encrypt, decrypt, hash and random generation for every size,
+   * onion encryption and decryption for every size and layer count,
+   * hashing a batch of commits, one slice per member, for every hash and
+   * commit count, the Diffie-Hellman operations, and verifying a number of
+   * shared secret proofs as a batch or one at a time.  Every thread runs
+   * its own copy of the operation, with its own keys, for msecs.
+   * @param libraries library names, "cryptopp" or "null"
+   * @param threads thread counts to run each operation with
+   * @param sizes message sizes in bytes
+   * @param layers onion layer counts
+   * @param hashes hash algorithm names, see Crypto::Hash
+   * @param commits numbers of slices hashed per batch
+   * @param proofs numbers of shared secret proofs verified per batch
+   * @param msecs time to run each operation for
+   */
+  QVariantList RunCryptoBenchmark(const QStringList &libraries,
+      const QList<int> &threads, const QList<int> &sizes,
+      const QList<int> &layers, const QStringList &hashes,
+      const QList<int> &commits, const QList<int> &proofs, int msecs);
+
+  /**
+   * Fills a BlameMatrix for users x servers with consistent alibis except
+   * that the first conflicts servers each lie about one user, then times
+   * GetConflicts, the bad member parity checks and the per member conflict
+   * counts, each averaged over iterations
+   * @param users number of users
+   * @param servers number of servers
+   * @param conflicts number of conflicting cells
+   * @param iterations number of times each scan is repeated
+   */
+  QVariantMap RunBlameBenchmark(int users, int servers, int conflicts,
+      int iterations);
+
+  /**
+   * Feeds phases rounds of users messages and servers messages, each holding
+   * one slot of slot_length bytes per user, through the tolerant round's
+   * MessageHistory and through a history copying every slot out of every
+   * message, as the round once did, counting the allocations and timing
+   * each phase
+   * @param users number of users, and of slots
+   * @param servers number of servers
+   * @param slot_length bytes per slot
+   * @param phases number of phases
+   */
+  QVariantMap RunHistoryBenchmark(int users, int servers, int slot_length,
+      int phases);
+
+  /**
+   * Fills an Anonymity::Log with entries messages from ten senders, each
+   * half random and half zero padding, then times serializing and parsing
+   * it as the former QDataStream of entries, in the indexed format and
+   * compressed, and serializing and verifying a partial log holding one
+   * entry in a hundred, each averaged over iterations
+   * @param entries number of log entries
+   * @param msg_size size of each entry in bytes
+   * @param iterations number of times each operation is repeated
+   */
+  QVariantMap RunLogBenchmark(int entries, int msg_size, int iterations);
+
+  /**
+   * Logs lines messages of msg_size bytes through Logging::UseFile, which
+   * reopens the file per line, and through Logging::UseAsyncFile, timing
+   * the calls on the logging thread and the time until every line is on
+   * disk, and counting the lines the asynchronous writer dropped
+   * @param lines number of lines logged per mode
+   * @param msg_size size of each message in bytes
+   */
+  QVariantMap RunLoggingBenchmark(int lines, int msg_size);
+
+  /**
+   * Runs a shuffle round on virtual time with one shuffler replacing a
+   * ciphertext, captures the blame data the first honest member receives,
+   * then times ShuffleBlamer over it with serial and with parallel replay,
+   * each averaged over iterations
+   * @param count number of group members, all of them shufflers
+   * @param iterations number of times the blamer is run per mode
+   */
+  QVariantMap RunShuffleBlameBenchmark(int count, int iterations);
+
+  /**
+   * Fills a random bulk message of descriptors slices of length bytes for
+   * each of members, then opens every descriptor as BulkRound does, timing
+   * hashing and xoring the slices in separate passes, in one fused pass,
+   * and in one fused pass with the descriptors spread across threads, each
+   * averaged over iterations
+   * @param members number of group members
+   * @param descriptors number of descriptors
+   * @param length bytes per descriptor
+   * @param iterations number of times each mode is repeated
+   */
+  QVariantMap RunBulkXorBenchmark(int members, int descriptors, int length,
+      int iterations);
+
+  /**
+   * Builds a group of count members, each with a DH component, then times
+   * BulkRound::CreateDescriptor for length bytes of data in a fresh round,
+   * so every shared secret is computed within the call, with a single
+   * thread and with the global thread pool capped at each thread count,
+   * each averaged over iterations
+   * @param count number of group members
+   * @param threads thread counts to run the parallel descriptor with
+   * @param length bytes of data in the descriptor
+   * @param iterations number of descriptors created per configuration
+   */
+  QVariantMap RunDescriptorBenchmark(int count, const QList<int> &threads,
+      int length, int iterations);
+
+  /**
+   * Formats the results of RunCryptoBenchmark as an aligned text table
+   * @param results the results
+   */
+  QString CryptoResultsTable(const QVariantList &results);
+}
+}
+
+#endif
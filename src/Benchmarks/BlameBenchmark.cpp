@@ -0,0 +1,82 @@
+#include <ctime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+using Dissent::Anonymity::Tolerant::BlameMatrix;
+using Dissent::Anonymity::Tolerant::Conflict;
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    double Seconds(clock_t start)
+    {
+      return double(clock() - start) / CLOCKS_PER_SEC;
+    }
+  }
+
+  QVariantMap RunBlameBenchmark(int users, int servers, int conflicts,
+      int iterations)
+  {
+    qsrand(1);
+    BlameMatrix matrix(users, servers);
+
+    // Consistent alibis, except that the first conflicts servers each lie
+    // about one user
+    QVector<QBitArray> rows(users, QBitArray(servers));
+    clock_t start = clock();
+    for(int user_idx = 0; user_idx < users; user_idx++) {
+      for(int server_idx = 0; server_idx < servers; server_idx++) {
+        rows[user_idx].setBit(server_idx, qrand() % 2);
+      }
+      matrix.AddUserAlibi(user_idx, rows[user_idx]);
+    }
+
+    for(int server_idx = 0; server_idx < servers; server_idx++) {
+      QBitArray column(users);
+      for(int user_idx = 0; user_idx < users; user_idx++) {
+        column.setBit(user_idx, rows[user_idx].testBit(server_idx));
+      }
+      if(server_idx < conflicts) {
+        column.toggleBit(qrand() % users);
+      }
+      matrix.AddServerAlibi(server_idx, column);
+    }
+    double fill = Seconds(start);
+
+    int found = 0;
+    start = clock();
+    for(int idx = 0; idx < iterations; idx++) {
+      found = matrix.GetConflicts(0).count();
+    }
+    double scan = Seconds(start);
+
+    start = clock();
+    for(int idx = 0; idx < iterations; idx++) {
+      matrix.GetBadUsers();
+      matrix.GetBadServers();
+    }
+    double parity = Seconds(start);
+
+    start = clock();
+    for(int idx = 0; idx < iterations; idx++) {
+      matrix.GetUserConflictCounts();
+      matrix.GetServerConflictCounts();
+    }
+    double counts = Seconds(start);
+
+    QVariantMap result;
+    result["benchmark"] = "blame";
+    result["users"] = users;
+    result["servers"] = servers;
+    result["conflicts"] = found;
+    result["iterations"] = iterations;
+    result["fill_msecs"] = fill * 1000.0;
+    result["get_conflicts_usecs"] = scan * 1e6 / iterations;
+    result["bad_members_usecs"] = parity * 1e6 / iterations;
+    result["conflict_counts_usecs"] = counts * 1e6 / iterations;
+    return result;
+  }
+}
+}
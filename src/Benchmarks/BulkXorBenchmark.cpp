@@ -0,0 +1,130 @@
+#include <QFuture>
+#include <QThread>
+#include <QTime>
+#include <QtConcurrentRun>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * The slice of every member's message belonging to one descriptor
+     */
+    QVector<const char *> Slices(const QVector<QByteArray> &messages,
+        int offset)
+    {
+      QVector<const char *> slices;
+      foreach(const QByteArray &message, messages) {
+        slices.append(message.constData() + offset);
+      }
+      return slices;
+    }
+
+    /**
+     * Opens one descriptor the way BulkRound::ProcessMessage used to: all
+     * slices are hashed, then read again to be xored
+     */
+    QByteArray TwoPass(Hash *hash, const QVector<QByteArray> &messages,
+        int offset, int length, QVector<QByteArray> *hashes)
+    {
+      QVector<QByteArray> slices;
+      foreach(const QByteArray &message, messages) {
+        slices.append(QByteArray::fromRawData(message.constData() + offset,
+              length));
+      }
+
+      *hashes = hash->ComputeHashes(slices);
+      QByteArray cleartext(length, 0);
+      foreach(const QByteArray &slice, slices) {
+        Xor(cleartext, cleartext, slice);
+      }
+      return cleartext;
+    }
+
+    /**
+     * Opens one descriptor with the fused kernel
+     */
+    QByteArray Fused(Hash *hash, const QVector<QByteArray> &messages,
+        int offset, int length, QVector<QByteArray> *hashes)
+    {
+      QByteArray cleartext(length, 0);
+      *hashes = HashXor(hash, cleartext.data(), Slices(messages, offset),
+          length);
+      return cleartext;
+    }
+  }
+
+  QVariantMap RunBulkXorBenchmark(int members, int descriptors, int length,
+      int iterations)
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+    QScopedPointer<Hash> hash(lib->GetHashAlgorithm());
+
+    // Every member sends one slice of length bytes per descriptor
+    QVector<QByteArray> messages;
+    for(int idx = 0; idx < members; idx++) {
+      QByteArray message(descriptors * length, 0);
+      rand->GenerateBlock(message);
+      messages.append(message);
+    }
+
+    QVariantMap result;
+    result["benchmark"] = "bulkxor";
+    result["members"] = members;
+    result["descriptors"] = descriptors;
+    result["length"] = length;
+    result["iterations"] = iterations;
+
+    QVector<QByteArray> expected(descriptors);
+    QVector<QVector<QByteArray> > hashes(descriptors);
+
+    QTime timer;
+    timer.start();
+    for(int iter = 0; iter < iterations; iter++) {
+      for(int idx = 0; idx < descriptors; idx++) {
+        expected[idx] = TwoPass(hash.data(), messages, idx * length, length,
+            &hashes[idx]);
+      }
+    }
+    result["two_pass_msecs"] = timer.elapsed() / double(iterations);
+    const QVector<QVector<QByteArray> > expected_hashes = hashes;
+
+    bool matched = true;
+    timer.restart();
+    for(int iter = 0; iter < iterations; iter++) {
+      for(int idx = 0; idx < descriptors; idx++) {
+        QByteArray cleartext = Fused(hash.data(), messages, idx * length,
+            length, &hashes[idx]);
+        matched = matched && cleartext == expected[idx];
+      }
+    }
+    result["fused_msecs"] = timer.elapsed() / double(iterations);
+    matched = matched && hashes == expected_hashes;
+
+    // As BulkRound::ProcessMessages does when multithreaded
+    timer.restart();
+    for(int iter = 0; iter < iterations; iter++) {
+      QList<Hash *> clones;
+      QList<QFuture<QByteArray> > futures;
+      for(int idx = 0; idx < descriptors; idx++) {
+        Hash *clone = hash->Clone();
+        clones.append(clone);
+        futures.append(QtConcurrent::run(&Fused, clone, messages,
+              idx * length, length, &hashes[idx]));
+      }
+      for(int idx = 0; idx < descriptors; idx++) {
+        matched = matched && futures[idx].result() == expected[idx];
+      }
+      qDeleteAll(clones);
+    }
+    result["fused_parallel_msecs"] = timer.elapsed() / double(iterations);
+    result["threads"] = QThread::idealThreadCount();
+    result["matched"] = matched && hashes == expected_hashes;
+    return result;
+  }
+}
+}
@@ -0,0 +1,562 @@
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * A single crypto operation with its own keys and inputs, so that
+     * threads never share state
+     */
+    class CryptoOperation {
+      public:
+        virtual ~CryptoOperation() {}
+        virtual void Run() = 0;
+    };
+
+    typedef CryptoOperation *(*CreateOperation)(Library *lib, int size,
+        int layers);
+
+    QByteArray RandomData(Library *lib, int size)
+    {
+      QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+      QByteArray data(size, 0);
+      rand->GenerateBlock(data);
+      return data;
+    }
+
+    class SignOperation : public CryptoOperation {
+      public:
+        SignOperation(Library *lib, int size) :
+          _key(lib->CreatePrivateKey()), _data(RandomData(lib, size)) {}
+
+        virtual void Run() { _key->Sign(_data); }
+
+      private:
+        QScopedPointer<AsymmetricKey> _key;
+        QByteArray _data;
+    };
+
+    class VerifyOperation : public CryptoOperation {
+      public:
+        VerifyOperation(Library *lib, int size) :
+          _data(RandomData(lib, size))
+        {
+          QScopedPointer<AsymmetricKey> key(lib->CreatePrivateKey());
+          _key.reset(key->GetPublicKey());
+          _sig = key->Sign(_data);
+        }
+
+        virtual void Run() { _key->Verify(_data, _sig); }
+
+      private:
+        QScopedPointer<AsymmetricKey> _key;
+        QByteArray _data;
+        QByteArray _sig;
+    };
+
+    class EncryptOperation : public CryptoOperation {
+      public:
+        EncryptOperation(Library *lib, int size) :
+          _data(RandomData(lib, size))
+        {
+          QScopedPointer<AsymmetricKey> key(lib->CreatePrivateKey());
+          _key.reset(key->GetPublicKey());
+        }
+
+        virtual void Run() { _key->Encrypt(_data); }
+
+      private:
+        QScopedPointer<AsymmetricKey> _key;
+        QByteArray _data;
+    };
+
+    class DecryptOperation : public CryptoOperation {
+      public:
+        DecryptOperation(Library *lib, int size) :
+          _key(lib->CreatePrivateKey())
+        {
+          QScopedPointer<AsymmetricKey> pub(_key->GetPublicKey());
+          _ciphertext = pub->Encrypt(RandomData(lib, size));
+        }
+
+        virtual void Run() { _key->Decrypt(_ciphertext); }
+
+      private:
+        QScopedPointer<AsymmetricKey> _key;
+        QByteArray _ciphertext;
+    };
+
+    class SharedSecretOperation : public CryptoOperation {
+      public:
+        explicit SharedSecretOperation(Library *lib) :
+          _dh(lib->CreateDiffieHellman())
+        {
+          QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+          _remote_pub = remote->GetPublicComponent();
+        }
+
+        virtual void Run() { _dh->GetSharedSecret(_remote_pub); }
+
+      private:
+        QScopedPointer<DiffieHellman> _dh;
+        QByteArray _remote_pub;
+    };
+
+    class ProveSharedSecretOperation : public CryptoOperation {
+      public:
+        explicit ProveSharedSecretOperation(Library *lib) :
+          _dh(lib->CreateDiffieHellman())
+        {
+          QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+          _remote_pub = remote->GetPublicComponent();
+        }
+
+        virtual void Run() { _dh->ProveSharedSecret(_remote_pub); }
+
+      private:
+        QScopedPointer<DiffieHellman> _dh;
+        QByteArray _remote_pub;
+    };
+
+    class VerifySharedSecretOperation : public CryptoOperation {
+      public:
+        explicit VerifySharedSecretOperation(Library *lib) :
+          _verifier(lib->CreateDiffieHellman())
+        {
+          QScopedPointer<DiffieHellman> prover(lib->CreateDiffieHellman());
+          QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+          _prover_pub = prover->GetPublicComponent();
+          _remote_pub = remote->GetPublicComponent();
+          _proof = prover->ProveSharedSecret(_remote_pub);
+        }
+
+        virtual void Run()
+        {
+          _verifier->VerifySharedSecret(_prover_pub, _remote_pub, _proof);
+        }
+
+      private:
+        QScopedPointer<DiffieHellman> _verifier;
+        QByteArray _prover_pub;
+        QByteArray _remote_pub;
+        QByteArray _proof;
+    };
+
+    /**
+     * Verifies count proofs of distinct shared secrets, as blame in a
+     * tolerant round does for each accusation, either as one batch or one
+     * proof at a time
+     */
+    class VerifySharedSecretsOperation : public CryptoOperation {
+      public:
+        VerifySharedSecretsOperation(Library *lib, int count, bool batch) :
+          _verifier(lib->CreateDiffieHellman()), _batch(batch)
+        {
+          for(int idx = 0; idx < count; idx++) {
+            QScopedPointer<DiffieHellman> prover(lib->CreateDiffieHellman());
+            QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+            _prover_pubs.append(prover->GetPublicComponent());
+            _remote_pubs.append(remote->GetPublicComponent());
+            _proofs.append(prover->ProveSharedSecret(_remote_pubs.last()));
+          }
+        }
+
+        virtual void Run()
+        {
+          if(_batch) {
+            _verifier->VerifySharedSecrets(_prover_pubs, _remote_pubs, _proofs);
+            return;
+          }
+
+          for(int idx = 0; idx < _proofs.count(); idx++) {
+            _verifier->VerifySharedSecret(_prover_pubs[idx], _remote_pubs[idx],
+                _proofs[idx]);
+          }
+        }
+
+      private:
+        QScopedPointer<DiffieHellman> _verifier;
+        QVector<QByteArray> _prover_pubs;
+        QVector<QByteArray> _remote_pubs;
+        QVector<QByteArray> _proofs;
+        bool _batch;
+    };
+
+    class VerifySharedSecretsBatchOperation : public VerifySharedSecretsOperation {
+      public:
+        VerifySharedSecretsBatchOperation(Library *lib, int, int count) :
+          VerifySharedSecretsOperation(lib, count, true) {}
+    };
+
+    class VerifySharedSecretsSerialOperation : public VerifySharedSecretsOperation {
+      public:
+        VerifySharedSecretsSerialOperation(Library *lib, int, int count) :
+          VerifySharedSecretsOperation(lib, count, false) {}
+    };
+
+    class HashOperation : public CryptoOperation {
+      public:
+        HashOperation(Library *lib, int size) :
+          _hash(lib->GetHashAlgorithm()), _data(RandomData(lib, size)) {}
+
+        virtual void Run() { _hash->ComputeHash(_data); }
+
+      private:
+        QScopedPointer<Hash> _hash;
+        QByteArray _data;
+    };
+
+    /**
+     * Hashes count slices of a message, as a round checks one commit per
+     * member, either as one batch or one slice at a time
+     */
+    class HashCommitsOperation : public CryptoOperation {
+      public:
+        HashCommitsOperation(Library *lib, int size, int count, bool batch) :
+          _hash(lib->GetHashAlgorithm()), _data(RandomData(lib, size * count)),
+          _batch(batch)
+        {
+          for(int idx = 0; idx < count; idx++) {
+            _slices.append(QByteArray::fromRawData(_data.constData() +
+                  idx * size, size));
+          }
+        }
+
+        virtual void Run()
+        {
+          if(_batch) {
+            _hash->ComputeHashes(_slices);
+            return;
+          }
+
+          foreach(const QByteArray &slice, _slices) {
+            _hash->ComputeHash(slice);
+          }
+        }
+
+      private:
+        QScopedPointer<Hash> _hash;
+        QByteArray _data;
+        QVector<QByteArray> _slices;
+        bool _batch;
+    };
+
+    class HashCommitsBatchOperation : public HashCommitsOperation {
+      public:
+        HashCommitsBatchOperation(Library *lib, int size, int count) :
+          HashCommitsOperation(lib, size, count, true) {}
+    };
+
+    class HashCommitsSerialOperation : public HashCommitsOperation {
+      public:
+        HashCommitsSerialOperation(Library *lib, int size, int count) :
+          HashCommitsOperation(lib, size, count, false) {}
+    };
+
+    class RandomOperation : public CryptoOperation {
+      public:
+        RandomOperation(Library *lib, int size) :
+          _rand(lib->GetRandomNumberGenerator()), _data(size, 0) {}
+
+        virtual void Run() { _rand->GenerateBlock(_data); }
+
+      private:
+        QScopedPointer<Random> _rand;
+        QByteArray _data;
+    };
+
+    /**
+     * Base for the onion operations, holds one key pair per layer
+     */
+    class OnionOperation : public CryptoOperation {
+      public:
+        OnionOperation(Library *lib, int size, int layers) :
+          _oe(CryptoFactory::GetInstance().GetOnionEncryptor()),
+          _data(RandomData(lib, size))
+        {
+          for(int idx = 0; idx < layers; idx++) {
+            AsymmetricKey *key = lib->CreatePrivateKey();
+            _private_keys.append(key);
+            _public_keys.append(key->GetPublicKey());
+          }
+        }
+
+        virtual ~OnionOperation()
+        {
+          qDeleteAll(_private_keys);
+          qDeleteAll(_public_keys);
+        }
+
+      protected:
+        OnionEncryptor *_oe;
+        QByteArray _data;
+        QVector<AsymmetricKey *> _private_keys;
+        QVector<AsymmetricKey *> _public_keys;
+    };
+
+    class OnionEncryptOperation : public OnionOperation {
+      public:
+        OnionEncryptOperation(Library *lib, int size, int layers) :
+          OnionOperation(lib, size, layers) {}
+
+        virtual void Run()
+        {
+          QByteArray ciphertext;
+          _oe->Encrypt(_public_keys, _data, ciphertext, 0);
+        }
+    };
+
+    /**
+     * Peels every layer of a single onion, outermost key first
+     */
+    class OnionDecryptOperation : public OnionOperation {
+      public:
+        OnionDecryptOperation(Library *lib, int size, int layers) :
+          OnionOperation(lib, size, layers)
+        {
+          QByteArray ciphertext;
+          _oe->Encrypt(_public_keys, _data, ciphertext, 0);
+          _onion.append(ciphertext);
+        }
+
+        virtual void Run()
+        {
+          QVector<QByteArray> current = _onion;
+          QVector<QByteArray> next;
+          for(int idx = _private_keys.count() - 1; idx >= 0; idx--) {
+            _oe->Decrypt(_private_keys[idx], current, next, 0);
+            current = next;
+          }
+        }
+
+      private:
+        QVector<QByteArray> _onion;
+    };
+
+    template <typename T> CryptoOperation *TCreateSized(Library *lib,
+        int size, int)
+    {
+      return new T(lib, size);
+    }
+
+    template <typename T> CryptoOperation *TCreateUnsized(Library *lib,
+        int, int)
+    {
+      return new T(lib);
+    }
+
+    template <typename T> CryptoOperation *TCreateCounted(Library *lib,
+        int size, int count)
+    {
+      return new T(lib, size, count);
+    }
+
+    /**
+     * Runs an operation in a loop until a deadline
+     */
+    class OperationThread : public QThread {
+      public:
+        OperationThread(CryptoOperation *op, int msecs) :
+          count(0), _op(op), _msecs(msecs) {}
+
+        qint64 count;
+
+      protected:
+        virtual void run()
+        {
+          QTime timer;
+          timer.start();
+          do {
+            _op->Run();
+            count++;
+          } while(timer.elapsed() < _msecs);
+        }
+
+      private:
+        QScopedPointer<CryptoOperation> _op;
+        int _msecs;
+    };
+
+    /**
+     * Describes one measured configuration
+     */
+    class Measurement {
+      public:
+        /**
+         * Constructor
+         * @param name the operation's name
+         * @param create creates the operation
+         * @param size the message size
+         * @param count onion layers, hashed slices or verified proofs
+         * @param bytes bytes processed per operation
+         * @param hash the hash algorithm to select, empty for the default
+         */
+        Measurement(const QString &name, CreateOperation create, int size = 0,
+            int count = 0, qint64 bytes = -1, const QString &hash = QString()) :
+          name(name), create(create), size(size), count(count),
+          bytes(bytes == -1 ? size : bytes), hash(hash) {}
+
+        QString name;
+        CreateOperation create;
+        int size;
+        int count;
+        qint64 bytes;
+        QString hash;
+    };
+
+    QVariantMap Measure(const QString &library, const Measurement &m,
+        int threads, int msecs)
+    {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+
+      Hash::Algorithm algo = Hash::SHA1;
+      if(!m.hash.isEmpty() && (!Hash::AlgorithmFromString(m.hash, algo) ||
+            !lib->SetHashAlgorithm(algo)))
+      {
+        qCritical("Unsupported hash: %s", m.hash.toUtf8().data());
+        return QVariantMap();
+      }
+
+      // Fixtures are built before the clock starts
+      QList<OperationThread *> workers;
+      for(int idx = 0; idx < threads; idx++) {
+        workers.append(new OperationThread(m.create(lib, m.size, m.count),
+              msecs));
+      }
+      lib->SetHashAlgorithm(Hash::SHA1);
+
+      QTime timer;
+      timer.start();
+      foreach(OperationThread *worker, workers) {
+        worker->start();
+      }
+
+      qint64 ops = 0;
+      foreach(OperationThread *worker, workers) {
+        worker->wait();
+        ops += worker->count;
+      }
+      int elapsed = qMax(timer.elapsed(), 1);
+      qDeleteAll(workers);
+
+      double ops_per_sec = ops * 1000.0 / elapsed;
+      QVariantMap result;
+      result["benchmark"] = "crypto";
+      result["library"] = library;
+      result["operation"] = m.name;
+      result["threads"] = threads;
+      result["size"] = m.size;
+      result["count"] = m.count;
+      result["hash"] = m.hash;
+      result["ops"] = ops;
+      result["msecs"] = elapsed;
+      result["ops_per_sec"] = ops_per_sec;
+      result["mb_per_sec"] = ops_per_sec * m.bytes / (1024.0 * 1024.0);
+      return result;
+    }
+  }
+
+  QVariantList RunCryptoBenchmark(const QStringList &libraries,
+      const QList<int> &threads, const QList<int> &sizes,
+      const QList<int> &layers, const QStringList &hashes,
+      const QList<int> &commits, const QList<int> &proofs, int msecs)
+  {
+    QList<Measurement> measurements;
+    measurements.append(Measurement("dh_shared_secret",
+          &TCreateUnsized<SharedSecretOperation>));
+    measurements.append(Measurement("dh_prove_shared_secret",
+          &TCreateUnsized<ProveSharedSecretOperation>));
+    measurements.append(Measurement("dh_verify_shared_secret",
+          &TCreateUnsized<VerifySharedSecretOperation>));
+    foreach(int count, proofs) {
+      measurements.append(Measurement("dh_verify_shared_secrets",
+            &TCreateCounted<VerifySharedSecretsBatchOperation>, 0, count));
+      measurements.append(Measurement("dh_verify_shared_secrets_serial",
+            &TCreateCounted<VerifySharedSecretsSerialOperation>, 0, count));
+    }
+
+    foreach(int size, sizes) {
+      measurements.append(Measurement("sign",
+            &TCreateSized<SignOperation>, size));
+      measurements.append(Measurement("verify",
+            &TCreateSized<VerifyOperation>, size));
+      measurements.append(Measurement("encrypt",
+            &TCreateSized<EncryptOperation>, size));
+      measurements.append(Measurement("decrypt",
+            &TCreateSized<DecryptOperation>, size));
+      foreach(const QString &hash, hashes) {
+        measurements.append(Measurement("hash",
+              &TCreateSized<HashOperation>, size, 0, size, hash));
+        foreach(int count, commits) {
+          measurements.append(Measurement("hash_commits",
+                &TCreateCounted<HashCommitsBatchOperation>, size, count,
+                qint64(size) * count, hash));
+          measurements.append(Measurement("hash_commits_serial",
+                &TCreateCounted<HashCommitsSerialOperation>, size, count,
+                qint64(size) * count, hash));
+        }
+      }
+      measurements.append(Measurement("random",
+            &TCreateSized<RandomOperation>, size));
+      foreach(int count, layers) {
+        measurements.append(Measurement("onion_encrypt",
+              &TCreateCounted<OnionEncryptOperation>, size, count));
+        measurements.append(Measurement("onion_decrypt",
+              &TCreateCounted<OnionDecryptOperation>, size, count));
+      }
+    }
+
+    QVariantList results;
+    foreach(const QString &library, libraries) {
+      if(library == "null") {
+        CryptoFactory::GetInstance().SetLibrary(CryptoFactory::Null);
+      } else if(library == "cryptopp") {
+        CryptoFactory::GetInstance().SetLibrary(CryptoFactory::CryptoPP);
+      } else {
+        qCritical("Unknown crypto library: %s", library.toUtf8().data());
+        continue;
+      }
+
+      foreach(int count, threads) {
+        foreach(const Measurement &m, measurements) {
+          QVariantMap result = Measure(library, m, count, msecs);
+          if(!result.isEmpty()) {
+            results.append(result);
+          }
+        }
+      }
+    }
+
+    return results;
+  }
+
+  QString CryptoResultsTable(const QVariantList &results)
+  {
+    QString table;
+    QTextStream out(&table);
+    out << qSetFieldWidth(10) << left << "library" << "threads" <<
+      qSetFieldWidth(26) << "operation" << qSetFieldWidth(8) << "hash" <<
+      "size" << "count" << qSetFieldWidth(14) << right << "ops/s" << "MB/s" <<
+      qSetFieldWidth(0) << endl;
+
+    foreach(const QVariant &entry, results) {
+      QVariantMap row = entry.toMap();
+      out << qSetFieldWidth(10) << left << row["library"].toString() <<
+        row["threads"].toInt() << qSetFieldWidth(26) <<
+        row["operation"].toString() << qSetFieldWidth(8) <<
+        row["hash"].toString() << row["size"].toInt() << row["count"].toInt() <<
+        qSetFieldWidth(14) << right << fixed << qSetRealNumberPrecision(1) <<
+        row["ops_per_sec"].toDouble() << row["mb_per_sec"].toDouble() <<
+        qSetFieldWidth(0) << endl;
+    }
+
+    return table;
+  }
+}
+}
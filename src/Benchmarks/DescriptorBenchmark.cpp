@@ -0,0 +1,94 @@
+#include <QThreadPool>
+#include <QTime>
+
+#include "Tests/DissentTest.hpp"
+#include "Tests/TestNode.hpp"
+
+#include "Benchmarks.hpp"
+
+using namespace Dissent::Tests;
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * A BulkRound whose descriptor can be created without running a shuffle
+     */
+    class DescriptorRound : public BulkRound {
+      public:
+        explicit DescriptorRound(const Group &group, const Credentials &creds,
+            const Id &round_id, QSharedPointer<Network> net,
+            GetDataCallback &get_data) :
+          BulkRound(group, creds, round_id, net, get_data) {}
+
+        virtual ~DescriptorRound() {}
+
+        QByteArray Create(const QByteArray &data)
+        {
+          CreateDescriptor(data);
+          return GetMyDescriptor().CleartextHash();
+        }
+    };
+  }
+
+  QVariantMap RunDescriptorBenchmark(int count, const QList<int> &threads,
+      int length, int iterations)
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+
+    // Only the local member needs a network, the rest only a DH component
+    TestNode node(Id(), 0);
+    QVector<GroupContainer> roster;
+    roster.append(GetPublicComponents(node.creds));
+    for(int idx = 1; idx < count; idx++) {
+      QScopedPointer<DiffieHellman> dh(lib->CreateDiffieHellman());
+      roster.append(GroupContainer(Id(), Group::EmptyKey(),
+            dh->GetPublicComponent()));
+    }
+    Group group(roster);
+
+    QByteArray data(length, 0);
+    rand->GenerateBlock(data);
+
+    QVariantMap result;
+    result["benchmark"] = "descriptor";
+    result["group_size"] = count;
+    result["length"] = length;
+    result["iterations"] = iterations;
+
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    const CryptoFactory::ThreadingType threading = cf.GetThreadingType();
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int max_threads = pool->maxThreadCount();
+
+    // A new round each time, so no secrets are carried over
+    cf.SetThreading(CryptoFactory::SingleThreaded);
+    QTime timer;
+    timer.start();
+    for(int idx = 0; idx < iterations; idx++) {
+      DescriptorRound round(group, node.creds, Id(), node.net,
+          EmptyGetDataCallback::GetInstance());
+      round.Create(data);
+    }
+    result["serial_msecs"] = double(timer.elapsed()) / iterations;
+
+    cf.SetThreading(CryptoFactory::MultiThreaded);
+    foreach(int thread_count, threads) {
+      pool->setMaxThreadCount(thread_count);
+      timer.restart();
+      for(int idx = 0; idx < iterations; idx++) {
+        DescriptorRound round(group, node.creds, Id(), node.net,
+            EmptyGetDataCallback::GetInstance());
+        round.Create(data);
+      }
+      result[QString("threads_%1_msecs").arg(thread_count)] =
+        double(timer.elapsed()) / iterations;
+    }
+
+    pool->setMaxThreadCount(max_threads);
+    cf.SetThreading(threading);
+    return result;
+  }
+}
+}
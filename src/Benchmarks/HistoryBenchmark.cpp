@@ -0,0 +1,114 @@
+#include <ctime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+using Dissent::Anonymity::Tolerant::MessageHistory;
+using Dissent::Utils::AllocationCounter;
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    double Seconds(clock_t start)
+    {
+      return double(clock() - start) / CLOCKS_PER_SEC;
+    }
+
+    /**
+     * The history as it was kept before MessageHistory referenced whole
+     * messages: every slot of every message copied out, per phase
+     */
+    class CopyingHistory {
+      public:
+        CopyingHistory(int users) : _user_data(users), _server_data(users) {}
+
+        void AddPhase(uint phase, const QVector<uint> &slot_offsets,
+            int slot_length, const QVector<QByteArray> &user_messages,
+            const QVector<QByteArray> &server_messages)
+        {
+          for(int slot = 0; slot < slot_offsets.count(); slot++) {
+            QVector<QByteArray> &users = _user_data[slot][phase];
+            users.resize(user_messages.count());
+            for(int idx = 0; idx < user_messages.count(); idx++) {
+              users[idx] = user_messages[idx].mid(slot_offsets[slot], slot_length);
+            }
+
+            QVector<QByteArray> &servers = _server_data[slot][phase];
+            servers.resize(server_messages.count());
+            for(int idx = 0; idx < server_messages.count(); idx++) {
+              servers[idx] = server_messages[idx].mid(slot_offsets[slot], slot_length);
+            }
+          }
+        }
+
+        void NextPhase()
+        {
+          for(int slot = 0; slot < _user_data.count(); slot++) {
+            _user_data[slot].clear();
+            _server_data[slot].clear();
+          }
+        }
+
+      private:
+        QVector<QHash<uint, QVector<QByteArray> > > _user_data;
+        QVector<QHash<uint, QVector<QByteArray> > > _server_data;
+    };
+  }
+
+  QVariantMap RunHistoryBenchmark(int users, int servers, int slot_length,
+      int phases)
+  {
+    QVector<uint> offsets(users);
+    for(int slot = 0; slot < users; slot++) {
+      offsets[slot] = slot * slot_length;
+    }
+
+    // One set of messages, shared by every phase, so that only the history
+    // allocates while it is measured
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+    QVector<QByteArray> user_msgs(users, QByteArray(users * slot_length, 0));
+    for(int idx = 0; idx < users; idx++) {
+      rand->GenerateBlock(user_msgs[idx]);
+    }
+    QVector<QByteArray> server_msgs(servers, QByteArray(users * slot_length, 0));
+    for(int idx = 0; idx < servers; idx++) {
+      rand->GenerateBlock(server_msgs[idx]);
+    }
+
+    MessageHistory history(users, servers);
+    int allocs = AllocationCounter::Count();
+    clock_t start = clock();
+    for(int phase = 0; phase < phases; phase++) {
+      history.AddPhase(phase, offsets, user_msgs, server_msgs);
+      history.NextPhase();
+    }
+    double history_time = Seconds(start);
+    int history_allocs = AllocationCounter::Count() - allocs;
+
+    CopyingHistory copying(users);
+    allocs = AllocationCounter::Count();
+    start = clock();
+    for(int phase = 0; phase < phases; phase++) {
+      copying.AddPhase(phase, offsets, slot_length, user_msgs, server_msgs);
+      copying.NextPhase();
+    }
+    double copy_time = Seconds(start);
+    int copy_allocs = AllocationCounter::Count() - allocs;
+
+    QVariantMap result;
+    result["benchmark"] = "history";
+    result["users"] = users;
+    result["servers"] = servers;
+    result["slot_length"] = slot_length;
+    result["phases"] = phases;
+    result["allocations_counted"] = AllocationCounter::Enabled();
+    result["history_allocs_per_phase"] = double(history_allocs) / phases;
+    result["history_usecs_per_phase"] = history_time * 1e6 / phases;
+    result["copy_allocs_per_phase"] = double(copy_allocs) / phases;
+    result["copy_usecs_per_phase"] = copy_time * 1e6 / phases;
+    return result;
+  }
+}
+}
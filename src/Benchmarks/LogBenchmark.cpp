@@ -0,0 +1,110 @@
+#include <QDataStream>
+#include <QTime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * Average microseconds per iteration for a timer started before the loop
+     */
+    double USecs(const QTime &timer, int iterations)
+    {
+      return timer.elapsed() * 1000.0 / iterations;
+    }
+  }
+
+  QVariantMap RunLogBenchmark(int entries, int msg_size, int iterations)
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+
+    // A group of senders, each message half random and half zero padding
+    QVector<Id> senders;
+    for(int idx = 0; idx < 10; idx++) {
+      senders.append(Id());
+    }
+
+    Log log;
+    QVector<QPair<QByteArray, Id> > legacy;
+    for(int idx = 0; idx < entries; idx++) {
+      QByteArray msg(msg_size, 0);
+      QByteArray noise(msg_size / 2, 0);
+      rand->GenerateBlock(noise);
+      msg.replace(0, noise.size(), noise);
+      log.Append(msg, senders[idx % senders.count()]);
+      legacy.append(QPair<QByteArray, Id>(msg, senders[idx % senders.count()]));
+    }
+
+    QVariantMap result;
+    result["benchmark"] = "log";
+    result["entries"] = entries;
+    result["message_size"] = msg_size;
+    result["iterations"] = iterations;
+
+    // The QDataStream of entries the log used to be sent as
+    QByteArray data;
+    QTime timer;
+    timer.start();
+    for(int idx = 0; idx < iterations; idx++) {
+      data.clear();
+      QDataStream stream(&data, QIODevice::WriteOnly);
+      stream << legacy;
+    }
+    result["legacy_bytes"] = data.size();
+    result["legacy_serialize_usecs"] = USecs(timer, iterations);
+
+    timer.restart();
+    for(int idx = 0; idx < iterations; idx++) {
+      QVector<QPair<QByteArray, Id> > parsed;
+      QDataStream stream(data);
+      stream >> parsed;
+    }
+    result["legacy_parse_usecs"] = USecs(timer, iterations);
+
+    const char *modes[] = { "indexed", "compressed" };
+    for(int mode = 0; mode < 2; mode++) {
+      const QString prefix = QString(modes[mode]) + "_";
+      timer.restart();
+      for(int idx = 0; idx < iterations; idx++) {
+        data = log.Serialize(mode == 1);
+      }
+      result[prefix + "bytes"] = data.size();
+      result[prefix + "serialize_usecs"] = USecs(timer, iterations);
+
+      timer.restart();
+      for(int idx = 0; idx < iterations; idx++) {
+        Log parsed(data);
+      }
+      result[prefix + "parse_usecs"] = USecs(timer, iterations);
+    }
+
+    // A blame request for one entry in a hundred
+    QVector<int> indices;
+    for(int idx = 0; idx < entries; idx += 100) {
+      indices.append(idx);
+    }
+    const QByteArray digest = log.GetDigest();
+
+    timer.restart();
+    for(int idx = 0; idx < iterations; idx++) {
+      data = log.Serialize(indices);
+    }
+    result["partial_entries"] = indices.count();
+    result["partial_bytes"] = data.size();
+    result["partial_serialize_usecs"] = USecs(timer, iterations);
+
+    bool verified = true;
+    timer.restart();
+    for(int idx = 0; idx < iterations; idx++) {
+      verified = Log(data).GetDigest() == digest && verified;
+    }
+    result["partial_verify_usecs"] = USecs(timer, iterations);
+    result["partial_verified"] = verified;
+    return result;
+  }
+}
+}
@@ -0,0 +1,56 @@
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QTime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+  QVariantMap RunLoggingBenchmark(int lines, int msg_size)
+  {
+    const QByteArray msg(msg_size, 'x');
+
+    QVariantMap result;
+    result["benchmark"] = "logging";
+    result["lines"] = lines;
+    result["message_size"] = msg_size;
+
+    const char *modes[] = { "file", "async_file" };
+    for(int mode = 0; mode < 2; mode++) {
+      QTemporaryFile file;
+      if(!file.open()) {
+        qFatal("Unable to create a temporary log file");
+      }
+
+      if(mode == 0) {
+        Logging::UseFile(file.fileName());
+      } else {
+        Logging::UseAsyncFile(file.fileName());
+      }
+
+      // Handed to the installed handler as qDebug() would, the benchmarks
+      // are built with debug and warning output compiled out
+      QTime timer;
+      timer.start();
+      for(int idx = 0; idx < lines; idx++) {
+        qt_message_output(QtDebugMsg, msg.constData());
+      }
+      int caller_msecs = timer.elapsed();
+      Logging::FlushAsync();
+      int total_msecs = timer.elapsed();
+      int dropped = Logging::AsyncDropped();
+      Logging::Disable();
+
+      const QString prefix = QString(modes[mode]) + "_";
+      result[prefix + "caller_usecs_per_line"] = caller_msecs * 1000.0 / lines;
+      result[prefix + "lines_per_sec"] = total_msecs > 0 ?
+        (lines - dropped) * 1000.0 / total_msecs : 0.0;
+      result[prefix + "dropped"] = dropped;
+      result[prefix + "bytes"] = QFileInfo(file.fileName()).size();
+    }
+    return result;
+  }
+}
+}
@@ -0,0 +1,545 @@
+#include <ctime>
+
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "json.h"
+
+#include "Tests/DissentTest.hpp"
+#include "Tests/TestNode.hpp"
+
+#include "Benchmarks.hpp"
+
+using namespace Dissent::Tests;
+
+namespace Dissent {
+namespace Benchmarks {
+  /**
+   * Round types the benchmark knows how to instantiate
+   */
+  QHash<QString, CreateSessionCallback> GetRoundTypes()
+  {
+    QHash<QString, CreateSessionCallback> types;
+    types["null"] = &TCreateSession<NullRound>;
+    types["shuffle"] = &TCreateSession<ShuffleRound>;
+    types["bulk"] = &TCreateSession<BulkRound>;
+    types["repeatingbulk"] = &TCreateSession<RepeatingBulkRound>;
+    types["aggregatedbulk"] = &TCreateSession<AggregatedBulkRound>;
+    types["tolerantbulk"] = &TCreateSession<TolerantBulkRound>;
+    types["toleranttree"] = &TCreateSession<TolerantTreeRound>;
+    return types;
+  }
+
+  /**
+   * A ShuffleRound whose cell size and count are set at run time, so cell
+   * sizes can be compared without a CellShuffleRound for each
+   */
+  class ConfiguredShuffleRound : public ShuffleRound {
+    public:
+      explicit ConfiguredShuffleRound(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> net, GetDataCallback &get_data) :
+        ShuffleRound(group, creds, round_id, net, get_data, CellSize, Cells)
+      {
+      }
+
+      virtual ~ConfiguredShuffleRound() {}
+
+      static int CellSize;
+      static int Cells;
+  };
+
+  int ConfiguredShuffleRound::CellSize = ShuffleRound::BlockSize;
+  int ConfiguredShuffleRound::Cells = 1;
+
+  /**
+   * Upper bound on the virtual time spent in a single iteration
+   */
+  static const qint64 MaxIterationMSecs = 3600 * 1000;
+
+  /**
+   * Returns the value at quantile q of a sorted list
+   */
+  qint64 Quantile(const QList<qint64> &sorted, double q)
+  {
+    if(sorted.isEmpty()) {
+      return 0;
+    }
+    int idx = qMin(sorted.count() - 1, static_cast<int>(q * sorted.count()));
+    return sorted[idx];
+  }
+
+  /**
+   * Runs a single configuration to completion on virtual time: builds the
+   * overlay, then sends iterations messages from random members, each
+   * iteration completing when every member either received the message or
+   * finished a round.  The overlay construction is excluded from the
+   * measurement.
+   * @param type name of the round
+   * @param callback creates the session for that round
+   * @param count number of group members
+   * @param msg_size size of each anonymous message in bytes
+   * @param iterations number of messages to push through the group
+   * @param straggler_delay if positive, one member other than the leader
+   * sends all of its messages this many ms late and is not waited on
+   */
+  QVariantMap RunBenchmark(const QString &type, CreateSessionCallback callback,
+      int count, int msg_size, int iterations, int straggler_delay)
+  {
+    Timer::GetInstance().UseVirtualTime();
+    SimNetwork::GetInstance().Reset();
+
+    QVector<TestNode *> nodes;
+    Group group;
+    ConstructOverlay(count, nodes, group, Group::FixedSubgroup);
+    CreateSessions(nodes, group, Id(), callback);
+
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+
+    int straggler = -1;
+    if(straggler_delay > 0) {
+      do {
+        straggler = rand->GetInt(0, count);
+      } while(nodes[straggler]->cm.GetId() == group.GetLeader());
+      DelayNode(nodes[straggler], straggler_delay);
+    }
+    const int waiting = straggler == -1 ? count : count - 1;
+
+    SignalCounter sc;
+    for(int idx = 0; idx < count; idx++) {
+      if(idx == straggler) {
+        continue;
+      }
+      QObject::connect(&nodes[idx]->sink, SIGNAL(DataReceived()), &sc, SLOT(Counter()));
+    }
+
+    const quint64 start_bytes = BufferEdge::BytesSent;
+    const quint64 start_packets = BufferEdge::PacketsSent;
+    const int start_allocs = AllocationCounter::Count();
+    const quint64 start_copied = Round::BytesCopied;
+    const qint64 start_vtime = Time::GetInstance().MSecsSinceEpoch();
+    const clock_t start_cpu = clock();
+
+    QByteArray msg(msg_size, 0);
+    rand->GenerateBlock(msg);
+    int sender = rand->GetInt(0, count);
+    while(sender == straggler) {
+      sender = rand->GetInt(0, count);
+    }
+    nodes[sender]->session->Send(msg);
+
+    for(int idx = 0; idx < count; idx++) {
+      nodes[idx]->session->Start();
+    }
+
+    TestNode::calledback = TestNode::failure = TestNode::success = 0;
+    int completed = 0;
+    int steady_allocs = 0;
+    QList<qint64> latencies;
+    for(; completed < iterations; completed++) {
+      if(completed == 1) {
+        // Later phases run with warm buffers and RNG streams
+        steady_allocs = AllocationCounter::Count();
+      }
+
+      if(completed > 0) {
+        rand->GenerateBlock(msg);
+        do {
+          sender = rand->GetInt(0, count);
+        } while(sender == straggler);
+        nodes[sender]->session->Send(msg);
+      }
+
+      const qint64 start = Time::GetInstance().MSecsSinceEpoch();
+      const int target = waiting * (completed + 1);
+      qint64 next = Timer::GetInstance().VirtualRun();
+      while(next != -1 && sc.GetCount() < target &&
+          TestNode::calledback < count * (completed + 1) &&
+          Time::GetInstance().MSecsSinceEpoch() - start < MaxIterationMSecs)
+      {
+        Time::GetInstance().IncrementVirtualClock(next);
+        next = Timer::GetInstance().VirtualRun();
+      }
+
+      latencies.append(Time::GetInstance().MSecsSinceEpoch() - start);
+      if(next == -1 || latencies.last() >= MaxIterationMSecs) {
+        break;
+      }
+    }
+    qSort(latencies);
+    steady_allocs = AllocationCounter::Count() - steady_allocs;
+
+    const double cpu = double(clock() - start_cpu) / CLOCKS_PER_SEC;
+
+    QVariantMap result;
+    result["round"] = type;
+    result["group_size"] = count;
+    result["message_size"] = msg_size;
+    result["phases"] = completed;
+    result["cpu_seconds"] = cpu;
+    result["virtual_msecs"] = Time::GetInstance().MSecsSinceEpoch() - start_vtime;
+    result["bytes_on_wire"] = BufferEdge::BytesSent - start_bytes;
+    result["packets_on_wire"] = BufferEdge::PacketsSent - start_packets;
+    result["allocations"] = AllocationCounter::Count() - start_allocs;
+    result["allocations_counted"] = AllocationCounter::Enabled();
+    result["bytes_copied_per_phase"] = completed > 0 ?
+      qint64(Round::BytesCopied - start_copied) / completed : 0;
+    result["steady_allocations_per_phase"] = completed > 1 ?
+      steady_allocs / (completed - 1) : 0;
+    result["phases_per_sec"] = cpu > 0 ? completed / cpu : 0.0;
+    result["failures"] = TestNode::failure;
+    result["straggler_delay"] = straggler_delay;
+    result["phase_msecs_p50"] = Quantile(latencies, 0.5);
+    result["phase_msecs_p99"] = Quantile(latencies, 0.99);
+    result["phase_msecs_max"] = latencies.isEmpty() ? 0 : latencies.last();
+
+    if(TestNode::Simulated) {
+      SimNetwork &network = SimNetwork::GetInstance();
+      qint64 cpu_max = 0;
+      for(int idx = 1; idx <= count; idx++) {
+        cpu_max = qMax(cpu_max, network.GetCpuTime(idx));
+      }
+      result["sim_messages"] = network.GetMessagesSent();
+      result["sim_bytes"] = network.GetBytesSent();
+      result["sim_retransmissions"] = network.GetRetransmissions();
+      result["sim_node_cpu_msecs_max"] = cpu_max / 1000;
+    }
+
+    if(straggler != -1) {
+      DelayNode(nodes[straggler], 0);
+    }
+
+    CleanUp(nodes);
+    return result;
+  }
+
+  /**
+   * Parses a comma separated list of integers, falling back to a default
+   */
+  QList<int> ParseIntList(const QString &value, const QList<int> &def)
+  {
+    if(value.isEmpty()) {
+      return def;
+    }
+
+    QList<int> values;
+    foreach(const QString &entry, value.split(",", QString::SkipEmptyParts)) {
+      bool ok;
+      int ivalue = entry.toInt(&ok);
+      if(ok && ivalue > 0) {
+        values.append(ivalue);
+      }
+    }
+    return values.isEmpty() ? def : values;
+  }
+}
+}
+
+using namespace Dissent::Benchmarks;
+
+/**
+ * Usage: bench [--rounds=null,bulk,...] [--sizes=5,10,20]
+ *   [--messages=128,1024] [--iterations=N] [--crypto=null|cryptopp]
+ *   [--hash=sha1|sha256|sha512|blake2b]
+ *   [--straggler=ms] [--deadline=ms]
+ *   [--simulate [--latency=ms] [--jitter=ms] [--bandwidth=bytes/ms]
+ *     [--loss=p] [--regions=N --remote-latency=ms] [--sign-cost=us]
+ *     [--verify-cost=us] [--dh-cost=us] [--encrypt-cost=us]
+ *     [--decrypt-cost=us]]
+ *        bench --suite=timers [--timers=N] [--span=ms]
+ *        bench --suite=blame [--users=N] [--servers=N] [--conflicts=N]
+ *          [--iterations=N]
+ *        bench --suite=history [--users=N] [--servers=N] [--length=bytes]
+ *          [--phases=N]
+ *        bench --suite=shuffleblame [--nodes=N] [--iterations=N]
+ *        bench --suite=log [--entries=N] [--messages=128,1024]
+ *          [--iterations=N]
+ *        bench --suite=logging [--lines=N] [--messages=64,256]
+ *        bench --suite=bulkxor [--members=N] [--descriptors=N]
+ *          [--length=bytes] [--iterations=N]
+ *        bench --suite=descriptor [--nodes=N] [--threads=1,2,4,8]
+ *          [--length=bytes] [--iterations=N]
+ *        bench --suite=cells [--nodes=N] [--cells=64,256,1024,4096]
+ *          [--messages=bytes] [--iterations=N]
+ *        bench --suite=crypto [--libraries=cryptopp,null] [--threads=1,4]
+ *          [--sizes=64,1024] [--layers=1,4,16] [--hashes=sha1,sha256]
+ *          [--commits=500] [--proofs=48] [--key-size=bits]
+ *          [--msecs=ms] [--format=table]
+ * Emits a JSON array with one object per configuration on stdout.
+ */
+int main(int argc, char **argv)
+{
+  QCoreApplication qca(argc, argv);
+  QStringList args = QCoreApplication::arguments();
+
+  QHash<QString, QString> options;
+  for(int idx = 1; idx < args.count(); idx++) {
+    QString arg = args[idx];
+    if(!arg.startsWith("--")) {
+      continue;
+    }
+    int eq = arg.indexOf('=');
+    if(eq == -1) {
+      options[arg.mid(2)] = QString();
+    } else {
+      options[arg.mid(2, eq - 2)] = arg.mid(eq + 1);
+    }
+  }
+
+  CryptoFactory::GetInstance().SetThreading(CryptoFactory::MultiThreaded);
+  if(options.value("crypto") == "null") {
+    CryptoFactory::GetInstance().SetLibrary(CryptoFactory::Null);
+  }
+
+  if(options.contains("hash")) {
+    Hash::Algorithm algo;
+    if(!Hash::AlgorithmFromString(options.value("hash"), algo) ||
+        !CryptoFactory::GetInstance().GetLibrary()->SetHashAlgorithm(algo))
+    {
+      qFatal("Unsupported hash: %s", options.value("hash").toUtf8().data());
+    }
+  }
+  Dissent::Crypto::AsymmetricKey::DefaultKeySize = 512;
+  Logging::Disable();
+
+  QVariantList results;
+  QTextStream out(stdout);
+
+  if(options.value("suite") == "timers") {
+    int timers = ParseIntList(options.value("timers"),
+        QList<int>() << 1000 * 1000).first();
+    int span = ParseIntList(options.value("span"),
+        QList<int>() << 600 * 1000).first();
+    results.append(RunTimerBenchmark(timers, span));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "blame") {
+    int users = ParseIntList(options.value("users"),
+        QList<int>() << 10000).first();
+    int servers = ParseIntList(options.value("servers"),
+        QList<int>() << 100).first();
+    int conflicts = ParseIntList(options.value("conflicts"),
+        QList<int>() << 10).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 100).first();
+    results.append(RunBlameBenchmark(users, servers, conflicts, iterations));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "history") {
+    int users = ParseIntList(options.value("users"),
+        QList<int>() << 100).first();
+    int servers = ParseIntList(options.value("servers"),
+        QList<int>() << 10).first();
+    int length = ParseIntList(options.value("length"),
+        QList<int>() << 128).first();
+    int phases = ParseIntList(options.value("phases"),
+        QList<int>() << 100).first();
+    results.append(RunHistoryBenchmark(users, servers, length, phases));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "shuffleblame") {
+    int nodes = ParseIntList(options.value("nodes"),
+        QList<int>() << 100).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 3).first();
+    results.append(RunShuffleBlameBenchmark(nodes, iterations));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "log") {
+    int entries = ParseIntList(options.value("entries"),
+        QList<int>() << 1000).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 100).first();
+    foreach(int msg_size, ParseIntList(options.value("messages"),
+          QList<int>() << 128 << 1024))
+    {
+      results.append(RunLogBenchmark(entries, msg_size, iterations));
+    }
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "logging") {
+    int lines = ParseIntList(options.value("lines"),
+        QList<int>() << 100000).first();
+    foreach(int msg_size, ParseIntList(options.value("messages"),
+          QList<int>() << 64 << 256))
+    {
+      results.append(RunLoggingBenchmark(lines, msg_size));
+    }
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "bulkxor") {
+    int members = ParseIntList(options.value("members"),
+        QList<int>() << 10).first();
+    int descriptors = ParseIntList(options.value("descriptors"),
+        QList<int>() << 100).first();
+    int length = ParseIntList(options.value("length"),
+        QList<int>() << 64 * 1024).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 3).first();
+    results.append(RunBulkXorBenchmark(members, descriptors, length,
+          iterations));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "descriptor") {
+    int nodes = ParseIntList(options.value("nodes"),
+        QList<int>() << 200).first();
+    QList<int> threads = ParseIntList(options.value("threads"),
+        QList<int>() << 1 << 2 << 4 << 8);
+    int length = ParseIntList(options.value("length"),
+        QList<int>() << 1024).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 3).first();
+    results.append(RunDescriptorBenchmark(nodes, threads, length,
+          iterations));
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "cells") {
+    int nodes = ParseIntList(options.value("nodes"),
+        QList<int>() << 10).first();
+    int msg_size = ParseIntList(options.value("messages"),
+        QList<int>() << 4096).first();
+    int iterations = ParseIntList(options.value("iterations"),
+        QList<int>() << 3).first();
+    foreach(int cell_size, ParseIntList(options.value("cells"),
+          QList<int>() << 64 << 256 << 1024 << 4096))
+    {
+      // Just enough cells to carry the message
+      ConfiguredShuffleRound::CellSize = cell_size;
+      ConfiguredShuffleRound::Cells = (msg_size + cell_size - 1) / cell_size;
+
+      QVariantMap result = RunBenchmark("shuffle",
+          &TCreateSession<ConfiguredShuffleRound>, nodes, msg_size,
+          iterations, 0);
+      const double cpu = result["cpu_seconds"].toDouble();
+      result["cell_size"] = cell_size;
+      result["cells"] = ConfiguredShuffleRound::Cells;
+      result["payload_bytes_per_sec"] = cpu > 0 ?
+        msg_size * result["phases"].toInt() / cpu : 0.0;
+      results.append(result);
+    }
+    out << QtJson::Json::serialize(results) << endl;
+    return 0;
+  }
+
+  if(options.value("suite") == "crypto") {
+    // Threads are controlled by the benchmark, not the onion encryptor
+    CryptoFactory::GetInstance().SetThreading(CryptoFactory::SingleThreaded);
+    Dissent::Crypto::AsymmetricKey::DefaultKeySize = ParseIntList(
+        options.value("key-size"), QList<int>() << 1024).first();
+
+    QStringList libraries = options.value("libraries", "cryptopp,null").split(
+        ",", QString::SkipEmptyParts);
+    QList<int> threads = ParseIntList(options.value("threads"),
+        QList<int>() << 1 << QThread::idealThreadCount());
+    QList<int> sizes = ParseIntList(options.value("sizes"),
+        QList<int>() << 64 << 1024);
+    QList<int> layers = ParseIntList(options.value("layers"),
+        QList<int>() << 1 << 4 << 16);
+    QStringList hashes = options.value("hashes", "sha1").split(",",
+        QString::SkipEmptyParts);
+    QList<int> commits = ParseIntList(options.value("commits"),
+        QList<int>() << 500);
+    QList<int> proofs = ParseIntList(options.value("proofs"),
+        QList<int>() << 48);
+    int msecs = ParseIntList(options.value("msecs"),
+        QList<int>() << 1000).first();
+
+    results = RunCryptoBenchmark(libraries, threads, sizes, layers, hashes,
+        commits, proofs, msecs);
+    if(options.value("format") == "table") {
+      out << CryptoResultsTable(results);
+    } else {
+      out << QtJson::Json::serialize(results) << endl;
+    }
+    return 0;
+  }
+
+  QHash<QString, CreateSessionCallback> types = GetRoundTypes();
+  QStringList rounds = options.value("rounds").split(",", QString::SkipEmptyParts);
+  if(rounds.isEmpty()) {
+    rounds << "null" << "shuffle" << "bulk" << "repeatingbulk" <<
+      "tolerantbulk" << "toleranttree";
+  }
+
+  QList<int> sizes = ParseIntList(options.value("sizes"),
+      QList<int>() << 5 << 10 << 20);
+  QList<int> msg_sizes = ParseIntList(options.value("messages"),
+      QList<int>() << 128 << 1024);
+  int iterations = ParseIntList(options.value("iterations"),
+      QList<int>() << 5).first();
+  int straggler_delay = options.value("straggler").toInt();
+
+  int deadline = options.value("deadline").toInt();
+  RepeatingBulkRound::DefaultPhaseDeadline = deadline;
+  TolerantBulkRound::DefaultPhaseDeadline = deadline;
+
+  if(options.contains("simulate")) {
+    TestNode::Simulated = true;
+    SimNetwork &network = SimNetwork::GetInstance();
+    SimLink local(options.value("latency", "10").toInt(),
+        options.value("jitter").toInt(), options.value("bandwidth").toInt(),
+        options.value("loss").toDouble());
+
+    int regions = options.value("regions").toInt();
+    if(regions > 1) {
+      SimLink remote = local;
+      remote.latency = options.value("remote-latency", "50").toInt();
+      network.SetTopology(QSharedPointer<SimTopology>(
+            new RegionTopology(regions, local, remote)));
+    } else {
+      network.SetTopology(QSharedPointer<SimTopology>(
+            new UniformTopology(local)));
+    }
+
+    if(options.contains("sign-cost")) {
+      network.SetCost(CryptoCost::Sign, options.value("sign-cost").toInt());
+    }
+    if(options.contains("verify-cost")) {
+      network.SetCost(CryptoCost::Verify, options.value("verify-cost").toInt());
+    }
+    if(options.contains("dh-cost")) {
+      network.SetCost(CryptoCost::SharedSecret, options.value("dh-cost").toInt());
+    }
+    if(options.contains("encrypt-cost")) {
+      network.SetCost(CryptoCost::Encrypt, options.value("encrypt-cost").toInt());
+    }
+    if(options.contains("decrypt-cost")) {
+      network.SetCost(CryptoCost::Decrypt, options.value("decrypt-cost").toInt());
+    }
+  }
+
+  foreach(const QString &round, rounds) {
+    if(!types.contains(round)) {
+      qCritical("Unknown round type: %s", round.toUtf8().data());
+      return -1;
+    }
+
+    foreach(int size, sizes) {
+      foreach(int msg_size, msg_sizes) {
+        results.append(RunBenchmark(round, types[round], size, msg_size,
+              iterations, straggler_delay));
+      }
+    }
+  }
+
+  out << QtJson::Json::serialize(results) << endl;
+  return 0;
+}
@@ -0,0 +1,168 @@
+#include <QTime>
+
+#include "Anonymity/ShuffleBlamer.hpp"
+
+#include "Tests/DissentTest.hpp"
+#include "Tests/ShuffleRoundHelpers.hpp"
+#include "Tests/TestNode.hpp"
+
+#include "Benchmarks.hpp"
+
+using namespace Dissent::Tests;
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * A ShuffleRound that, instead of running the blamer itself, keeps a copy
+     * of the first blame data it sees and finishes the round
+     */
+    class BlameCaptureRound : public ShuffleRound {
+      public:
+        explicit BlameCaptureRound(const Group &group,
+            const Credentials &creds, const Id &round_id,
+            QSharedPointer<Network> net, GetDataCallback &get_data) :
+          ShuffleRound(group, creds, round_id, net, get_data) {}
+
+        virtual ~BlameCaptureRound() {}
+
+        static bool Captured;
+        static Group CapturedGroup;
+        static Id CapturedRoundId;
+        static QVector<Log> CapturedLogs;
+        static QVector<QByteArray> CapturedKeys;
+
+      protected:
+        virtual void BlameRound()
+        {
+          if(!Captured) {
+            Captured = true;
+            CapturedGroup = GetGroup();
+            CapturedRoundId = GetRoundId();
+            CapturedLogs = _logs;
+            CapturedKeys.clear();
+            foreach(AsymmetricKey *key, _private_outer_keys) {
+              CapturedKeys.append(key ? key->GetByteArray() : QByteArray());
+            }
+          }
+
+          SetState(Finished);
+          Stop("Blame data captured");
+        }
+    };
+
+    bool BlameCaptureRound::Captured = false;
+    Group BlameCaptureRound::CapturedGroup;
+    Id BlameCaptureRound::CapturedRoundId;
+    QVector<Log> BlameCaptureRound::CapturedLogs;
+    QVector<QByteArray> BlameCaptureRound::CapturedKeys;
+
+    /**
+     * Runs the blamer over the captured data, returning the bad members
+     */
+    QVector<int> RunBlamer(const QVector<AsymmetricKey *> &keys)
+    {
+      ShuffleBlamer blamer(BlameCaptureRound::CapturedGroup,
+          BlameCaptureRound::CapturedRoundId, BlameCaptureRound::CapturedLogs,
+          keys);
+      blamer.Start();
+
+      QVector<int> bad;
+      for(int idx = 0; idx < blamer.GetBadNodes().count(); idx++) {
+        if(blamer.GetBadNodes().testBit(idx)) {
+          bad.append(idx);
+        }
+      }
+      return bad;
+    }
+  }
+
+  QVariantMap RunShuffleBlameBenchmark(int count, int iterations)
+  {
+    Timer::GetInstance().UseVirtualTime();
+    SimNetwork::GetInstance().Reset();
+    BlameCaptureRound::Captured = false;
+
+    QVector<TestNode *> nodes;
+    Group group;
+    ConstructOverlay(count, nodes, group, Group::CompleteGroup);
+
+    Id session_id;
+    CreateSessions(nodes, group, session_id,
+        &TCreateSession<BlameCaptureRound>);
+
+    // Any shuffler but the leader replaces a ciphertext while shuffling
+    Group egroup = group;
+    group = BuildGroup(nodes, group);
+    int leader = group.GetIndex(group.GetLeader());
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator());
+    int badguy = rand->GetInt(0, count);
+    while(badguy == leader) {
+      badguy = rand->GetInt(0, count);
+    }
+    CreateSession(nodes[badguy], egroup, session_id,
+        &TCreateSession<ShuffleRoundMessageSwitcher<1> >);
+
+    QByteArray msg(128, 0);
+    rand->GenerateBlock(msg);
+    nodes[(badguy + 1) % count]->session->Send(msg);
+
+    QTime timer;
+    timer.start();
+    for(int idx = 0; idx < count; idx++) {
+      nodes[idx]->session->Start();
+    }
+
+    qint64 next = Timer::GetInstance().VirtualRun();
+    while(next != -1 && !BlameCaptureRound::Captured) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+    }
+    const int round_msecs = timer.elapsed();
+
+    QVariantMap result;
+    result["benchmark"] = "shuffleblame";
+    result["group_size"] = count;
+    result["bad_member"] = badguy;
+    result["iterations"] = iterations;
+    result["round_msecs"] = round_msecs;
+
+    if(!BlameCaptureRound::Captured) {
+      qWarning() << "The bad shuffler never caused blame";
+      CleanUp(nodes);
+      return result;
+    }
+
+    QVector<AsymmetricKey *> keys;
+    foreach(const QByteArray &key, BlameCaptureRound::CapturedKeys) {
+      keys.append(key.isEmpty() ? 0 : lib->LoadPrivateKeyFromByteArray(key));
+    }
+
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    const CryptoFactory::ThreadingType threading = cf.GetThreadingType();
+    const char *modes[] = { "serial", "parallel" };
+    const CryptoFactory::ThreadingType types[] = {
+      CryptoFactory::SingleThreaded, CryptoFactory::MultiThreaded };
+
+    for(int mode = 0; mode < 2; mode++) {
+      cf.SetThreading(types[mode]);
+      QVector<int> bad;
+      timer.restart();
+      for(int idx = 0; idx < iterations; idx++) {
+        bad = RunBlamer(keys);
+      }
+      const QString prefix = QString(modes[mode]) + "_";
+      result[prefix + "blame_msecs"] = double(timer.elapsed()) / iterations;
+      result[prefix + "found"] = bad.count() == 1 && bad[0] == badguy;
+    }
+    cf.SetThreading(threading);
+
+    foreach(AsymmetricKey *key, keys) {
+      delete key;
+    }
+    CleanUp(nodes);
+    return result;
+  }
+}
+}
@@ -0,0 +1,89 @@
+#include <ctime>
+
+#include "Tests/DissentTest.hpp"
+
+#include "Benchmarks.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+  namespace {
+    /**
+     * Callback target that only counts invocations
+     */
+    class TimerCounter {
+      public:
+        TimerCounter() : count(0) {}
+
+        void Fire(const int &)
+        {
+          count++;
+        }
+
+        int count;
+    };
+
+    double Seconds(clock_t start)
+    {
+      return double(clock() - start) / CLOCKS_PER_SEC;
+    }
+
+    double NanosPerOp(double seconds, int ops)
+    {
+      return ops > 0 ? seconds * 1e9 / ops : 0.0;
+    }
+  }
+
+  QVariantMap RunTimerBenchmark(int count, int span)
+  {
+    Timer &timer = Timer::GetInstance();
+    timer.UseVirtualTime();
+    timer.Clear();
+    Time &time = Time::GetInstance();
+    qsrand(1);
+
+    TimerCounter counter;
+    QVector<TimerEvent> events;
+    events.reserve(count);
+
+    clock_t start = clock();
+    for(int idx = 0; idx < count; idx++) {
+      events.append(timer.QueueCallback(
+            new TimerMethod<TimerCounter, int>(&counter,
+              &TimerCounter::Fire, idx), qrand() % span));
+    }
+    double insert = Seconds(start);
+
+    start = clock();
+    int cancelled = 0;
+    for(int idx = 0; idx < count; idx += 2) {
+      events[idx].Stop();
+      cancelled++;
+    }
+    double cancel = Seconds(start);
+    events.clear();
+
+    start = clock();
+    int runs = 0;
+    qint64 next = timer.VirtualRun();
+    while(next != -1) {
+      time.IncrementVirtualClock(next);
+      next = timer.VirtualRun();
+      runs++;
+    }
+    double expire = Seconds(start);
+
+    QVariantMap result;
+    result["benchmark"] = "timers";
+    result["timers"] = count;
+    result["span_msecs"] = span;
+    result["cancelled"] = cancelled;
+    result["fired"] = counter.count;
+    result["virtual_runs"] = runs;
+    result["insert_ns_per_op"] = NanosPerOp(insert, count);
+    result["cancel_ns_per_op"] = NanosPerOp(cancel, cancelled);
+    result["expire_ns_per_op"] = NanosPerOp(expire, counter.count);
+    result["cpu_seconds"] = insert + cancel + expire;
+    return result;
+  }
+}
+}
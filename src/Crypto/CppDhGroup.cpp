@@ -0,0 +1,111 @@
+#include <QThreadStorage>
+
+#include "CppDhGroup.hpp"
+#include "CppDiffieHellman.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  CppDhGroup &CppDhGroup::GetInstance()
+  {
+    static QThreadStorage<CppDhGroup *> groups;
+    if(!groups.hasLocalData()) {
+      groups.setLocalData(new CppDhGroup());
+    }
+    return *groups.localData();
+  }
+
+  CppDhGroup::CppDhGroup() :
+    _modulus(CppDiffieHellman::GetPInt()),
+    _generator(CppDiffieHellman::GetGInt()),
+    _order(CppDiffieHellman::GetQInt()),
+    _mont(_modulus)
+  {
+    _params.Initialize(_modulus, _order, _generator);
+    _params.Precompute();
+  }
+
+  CryptoPP::Integer CppDhGroup::ExponentiateBase(
+      const CryptoPP::Integer &exp) const
+  {
+    return _params.ExponentiateBase(exp);
+  }
+
+  CryptoPP::Integer CppDhGroup::Exponentiate(const CryptoPP::Integer &base,
+      const CryptoPP::Integer &exp) const
+  {
+    return _mont.ConvertOut(_mont.Exponentiate(_mont.ConvertIn(base), exp));
+  }
+
+  CryptoPP::Integer CppDhGroup::CascadeExponentiate(const CryptoPP::Integer &x,
+      const CryptoPP::Integer &e1, const CryptoPP::Integer &y,
+      const CryptoPP::Integer &e2) const
+  {
+    return _mont.ConvertOut(_mont.CascadeExponentiate(_mont.ConvertIn(x), e1,
+          _mont.ConvertIn(y), e2));
+  }
+
+  CryptoPP::Integer CppDhGroup::CascadeExponentiateBase(
+      const CryptoPP::Integer &e1, const CryptoPP::Integer &y,
+      const CryptoPP::Integer &e2) const
+  {
+    // The table makes g^e1 far cheaper than a squaring chain, so it is not
+    // worth folding into a simultaneous exponentiation with y
+    return CryptoPP::a_times_b_mod_c(ExponentiateBase(e1),
+        Exponentiate(y, e2), _modulus);
+  }
+
+  CryptoPP::Integer CppDhGroup::MultiExponentiate(
+      const QVector<CryptoPP::Integer> &bases,
+      const QVector<CryptoPP::Integer> &exps) const
+  {
+    // Interleaved fixed windows, each base gets a table of its first
+    // 2^Window - 1 powers and a window of every exponent is consumed after
+    // each run of Window shared squarings
+    const int Window = 4;
+    const int TableSize = 1 << Window;
+
+    QVector<QVector<CryptoPP::Integer> > tables(bases.count());
+    unsigned int bits = 0;
+    for(int idx = 0; idx < bases.count(); idx++) {
+      bits = qMax(bits, exps[idx].BitCount());
+      QVector<CryptoPP::Integer> &table = tables[idx];
+      table.resize(TableSize);
+      table[1] = _mont.ConvertIn(bases[idx]);
+      for(int power = 2; power < TableSize; power++) {
+        table[power] = _mont.Multiply(table[power - 1], table[1]);
+      }
+    }
+
+    CryptoPP::Integer acc = _mont.MultiplicativeIdentity();
+    int windows = (bits + Window - 1) / Window;
+    for(int window = windows - 1; window >= 0; window--) {
+      if(window != windows - 1) {
+        for(int square = 0; square < Window; square++) {
+          acc = _mont.Square(acc);
+        }
+      }
+
+      for(int idx = 0; idx < bases.count(); idx++) {
+        int digit = static_cast<int>(exps[idx].GetBits(window * Window, Window));
+        if(digit) {
+          acc = _mont.Multiply(acc, tables[idx][digit]);
+        }
+      }
+    }
+
+    return _mont.ConvertOut(acc);
+  }
+
+  CryptoPP::Integer CppDhGroup::GetRandomExponent()
+  {
+    return CryptoPP::Integer(*_rng.GetHandle(), CryptoPP::Integer::One(),
+        _order - CryptoPP::Integer::One());
+  }
+
+  CryptoPP::Integer CppDhGroup::GetRandomExponent(unsigned int bits)
+  {
+    return CryptoPP::Integer(*_rng.GetHandle(), CryptoPP::Integer::One(),
+        CryptoPP::Integer::Power2(bits) - CryptoPP::Integer::One());
+  }
+}
+}
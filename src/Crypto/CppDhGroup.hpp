@@ -0,0 +1,120 @@
+#ifndef DISSENT_CRYPTO_CPP_DH_GROUP_H_GUARD
+#define DISSENT_CRYPTO_CPP_DH_GROUP_H_GUARD
+
+#include <QVector>
+
+#include "cryptopp/gfpcrypt.h"
+#include "cryptopp/modarith.h"
+
+#include "CppRandom.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  /**
+   * Arithmetic in the Diffie-Hellman group shared by every CppDiffieHellman
+   * key.  Holds a fixed-base table for the generator and the Montgomery
+   * constants of the modulus, so that they are computed once rather than on
+   * every exponentiation.  CryptoPP keeps scratch space inside both, so each
+   * thread is handed its own instance.
+   */
+  class CppDhGroup {
+    public:
+      /**
+       * Returns the calling thread's instance, built on first use
+       */
+      static CppDhGroup &GetInstance();
+
+      /**
+       * Destructor
+       */
+      ~CppDhGroup() {}
+
+      /**
+       * Returns g^exp using the fixed-base table
+       * @param exp the exponent
+       */
+      CryptoPP::Integer ExponentiateBase(const CryptoPP::Integer &exp) const;
+
+      /**
+       * Returns base^exp
+       * @param base an element of the group
+       * @param exp the exponent
+       */
+      CryptoPP::Integer Exponentiate(const CryptoPP::Integer &base,
+          const CryptoPP::Integer &exp) const;
+
+      /**
+       * Returns x^e1 * y^e2 in a single pass over the exponents
+       * @param x the first base
+       * @param e1 the first exponent
+       * @param y the second base
+       * @param e2 the second exponent
+       */
+      CryptoPP::Integer CascadeExponentiate(const CryptoPP::Integer &x,
+          const CryptoPP::Integer &e1, const CryptoPP::Integer &y,
+          const CryptoPP::Integer &e2) const;
+
+      /**
+       * Returns g^e1 * y^e2, using the fixed-base table for g
+       * @param e1 the generator's exponent
+       * @param y the second base
+       * @param e2 the second exponent
+       */
+      CryptoPP::Integer CascadeExponentiateBase(const CryptoPP::Integer &e1,
+          const CryptoPP::Integer &y, const CryptoPP::Integer &e2) const;
+
+      /**
+       * Returns the product of bases[i]^exps[i], sharing the squarings across
+       * every base
+       * @param bases elements of the group
+       * @param exps non-negative exponents, one per base
+       */
+      CryptoPP::Integer MultiExponentiate(
+          const QVector<CryptoPP::Integer> &bases,
+          const QVector<CryptoPP::Integer> &exps) const;
+
+      /**
+       * Returns a uniformly random exponent in [1, q)
+       */
+      CryptoPP::Integer GetRandomExponent();
+
+      /**
+       * Returns a uniformly random exponent in [1, 2^bits)
+       * @param bits the exponent length in bits
+       */
+      CryptoPP::Integer GetRandomExponent(unsigned int bits);
+
+      /**
+       * Returns the modulus p
+       */
+      inline const CryptoPP::Integer &GetModulus() const { return _modulus; }
+
+      /**
+       * Returns the generator g
+       */
+      inline const CryptoPP::Integer &GetGenerator() const { return _generator; }
+
+      /**
+       * Returns the order q of the generator
+       */
+      inline const CryptoPP::Integer &GetOrder() const { return _order; }
+
+    private:
+      /**
+       * Use GetInstance
+       */
+      explicit CppDhGroup();
+
+      Q_DISABLE_COPY(CppDhGroup)
+
+      const CryptoPP::Integer _modulus;
+      const CryptoPP::Integer _generator;
+      const CryptoPP::Integer _order;
+      CryptoPP::DL_GroupParameters_GFP _params;
+      CryptoPP::MontgomeryRepresentation _mont;
+      CppRandom _rng;
+  };
+}
+}
+
+#endif
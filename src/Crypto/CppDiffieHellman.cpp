@@ -2,10 +2,12 @@
 
 #include "Utils/Serialization.hpp"
 
+#include "CppDhGroup.hpp"
 #include "CppDiffieHellman.hpp"
 #include "CppHash.hpp"
 #include "CppIntegerData.hpp"
 #include "CppRandom.hpp"
+#include "CryptoCost.hpp"
 
 namespace Dissent {
 namespace Crypto {
@@ -32,6 +34,7 @@ namespace Crypto {
 
   QByteArray CppDiffieHellman::GetSharedSecret(const QByteArray &remote_pub) const
   {
+    CryptoCost::Charge(CryptoCost::SharedSecret);
     QByteArray shared = QByteArray(_dh_params.AgreedValueLength(), 0);
 
     bool valid = _dh_params.Agree(reinterpret_cast<byte *>(shared.data()),
@@ -46,142 +49,279 @@ namespace Crypto {
 
   QByteArray CppDiffieHellman::ProveSharedSecret(const QByteArray &remote_pub) const
   {
-    // For modular arithmetic in our DH group
-    CryptoPP::Integer modulus = _dh_params.GetGroupParameters().GetModulus();
-    CryptoPP::Integer generator = _dh_params.GetGroupParameters().GetGenerator();
-
-    // Arithmetic modulo N
-    CryptoPP::ModularArithmetic mod_arith(modulus);
-    // Arithmetic modulo phi(N) = N-1
-    CryptoPP::ModularArithmetic mod_arith_phi(modulus-1);
-
-
-    CppHash hash;
-    CppDiffieHellman rand_key;
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    SharedSecretProof proof;
 
     // A random value v in the group Z_q
-    QByteArray value_bytes = rand_key.GetPrivateComponent();
-    CppIntegerData value(value_bytes);
+    CryptoPP::Integer value = group.GetRandomExponent();
 
-    // g  -- the group generator
-    QByteArray gen = CppIntegerData(generator).GetByteArray();
-
-    // g^a  -- where a is the prover's secret
-    QByteArray prover_pub = GetPublicComponent();
-
-    // g^b  -- where b is the other guy's secret
-    QByteArray other_pub = remote_pub;
-
-    // g^(ab)  -- Where a is the prover's secret
-    QByteArray dh_secret = GetSharedSecret(other_pub);
+    // g^(ab)  -- Where a is the prover's secret and b the other guy's
+    proof.dh_secret = GetSharedSecret(remote_pub);
 
     // t_1 = g^v
-    CryptoPP::Integer commit_1_int = mod_arith.Exponentiate(generator, value.GetCryptoInteger());
-    QByteArray commit_1 = CppIntegerData(commit_1_int).GetByteArray();
+    proof.commit_1 = CppIntegerData(group.ExponentiateBase(value)).GetByteArray();
 
     // t_2 = (g^b)^v  -- Where b is the other guy's secret
-    QByteArray commit_2 = rand_key.GetSharedSecret(other_pub);
+    proof.commit_2 = CppIntegerData(group.Exponentiate(
+          CppIntegerData(remote_pub).GetCryptoInteger(), value)).GetByteArray();
 
     // c = HASH(g, g^a, g^b, g^ab, t_1, t_2)
-    QByteArray challenge_bytes = hash.ComputeHash(gen + prover_pub + other_pub + dh_secret + commit_1 + commit_2);
-    CppIntegerData challenge_data(challenge_bytes);
-    CryptoPP::Integer challenge = challenge_data.GetCryptoInteger();
+    proof.challenge = ComputeChallenge(GetPublicComponent(), remote_pub, proof);
+    CryptoPP::Integer challenge = CppIntegerData(proof.challenge).GetCryptoInteger();
 
     // a = prover secret 
     CryptoPP::Integer prover_priv = CppIntegerData(GetPrivateComponent()).GetCryptoInteger();
 
-    // prod = c*a mod n
-    CryptoPP::Integer product_ca = mod_arith_phi.Multiply(challenge, prover_priv);
-
-    // r = v - ca mod n
-    CryptoPP::Integer response = mod_arith_phi.Subtract(value.GetCryptoInteger(), product_ca);
-    CppIntegerData response_data(response);
+    // Every element involved has order q, so the response is reduced mod q
+    // rather than mod p-1, keeping the verifier's exponents short
+    CryptoPP::ModularArithmetic mod_arith_q(group.GetOrder());
 
-    // TEST
-    CryptoPP::Integer commit_1p = mod_arith.CascadeExponentiate(generator, 
-        response, CppIntegerData(prover_pub).GetCryptoInteger(), challenge);
+    // prod = c*a mod q
+    CryptoPP::Integer product_ca = mod_arith_q.Multiply(challenge % group.GetOrder(), prover_priv);
 
-    // Get encoded version of data
-    QByteArray challenge_enc = challenge_data.GetByteArray();
-    QByteArray response_enc = response_data.GetByteArray();
+    // r = v - ca mod q
+    CryptoPP::Integer response = mod_arith_q.Subtract(value, product_ca);
+    proof.response = CppIntegerData(response).GetByteArray();
 
-    // The header is 3 4-byte lengths
+    // The header is the format followed by 5 4-byte lengths
     QByteArray header(ZeroKnowledgeProofHeaderSize, 0); 
-    int len_dh_secret = dh_secret.count();
-    int len_challenge = challenge_enc.count();
-    int len_response = response_enc.count();
-    
-    Utils::Serialization::WriteInt(len_dh_secret, header, 0);
-    Utils::Serialization::WriteInt(len_challenge, header, 4);
-    Utils::Serialization::WriteInt(len_response, header, 8);
-
-    // We return (dh_secret, challenge, response)
-    return header + dh_secret + challenge_enc + response_enc;
+    Utils::Serialization::WriteInt(CommitmentProofFormat, header, 0);
+    Utils::Serialization::WriteInt(proof.dh_secret.count(), header, 4);
+    Utils::Serialization::WriteInt(proof.challenge.count(), header, 8);
+    Utils::Serialization::WriteInt(proof.response.count(), header, 12);
+    Utils::Serialization::WriteInt(proof.commit_1.count(), header, 16);
+    Utils::Serialization::WriteInt(proof.commit_2.count(), header, 20);
+
+    // We return (dh_secret, challenge, response, t_1, t_2), the commitments
+    // let verifiers check many proofs at once
+    return header + proof.dh_secret + proof.challenge + proof.response +
+      proof.commit_1 + proof.commit_2;
   }
 
-  QByteArray CppDiffieHellman::VerifySharedSecret(const QByteArray &prover_pub,
-      const QByteArray &remote_pub, const QByteArray &proof) const
+  bool CppDiffieHellman::ParseProof(const QByteArray &proof,
+      const QByteArray &prover_pub, const QByteArray &remote_pub,
+      SharedSecretProof &parsed)
   {
-    // For modular arithmetic in our DH group
-    CryptoPP::Integer modulus = _dh_params.GetGroupParameters().GetModulus();
-    CryptoPP::Integer generator = _dh_params.GetGroupParameters().GetGenerator();
-    CryptoPP::ModularArithmetic mod_arith(modulus);
+    if(proof.size() < LegacyProofHeaderSize) {
+      return false;
+    }
 
-    CppHash hash;
+    QByteArray *fields[] = { &parsed.dh_secret, &parsed.challenge,
+      &parsed.response, &parsed.commit_1, &parsed.commit_2 };
+
+    // Legacy proofs start with the length of the secret rather than a format
+    bool legacy = Utils::Serialization::ReadInt(proof, 0) != CommitmentProofFormat;
+    int header_size = legacy ? LegacyProofHeaderSize : ZeroKnowledgeProofHeaderSize;
+    int field_count = legacy ? 3 : 5;
+    int length_offset = legacy ? 0 : 4;
+    if(proof.size() < header_size) {
+      return false;
+    }
+
+    int offset = header_size;
+    for(int idx = 0; idx < field_count; idx++) {
+      int length = Utils::Serialization::ReadInt(proof, length_offset + idx * 4);
+      if(length < 1 || proof.size() - offset < length) {
+        return false;
+      }
+      *fields[idx] = proof.mid(offset, length);
+      offset += length;
+    }
+
+    if(!IsGroupElement(parsed.dh_secret)) {
+      return false;
+    }
+
+    if(!legacy) {
+      return IsGroupElement(parsed.commit_1) && IsGroupElement(parsed.commit_2);
+    }
+
+    // A legacy proof only carries (dh_secret, challenge, response), so its
+    // commitments are recomputed and checked through the challenge alone:
+    //   t_1 = (g^r) * (g^a)^c, t_2 = (g^b)^r * (g^ab)^c
+    // Every base has order q, so the exponents, the response of which was
+    // reduced mod p-1, may be reduced mod q
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    const CryptoPP::Integer &order = group.GetOrder();
+    CryptoPP::Integer challenge =
+      CppIntegerData(parsed.challenge).GetCryptoInteger() % order;
+    CryptoPP::Integer response =
+      CppIntegerData(parsed.response).GetCryptoInteger() % order;
+
+    parsed.commit_1 = CppIntegerData(group.CascadeExponentiateBase(response,
+          CppIntegerData(prover_pub).GetCryptoInteger(), challenge)).GetByteArray();
+    parsed.commit_2 = CppIntegerData(group.CascadeExponentiate(
+          CppIntegerData(remote_pub).GetCryptoInteger(), response,
+          CppIntegerData(parsed.dh_secret).GetCryptoInteger(),
+          challenge)).GetByteArray();
+    return true;
+  }
+
+  bool CppDiffieHellman::IsGroupElement(const QByteArray &element)
+  {
+    // Elements must be reduced, otherwise a proof could satisfy the
+    // equations modulo p while hashing differently
+    CryptoPP::Integer x = CppIntegerData(element).GetCryptoInteger();
+    if(x <= CryptoPP::Integer::Zero() || x >= GetPInt()) {
+      return false;
+    }
+
+    // An element outside the order q subgroup, such as -g^ab, passes the
+    // equations whenever its stray component is raised to an even power
+    return CryptoPP::a_exp_b_mod_c(x, GetQInt(), GetPInt()) ==
+      CryptoPP::Integer::One();
+  }
+
+  bool CppDiffieHellman::IsGroupElement(const QByteArray &element,
+      QHash<QByteArray, bool> &checked)
+  {
+    QHash<QByteArray, bool>::const_iterator it = checked.constFind(element);
+    if(it != checked.constEnd()) {
+      return it.value();
+    }
 
-    QByteArray header = proof.mid(0, ZeroKnowledgeProofHeaderSize);
-    QByteArray body = proof.mid(ZeroKnowledgeProofHeaderSize);
+    bool valid = IsGroupElement(element);
+    checked.insert(element, valid);
+    return valid;
+  }
 
-    int len_dh_secret = Utils::Serialization::ReadInt(header, 0);
-    if(len_dh_secret < 1) return QByteArray();
+  QByteArray CppDiffieHellman::ComputeChallenge(const QByteArray &prover_pub,
+      const QByteArray &remote_pub, const SharedSecretProof &proof)
+  {
+    CppHash hash;
+    QByteArray gen = CppIntegerData(GetGInt()).GetByteArray();
 
-    int len_challenge = Utils::Serialization::ReadInt(header, 4);
-    if(len_challenge < 1) return QByteArray();
+    // c = HASH(g, g^a, g^b, g^ab, t_1, t_2)
+    return hash.ComputeHash(gen + prover_pub + remote_pub + proof.dh_secret +
+        proof.commit_1 + proof.commit_2);
+  }
 
-    int len_response = Utils::Serialization::ReadInt(header, 8);
-    if(len_response < 1) return QByteArray();
+  QByteArray CppDiffieHellman::VerifySharedSecret(const QByteArray &prover_pub,
+      const QByteArray &remote_pub, const QByteArray &proof) const
+  {
+    SharedSecretProof parsed;
+    if(!IsGroupElement(prover_pub) || !IsGroupElement(remote_pub) ||
+        !ParseProof(proof, prover_pub, remote_pub, parsed))
+    {
+      return QByteArray();
+    }
 
-    if(proof.size() < (ZeroKnowledgeProofHeaderSize+len_dh_secret+len_challenge+len_response)) {
+    if(parsed.challenge != ComputeChallenge(prover_pub, remote_pub, parsed)) {
       return QByteArray();
     }
 
-    // Recover byte arrays of integers
-    int offset = 0;
-    QByteArray bytes_dh_secret = body.mid(offset, len_dh_secret);
-    offset += len_dh_secret;
-    QByteArray bytes_challenge = body.mid(offset, len_challenge);
-    offset += len_challenge;
-    QByteArray bytes_response = body.mid(offset, len_response);
-   
-    CppIntegerData dh_secret(bytes_dh_secret);
-    CppIntegerData challenge(bytes_challenge);
-    CppIntegerData response(bytes_response);
-
-    // commit'_1 = (g^r) * (g^a)^c
-    // commit'_1 = (g^r) * (public_key_a)^challenge
-    CppIntegerData public_key_a(prover_pub);
-    CryptoPP::Integer commit_1 = mod_arith.CascadeExponentiate(CppIntegerData(generator).GetCryptoInteger(), 
-        response.GetCryptoInteger(), public_key_a.GetCryptoInteger(), challenge.GetCryptoInteger());
-
-    // commit'_2 = (g^b)^r * (g^ab)^c
-    // commit'_2 = (public_key_b)^response * (dh_secret)^challenge
-
-    CppIntegerData public_key_b(remote_pub);
-    CryptoPP::Integer commit_2 = mod_arith.CascadeExponentiate(public_key_b.GetCryptoInteger(), 
-        response.GetCryptoInteger(), dh_secret.GetCryptoInteger(), challenge.GetCryptoInteger());
-
-    // Group generator g
-    QByteArray gen = CppIntegerData(generator).GetByteArray();
-
-    // HASH(g, g^a, g^b
-    QByteArray expected_challenge = hash.ComputeHash(gen + prover_pub + remote_pub + 
-        bytes_dh_secret + CppIntegerData(commit_1).GetByteArray() + CppIntegerData(commit_2).GetByteArray());
-
-    if(bytes_challenge == expected_challenge) {
-      return bytes_dh_secret;
-    } else {
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    CryptoPP::Integer dh_secret = CppIntegerData(parsed.dh_secret).GetCryptoInteger();
+    CryptoPP::Integer challenge = CppIntegerData(parsed.challenge).GetCryptoInteger();
+    CryptoPP::Integer response = CppIntegerData(parsed.response).GetCryptoInteger();
+
+    // t_1 == (g^r) * (g^a)^c
+    // t_1 == (g^r) * (public_key_a)^challenge
+    CryptoPP::Integer public_key_a = CppIntegerData(prover_pub).GetCryptoInteger();
+    CryptoPP::Integer commit_1 = group.CascadeExponentiateBase(response,
+        public_key_a, challenge);
+    if(commit_1 != CppIntegerData(parsed.commit_1).GetCryptoInteger()) {
+      return QByteArray();
+    }
+
+    // t_2 == (g^b)^r * (g^ab)^c
+    // t_2 == (public_key_b)^response * (dh_secret)^challenge
+    CryptoPP::Integer public_key_b = CppIntegerData(remote_pub).GetCryptoInteger();
+    CryptoPP::Integer commit_2 = group.CascadeExponentiate(public_key_b,
+        response, dh_secret, challenge);
+    if(commit_2 != CppIntegerData(parsed.commit_2).GetCryptoInteger()) {
       return QByteArray();
     }
+
+    return parsed.dh_secret;
+  }
+
+  QVector<QByteArray> CppDiffieHellman::VerifySharedSecrets(
+      const QVector<QByteArray> &prover_pubs,
+      const QVector<QByteArray> &remote_pubs,
+      const QVector<QByteArray> &proofs) const
+  {
+    QVector<QByteArray> secrets(proofs.count());
+    if(proofs.count() < 2) {
+      return DiffieHellman::VerifySharedSecrets(prover_pubs, remote_pubs, proofs);
+    }
+
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    const CryptoPP::Integer &order = group.GetOrder();
+
+    // Each proof i is weighted by a random d_i and the verifier checks
+    //   g^(sum d_i r_i) * prod (g^a_i)^(d_i c_i) == prod t_1,i^(d_i)
+    //   prod (g^b_i)^(d_i r_i) * (g^a_ib_i)^(d_i c_i) == prod t_2,i^(d_i)
+    // which fails with probability 1 - 2^-BatchExponentBits if any single
+    // proof is invalid
+    CryptoPP::Integer base_exp = CryptoPP::Integer::Zero();
+    QVector<CryptoPP::Integer> lhs_1_bases, lhs_1_exps;
+    QVector<CryptoPP::Integer> lhs_2_bases, lhs_2_exps;
+    QVector<CryptoPP::Integer> rhs_1_bases, rhs_2_bases, rhs_exps;
+    QVector<int> batched;
+
+    // The same few public keys recur across the proofs, each is checked once
+    QHash<QByteArray, bool> valid_keys;
+
+    for(int idx = 0; idx < proofs.count(); idx++) {
+      SharedSecretProof parsed;
+      // The challenge and group membership are checked here, a proof failing
+      // them fails on its own
+      if(!IsGroupElement(prover_pubs[idx], valid_keys) ||
+          !IsGroupElement(remote_pubs[idx], valid_keys) ||
+          !ParseProof(proofs[idx], prover_pubs[idx], remote_pubs[idx], parsed) ||
+          parsed.challenge !=
+          ComputeChallenge(prover_pubs[idx], remote_pubs[idx], parsed))
+      {
+        continue;
+      }
+
+      CryptoPP::Integer weight = group.GetRandomExponent(BatchExponentBits);
+      CryptoPP::Integer challenge = CppIntegerData(parsed.challenge).GetCryptoInteger();
+      CryptoPP::Integer response = CppIntegerData(parsed.response).GetCryptoInteger();
+      CryptoPP::Integer weighted_challenge = weight * challenge;
+      CryptoPP::Integer weighted_response = weight * response;
+
+      base_exp = (base_exp + weighted_response) % order;
+
+      lhs_1_bases.append(CppIntegerData(prover_pubs[idx]).GetCryptoInteger());
+      lhs_1_exps.append(weighted_challenge);
+
+      lhs_2_bases.append(CppIntegerData(remote_pubs[idx]).GetCryptoInteger());
+      lhs_2_exps.append(weighted_response);
+      lhs_2_bases.append(CppIntegerData(parsed.dh_secret).GetCryptoInteger());
+      lhs_2_exps.append(weighted_challenge);
+
+      rhs_1_bases.append(CppIntegerData(parsed.commit_1).GetCryptoInteger());
+      rhs_2_bases.append(CppIntegerData(parsed.commit_2).GetCryptoInteger());
+      rhs_exps.append(weight);
+
+      secrets[idx] = parsed.dh_secret;
+      batched.append(idx);
+    }
+
+    if(batched.isEmpty()) {
+      return secrets;
+    }
+
+    CryptoPP::Integer lhs_1 = CryptoPP::a_times_b_mod_c(
+        group.ExponentiateBase(base_exp),
+        group.MultiExponentiate(lhs_1_bases, lhs_1_exps),
+        group.GetModulus());
+
+    if(lhs_1 == group.MultiExponentiate(rhs_1_bases, rhs_exps) &&
+        group.MultiExponentiate(lhs_2_bases, lhs_2_exps) ==
+        group.MultiExponentiate(rhs_2_bases, rhs_exps))
+    {
+      return secrets;
+    }
+
+    // Find the offenders
+    foreach(int idx, batched) {
+      secrets[idx] = VerifySharedSecret(prover_pubs[idx], remote_pubs[idx],
+          proofs[idx]);
+    }
+    return secrets;
   }
 
   CryptoPP::Integer CppDiffieHellman::_p_int;
@@ -1,6 +1,8 @@
 #ifndef DISSENT_CRYPTO_CPP_DIFFIE_HELLMAN_KEY_H_GUARD
 #define DISSENT_CRYPTO_CPP_DIFFIE_HELLMAN_KEY_H_GUARD
 
+#include <QHash>
+
 #include "DiffieHellman.hpp"
 #include "cryptopp/dh.h"
 
@@ -64,6 +66,21 @@ namespace Crypto {
       virtual QByteArray VerifySharedSecret(const QByteArray &prover_pub,
           const QByteArray &remote_pub, const QByteArray &proof) const;
 
+      /**
+       * Verifies many proofs with one random linear combination of their
+       * verification equations, falling back to VerifySharedSecret on each
+       * proof only if the combination does not hold
+       * @param prover_pubs the provers public components
+       * @param remote_pubs the public components the provers shared secrets with
+       * @param proofs the proofs
+       * @returns for each proof, QByteArray() if verification fails, otherwise
+       * the shared secret
+       */
+      virtual QVector<QByteArray> VerifySharedSecrets(
+          const QVector<QByteArray> &prover_pubs,
+          const QVector<QByteArray> &remote_pubs,
+          const QVector<QByteArray> &proofs) const;
+
       inline static const CryptoPP::Integer &GetPInt()
       {
         if(_p_int == CryptoPP::Integer::Zero()) {
@@ -89,8 +106,67 @@ namespace Crypto {
       }
 
     private:
+      /**
+       * The fields of a proof of a shared secret
+       */
+      class SharedSecretProof {
+        public:
+          QByteArray dh_secret;
+          QByteArray challenge;
+          QByteArray response;
+          QByteArray commit_1;
+          QByteArray commit_2;
+      };
+
+      /**
+       * Splits a proof into its fields, returns false if it is malformed or
+       * if any group element in it is not in the order q subgroup.  Legacy
+       * proofs without commitments have them recomputed from the public
+       * components, which must already be known group elements
+       * @param proof the serialized proof
+       * @param prover_pub the provers public component
+       * @param remote_pub the public component the prover shared a secret with
+       * @param parsed returns the fields
+       */
+      static bool ParseProof(const QByteArray &proof,
+          const QByteArray &prover_pub, const QByteArray &remote_pub,
+          SharedSecretProof &parsed);
+
+      /**
+       * Returns true if the element lies in [1, p) and x^q mod p == 1
+       * @param element the serialized element
+       */
+      static bool IsGroupElement(const QByteArray &element);
+
+      /**
+       * IsGroupElement remembering the elements already checked
+       * @param element the serialized element
+       * @param checked the elements checked so far and their results
+       */
+      static bool IsGroupElement(const QByteArray &element,
+          QHash<QByteArray, bool> &checked);
+
+      /**
+       * Returns the challenge the proof should carry given the public
+       * components and the proof's commitments
+       * @param prover_pub the provers public component
+       * @param remote_pub the public component the prover shared a secret with
+       * @param proof the parsed proof
+       */
+      static QByteArray ComputeChallenge(const QByteArray &prover_pub,
+          const QByteArray &remote_pub, const SharedSecretProof &proof);
+
       static void Init();
-      static const int ZeroKnowledgeProofHeaderSize = 12;
+      /**
+       * A proof is [format][5 lengths][dh_secret, challenge, response, t_1,
+       * t_2], the format is negative so that it cannot be mistaken for the
+       * leading length of a legacy [3 lengths][dh_secret, challenge, response]
+       * proof
+       */
+      static const int CommitmentProofFormat = -1;
+      static const int ZeroKnowledgeProofHeaderSize = 24;
+      static const int LegacyProofHeaderSize = 12;
+      static const int BatchExponentBits = 64;
       static CryptoPP::Integer  _p_int, _q_int, _g_int;
       CryptoPP::DH _dh_params;
       QByteArray _public_key;
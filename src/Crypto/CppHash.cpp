@@ -1,29 +1,76 @@
+#include <cryptopp/sha.h>
+#if CRYPTOPP_VERSION >= 564
+#include <cryptopp/blake2.h>
+#define DISSENT_CRYPTOPP_BLAKE2
+#endif
+
 #include "CppHash.hpp"
 
 namespace Dissent {
 namespace Crypto {
+  CppHash::CppHash(Algorithm algo) :
+    _algo(IsSupported(algo) ? algo : SHA1)
+  {
+    switch(_algo) {
+      case SHA256:
+        _hash.reset(new CryptoPP::SHA256());
+        break;
+      case SHA512:
+        _hash.reset(new CryptoPP::SHA512());
+        break;
+#ifdef DISSENT_CRYPTOPP_BLAKE2
+      case BLAKE2b:
+        _hash.reset(new CryptoPP::BLAKE2b());
+        break;
+#endif
+      default:
+        _hash.reset(new CryptoPP::SHA1());
+    }
+  }
+
+  bool CppHash::IsSupported(Algorithm algo)
+  {
+    switch(algo) {
+      case SHA1:
+      case SHA256:
+      case SHA512:
+        return true;
+#ifdef DISSENT_CRYPTOPP_BLAKE2
+      case BLAKE2b:
+        return true;
+#endif
+      default:
+        return false;
+    }
+  }
+
   void CppHash::Restart()
   {
-    sha1.Restart();
+    _hash->Restart();
   }
 
   void CppHash::Update(const QByteArray &data)
   {
-    sha1.Update(reinterpret_cast<const byte *>(data.data()), data.size());
+    _hash->Update(reinterpret_cast<const byte *>(data.data()), data.size());
   }
 
   QByteArray CppHash::ComputeHash()
   {
     QByteArray hash(GetDigestSize(), 0);
-    sha1.Final(reinterpret_cast<byte *>(hash.data()));
+    _hash->Final(reinterpret_cast<byte *>(hash.data()));
     return hash;
   }
 
   QByteArray CppHash::ComputeHash(const QByteArray &data)
+  {
+    return ComputeHash(data.constData(), data.size());
+  }
+
+  QByteArray CppHash::ComputeHash(const char *data, int length)
   {
     QByteArray hash(GetDigestSize(), 0);
-    sha1.CalculateDigest(reinterpret_cast<byte *>(hash.data()),
-        reinterpret_cast<const byte *>(data.data()), data.size());
+    _hash->CalculateDigest(reinterpret_cast<byte *>(hash.data()),
+        reinterpret_cast<const byte *>(data), length);
     return hash;
   }
 }
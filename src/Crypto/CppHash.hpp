@@ -2,30 +2,52 @@
 #define DISSENT_CRYPTO_CPP_HASH_H_GUARD
 
 #include <QByteArray>
+#include <QScopedPointer>
 
-#include <cryptopp/sha.h>
+#include <cryptopp/cryptlib.h>
 
 #include "Hash.hpp"
 
 namespace Dissent {
 namespace Crypto {
   /**
-   * Hash wrapper for CryptoPP::SHA1
+   * Hash wrapper for the CryptoPP hash functions: SHA1, SHA256, SHA512, and
+   * BLAKE2b when CryptoPP is recent enough to provide it (5.6.4)
    */
   class CppHash : public Hash {
     public:
+      /**
+       * Constructor
+       * @param algo the algorithm, SHA1 if it is not supported
+       */
+      explicit CppHash(Algorithm algo = SHA1);
+
       /**
        * Destructor
        */
       virtual ~CppHash() {}
 
-      inline virtual int GetDigestSize() { return sha1.DigestSize(); }
+      /**
+       * Returns true if the CryptoPP in use provides the algorithm
+       * @param algo the algorithm
+       */
+      static bool IsSupported(Algorithm algo);
+
+      /**
+       * Returns the algorithm in use
+       */
+      inline Algorithm GetAlgorithm() const { return _algo; }
+
+      virtual Hash *Clone() const { return new CppHash(_algo); }
+      inline virtual int GetDigestSize() { return _hash->DigestSize(); }
       virtual void Restart();
       virtual void Update(const QByteArray &data);
       virtual QByteArray ComputeHash();
       virtual QByteArray ComputeHash(const QByteArray &data);
+      virtual QByteArray ComputeHash(const char *data, int length);
     private:
-      CryptoPP::SHA1 sha1;
+      Algorithm _algo;
+      QScopedPointer<CryptoPP::HashTransformation> _hash;
   };
 }
 }
@@ -88,7 +88,18 @@ namespace Crypto {
        */
       inline virtual Hash *GetHashAlgorithm() 
       {
-        return new CppHash();
+        return new CppHash(_hash_algorithm);
+      }
+
+      /**
+       * Selects the hash algorithm, if CryptoPP provides it
+       */
+      inline virtual bool SetHashAlgorithm(Hash::Algorithm algo)
+      {
+        if(!CppHash::IsSupported(algo)) {
+          return false;
+        }
+        return Library::SetHashAlgorithm(algo);
       }
 
       /**
@@ -1,5 +1,6 @@
 #include "CppPrivateKey.hpp"
 #include "CppRandom.hpp"
+#include "CryptoCost.hpp"
 
 using namespace CryptoPP;
 
@@ -47,6 +48,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Sign);
     const RSA::PrivateKey &private_key = *_private_key;
     RSASS<PKCS1v15, SHA>::Signer signer(private_key);
     QByteArray sig(signer.MaxSignatureLength(), 0);
@@ -63,6 +65,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Decrypt);
     AutoSeededX917RNG<DES_EDE3> rng;
     const RSA::PrivateKey &private_key = *_private_key;
     RSAES<OAEP<SHA> >::Decryptor decryptor(private_key);
@@ -1,6 +1,7 @@
 #include "CppPublicKey.hpp"
 #include "CppPrivateKey.hpp"
 #include "CppRandom.hpp"
+#include "CryptoCost.hpp"
 
 using namespace CryptoPP;
 
@@ -102,6 +103,7 @@ namespace Crypto {
       return false;
     }
 
+    CryptoCost::Charge(CryptoCost::Verify);
     const RSA::PublicKey &public_key = *_public_key;
     RSASS<PKCS1v15, SHA>::Verifier verifier(public_key);
     return verifier.VerifyMessage(reinterpret_cast<const byte *>(data.data()),
@@ -114,6 +116,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Encrypt);
     const RSA::PublicKey &public_key = *_public_key;
     RSAES<OAEP<SHA> >::Encryptor encryptor(public_key);
     int clength = ((data.size() / AES::BLOCKSIZE) + 1) * AES::BLOCKSIZE;
@@ -38,8 +38,13 @@ namespace Crypto {
 
   void CppRandom::GenerateBlock(QByteArray &data)
   {
-    _rng->GenerateBlock(reinterpret_cast<byte *>(data.data()), data.size());
-    IncrementByteCount(data.size());
+    GenerateBlock(data.data(), data.size());
+  }
+
+  void CppRandom::GenerateBlock(char *data, int length)
+  {
+    _rng->GenerateBlock(reinterpret_cast<byte *>(data), length);
+    IncrementByteCount(length);
   }
 }
 }
@@ -32,6 +32,7 @@ namespace Crypto {
 
       virtual int GetInt(int min = 0, int max = RAND_MAX);
       virtual void GenerateBlock(QByteArray &data);
+      virtual void GenerateBlock(char *data, int length);
       CryptoPP::RandomNumberGenerator *GetHandle() { return _rng.data(); }
     private:
       QScopedPointer<CryptoPP::RandomNumberGenerator> _rng;
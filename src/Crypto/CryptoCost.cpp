@@ -0,0 +1,7 @@
+#include "CryptoCost.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  CryptoCost::Handler CryptoCost::_handler = 0;
+}
+}
@@ -0,0 +1,65 @@
+#ifndef DISSENT_CRYPTO_CRYPTO_COST_H_GUARD
+#define DISSENT_CRYPTO_CRYPTO_COST_H_GUARD
+
+namespace Dissent {
+namespace Crypto {
+  /**
+   * Reports the public key operations performed by the key and
+   * Diffie-Hellman implementations to an optional handler.  The network
+   * simulator installs one to charge them to the virtual CPU of the node
+   * handling the current message, without the crypto or anonymity layers
+   * depending on it.  Outside the simulator no handler is set and Charge
+   * costs a single test.
+   */
+  class CryptoCost {
+    public:
+      /**
+       * Operations reported to the handler
+       */
+      enum Operation {
+        Sign = 0,
+        Verify,
+        SharedSecret,
+        Encrypt,
+        Decrypt,
+        OperationCount
+      };
+
+      /**
+       * Receives the operations performed
+       * @param op the operation
+       * @param count the number of operations
+       */
+      typedef void (*Handler)(Operation op, int count);
+
+      /**
+       * Sets the handler, 0 for none.  Must be set before any thread
+       * performs crypto operations, it is not synchronized.
+       * @param handler the handler
+       */
+      inline static void SetHandler(Handler handler) { _handler = handler; }
+
+      /**
+       * Reports operations to the handler, if any
+       * @param op the operation
+       * @param count the number of operations
+       */
+      inline static void Charge(Operation op, int count = 1)
+      {
+        if(_handler) {
+          _handler(op, count);
+        }
+      }
+
+    private:
+      /**
+       * Static class, disabled
+       */
+      explicit CryptoCost();
+
+      static Handler _handler;
+  };
+}
+}
+
+#endif
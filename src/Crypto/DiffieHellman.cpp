@@ -6,6 +6,19 @@ namespace Crypto {
   QByteArray DiffieHellman::_q;
   QByteArray DiffieHellman::_g;
 
+  QVector<QByteArray> DiffieHellman::VerifySharedSecrets(
+      const QVector<QByteArray> &prover_pubs,
+      const QVector<QByteArray> &remote_pubs,
+      const QVector<QByteArray> &proofs) const
+  {
+    QVector<QByteArray> secrets(proofs.count());
+    for(int idx = 0; idx < proofs.count(); idx++) {
+      secrets[idx] = VerifySharedSecret(prover_pubs[idx], remote_pubs[idx],
+          proofs[idx]);
+    }
+    return secrets;
+  }
+
   void DiffieHellman::Init()
   {
     _p = QByteArray::fromHex("0x"
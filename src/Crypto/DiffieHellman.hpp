@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QByteArray>
 #include <QString>
+#include <QVector>
 
 namespace Dissent {
 namespace Crypto {
@@ -81,6 +82,21 @@ namespace Crypto {
       virtual QByteArray VerifySharedSecret(const QByteArray &prover_pub,
           const QByteArray &remote_pub, const QByteArray &proof) const = 0;
 
+      /**
+       * Verify many proofs of shared Diffie-Hellman secrets, as in
+       * VerifySharedSecret.  Implementations may check the proofs together
+       * and only examine them one at a time when the combined check fails.
+       * @param prover_pubs the provers public components
+       * @param remote_pubs the public components the provers shared secrets with
+       * @param proofs the proofs
+       * @returns for each proof, QByteArray() if verification fails, otherwise
+       * the shared secret
+       */
+      virtual QVector<QByteArray> VerifySharedSecrets(
+          const QVector<QByteArray> &prover_pubs,
+          const QVector<QByteArray> &remote_pubs,
+          const QVector<QByteArray> &proofs) const;
+
     private:
       static void Init();
       static QByteArray _p, _g, _q;
@@ -0,0 +1,84 @@
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include "Hash.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  int Hash::ParallelThreshold = 64 * 1024;
+
+  namespace {
+    void HashRange(Hash *hash, const QByteArray *data, QByteArray *hashes,
+        int count)
+    {
+      for(int idx = 0; idx < count; idx++) {
+        hashes[idx] = hash->ComputeHash(data[idx]);
+      }
+    }
+
+    const char *AlgorithmNames[] = {
+      "sha1",
+      "sha256",
+      "sha512",
+      "blake2b"
+    };
+  }
+
+  QString Hash::AlgorithmToString(Algorithm algo)
+  {
+    return AlgorithmNames[algo];
+  }
+
+  bool Hash::AlgorithmFromString(const QString &name, Algorithm &algo)
+  {
+    QString lname = name.toLower();
+    for(int idx = SHA1; idx <= BLAKE2b; idx++) {
+      if(lname == AlgorithmNames[idx]) {
+        algo = static_cast<Algorithm>(idx);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  QVector<QByteArray> Hash::ComputeHashes(const QVector<QByteArray> &data,
+      bool parallel)
+  {
+    int count = data.count();
+    QVector<QByteArray> hashes(count);
+
+    qint64 total = 0;
+    foreach(const QByteArray &entry, data) {
+      total += entry.size();
+    }
+
+    int threads = qMin(QThread::idealThreadCount(), count);
+    if(!parallel || threads <= 1 || total < ParallelThreshold) {
+      HashRange(this, data.constData(), hashes.data(), count);
+      return hashes;
+    }
+
+    // Each thread fills its own range of hashes, this thread takes the first
+    int per_thread = (count + threads - 1) / threads;
+    QList<Hash *> clones;
+    QList<QFuture<void> > futures;
+    for(int start = per_thread; start < count; start += per_thread) {
+      Hash *clone = Clone();
+      clones.append(clone);
+      futures.append(QtConcurrent::run(&HashRange, clone,
+            data.constData() + start, hashes.data() + start,
+            qMin(per_thread, count - start)));
+    }
+
+    HashRange(this, data.constData(), hashes.data(), per_thread);
+
+    for(int idx = 0; idx < futures.count(); idx++) {
+      futures[idx].waitForFinished();
+    }
+    qDeleteAll(clones);
+    return hashes;
+  }
+}
+}
@@ -1,6 +1,10 @@
 #ifndef DISSENT_CRYPTO_HASH_H_GUARD
 #define DISSENT_CRYPTO_HASH_H_GUARD
 
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
 namespace Dissent {
 namespace Crypto {
   /**
@@ -8,11 +12,45 @@ namespace Crypto {
    */
   class Hash {
     public:
+      /**
+       * Algorithms a Library may provide
+       */
+      enum Algorithm {
+        SHA1 = 0,
+        SHA256,
+        SHA512,
+        BLAKE2b
+      };
+
+      /**
+       * Total bytes below which ComputeHashes does not bother with threads
+       */
+      static int ParallelThreshold;
+
+      /**
+       * Returns the name of an algorithm, e.g., "sha256"
+       * @param algo the algorithm
+       */
+      static QString AlgorithmToString(Algorithm algo);
+
+      /**
+       * Parses the name of an algorithm, returns false if it is unknown
+       * @param name the name, case insensitive
+       * @param algo returns the algorithm
+       */
+      static bool AlgorithmFromString(const QString &name, Algorithm &algo);
+
       /**
        * Descructor
        */
       virtual ~Hash() {}
 
+      /**
+       * Returns a new hash object for the same algorithm, used to hash from
+       * many threads at once
+       */
+      virtual Hash *Clone() const = 0;
+
       /**
        * Returns the blocksize of the underlying hash function
        */
@@ -39,6 +77,23 @@ namespace Crypto {
        * @param data the data to hash
        */
       virtual QByteArray ComputeHash(const QByteArray &data) = 0;
+
+      /**
+       * Restarts the hash object and calculates the hash of a region of
+       * memory, such as a slice of a larger message
+       * @param data the start of the region
+       * @param length the length of the region
+       */
+      virtual QByteArray ComputeHash(const char *data, int length) = 0;
+
+      /**
+       * Hashes each entry independently, as many calls to ComputeHash would.
+       * Large batches are split across threads, each with its own Clone.
+       * @param data the entries to hash
+       * @param parallel false to hash every entry on the calling thread
+       */
+      QVector<QByteArray> ComputeHashes(const QVector<QByteArray> &data,
+          bool parallel = true);
   };
 }
 }
@@ -11,6 +11,11 @@ namespace Dissent {
 namespace Crypto {
   class Library {
     public:
+      /**
+       * Constructor
+       */
+      Library() : _hash_algorithm(Hash::SHA1) {}
+
       /**
        * Load a public key from a file
        */
@@ -62,6 +67,23 @@ namespace Crypto {
        */
       virtual Hash *GetHashAlgorithm() = 0;
 
+      /**
+       * Selects the algorithm returned by GetHashAlgorithm, SHA1 by default.
+       * Every member of a group must use the same one.
+       * @param algo the algorithm
+       * @returns false if the library does not support it
+       */
+      virtual bool SetHashAlgorithm(Hash::Algorithm algo)
+      {
+        _hash_algorithm = algo;
+        return true;
+      }
+
+      /**
+       * Returns the algorithm returned by GetHashAlgorithm
+       */
+      inline Hash::Algorithm GetHashAlgorithmType() const { return _hash_algorithm; }
+
       /**
        * Returns an integer data
        */
@@ -98,6 +120,9 @@ namespace Crypto {
        * Destructor
        */
       virtual ~Library() {}
+
+    protected:
+      Hash::Algorithm _hash_algorithm;
   };
 }
 }
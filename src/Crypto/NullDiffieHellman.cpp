@@ -1,3 +1,4 @@
+#include "CryptoCost.hpp"
 #include "NullDiffieHellman.hpp"
 
 namespace Dissent {
@@ -24,6 +25,7 @@ namespace Crypto {
 
   QByteArray NullDiffieHellman::GetSharedSecret(const QByteArray &remote_pub) const
   {
+    CryptoCost::Charge(CryptoCost::SharedSecret);
     int size = std::min(_key.size(), remote_pub.size());
     QByteArray shared(size, 0);
     for(int idx = 0; idx < size; idx++) {
@@ -26,5 +26,10 @@ namespace Crypto {
     _current = QByteArray();
     return hash;
   }
+
+  QByteArray NullHash::ComputeHash(const char *data, int length)
+  {
+    return ComputeHash(QByteArray::fromRawData(data, length));
+  }
 }
 }
@@ -8,7 +8,8 @@
 namespace Dissent {
 namespace Crypto {
   /**
-   * Hash wrapper for CryptoPP::SHA1
+   * A fast, insecure hash for testing, the algorithm selected in the
+   * Library is ignored
    */
   class NullHash : public Hash {
       /**
@@ -16,11 +17,13 @@ namespace Crypto {
        */
       virtual ~NullHash() {}
 
+      virtual Hash *Clone() const { return new NullHash(); }
       inline virtual int GetDigestSize() { return sizeof(uint); }
       virtual void Restart();
       virtual void Update(const QByteArray &data);
       virtual QByteArray ComputeHash();
       virtual QByteArray ComputeHash(const QByteArray &data);
+      virtual QByteArray ComputeHash(const char *data, int length);
     private:
       QByteArray _current;
   };
@@ -1,3 +1,4 @@
+#include "CryptoCost.hpp"
 #include "NullPrivateKey.hpp"
 #include "Utils/Serialization.hpp"
 #include <QHash>
@@ -50,6 +51,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Sign);
     QByteArray sig(8, 0);
     Dissent::Utils::Serialization::WriteUInt(_key_id, sig, 0);
     Dissent::Utils::Serialization::WriteUInt(qHash(data), sig, 4);
@@ -62,6 +64,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Decrypt);
     uint key_id = Dissent::Utils::Serialization::ReadInt(data, 0);
     if(key_id != _key_id) {
       return QByteArray();
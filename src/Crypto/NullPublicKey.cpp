@@ -1,3 +1,4 @@
+#include "CryptoCost.hpp"
 #include "NullPublicKey.hpp"
 #include "Utils/Serialization.hpp"
 #include <QHash>
@@ -99,6 +100,7 @@ namespace Crypto {
       return false;
     }
 
+    CryptoCost::Charge(CryptoCost::Verify);
     uint key_id = Dissent::Utils::Serialization::ReadInt(sig, 0);
     uint hash = Dissent::Utils::Serialization::ReadInt(sig, 4);
     return hash == qHash(data) && key_id == _key_id;
@@ -110,6 +112,7 @@ namespace Crypto {
       return QByteArray();
     }
 
+    CryptoCost::Charge(CryptoCost::Encrypt);
     QByteArray base(8, 0);
     Dissent::Utils::Serialization::WriteUInt(_key_id, base, 0);
     Dissent::Utils::Serialization::WriteUInt(_unique++, base, 4);
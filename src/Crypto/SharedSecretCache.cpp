@@ -0,0 +1,78 @@
+#include <QMutexLocker>
+#include <QScopedPointer>
+
+#include "CryptoFactory.hpp"
+#include "DiffieHellman.hpp"
+#include "Hash.hpp"
+#include "SharedSecretCache.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  SharedSecretCache &SharedSecretCache::GetInstance()
+  {
+    static SharedSecretCache cache;
+    return cache;
+  }
+
+  SharedSecretCache::SharedSecretCache() :
+    _hits(0),
+    _misses(0)
+  {
+  }
+
+  QByteArray SharedSecretCache::GetSharedSecret(const DiffieHellman &local,
+      const QByteArray &remote_pub, bool *computed)
+  {
+    Key key(local.GetPublicComponent(), remote_pub);
+    if(computed) {
+      *computed = false;
+    }
+
+    {
+      QMutexLocker locker(&_lock);
+      QHash<Key, QByteArray>::const_iterator it = _secrets.find(key);
+      if(it != _secrets.end()) {
+        _hits++;
+        return it.value();
+      }
+    }
+
+    // Computed without the lock, two threads racing on the same pair both
+    // arrive at the same secret
+    QByteArray secret = local.GetSharedSecret(remote_pub);
+    if(computed) {
+      *computed = true;
+    }
+    QMutexLocker locker(&_lock);
+    _misses++;
+    if(!secret.isEmpty()) {
+      _secrets[key] = secret;
+    }
+    return secret;
+  }
+
+  QByteArray SharedSecretCache::DeriveSeed(const QByteArray &secret,
+      const QByteArray &round_id)
+  {
+    QScopedPointer<Hash> hash(
+        CryptoFactory::GetInstance().GetLibrary()->GetHashAlgorithm());
+    hash->Update(secret);
+    hash->Update(round_id);
+    return hash->ComputeHash();
+  }
+
+  void SharedSecretCache::Clear()
+  {
+    QMutexLocker locker(&_lock);
+    _secrets.clear();
+    _hits = 0;
+    _misses = 0;
+  }
+
+  int SharedSecretCache::Count()
+  {
+    QMutexLocker locker(&_lock);
+    return _secrets.count();
+  }
+}
+}
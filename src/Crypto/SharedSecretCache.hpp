@@ -0,0 +1,87 @@
+#ifndef DISSENT_CRYPTO_SHARED_SECRET_CACHE_H_GUARD
+#define DISSENT_CRYPTO_SHARED_SECRET_CACHE_H_GUARD
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+
+namespace Dissent {
+namespace Crypto {
+  class DiffieHellman;
+
+  /**
+   * Remembers the Diffie-Hellman shared secrets between long-term keys, so
+   * that rounds created from the same credentials do not repeat the modular
+   * exponentiations.  Entries are keyed by the public components of both
+   * sides.  Secrets taken from the cache must not be used as pad seeds
+   * directly, since they are identical every round, use DeriveSeed instead.
+   */
+  class SharedSecretCache {
+    public:
+      /**
+       * Returns a reference to the singleton
+       */
+      static SharedSecretCache &GetInstance();
+
+      /**
+       * Returns the shared secret between local and remote_pub, computing
+       * and storing it only the first time the pair is seen
+       * @param local the local long-term Diffie-Hellman key
+       * @param remote_pub the remote sides public component
+       * @param computed if not null, set to whether the secret was computed
+       * rather than found in the cache
+       */
+      QByteArray GetSharedSecret(const DiffieHellman &local,
+          const QByteArray &remote_pub, bool *computed = 0);
+
+      /**
+       * Derives a seed unique to one round from a long-term shared secret
+       * @param secret the shared secret
+       * @param round_id the round id (nonce)
+       */
+      static QByteArray DeriveSeed(const QByteArray &secret,
+          const QByteArray &round_id);
+
+      /**
+       * Removes every stored secret
+       */
+      void Clear();
+
+      /**
+       * Returns the number of stored secrets
+       */
+      int Count();
+
+      /**
+       * Returns the number of lookups answered from the cache
+       */
+      inline quint64 Hits() const { return _hits; }
+
+      /**
+       * Returns the number of lookups that had to compute the secret
+       */
+      inline quint64 Misses() const { return _misses; }
+
+    private:
+      /**
+       * No inheritance, this is a singleton object
+       */
+      explicit SharedSecretCache();
+
+      /**
+       * No copying of singleton objects
+       */
+      Q_DISABLE_COPY(SharedSecretCache)
+
+      typedef QPair<QByteArray, QByteArray> Key;
+
+      QMutex _lock;
+      QHash<Key, QByteArray> _secrets;
+      quint64 _hits;
+      quint64 _misses;
+  };
+}
+}
+
+#endif
@@ -1,14 +1,18 @@
 #ifndef DISSENT_DISSENT_H_GUARD
 #define DISSENT_DISSENT_H_GUARD
 
+#include "Anonymity/AggregatedBulkRound.hpp"
+#include "Anonymity/ArrivalLatency.hpp"
 #include "Anonymity/BulkRound.hpp"
 #include "Anonymity/Credentials.hpp"
+#include "Anonymity/EarlyArrivalQueue.hpp"
 #include "Anonymity/Group.hpp"
 #include "Anonymity/Log.hpp"
 #include "Anonymity/MessageRandomizer.hpp"
 #include "Anonymity/NullRound.hpp"
 #include "Anonymity/RepeatingBulkRound.hpp"
 #include "Anonymity/Round.hpp"
+#include "Anonymity/RoundMetrics.hpp"
 #include "Anonymity/Session.hpp"
 #include "Anonymity/SessionManager.hpp"
 #include "Anonymity/ShuffleRound.hpp"
@@ -29,6 +33,7 @@
 #include "Applications/Settings.hpp"
 
 #include "Crypto/AsymmetricKey.hpp"
+#include "Crypto/CppDhGroup.hpp"
 #include "Crypto/CppDiffieHellman.hpp"
 #include "Crypto/CppHash.hpp"
 #include "Crypto/CppIntegerData.hpp"
@@ -36,6 +41,7 @@
 #include "Crypto/CppPrivateKey.hpp"
 #include "Crypto/CppPublicKey.hpp"
 #include "Crypto/CppRandom.hpp"
+#include "Crypto/CryptoCost.hpp"
 #include "Crypto/CryptoFactory.hpp"
 #include "Crypto/DiffieHellman.hpp"
 #include "Crypto/CppHash.hpp"
@@ -50,6 +56,7 @@
 #include "Crypto/NullPublicKey.hpp"
 #include "Crypto/OnionEncryptor.hpp"
 #include "Crypto/Serialization.hpp"
+#include "Crypto/SharedSecretCache.hpp"
 #include "Crypto/ThreadedOnionEncryptor.hpp"
 
 #include "Connections/Bootstrapper.hpp"
@@ -90,10 +97,18 @@
 #include "Transports/EdgeFactory.hpp"
 #include "Transports/EdgeListener.hpp"
 #include "Transports/EdgeListenerFactory.hpp"
+#include "Transports/SimEdge.hpp"
+#include "Transports/SimEdgeListener.hpp"
+#include "Transports/SimNetwork.hpp"
+#include "Transports/SimTopology.hpp"
 #include "Transports/TcpAddress.hpp"
 #include "Transports/TcpEdge.hpp"
 #include "Transports/TcpEdgeListener.hpp"
 
+#include "Utils/AllocationCounter.hpp"
+#include "Utils/AsyncLogWriter.hpp"
+#include "Utils/BufferedRandom.hpp"
+#include "Utils/BufferPool.hpp"
 #include "Utils/Logging.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Random.hpp"
@@ -106,6 +121,7 @@
 #include "Utils/Timer.hpp"
 #include "Utils/TimerCallback.hpp"
 #include "Utils/TimerEvent.hpp"
+#include "Utils/TimerWheel.hpp"
 #include "Utils/Triggerable.hpp"
 #include "Utils/Triple.hpp"
 
@@ -119,6 +135,7 @@
 #include "Web/Services/GetMessagesService.hpp"
 #include "Web/Services/MessageWebService.hpp"
 #include "Web/Services/RoundIdService.hpp"
+#include "Web/Services/RoundMetricsService.hpp"
 #include "Web/Services/SendMessageService.hpp"
 #include "Web/Services/SessionIdService.hpp"
 #include "Web/Services/SessionWebService.hpp"
@@ -319,6 +319,69 @@ namespace Tests {
     ASSERT_TRUE(con.GetUserBit());
   }
 
+  TEST(BlameUtils, BlameMatrix_Wide) {
+    // Spans several words per row
+    const uint nusers = 150;
+    const uint nservers = 130;
+    BlameMatrix b(nusers, nservers);
+
+    QVector<QBitArray> rows(nusers, QBitArray(nservers));
+    for(uint user_idx = 0; user_idx < nusers; user_idx++) {
+      bool parity = false;
+      for(uint server_idx = 0; server_idx < nservers; server_idx++) {
+        bool bit = qrand() % 2;
+        rows[user_idx][server_idx] = bit;
+        parity ^= bit;
+      }
+      b.AddUserAlibi(user_idx, rows[user_idx]);
+      b.AddUserOutputBit(user_idx, parity);
+    }
+
+    for(uint server_idx = 0; server_idx < nservers; server_idx++) {
+      QBitArray column(nusers);
+      bool parity = false;
+      for(uint user_idx = 0; user_idx < nusers; user_idx++) {
+        column[user_idx] = rows[user_idx][server_idx];
+        parity ^= column[user_idx];
+      }
+
+      // Servers 64 and 129 lie about one user each
+      if(server_idx == 64) {
+        column.toggleBit(140);
+      } else if(server_idx == 129) {
+        column.toggleBit(7);
+      }
+      b.AddServerAlibi(server_idx, column);
+      b.AddServerOutputBit(server_idx, parity);
+    }
+
+    ASSERT_EQ(0, b.GetBadUsers().count());
+    QVector<int> bad_servers = b.GetBadServers();
+    ASSERT_EQ(2, bad_servers.count());
+    ASSERT_EQ(64, bad_servers[0]);
+    ASSERT_EQ(129, bad_servers[1]);
+
+    QList<Conflict> conflicts = b.GetConflicts(3);
+    ASSERT_EQ(2, conflicts.count());
+    ASSERT_EQ(7u, conflicts[0].GetUserIndex());
+    ASSERT_EQ(129u, conflicts[0].GetServerIndex());
+    ASSERT_EQ(rows[7].testBit(129), conflicts[0].GetUserBit());
+    ASSERT_EQ(!rows[7].testBit(129), conflicts[0].GetServerBit());
+    ASSERT_EQ(140u, conflicts[1].GetUserIndex());
+    ASSERT_EQ(64u, conflicts[1].GetServerIndex());
+
+    QVector<int> user_counts = b.GetUserConflictCounts();
+    QVector<int> server_counts = b.GetServerConflictCounts();
+    for(uint user_idx = 0; user_idx < nusers; user_idx++) {
+      int expected = (user_idx == 7 || user_idx == 140) ? 1 : 0;
+      ASSERT_EQ(expected, user_counts[user_idx]);
+    }
+    for(uint server_idx = 0; server_idx < nservers; server_idx++) {
+      int expected = (server_idx == 64 || server_idx == 129) ? 1 : 0;
+      ASSERT_EQ(expected, server_counts[server_idx]);
+    }
+  }
+
   TEST(BlameUtils, MessageHistory_Basic) {
     const uint nusers = 10;
     const uint nservers = 5;
@@ -329,16 +392,27 @@ namespace Tests {
     hist.NextPhase();
     const uint phase = 999;
     const uint slot = 8;
+
+    // Every slot is 20 bytes long
+    QVector<uint> offsets(nusers);
+    for(uint idx=0; idx<nusers; idx++) {
+      offsets[idx] = 20 * idx;
+    }
+
+    QVector<QByteArray> user_msgs(nusers);
     for(uint user_idx=0; user_idx<nusers; user_idx++) {
-      QByteArray msg(20, user_idx);
-      hist.AddUserMessage(phase, slot, user_idx, msg);
+      user_msgs[user_idx] = QByteArray(20 * nusers, 0);
+      user_msgs[user_idx].replace(offsets[slot], 20, QByteArray(20, user_idx));
     }
 
+    QVector<QByteArray> server_msgs(nservers);
     for(uint server_idx=0; server_idx<nservers; server_idx++) {
-      QByteArray msg(20, server_idx+93);
-      hist.AddServerMessage(phase, slot, server_idx, msg);
+      server_msgs[server_idx] = QByteArray(20 * nusers, 0);
+      server_msgs[server_idx].replace(offsets[slot], 20, QByteArray(20, server_idx+93));
     }
 
+    hist.AddPhase(phase, offsets, user_msgs, server_msgs);
+
     Accusation acc;
     // Phase 999, slot 7, bit index 3
     acc.SetData(phase, 7, (1 << 3));
@@ -353,5 +427,78 @@ namespace Tests {
       ASSERT_EQ((bool)((server_idx+93)&(1 << 3)), out);
     }
   }
+
+  TEST(BlameUtils, MessageHistory_Retention) {
+    const uint nusers = 4;
+    const uint nservers = 2;
+    MessageHistory hist(nusers, nservers);
+
+    QVector<uint> offsets(nusers);
+    for(uint idx=0; idx<nusers; idx++) {
+      offsets[idx] = 4 * idx;
+    }
+
+    QVector<QByteArray> user_msgs(nusers, QByteArray(4 * nusers, 0x7f));
+    QVector<QByteArray> server_msgs(nservers, QByteArray(4 * nusers, 0x01));
+
+    hist.AddPhase(0, offsets, user_msgs, server_msgs);
+    ASSERT_EQ(1, hist.RetainedPhaseCount());
+
+    // No corrupted slots, nothing is kept
+    hist.NextPhase();
+    ASSERT_EQ(0, hist.RetainedPhaseCount());
+
+    hist.AddPhase(1, offsets, user_msgs, server_msgs);
+    hist.MarkSlotCorrupted(2);
+    hist.NextPhase();
+    ASSERT_EQ(1, hist.RetainedPhaseCount());
+
+    Accusation acc;
+    acc.SetData(1, 3, (1 << 6));
+    ASSERT_TRUE(hist.GetUserOutputBit(2, 1, acc));
+    ASSERT_FALSE(hist.GetServerOutputBit(2, 1, acc));
+
+    hist.AddPhase(2, offsets, user_msgs, server_msgs);
+    hist.MarkSlotBlameFinished(2);
+    hist.NextPhase();
+    ASSERT_EQ(0, hist.RetainedPhaseCount());
+  }
+
+  TEST(BlameUtils, MessageHistory_MissingEvidence) {
+    const uint nusers = 4;
+    const uint nservers = 2;
+    MessageHistory hist(nusers, nservers);
+
+    QVector<uint> offsets(nusers);
+    for(uint idx=0; idx<nusers; idx++) {
+      offsets[idx] = 4 * idx;
+    }
+
+    QVector<QByteArray> user_msgs(nusers, QByteArray(4 * nusers, 0x7f));
+    QVector<QByteArray> server_msgs(nservers, QByteArray(4 * nusers, 0x01));
+
+    hist.AddPhase(1, offsets, user_msgs, server_msgs);
+    hist.MarkSlotCorrupted(2);
+    hist.NextPhase();
+
+    Accusation acc;
+    acc.SetData(1, 3, (1 << 6));
+    ASSERT_TRUE(hist.HasEvidence(2, acc));
+
+    // Slot 1 of phase 1 was not retained
+    ASSERT_FALSE(hist.HasEvidence(1, acc));
+    ASSERT_THROW(hist.GetUserOutputBit(1, 1, acc), QRunTimeError);
+
+    // Phase 5 was never seen
+    Accusation late;
+    late.SetData(5, 3, (1 << 6));
+    ASSERT_FALSE(hist.HasEvidence(2, late));
+    ASSERT_THROW(hist.GetServerOutputBit(2, 1, late), QRunTimeError);
+
+    // Byte 4 lies in the next slot
+    Accusation past;
+    past.SetData(1, 4, (1 << 6));
+    ASSERT_FALSE(hist.HasEvidence(2, past));
+  }
 }
 }
@@ -0,0 +1,58 @@
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  TEST(BufferPool, Reuse)
+  {
+    BufferPool pool;
+    QByteArray &first = pool.Acquire(1024);
+    QByteArray &second = pool.Acquire(64);
+    EXPECT_EQ(first.size(), 1024);
+    EXPECT_EQ(second.size(), 64);
+    EXPECT_EQ(pool.Count(), 2);
+    EXPECT_EQ(pool.Misses(), 2);
+
+    const char *first_data = first.constData();
+    const char *second_data = second.constData();
+
+    pool.Reset();
+    EXPECT_EQ(pool.InUse(), 0);
+    EXPECT_EQ(pool.Acquire(1000).constData(), first_data);
+    EXPECT_EQ(pool.Acquire(64).constData(), second_data);
+    EXPECT_EQ(pool.Count(), 2);
+    EXPECT_EQ(pool.Misses(), 2);
+
+    // Growing, or shrinking below half, cannot reuse the memory
+    pool.Reset();
+    EXPECT_EQ(pool.Acquire(4096).size(), 4096);
+    EXPECT_EQ(pool.Acquire(16).size(), 16);
+    EXPECT_EQ(pool.Misses(), 4);
+  }
+
+  TEST(BufferPool, Shared)
+  {
+    BufferPool pool;
+    QByteArray &buffer = pool.Acquire(128);
+    buffer.fill('a');
+    QByteArray copy = buffer;
+
+    // The copy keeps its contents when the slot is handed out again
+    pool.Reset();
+    QByteArray &again = pool.Acquire(128);
+    again.fill('b');
+    EXPECT_EQ(copy, QByteArray(128, 'a'));
+    EXPECT_EQ(again, QByteArray(128, 'b'));
+    EXPECT_EQ(pool.Misses(), 2);
+
+    // References stay valid as the pool grows
+    pool.Reset();
+    QByteArray &held = pool.Acquire(128);
+    for(int idx = 0; idx < 64; idx++) {
+      pool.Acquire(32);
+    }
+    held.fill('c');
+    pool.Reset();
+    EXPECT_EQ(pool.Acquire(128), QByteArray(128, 'c'));
+  }
+}
+}
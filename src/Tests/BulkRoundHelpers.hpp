@@ -139,6 +139,32 @@ namespace Tests {
       }
   };
 
+  /**
+   * An aggregating leader that leaves the next member's xor message out of
+   * its signed commitment
+   */
+  class AggregatedBulkRoundBadLeader : public AggregatedBulkRound,
+      public Triggerable
+  {
+    public:
+      explicit AggregatedBulkRoundBadLeader(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> network, GetDataCallback &get_data) :
+        AggregatedBulkRound(group, creds, round_id, network, get_data)
+      {
+      }
+
+    protected:
+      virtual void SendAggregatedBulkData()
+      {
+        QVector<QByteArray> &hashes = GetInputHashes();
+        int idx = (GetGroup().GetIndex(GetLocalId()) + 1) % hashes.count();
+        hashes[idx] = QByteArray(hashes[idx].size(), 0);
+        SetTriggered();
+        AggregatedBulkRound::SendAggregatedBulkData();
+      }
+  };
+
   /// @todo not implemented
   class BulkRoundFalseAccusation : public BulkRound, public Triggerable {
     public:
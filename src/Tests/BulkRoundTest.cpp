@@ -104,5 +104,36 @@ namespace Tests {
         Group::FixedSubgroup,
         TBadGuyCB<badbulk>);
   }
+
+  TEST(BulkRound, HashXor)
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
+    QScopedPointer<Hash> hash(lib->GetHashAlgorithm());
+
+    // Spans several blocks and ends off a word boundary, read from an
+    // unaligned offset
+    int length = 3 * HashXorBlockSize + 13;
+    QVector<QByteArray> regions;
+    QVector<const char *> starts;
+    for(int idx = 0; idx < 5; idx++) {
+      QByteArray region(length + 1, 0);
+      rand->GenerateBlock(region);
+      regions.append(region);
+      starts.append(regions.last().constData() + 1);
+    }
+
+    QByteArray expected(length, 0);
+    QVector<QByteArray> expected_hashes;
+    foreach(const QByteArray &region, regions) {
+      QByteArray slice = region.mid(1);
+      expected_hashes.append(hash->ComputeHash(slice));
+      Xor(expected, expected, slice);
+    }
+
+    QByteArray actual(length, 0);
+    EXPECT_EQ(expected_hashes, HashXor(hash.data(), actual.data(), starts, length));
+    EXPECT_EQ(expected, actual);
+  }
 }
 }
@@ -326,6 +326,49 @@ namespace Tests {
     DiffieHellmanTest(lib.data());
   }
 
+  TEST(Crypto, SharedSecretCache)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    QScopedPointer<DiffieHellman> dh0(lib->CreateDiffieHellman());
+    QScopedPointer<DiffieHellman> dh1(lib->CreateDiffieHellman());
+    QScopedPointer<DiffieHellman> dh2(lib->CreateDiffieHellman());
+
+    SharedSecretCache &cache = SharedSecretCache::GetInstance();
+    cache.Clear();
+
+    bool computed = false;
+    QByteArray shared_0_1 = cache.GetSharedSecret(*dh0,
+        dh1->GetPublicComponent(), &computed);
+    EXPECT_TRUE(computed);
+    EXPECT_EQ(dh0->GetSharedSecret(dh1->GetPublicComponent()), shared_0_1);
+
+    EXPECT_EQ(shared_0_1, cache.GetSharedSecret(*dh0,
+          dh1->GetPublicComponent(), &computed));
+    EXPECT_FALSE(computed);
+    EXPECT_EQ(shared_0_1, cache.GetSharedSecret(*dh1,
+          dh0->GetPublicComponent(), &computed));
+    EXPECT_TRUE(computed);
+
+    QByteArray shared_0_2 = cache.GetSharedSecret(*dh0, dh2->GetPublicComponent());
+    EXPECT_NE(shared_0_1, shared_0_2);
+    EXPECT_EQ(3, cache.Count());
+    EXPECT_EQ(1, (int) cache.Hits());
+    EXPECT_EQ(3, (int) cache.Misses());
+
+    Id round0, round1;
+    QByteArray seed0 = SharedSecretCache::DeriveSeed(shared_0_1,
+        round0.GetByteArray());
+    EXPECT_EQ(seed0, SharedSecretCache::DeriveSeed(shared_0_1,
+          round0.GetByteArray()));
+    EXPECT_NE(seed0, SharedSecretCache::DeriveSeed(shared_0_1,
+          round1.GetByteArray()));
+    EXPECT_NE(seed0, SharedSecretCache::DeriveSeed(shared_0_2,
+          round0.GetByteArray()));
+
+    cache.Clear();
+    EXPECT_EQ(0, cache.Count());
+  }
+
   void ZeroKnowledgeTest(Library* lib, bool test_bit_flip) 
   {
     QScopedPointer<DiffieHellman> dhA(lib->CreateDiffieHellman());
@@ -348,6 +391,81 @@ namespace Tests {
     }
   }
 
+  TEST(Crypto, CppDhGroup)
+  {
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    const CryptoPP::Integer &p = group.GetModulus();
+    const CryptoPP::Integer &g = group.GetGenerator();
+
+    CryptoPP::Integer e1 = group.GetRandomExponent();
+    CryptoPP::Integer e2 = group.GetRandomExponent();
+    EXPECT_NE(e1, e2);
+    EXPECT_TRUE(e1 > 0 && e1 < group.GetOrder());
+
+    CryptoPP::Integer y = CryptoPP::a_exp_b_mod_c(g, e2, p);
+    EXPECT_EQ(CryptoPP::a_exp_b_mod_c(g, e1, p), group.ExponentiateBase(e1));
+    EXPECT_EQ(CryptoPP::a_exp_b_mod_c(y, e1, p), group.Exponentiate(y, e1));
+    EXPECT_EQ(CryptoPP::Integer::One(), group.ExponentiateBase(group.GetOrder()));
+
+    CryptoPP::Integer expected = CryptoPP::a_times_b_mod_c(
+        CryptoPP::a_exp_b_mod_c(g, e1, p), CryptoPP::a_exp_b_mod_c(y, e2, p), p);
+    EXPECT_EQ(expected, group.CascadeExponentiate(g, e1, y, e2));
+    EXPECT_EQ(expected, group.CascadeExponentiateBase(e1, y, e2));
+  }
+
+  void BatchZeroKnowledgeTest(Library *lib, bool test_invalid)
+  {
+    QScopedPointer<DiffieHellman> verifier(lib->CreateDiffieHellman());
+    QVector<QByteArray> prover_pubs, remote_pubs, proofs, expected;
+    for(int idx = 0; idx < 8; idx++) {
+      QScopedPointer<DiffieHellman> prover(lib->CreateDiffieHellman());
+      QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+      prover_pubs.append(prover->GetPublicComponent());
+      remote_pubs.append(remote->GetPublicComponent());
+      proofs.append(prover->ProveSharedSecret(remote_pubs.last()));
+      expected.append(prover->GetSharedSecret(remote_pubs.last()));
+    }
+
+    EXPECT_EQ(expected, verifier->VerifySharedSecrets(prover_pubs,
+          remote_pubs, proofs));
+
+    if(test_invalid) {
+      // Proofs for a different pair of keys
+      qSwap(remote_pubs[1], remote_pubs[2]);
+      expected[1] = QByteArray();
+      expected[2] = QByteArray();
+
+      // The response is not covered by the challenge, so this proof is only
+      // caught by the combined check and then the individual ones
+      int offset = 24;
+      for(int field = 0; field < 3; field++) {
+        offset += Serialization::ReadInt(proofs[5], 4 + field * 4);
+      }
+      proofs[5][offset - 1] = proofs[5][offset - 1] ^ 1;
+      expected[5] = QByteArray();
+    }
+
+    QVector<QByteArray> secrets = verifier->VerifySharedSecrets(prover_pubs,
+        remote_pubs, proofs);
+    EXPECT_EQ(expected, secrets);
+    for(int idx = 0; idx < proofs.count(); idx++) {
+      EXPECT_EQ(verifier->VerifySharedSecret(prover_pubs[idx],
+            remote_pubs[idx], proofs[idx]), secrets[idx]);
+    }
+  }
+
+  TEST(Crypto, NullBatchZeroKnowledgeDhTest)
+  {
+    QScopedPointer<Library> lib(new NullLibrary());
+    BatchZeroKnowledgeTest(lib.data(), false);
+  }
+
+  TEST(Crypto, CppBatchZeroKnowledgeDhTest)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    BatchZeroKnowledgeTest(lib.data(), true);
+  }
+
   TEST(Crypto, NullZeroKnowledgeDhTest)
   {
     QScopedPointer<Library> lib(new NullLibrary());
@@ -359,5 +477,114 @@ namespace Tests {
     QScopedPointer<Library> lib(new CppLibrary());
     ZeroKnowledgeTest(lib.data(), true);
   }
+
+  TEST(Crypto, CppZeroKnowledgeDhNegatedSecret)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    CppDhGroup &group = CppDhGroup::GetInstance();
+    const CryptoPP::Integer &p = group.GetModulus();
+    const CryptoPP::Integer &q = group.GetOrder();
+
+    QScopedPointer<DiffieHellman> verifier(lib->CreateDiffieHellman());
+    QScopedPointer<DiffieHellman> prover(lib->CreateDiffieHellman());
+    QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+    QByteArray prover_pub = prover->GetPublicComponent();
+    QByteArray remote_pub = remote->GetPublicComponent();
+
+    // Claim -g^ab, i.e., g^ab * (p-1), as the secret, this has order 2q and
+    // passes t_2 == (g^b)^r * (dh_secret)^c whenever c is even
+    CryptoPP::Integer secret = CppIntegerData(
+        prover->GetSharedSecret(remote_pub)).GetCryptoInteger();
+    QByteArray dh_secret = CppIntegerData(p - secret).GetByteArray();
+    CryptoPP::Integer prover_priv = CppIntegerData(
+        prover->GetPrivateComponent()).GetCryptoInteger();
+    CryptoPP::Integer public_key_b = CppIntegerData(remote_pub).GetCryptoInteger();
+    QByteArray gen = CppIntegerData(group.GetGenerator()).GetByteArray();
+
+    CryptoPP::Integer value, challenge;
+    QByteArray commit_1, commit_2, challenge_bytes;
+    do {
+      value = group.GetRandomExponent();
+      commit_1 = CppIntegerData(group.ExponentiateBase(value)).GetByteArray();
+      commit_2 = CppIntegerData(group.Exponentiate(public_key_b,
+            value)).GetByteArray();
+      challenge_bytes = CppHash().ComputeHash(gen + prover_pub + remote_pub +
+          dh_secret + commit_1 + commit_2);
+      challenge = CppIntegerData(challenge_bytes).GetCryptoInteger();
+    } while(challenge.IsOdd());
+
+    CryptoPP::ModularArithmetic mod_arith_q(q);
+    QByteArray response = CppIntegerData(mod_arith_q.Subtract(value,
+          mod_arith_q.Multiply(challenge % q, prover_priv))).GetByteArray();
+
+    QByteArray header(24, 0);
+    Serialization::WriteInt(-1, header, 0);
+    Serialization::WriteInt(dh_secret.count(), header, 4);
+    Serialization::WriteInt(challenge_bytes.count(), header, 8);
+    Serialization::WriteInt(response.count(), header, 12);
+    Serialization::WriteInt(commit_1.count(), header, 16);
+    Serialization::WriteInt(commit_2.count(), header, 20);
+    QByteArray proof = header + dh_secret + challenge_bytes + response +
+      commit_1 + commit_2;
+
+    EXPECT_TRUE(verifier->VerifySharedSecret(prover_pub, remote_pub,
+          proof).isEmpty());
+
+    QVector<QByteArray> prover_pubs, remote_pubs, proofs, expected;
+    for(int idx = 0; idx < 4; idx++) {
+      QScopedPointer<DiffieHellman> honest(lib->CreateDiffieHellman());
+      QScopedPointer<DiffieHellman> other(lib->CreateDiffieHellman());
+      prover_pubs.append(honest->GetPublicComponent());
+      remote_pubs.append(other->GetPublicComponent());
+      proofs.append(honest->ProveSharedSecret(remote_pubs.last()));
+      expected.append(honest->GetSharedSecret(remote_pubs.last()));
+    }
+
+    prover_pubs[2] = prover_pub;
+    remote_pubs[2] = remote_pub;
+    proofs[2] = proof;
+    expected[2] = QByteArray();
+
+    EXPECT_EQ(expected, verifier->VerifySharedSecrets(prover_pubs,
+          remote_pubs, proofs));
+  }
+
+  TEST(Crypto, CppZeroKnowledgeDhLegacyProof)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    QScopedPointer<DiffieHellman> verifier(lib->CreateDiffieHellman());
+
+    QVector<QByteArray> prover_pubs, remote_pubs, proofs, expected;
+    for(int idx = 0; idx < 4; idx++) {
+      QScopedPointer<DiffieHellman> prover(lib->CreateDiffieHellman());
+      QScopedPointer<DiffieHellman> remote(lib->CreateDiffieHellman());
+      prover_pubs.append(prover->GetPublicComponent());
+      remote_pubs.append(remote->GetPublicComponent());
+      expected.append(prover->GetSharedSecret(remote_pubs.last()));
+
+      // Strip the format and commitments, leaving the three field proof the
+      // code before the commitments produced
+      QByteArray proof = prover->ProveSharedSecret(remote_pubs.last());
+      QByteArray header(12, 0);
+      int length = 0;
+      for(int field = 0; field < 3; field++) {
+        int field_length = Serialization::ReadInt(proof, 4 + field * 4);
+        Serialization::WriteInt(field_length, header, field * 4);
+        length += field_length;
+      }
+      proofs.append(header + proof.mid(24, length));
+
+      EXPECT_EQ(expected.last(), verifier->VerifySharedSecret(
+            prover_pubs.last(), remote_pubs.last(), proofs.last()));
+    }
+
+    EXPECT_EQ(expected, verifier->VerifySharedSecrets(prover_pubs,
+          remote_pubs, proofs));
+
+    proofs[1][proofs[1].size() - 1] = proofs[1][proofs[1].size() - 1] ^ 1;
+    expected[1] = QByteArray();
+    EXPECT_EQ(expected, verifier->VerifySharedSecrets(prover_pubs,
+          remote_pubs, proofs));
+  }
 }
 }
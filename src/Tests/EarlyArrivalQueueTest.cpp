@@ -0,0 +1,66 @@
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  TEST(EarlyArrivalQueue, Order)
+  {
+    EarlyArrivalQueue queue;
+    Id first, second;
+
+    EXPECT_TRUE(queue.Push(QByteArray("phase 1 data + sig"), 13, first, 1, 2));
+    EXPECT_TRUE(queue.Push(QByteArray("phase 1 data + other sig"), 13, second, 1, 2));
+    EXPECT_TRUE(queue.Push(QByteArray("phase 2 data + sig"), 13, first, 2, 2));
+    EXPECT_EQ(queue.Count(), 3);
+    EXPECT_EQ(queue.GetBytes(first), 36);
+
+    QList<EarlyArrivalQueue::Entry> entries = queue.TakeAll();
+    ASSERT_EQ(entries.count(), 3);
+    EXPECT_EQ(entries[0].from, first);
+    EXPECT_EQ(entries[0].GetPayload(), QByteArray("phase 1 data "));
+    EXPECT_EQ(entries[1].from, second);
+    EXPECT_EQ(entries[2].phase, uint(2));
+    EXPECT_EQ(entries[2].type, 2);
+
+    EXPECT_EQ(queue.Count(), 0);
+    EXPECT_EQ(queue.GetBytes(first), 0);
+    EXPECT_EQ(queue.GetDropped(), 0);
+  }
+
+  TEST(EarlyArrivalQueue, Duplicates)
+  {
+    EarlyArrivalQueue queue;
+    Id from, other;
+    QByteArray data("message + sig");
+
+    EXPECT_TRUE(queue.Push(data, 7, from, 1, 1));
+    EXPECT_FALSE(queue.Push(data, 7, from, 1, 1));
+    EXPECT_TRUE(queue.Push(data, 7, from, 2, 1));
+    EXPECT_TRUE(queue.Push(data, 7, from, 1, 3));
+    EXPECT_TRUE(queue.Push(data, 7, other, 1, 1));
+    EXPECT_EQ(queue.Count(), 4);
+    EXPECT_EQ(queue.GetDropped(), 1);
+  }
+
+  TEST(EarlyArrivalQueue, Limits)
+  {
+    EarlyArrivalQueue queue(4, 100);
+    Id flooder, honest;
+
+    for(int idx = 0; idx < 10; idx++) {
+      bool queued = queue.Push(QByteArray(10, char(idx)), 5, flooder, idx, 0);
+      EXPECT_EQ(queued, idx < 4);
+    }
+    EXPECT_EQ(queue.GetBytes(flooder), 40);
+    EXPECT_EQ(queue.GetDropped(), 6);
+
+    // Other senders are unaffected, but none may exceed its byte budget
+    EXPECT_TRUE(queue.Push(QByteArray(60, 0), 40, honest, 0, 0));
+    EXPECT_FALSE(queue.Push(QByteArray(60, 1), 40, honest, 1, 0));
+    EXPECT_TRUE(queue.Push(QByteArray(40, 1), 20, honest, 1, 0));
+    EXPECT_EQ(queue.Count(), 6);
+
+    queue.Clear();
+    EXPECT_TRUE(queue.Push(QByteArray(10, 0), 5, flooder, 0, 0));
+  }
+}
+}
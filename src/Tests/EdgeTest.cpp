@@ -140,5 +140,77 @@ namespace Tests {
     MockExecLoop(sc);
     EXPECT_EQ(sc.GetCount(), 1);
   }
+
+  TEST(EdgeTest, SimNetworkSchedule)
+  {
+    Timer::GetInstance().UseVirtualTime();
+    SimNetwork &network = SimNetwork::GetInstance();
+    network.Reset();
+
+    // 100 bytes per ms, 20 ms latency
+    network.SetTopology(QSharedPointer<SimTopology>(
+          new UniformTopology(SimLink(20, 0, 100))));
+
+    qint64 link_free = 0, last_arrival = 0;
+    EXPECT_EQ(network.ScheduleDelivery(1, 2, 1000, link_free, last_arrival), 30);
+    // Queued behind the first message on the link
+    EXPECT_EQ(network.ScheduleDelivery(1, 2, 1000, link_free, last_arrival), 40);
+    EXPECT_EQ(network.GetMessagesSent(), 2);
+    EXPECT_EQ(network.GetBytesSent(), 2000);
+
+    // Crypto charged to a node delays its messages
+    network.SetCost(CryptoCost::Sign, 5000);
+    int previous = network.SetCurrentNode(1);
+    CryptoCost::Charge(CryptoCost::Sign);
+    network.SetCurrentNode(previous);
+    CryptoCost::Charge(CryptoCost::Sign);
+    EXPECT_EQ(network.GetCpuTime(1), 5000);
+
+    // Key operations charge through the hook
+    network.SetCost(CryptoCost::Decrypt, 2000);
+    QScopedPointer<AsymmetricKey> key(new NullPrivateKey());
+    QByteArray ciphertext = key->Encrypt(QByteArray(10, 'a'));
+    previous = network.SetCurrentNode(2);
+    EXPECT_FALSE(key->Decrypt(ciphertext).isEmpty());
+    network.SetCurrentNode(previous);
+    EXPECT_EQ(network.GetCpuTime(2), 2000);
+
+    qint64 busy_free = 0, busy_arrival = 0;
+    EXPECT_EQ(network.ScheduleDelivery(1, 3, 0, busy_free, busy_arrival), 25);
+    qint64 idle_free = 0, idle_arrival = 0;
+    EXPECT_EQ(network.ScheduleDelivery(2, 3, 0, idle_free, idle_arrival), 20);
+
+    // Every transmission is lost, so the message goes out after the
+    // maximum number of retransmissions with exponential backoff
+    network.SetTopology(QSharedPointer<SimTopology>(
+          new UniformTopology(SimLink(10, 0, 0, 1.0))));
+    link_free = last_arrival = 0;
+    qint64 backoff = 0;
+    for(int idx = 0; idx < SimNetwork::MaxRetransmissions; idx++) {
+      backoff += SimNetwork::MinRetransmitTimeout << idx;
+    }
+    EXPECT_EQ(network.ScheduleDelivery(1, 2, 10, link_free, last_arrival),
+        10 + backoff);
+    EXPECT_EQ(network.GetRetransmissions(), SimNetwork::MaxRetransmissions);
+
+    // Jitter never reorders a link
+    network.SetTopology(QSharedPointer<SimTopology>(
+          new RegionTopology(2, SimLink(1), SimLink(10, 50))));
+    link_free = last_arrival = 0;
+    qint64 last = 0;
+    for(int idx = 0; idx < 100; idx++) {
+      qint64 delay = network.ScheduleDelivery(1, 2, 10, link_free, last_arrival);
+      EXPECT_GE(delay, last);
+      EXPECT_LE(delay, 60);
+      last = delay;
+    }
+    link_free = last_arrival = 0;
+    EXPECT_EQ(network.ScheduleDelivery(2, 4, 10, link_free, last_arrival), 1);
+
+    network.SetCost(CryptoCost::Sign, 1000);
+    network.SetCost(CryptoCost::Decrypt, 1000);
+    network.SetTopology(QSharedPointer<SimTopology>(new UniformTopology()));
+    network.Reset();
+  }
 }
 }
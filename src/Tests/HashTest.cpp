@@ -35,5 +35,61 @@ namespace Tests {
     QScopedPointer<Hash> hashalgo(new CppHash());
     HashTest(hashalgo.data());
   }
+
+  TEST(Crypto, CppHashAlgorithms)
+  {
+    QByteArray data("abc");
+    QScopedPointer<Hash> sha256(new CppHash(Hash::SHA256));
+    EXPECT_EQ(sha256->GetDigestSize(), 32);
+    EXPECT_EQ(sha256->ComputeHash(data).toHex(), QByteArray(
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    HashTest(sha256.data());
+
+    QScopedPointer<Hash> sha512(new CppHash(Hash::SHA512));
+    EXPECT_EQ(sha512->GetDigestSize(), 64);
+    HashTest(sha512.data());
+
+    if(CppHash::IsSupported(Hash::BLAKE2b)) {
+      QScopedPointer<Hash> blake2b(new CppHash(Hash::BLAKE2b));
+      HashTest(blake2b.data());
+    }
+
+    Hash::Algorithm algo;
+    EXPECT_TRUE(Hash::AlgorithmFromString("SHA256", algo));
+    EXPECT_EQ(algo, Hash::SHA256);
+    EXPECT_EQ(Hash::AlgorithmToString(algo), QString("sha256"));
+    EXPECT_FALSE(Hash::AlgorithmFromString("md5", algo));
+
+    CppLibrary lib;
+    EXPECT_TRUE(lib.SetHashAlgorithm(Hash::SHA256));
+    QScopedPointer<Hash> selected(lib.GetHashAlgorithm());
+    EXPECT_EQ(selected->ComputeHash(data), sha256->ComputeHash(data));
+  }
+
+  TEST(Crypto, ComputeHashes)
+  {
+    QByteArray data(500 * 256, 0);
+    CppRandom rand;
+    rand.GenerateBlock(data);
+
+    QVector<QByteArray> slices;
+    for(int idx = 0; idx < 500; idx++) {
+      slices.append(QByteArray::fromRawData(data.constData() + idx * 256, 256));
+    }
+
+    // Force the threaded path regardless of the batch size
+    int threshold = Hash::ParallelThreshold;
+    Hash::ParallelThreshold = 0;
+    QScopedPointer<Hash> hashalgo(new CppHash(Hash::SHA256));
+    QVector<QByteArray> hashes = hashalgo->ComputeHashes(slices);
+    Hash::ParallelThreshold = threshold;
+
+    ASSERT_EQ(hashes.count(), slices.count());
+    for(int idx = 0; idx < slices.count(); idx++) {
+      EXPECT_EQ(hashes[idx], hashalgo->ComputeHash(slices[idx]));
+      EXPECT_EQ(hashes[idx], hashalgo->ComputeHash(slices[idx].constData(),
+            slices[idx].size()));
+    }
+  }
 }
 }
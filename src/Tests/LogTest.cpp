@@ -63,5 +63,131 @@ namespace Tests {
     log.Append(data, id);
     EXPECT_NE(log.Count(), in_log.Count());
   }
+
+  TEST(Log, Compressed)
+  {
+    Log log;
+    QVector<Id> ids;
+    for(int idx = 0; idx < 5; idx++) {
+      ids.append(Id());
+    }
+
+    QByteArray shared(1000, 'a');
+    for(int idx = 0; idx < 50; idx++) {
+      log.Append(idx % 2 ? shared : QByteArray(200 + idx, char(idx)),
+          ids[idx % ids.count()]);
+    }
+
+    QByteArray plain = log.Serialize();
+    QByteArray packed = log.Serialize(true);
+    EXPECT_LT(packed.size(), plain.size());
+
+    Log plain_log(plain);
+    Log packed_log(packed);
+    ASSERT_EQ(log.Count(), plain_log.Count());
+    ASSERT_EQ(log.Count(), packed_log.Count());
+    for(int idx = 0; idx < log.Count(); idx++) {
+      EXPECT_EQ(log.At(idx), plain_log.At(idx));
+      EXPECT_EQ(log.At(idx), packed_log.At(idx));
+    }
+    EXPECT_EQ(log.GetDigest(), packed_log.GetDigest());
+
+    // A copy outlives the log it was parsed into
+    Log copy;
+    {
+      Log parsed(plain);
+      copy = parsed;
+    }
+    EXPECT_EQ(log.At(1).first, copy.At(1).first);
+
+    EXPECT_EQ(0, Log(plain.left(plain.size() - 1)).Count());
+    EXPECT_EQ(0, Log(QByteArray(100, 0)).Count());
+  }
+
+  TEST(Log, OversizedCompressedEntry)
+  {
+    Log log;
+    QByteArray data(1000, 'a');
+    log.Append(data, Id());
+
+    QByteArray packed = log.Serialize(true);
+    ASSERT_EQ(1, Log(packed).Count());
+
+    // The compressed payload is last and begins with its inflated size
+    int offset = packed.size() - qCompress(data).size();
+    packed[offset] = char(0x7f);
+    packed[offset + 1] = char(0xff);
+    packed[offset + 2] = char(0xff);
+    packed[offset + 3] = char(0xff);
+    EXPECT_EQ(0, Log(packed).Count());
+
+    // One byte past the limit
+    quint32 size = Log::MaxCompressedEntrySize + 1;
+    for(int idx = 0; idx < 4; idx++) {
+      packed[offset + idx] = char((size >> (24 - 8 * idx)) & 0xff);
+    }
+    EXPECT_EQ(0, Log(packed).Count());
+  }
+
+  TEST(Log, SharedCompressedEntry)
+  {
+    Log log;
+    Id id;
+    QByteArray data(1000, 'a');
+    log.Append(data, id);
+    log.Append(QByteArray(1000, 'a'), id);
+
+    QByteArray packed = log.Serialize(true);
+    ASSERT_EQ(2, Log(packed).Count());
+
+    // Point the second index entry at the first entry's payload
+    int packed_size = qCompress(data).size();
+    int index = packed.size() - 2 * packed_size - 2 * Log::IndexEntrySize;
+    ASSERT_EQ(0, Serialization::ReadInt(packed, index + 4));
+    ASSERT_EQ(packed_size, Serialization::ReadInt(packed,
+          index + Log::IndexEntrySize + 4));
+    Serialization::WriteInt(0, packed, index + Log::IndexEntrySize + 4);
+    EXPECT_EQ(0, Log(packed).Count());
+  }
+
+  TEST(Log, Partial)
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
+
+    Log log;
+    QByteArray data(64, 0);
+    for(int idx = 0; idx < 20; idx++) {
+      rand->GenerateBlock(data);
+      log.Append(data, Id());
+    }
+    QByteArray digest = log.GetDigest();
+
+    QVector<int> indices;
+    indices << 3 << 7 << 19;
+    QByteArray partial = log.Serialize(indices);
+    EXPECT_LT(partial.size(), log.Serialize().size());
+
+    Log partial_log(partial);
+    ASSERT_EQ(log.Count(), partial_log.Count());
+    EXPECT_EQ(digest, partial_log.GetDigest());
+    for(int idx = 0; idx < log.Count(); idx++) {
+      EXPECT_EQ(indices.contains(idx), partial_log.Contains(idx));
+      EXPECT_EQ(log.At(idx).second, partial_log.At(idx).second);
+      EXPECT_EQ(log.GetEntryHash(idx), partial_log.GetEntryHash(idx));
+      if(indices.contains(idx)) {
+        EXPECT_EQ(log.At(idx).first, partial_log.At(idx).first);
+      } else {
+        EXPECT_TRUE(partial_log.At(idx).first.isEmpty());
+      }
+    }
+
+    // An altered entry no longer matches the digest
+    int payload = partial.size() - 1;
+    partial[payload] = partial[payload] ^ 0x01;
+    Log altered_log(partial);
+    ASSERT_EQ(log.Count(), altered_log.Count());
+    EXPECT_NE(digest, altered_log.GetDigest());
+  }
 }
 }
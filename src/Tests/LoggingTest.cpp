@@ -0,0 +1,56 @@
+#include <QFile>
+
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  TEST(Logging, AsyncFile)
+  {
+    QString filename = "async_test.log";
+    QFile::remove(filename);
+
+    Logging::UseAsyncFile(filename);
+    const int count = 1000;
+    for(int idx = 0; idx < count; idx++) {
+      qDebug() << "line" << idx;
+    }
+    Logging::FlushAsync();
+    EXPECT_EQ(Logging::AsyncDropped(), 0);
+    Logging::UseFile("test.log");
+
+    QFile file(filename);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QList<QByteArray> lines = file.readAll().split('\n');
+    file.close();
+    QFile::remove(filename);
+
+    // The last element is the empty remainder after the final newline
+    ASSERT_EQ(lines.count(), count + 1);
+    for(int idx = 0; idx < count; idx++) {
+      EXPECT_TRUE(lines[idx].endsWith("line " + QByteArray::number(idx)));
+    }
+  }
+
+  TEST(Logging, Levels)
+  {
+    EXPECT_TRUE(Logging::IsEnabled("round.bulk", QtDebugMsg));
+
+    Logging::SetLevel(QtWarningMsg);
+    EXPECT_FALSE(Logging::IsEnabled("round.bulk", QtDebugMsg));
+    EXPECT_TRUE(Logging::IsEnabled("round.bulk", QtWarningMsg));
+
+    Logging::SetCategoryLevel("round.bulk", QtDebugMsg);
+    EXPECT_TRUE(Logging::IsEnabled("round.bulk", QtDebugMsg));
+    EXPECT_FALSE(Logging::IsEnabled("round.blame", QtDebugMsg));
+
+    Logging::SetLevel(QtDebugMsg);
+    Logging::SetCategoryLevel("round.blame", QtCriticalMsg);
+    EXPECT_FALSE(Logging::IsEnabled("round.blame", QtWarningMsg));
+    EXPECT_TRUE(Logging::IsEnabled("round.blame", QtCriticalMsg));
+    EXPECT_TRUE(Logging::IsEnabled("other", QtDebugMsg));
+
+    Logging::ClearCategoryLevels();
+    EXPECT_TRUE(Logging::IsEnabled("round.blame", QtDebugMsg));
+  }
+}
+}
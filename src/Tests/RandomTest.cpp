@@ -90,5 +90,41 @@ namespace Tests {
     QScopedPointer<Library> lib(new CppLibrary());
     SeededRandomTest(lib.data());
   }
+
+  void BufferedRandomTest(Library *lib)
+  {
+    QScopedPointer<Random> rng(lib->GetRandomNumberGenerator());
+    QByteArray seed(20, 0);
+    rng->GenerateBlock(seed);
+
+    QScopedPointer<Random> base(lib->GetRandomNumberGenerator(seed));
+    QByteArray expected(1000, 0);
+    base->GenerateBlock(expected);
+
+    // Odd sized requests mixed with prefetches return the same stream
+    BufferedRandom brng(lib->GetRandomNumberGenerator(seed));
+    QByteArray output;
+    QByteArray chunk(37, 0);
+    while(output.size() + chunk.size() <= expected.size()) {
+      brng.GenerateBlock(chunk);
+      output.append(chunk);
+      brng.Prefetch(output.size() % 300);
+    }
+
+    EXPECT_EQ(static_cast<uint>(output.size()), brng.BytesGenerated());
+    EXPECT_EQ(expected.left(output.size()), output);
+  }
+
+  TEST(Random, NullBufferedRandomTest)
+  {
+    QScopedPointer<Library> lib(new NullLibrary());
+    BufferedRandomTest(lib.data());
+  }
+
+  TEST(Random, CppBufferedRandomTest)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    BufferedRandomTest(lib.data());
+  }
 }
 }
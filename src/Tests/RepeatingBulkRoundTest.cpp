@@ -72,5 +72,119 @@ namespace Tests {
         Group::FixedSubgroup,
         TBadGuyCB<badbulk>);
   }
+
+  TEST(RepeatingBulkRound, PhaseDeadlineFixed)
+  {
+    RoundTest_Straggler(
+        &TCreateSession<PhaseDeadlineRound<RepeatingBulkRound, 5000> >,
+        Group::FixedSubgroup);
+  }
+
+  TEST(RepeatingBulkRound, ArrivalLatency)
+  {
+    Timer::GetInstance().UseVirtualTime();
+    ArrivalLatency latency(3);
+
+    for(int phase = 0; phase < 10; phase++) {
+      latency.StartPhase();
+      Time::GetInstance().IncrementVirtualClock(3);
+      latency.Arrived(0);
+      latency.Arrived(0);
+      Time::GetInstance().IncrementVirtualClock(phase == 9 ? 1000 : 20);
+      latency.Arrived(1);
+      EXPECT_EQ(latency.GetOutstanding(), QVector<int>(1, 2));
+    }
+
+    EXPECT_EQ(latency.GetCount(0), 10u);
+    EXPECT_EQ(latency.GetCount(1), 10u);
+    EXPECT_EQ(latency.GetCount(2), 0u);
+    EXPECT_EQ(latency.GetMax(0), 3);
+    EXPECT_EQ(latency.GetMax(1), 1003);
+    EXPECT_EQ(latency.GetLast(2), -1);
+    EXPECT_EQ(latency.GetHistogram(0)[2], 10u);
+    EXPECT_EQ(latency.GetQuantile(1, 0.5), 32);
+    EXPECT_EQ(latency.GetQuantile(1, 1.0), 1003);
+    EXPECT_EQ(latency.GetQuantile(2, 0.5), -1);
+  }
+
+  TEST(AggregatedBulkRound, BasicFixed)
+  {
+    RoundTest_Basic(&TCreateSession<AggregatedBulkRound>,
+        Group::FixedSubgroup);
+  }
+
+  TEST(AggregatedBulkRound, MultiRoundFixed)
+  {
+    RoundTest_MultiRound(&TCreateSession<AggregatedBulkRound>,
+        Group::FixedSubgroup);
+  }
+
+  TEST(AggregatedBulkRound, AddOne)
+  {
+    RoundTest_AddOne(&TCreateSession<AggregatedBulkRound>,
+        Group::FixedSubgroup);
+  }
+
+  TEST(AggregatedBulkRound, LeaderOmitsMessageFixed)
+  {
+    Timer::GetInstance().UseVirtualTime();
+
+    int count = Random::GetInstance().GetInt(TEST_RANGE_MIN, TEST_RANGE_MAX);
+
+    QVector<TestNode *> nodes;
+    Group group;
+    ConstructOverlay(count, nodes, group, Group::FixedSubgroup);
+
+    Id session_id;
+    CreateSessions(nodes, group, session_id,
+        &TCreateSession<AggregatedBulkRound>);
+
+    int leader = 0;
+    for(int idx = 0; idx < count; idx++) {
+      if(nodes[idx]->cm.GetId() == group.GetLeader()) {
+        leader = idx;
+      }
+    }
+    CreateSession(nodes[leader], group, session_id,
+        &TCreateSession<AggregatedBulkRoundBadLeader>);
+
+    int sender = Random::GetInstance().GetInt(0, count);
+    while(sender == leader) {
+      sender = Random::GetInstance().GetInt(0, count);
+    }
+
+    QByteArray msg(512, 0);
+    nodes[sender]->session->Send(msg);
+
+    for(int idx = 0; idx < count; idx++) {
+      nodes[idx]->session->Start();
+    }
+
+    // Every member's first round stops once the accusation reaches it
+    QVector<QSharedPointer<Round> > rounds(count);
+    bool stopped = false;
+    qint64 next = Timer::GetInstance().VirtualRun();
+    while(next != -1 && !stopped) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+
+      stopped = true;
+      for(int idx = 0; idx < count; idx++) {
+        if(rounds[idx].isNull()) {
+          rounds[idx] = nodes[idx]->session->GetCurrentRound();
+        }
+        stopped = stopped && !rounds[idx].isNull() && rounds[idx]->Stopped();
+      }
+    }
+
+    ASSERT_TRUE(stopped);
+    for(int idx = 0; idx < count; idx++) {
+      EXPECT_TRUE(rounds[idx]->Interrupted());
+      EXPECT_EQ(QVector<int>(1, group.GetIndex(group.GetLeader())),
+          rounds[idx]->GetBadMembers());
+    }
+
+    CleanUp(nodes);
+  }
 }
 }
@@ -423,6 +423,79 @@ namespace Tests {
     CleanUp(nodes);
   }
 
+  void RoundTest_Straggler(CreateSessionCallback callback,
+      Group::SubgroupPolicy sg_policy)
+  {
+    Timer::GetInstance().UseVirtualTime();
+
+    int count = Random::GetInstance().GetInt(TEST_RANGE_MIN, TEST_RANGE_MAX);
+
+    QVector<TestNode *> nodes;
+    Group group;
+    ConstructOverlay(count, nodes, group, sg_policy);
+    CreateSessions(nodes, group, Id(), callback);
+
+    int leader = 0;
+    for(int idx = 0; idx < count; idx++) {
+      if(nodes[idx]->cm.GetId() == group.GetLeader()) {
+        leader = idx;
+      }
+    }
+
+    int straggler = Random::GetInstance().GetInt(0, count);
+    while(straggler == leader) {
+      straggler = Random::GetInstance().GetInt(0, count);
+    }
+
+    int sender = Random::GetInstance().GetInt(0, count);
+    while(sender == straggler) {
+      sender = Random::GetInstance().GetInt(0, count);
+    }
+
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
+
+    QByteArray msg(512, 0);
+    rand->GenerateBlock(msg);
+    nodes[sender]->session->Send(msg);
+
+    SignalCounter sc;
+    for(int idx = 0; idx < count; idx++) {
+      QObject::connect(&nodes[idx]->sink, SIGNAL(DataReceived()), &sc, SLOT(Counter()));
+      nodes[idx]->session->Start();
+    }
+
+    TestNode::calledback = 0;
+    qint64 next = Timer::GetInstance().VirtualRun();
+    while(next != -1 && sc.GetCount() < count && TestNode::calledback < count) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+    }
+
+    ASSERT_EQ(sc.GetCount(), count);
+
+    // The straggler's messages now take far longer than the phase deadline
+    QSharedPointer<Round> round = nodes[leader]->session->GetCurrentRound();
+    DelayNode(nodes[straggler], 60000);
+
+    next = Timer::GetInstance().VirtualRun();
+    while(next != -1 && !round->Stopped()) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+    }
+
+    ASSERT_TRUE(round->Stopped());
+    EXPECT_EQ(round->GetStoppedReason(), QString("Phase deadline exceeded"));
+    EXPECT_TRUE(round->Interrupted());
+    int straggler_idx = round->GetGroup().GetIndex(nodes[straggler]->cm.GetId());
+    EXPECT_TRUE(round->GetBadMembers().contains(straggler_idx));
+    EXPECT_FALSE(round->GetBadMembers().contains(
+          round->GetGroup().GetIndex(nodes[leader]->cm.GetId())));
+
+    DelayNode(nodes[straggler], 0);
+    CleanUp(nodes);
+  }
+
   void RoundTest_BadGuy(CreateSessionCallback good_callback,
       CreateSessionCallback bad_callback, Group::SubgroupPolicy sg_policy,
       const BadGuyCB &cb)
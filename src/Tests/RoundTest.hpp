@@ -43,6 +43,20 @@ namespace Tests {
     return new T<N>(group, creds, round_id, network, get_data);
   }
 
+  /**
+   * A round with its phase deadline set to N ms
+   */
+  template <typename B, int N> class PhaseDeadlineRound : public B {
+    public:
+      explicit PhaseDeadlineRound(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> network, GetDataCallback &get_data) :
+        B(group, creds, round_id, network, get_data)
+      {
+        B::SetPhaseDeadline(N);
+      }
+  };
+
   typedef void(*SessionTestCallback)(SessionManager &sm);
 
   void RoundTest_Null(CreateSessionCallback callback,
@@ -59,6 +73,8 @@ namespace Tests {
       Group::SubgroupPolicy sg_policy);
   void RoundTest_PeerDisconnectMiddle(CreateSessionCallback callback,
       Group::SubgroupPolicy sg_policy);
+  void RoundTest_Straggler(CreateSessionCallback callback,
+      Group::SubgroupPolicy sg_policy);
   void RoundTest_BadGuy(CreateSessionCallback good_callback,
       CreateSessionCallback bad_callback,
       Group::SubgroupPolicy sg_policy,
@@ -0,0 +1,96 @@
+#include <QBitArray>
+#include <QByteArray>
+#include <QDataStream>
+
+#include "DissentTest.hpp"
+#include "Anonymity/ShuffleBlamer.hpp"
+
+namespace Dissent {
+namespace Tests {
+  namespace {
+    /**
+     * Replays the given logs and returns the members found faulty
+     */
+    QBitArray Blame(const Group &group, const Id &round_id,
+        const QVector<Log> &logs, const QVector<AsymmetricKey *> &keys,
+        CryptoFactory::ThreadingType type)
+    {
+      CryptoFactory &cf = CryptoFactory::GetInstance();
+      CryptoFactory::ThreadingType old = cf.GetThreadingType();
+      cf.SetThreading(type);
+
+      ShuffleBlamer blamer(group, round_id, logs, keys);
+      blamer.Start();
+
+      cf.SetThreading(old);
+      return blamer.GetBadNodes();
+    }
+  }
+
+  TEST(ShuffleBlamer, FirstFaultyLog)
+  {
+    const int count = 4;
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+
+    QVector<QSharedPointer<AsymmetricKey> > signing_keys;
+    QVector<GroupContainer> roster;
+    for(int idx = 0; idx < count; idx++) {
+      QSharedPointer<AsymmetricKey> key(lib->CreatePrivateKey());
+      QSharedPointer<AsymmetricKey> pkey(key->GetPublicKey());
+      signing_keys.append(key);
+      roster.append(GroupContainer(Id(), pkey, QByteArray()));
+    }
+
+    Group group(roster);
+    Id round_id;
+
+    QVector<QSharedPointer<AsymmetricKey> > outer_keys;
+    QVector<AsymmetricKey *> private_keys;
+    QVector<QByteArray> msgs;
+    for(int idx = 0; idx < count; idx++) {
+      QSharedPointer<AsymmetricKey> signing_key;
+      for(int jdx = 0; jdx < count; jdx++) {
+        if(roster[jdx].first == group.GetId(idx)) {
+          signing_key = signing_keys[jdx];
+        }
+      }
+
+      QScopedPointer<AsymmetricKey> inner_key(lib->CreatePrivateKey());
+      QScopedPointer<AsymmetricKey> inner_pkey(inner_key->GetPublicKey());
+      QSharedPointer<AsymmetricKey> outer_key(lib->CreatePrivateKey());
+      QScopedPointer<AsymmetricKey> outer_pkey(outer_key->GetPublicKey());
+      outer_keys.append(outer_key);
+      private_keys.append(outer_key.data());
+
+      QByteArray msg;
+      QDataStream stream(&msg, QIODevice::WriteOnly);
+      stream << ShuffleRound::PublicKeys << round_id.GetByteArray() <<
+        inner_pkey->GetByteArray() << outer_pkey->GetByteArray();
+      msgs.append(msg + signing_key->Sign(msg));
+    }
+
+    // Members 1 and 3 claim to have accepted a duplicate key message
+    QVector<Log> logs;
+    for(int idx = 0; idx < count; idx++) {
+      Log log;
+      for(int jdx = 0; jdx < count; jdx++) {
+        log.Append(msgs[jdx], group.GetId(jdx));
+        if(jdx == 0 && (idx == 1 || idx == 3)) {
+          log.Append(msgs[jdx], group.GetId(jdx));
+        }
+      }
+      logs.append(log);
+    }
+
+    QBitArray single = Blame(group, round_id, logs, private_keys,
+        CryptoFactory::SingleThreaded);
+    QBitArray multi = Blame(group, round_id, logs, private_keys,
+        CryptoFactory::MultiThreaded);
+
+    QBitArray expected(count, false);
+    expected[1] = true;
+    EXPECT_EQ(expected, single);
+    EXPECT_EQ(expected, multi);
+  }
+}
+}
@@ -246,7 +246,9 @@ namespace Tests {
         _state = DataSubmission;
 
         OnionEncryptor *oe = CryptoFactory::GetInstance().GetOnionEncryptor();
-        oe->Encrypt(_public_inner_keys, PrepareData(), _inner_ciphertext, 0);
+        _inner_ciphertexts = QVector<QByteArray>(1);
+        _outer_ciphertexts = QVector<QByteArray>(1);
+        oe->Encrypt(_public_inner_keys, PrepareData()[0], _inner_ciphertexts[0], 0);
 
         int count = Random::GetInstance().GetInt(0, GetShufflers().Count());
         int opposite = CalculateKidx(count);
@@ -256,12 +258,12 @@ namespace Tests {
 
         AsymmetricKey *tmp = _public_outer_keys[opposite];
         _public_outer_keys[opposite] = _public_outer_keys[count];
-        oe->Encrypt(_public_outer_keys, _inner_ciphertext, _outer_ciphertext, 0);
+        oe->Encrypt(_public_outer_keys, _inner_ciphertexts[0], _outer_ciphertexts[0], 0);
         _public_outer_keys[opposite] = tmp;
 
         QByteArray msg;
         QDataStream stream(&msg, QIODevice::WriteOnly);
-        stream << Data << GetRoundId().GetByteArray() << _outer_ciphertext;
+        stream << Data << GetRoundId().GetByteArray() << _outer_ciphertexts[0];
 
         _state = WaitingForShuffle;
         VerifiableSend(msg, GetShufflers().GetId(0));
@@ -16,6 +16,24 @@ namespace Tests {
         Group::CompleteGroup);
   }
 
+  TEST(ShuffleRound, SmallCell)
+  {
+    RoundTest_Basic(&TCreateSession<CellShuffleRound<512, 1> >,
+        Group::CompleteGroup);
+  }
+
+  TEST(ShuffleRound, MultiCell)
+  {
+    RoundTest_Basic(&TCreateSession<CellShuffleRound<96, 8> >,
+        Group::CompleteGroup);
+  }
+
+  TEST(ShuffleRound, MultiCellFixed)
+  {
+    RoundTest_Basic(&TCreateSession<CellShuffleRound<96, 8> >,
+        Group::FixedSubgroup);
+  }
+
   TEST(ShuffleRound, MultiRound)
   {
     RoundTest_MultiRound(&TCreateSession<ShuffleRound>,
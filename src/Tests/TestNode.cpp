@@ -5,6 +5,7 @@ namespace Tests {
   int TestNode::calledback;
   int TestNode::success;
   int TestNode::failure;
+  bool TestNode::Simulated = false;
 
   void ConstructOverlay(int count, QVector<TestNode *> &nodes, Group &group,
       Group::SubgroupPolicy sg_policy)
@@ -95,5 +96,17 @@ namespace Tests {
       delete nodes[idx];
     }
   }
+
+  void DelayNode(TestNode *node, int delay)
+  {
+    foreach(const QSharedPointer<Edge> &edge,
+        node->cm.GetConnectionTable().GetEdges())
+    {
+      BufferEdge *bedge = dynamic_cast<BufferEdge *>(edge.data());
+      if(bedge) {
+        bedge->SetAdditionalDelay(delay);
+      }
+    }
+  }
 }
 }
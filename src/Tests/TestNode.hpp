@@ -20,7 +20,9 @@ namespace Tests {
             QSharedPointer<DiffieHellman>(CryptoFactory::GetInstance().
               GetLibrary()->CreateDiffieHellman()))
       {
-        EdgeListener *be = EdgeListenerFactory::GetInstance().CreateEdgeListener(BufferAddress(idx));
+        EdgeListener *be = Simulated ?
+          SimEdgeListener::Create(BufferAddress(idx)) :
+          EdgeListenerFactory::GetInstance().CreateEdgeListener(BufferAddress(idx));
         cm.AddEdgeListener(QSharedPointer<EdgeListener>(be));
         be->Start();
       }
@@ -38,6 +40,12 @@ namespace Tests {
       static int success;
       static int failure;
 
+      /**
+       * Nodes created while set are connected through the SimNetwork
+       * rather than by BufferEdges
+       */
+      static bool Simulated;
+
     public slots:
       void HandleRoundFinished(QSharedPointer<Round> round)
       {
@@ -67,6 +75,13 @@ namespace Tests {
   }
 
   void CleanUp(const QVector<TestNode *> &nodes);
+
+  /**
+   * Slows down all messages sent by the node
+   * @param node the node to slow down
+   * @param delay additional latency in ms for each of its BufferEdges
+   */
+  void DelayNode(TestNode *node, int delay);
 }
 }
 
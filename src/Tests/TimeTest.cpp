@@ -132,6 +132,133 @@ namespace Tests {
     qc2.Stop();
   }
 
+  class TimerRecorder {
+    public:
+      QList<int> fired;
+      QList<qint64> times;
+
+      void Fire(const int &value)
+      {
+        fired.append(value);
+        times.append(Time::GetInstance().MSecsSinceEpoch());
+      }
+  };
+
+  TEST(Time, TimerWheelOrdering)
+  {
+    Timer &timer = Timer::GetInstance();
+    timer.UseVirtualTime();
+    timer.Clear();
+    Time &time = Time::GetInstance();
+    qint64 start = time.MSecsSinceEpoch();
+
+    // Spread due times across every level of the wheel, with collisions
+    int count = 2000;
+    QVector<int> due(count);
+    QVector<TimerEvent> events;
+    TimerRecorder recorder;
+    for(int idx = 0; idx < count; idx++) {
+      int level = Random::GetInstance().GetInt(0, 4);
+      int max = level == 3 ? 20 * 1000 * 1000 : (1 << (8 * (level + 1)));
+      due[idx] = Random::GetInstance().GetInt(0, max);
+      events.append(timer.QueueCallback(
+            new TimerMethod<TimerRecorder, int>(&recorder,
+              &TimerRecorder::Fire, idx), due[idx]));
+    }
+
+    QSet<int> stopped;
+    for(int idx = 0; idx < count; idx += 3) {
+      events[idx].Stop();
+      stopped.insert(idx);
+    }
+
+    qint64 next = timer.VirtualRun();
+    while(next != -1) {
+      time.IncrementVirtualClock(next);
+      next = timer.VirtualRun();
+    }
+
+    EXPECT_EQ(recorder.fired.count(), count - stopped.count());
+    for(int idx = 0; idx < recorder.fired.count(); idx++) {
+      int value = recorder.fired[idx];
+      EXPECT_FALSE(stopped.contains(value));
+      EXPECT_EQ(recorder.times[idx], start + due[value]);
+      if(idx > 0) {
+        int prev = recorder.fired[idx - 1];
+        EXPECT_TRUE(due[prev] < due[value] ||
+            (due[prev] == due[value] && prev < value));
+      }
+    }
+  }
+
+  TEST(Time, TimerWheelPeriodic)
+  {
+    Timer &timer = Timer::GetInstance();
+    timer.UseVirtualTime();
+    timer.Clear();
+    Time &time = Time::GetInstance();
+
+    TimerRecorder recorder;
+    TimerEvent periodic = timer.QueueCallback(
+        new TimerMethod<TimerRecorder, int>(&recorder,
+          &TimerRecorder::Fire, 1), 100, 5000);
+
+    // A large jump catches up on every missed period
+    time.IncrementVirtualClock(1000 * 1000);
+    qint64 next = timer.VirtualRun();
+    EXPECT_EQ(recorder.fired.count(), 200);
+    EXPECT_EQ(next, 100);
+
+    time.IncrementVirtualClock(next);
+    next = timer.VirtualRun();
+    EXPECT_EQ(recorder.fired.count(), 201);
+    EXPECT_EQ(next, 5000);
+
+    periodic.Stop();
+    EXPECT_EQ(timer.VirtualRun(), -1);
+    time.IncrementVirtualClock(5000);
+    timer.VirtualRun();
+    EXPECT_EQ(recorder.fired.count(), 201);
+  }
+
+  class ChainingRecorder : public TimerRecorder {
+    public:
+      void FireAndQueue(const int &value)
+      {
+        Fire(value);
+        Timer::GetInstance().QueueCallback(
+            new TimerMethod<TimerRecorder, int>(this,
+              &TimerRecorder::Fire, value + 100), 0);
+      }
+  };
+
+  TEST(Time, CheckTimerEventRealQueuedByCallback)
+  {
+    Timer &timer = Timer::GetInstance();
+    timer.UseRealTime();
+    timer.Clear();
+
+    // Events queued from a callback wait for those already due
+    ChainingRecorder recorder;
+    TimerEvent te0 = timer.QueueCallback(
+        new TimerMethod<ChainingRecorder, int>(&recorder,
+          &ChainingRecorder::FireAndQueue, 0), 2);
+    TimerEvent te1 = timer.QueueCallback(
+        new TimerMethod<TimerRecorder, int>(&recorder,
+          &TimerRecorder::Fire, 1), 2);
+
+    Sleeper::MSleep(5);
+    MockExec();
+    Sleeper::MSleep(5);
+    MockExec();
+
+    ASSERT_EQ(recorder.fired.count(), 3);
+    EXPECT_EQ(recorder.fired[0], 0);
+    EXPECT_EQ(recorder.fired[1], 1);
+    EXPECT_EQ(recorder.fired[2], 100);
+    timer.Clear();
+  }
+
   TEST(Time, Verify_46_Hack)
   {
     qint64 MSecsPerDay = 86400000;
@@ -14,6 +14,23 @@ namespace Tests {
         Group::FixedSubgroup);
   }
 
+  TEST(TolerantBulkRound, BasicSimulated)
+  {
+    SimNetwork &network = SimNetwork::GetInstance();
+    network.Reset();
+    network.SetTopology(QSharedPointer<SimTopology>(new RegionTopology(2,
+            SimLink(1), SimLink(40, 10, 1000, 0.01))));
+    TestNode::Simulated = true;
+
+    RoundTest_Basic(&TCreateSession<TolerantBulkRound>,
+        Group::FixedSubgroup);
+
+    TestNode::Simulated = false;
+    EXPECT_GT(network.GetMessagesSent(), 0);
+    network.SetTopology(QSharedPointer<SimTopology>(new UniformTopology()));
+    network.Reset();
+  }
+
   TEST(TolerantBulkRound, MultiRoundFixed)
   {
     RoundTest_MultiRound(&TCreateSession<TolerantBulkRound>,
@@ -21,6 +38,13 @@ namespace Tests {
   }
 
   
+  TEST(TolerantBulkRound, PhaseDeadlineFixed)
+  {
+    RoundTest_Straggler(
+        &TCreateSession<PhaseDeadlineRound<TolerantBulkRound, 5000> >,
+        Group::FixedSubgroup);
+  }
+
   TEST(TolerantBulkRound, AddOne)
   {
     RoundTest_AddOne(&TCreateSession<TolerantBulkRound>,
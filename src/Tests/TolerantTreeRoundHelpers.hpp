@@ -26,6 +26,21 @@ namespace Tests {
       }
   };
 
+  /**
+   * A TolerantTreeRound with a specific aggregation tree fanout
+   */
+  template<int K> class TolerantTreeRoundFanout : public TolerantTreeRound
+  {
+    public:
+      explicit TolerantTreeRoundFanout(const Group &group,
+          const Credentials &creds, const Id &round_id,
+          QSharedPointer<Network> network, GetDataCallback &get_data) :
+        TolerantTreeRound(group, creds, round_id, network, get_data,
+            &TCreateRound<ShuffleRound>, K)
+      {
+      }
+  };
+
 }
 }
 
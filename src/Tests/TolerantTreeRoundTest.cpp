@@ -21,6 +21,24 @@ namespace Tests {
   }
 
   
+  TEST(TolerantTreeRound, BinaryTreeFixed)
+  {
+    RoundTest_Basic(&TCreateSession<TolerantTreeRoundFanout<2> >,
+        Group::FixedSubgroup);
+  }
+
+  TEST(TolerantTreeRound, SingleLevelTreeFixed)
+  {
+    RoundTest_MultiRound(&TCreateSession<TolerantTreeRoundFanout<64> >,
+        Group::FixedSubgroup);
+  }
+
+  TEST(TolerantTreeRound, ZeroFanoutFixed)
+  {
+    RoundTest_Basic(&TCreateSession<TolerantTreeRoundFanout<0> >,
+        Group::FixedSubgroup);
+  }
+
   TEST(TolerantTreeRound, AddOne)
   {
     RoundTest_AddOne(&TCreateSession<TolerantTreeRound>,
@@ -234,5 +234,46 @@ namespace Tests {
     QSharedPointer<SendMessageService> smsp(new SendMessageService(sm));
     SessionServiceInactiveTestWrapper(smsp);
   }
+
+  void RoundMetricsServiceTest(SessionManager &)
+  {
+    WebServiceTestSink sink;
+    RoundMetricsService rms;
+    QObject::connect(&rms, SIGNAL(FinishedWebRequest(QSharedPointer<WebRequest>, bool)),
+       &sink, SLOT(HandleDoneRequest(QSharedPointer<WebRequest>)));
+
+    rms.Call(FakeRequest());
+    ASSERT_EQ(sink.handled.count(), 1);
+    ASSERT_EQ(HttpResponse::STATUS_OK, sink.handled[0]->GetStatus());
+
+    QVariantMap map = sink.handled[0]->GetOutputData().toMap();
+    ASSERT_TRUE(map["enabled"].toBool());
+    QVariantList rounds = map["rounds"].toList();
+    ASSERT_FALSE(rounds.isEmpty());
+
+    bool found_bytes = false;
+    foreach(const QVariant &round, rounds) {
+      foreach(const QVariant &state, round.toMap()["states"].toList()) {
+        found_bytes |= state.toMap()["bytes_sent"].toLongLong() > 0;
+      }
+    }
+    ASSERT_TRUE(found_bytes);
+
+    rms.Call(FakeRequest("/round/metrics?format=prometheus"));
+    ASSERT_EQ(sink.handled.count(), 2);
+    QString text = sink.handled[1]->GetOutputData().toString();
+    ASSERT_TRUE(text.contains("dissent_round_state_msecs{"));
+    ASSERT_TRUE(text.contains("state=\"DataSubmission\""));
+  }
+
+  TEST(WebServices, RoundMetricsService)
+  {
+    RoundMetrics::GetInstance().Clear();
+    RoundMetrics::SetEnabled(true);
+    RoundTest_Basic_SessionTest(&TCreateSession<ShuffleRound>,
+        Group::CompleteGroup, &RoundMetricsServiceTest);
+    RoundMetrics::SetEnabled(false);
+    RoundMetrics::GetInstance().Clear();
+  }
 }
 }
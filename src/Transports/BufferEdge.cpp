@@ -6,10 +6,13 @@ using Dissent::Utils::TimerMethod;
 
 namespace Dissent {
 namespace Transports {
+  quint64 BufferEdge::BytesSent = 0;
+  quint64 BufferEdge::PacketsSent = 0;
+
   BufferEdge::BufferEdge(const Address &local, const Address &remote,
       bool outgoing, int delay) :
     Edge(local, remote, outgoing), Delay(delay), _remote_edge(0),
-    _rem_closing(false), _incoming(0)
+    _rem_closing(false), _incoming(0), _additional_delay(0)
   {
   }
 
@@ -39,8 +42,10 @@ namespace Transports {
 
     TimerCallback *tm = new TimerMethod<BufferEdge, QByteArray>(_remote_edge.data(),
         &BufferEdge::DelayedReceive, data);
-    Timer::GetInstance().QueueCallback(tm, Delay);
+    Timer::GetInstance().QueueCallback(tm, Delay + _additional_delay);
     _remote_edge->_incoming++;
+    BytesSent += data.size();
+    PacketsSent++;
   }
 
   bool BufferEdge::Close(const QString& reason)
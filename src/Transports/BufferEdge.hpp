@@ -38,12 +38,35 @@ namespace Transports {
 
       void SetRemoteEdge(QSharedPointer<BufferEdge> remote);
 
+      /**
+       * Adds latency on top of Delay to messages sent from now on, used to
+       * inject slow links
+       * @param delay additional latency in ms
+       */
+      inline void SetAdditionalDelay(int delay) { _additional_delay = delay; }
+
+      /**
+       * Returns the latency injected on top of Delay
+       */
+      inline int GetAdditionalDelay() const { return _additional_delay; }
+
       /**
        * Time delay between when an edge sends a packet to when the remote
        * peer receives it.
        */
       const int Delay;
 
+      /**
+       * Total bytes handed to any BufferEdge::Send in this process, used by
+       * the benchmarks to measure traffic on the simulated wire
+       */
+      static quint64 BytesSent;
+
+      /**
+       * Total packets handed to any BufferEdge::Send in this process
+       */
+      static quint64 PacketsSent;
+
     protected:
       virtual bool RequiresCleanup() { return true; }
 
@@ -69,6 +92,11 @@ namespace Transports {
        * Packets sent but not arrived
        */
       int _incoming;
+
+      /**
+       * Injected latency in addition to Delay
+       */
+      int _additional_delay;
   };
 }
 }
@@ -0,0 +1,89 @@
+#include "BufferAddress.hpp"
+#include "SimEdge.hpp"
+#include "Utils/Timer.hpp"
+
+using Dissent::Utils::TimerCallback;
+using Dissent::Utils::Timer;
+using Dissent::Utils::TimerMethod;
+
+namespace Dissent {
+namespace Transports {
+  SimEdge::SimEdge(const Address &local, const Address &remote,
+      bool outgoing) :
+    Edge(local, remote, outgoing), _remote_edge(0), _rem_closing(false),
+    _incoming(0),
+    _local_id(static_cast<const BufferAddress &>(local).GetId()),
+    _remote_id(static_cast<const BufferAddress &>(remote).GetId()),
+    _link_free(0),
+    _last_arrival(0)
+  {
+  }
+
+  SimEdge::~SimEdge()
+  {
+  }
+
+  void SimEdge::SetRemoteEdge(QSharedPointer<SimEdge> remote_edge)
+  {
+    if(!_remote_edge.isNull()) {
+      qWarning() << "SimEdge's remote already set.";
+      return;
+    }
+    _remote_edge = remote_edge;
+  }
+
+  void SimEdge::Send(const QByteArray &data)
+  {
+    if(_closed) {
+      qWarning() << "Attempted to send on a closed edge.";
+      return;
+    }
+
+    if(_rem_closing) {
+      return;
+    }
+
+    qint64 delay = SimNetwork::GetInstance().ScheduleDelivery(_local_id,
+        _remote_id, data.size(), _link_free, _last_arrival);
+
+    TimerCallback *tm = new TimerMethod<SimEdge, QByteArray>(_remote_edge.data(),
+        &SimEdge::DelayedReceive, data);
+    Timer::GetInstance().QueueCallback(tm, delay);
+    _remote_edge->_incoming++;
+  }
+
+  bool SimEdge::Close(const QString& reason)
+  {
+    if(!Edge::Close(reason)) {
+      return false;
+    }
+
+    if(!_rem_closing) {
+      _remote_edge->_rem_closing = true;
+      _remote_edge.clear();
+    }
+
+    if(_incoming == 0) {
+      CloseCompleted();
+    }
+
+    return true;
+  }
+
+  void SimEdge::DelayedReceive(const QByteArray &data)
+  {
+    _incoming--;
+    if(_closed) {
+      if(_incoming == 0) {
+        CloseCompleted();
+      }
+      return;
+    }
+
+    SimNetwork &network = SimNetwork::GetInstance();
+    int previous = network.SetCurrentNode(_local_id);
+    PushData(data, this);
+    network.SetCurrentNode(previous);
+  }
+}
+}
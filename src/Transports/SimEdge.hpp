@@ -0,0 +1,72 @@
+#ifndef DISSENT_TRANSPORTS_SIM_EDGE_H_GUARD
+#define DISSENT_TRANSPORTS_SIM_EDGE_H_GUARD
+
+#include "Edge.hpp"
+#include "SimNetwork.hpp"
+
+namespace Dissent {
+namespace Transports {
+  /**
+   * Passes messages in a common process like BufferEdge, but delays each
+   * message as computed by the SimNetwork from the link's latency,
+   * bandwidth and loss and the sender's virtual CPU clock
+   */
+  class SimEdge : public Edge {
+    public:
+      /**
+       * Constructor
+       * @param local the local address of the edge
+       * @param remote the address of the remote point of the edge
+       * @param outgoing true if the remote side requested the creation of this edge
+       */
+      explicit SimEdge(const Address &local, const Address &remote,
+          bool outgoing);
+
+      /**
+       * Destructor
+       */
+      virtual ~SimEdge();
+      virtual void Send(const QByteArray &data);
+      virtual bool Close(const QString& reason);
+
+      /**
+       * Matches this edge with the edge where it will deliver sent messages
+       * @param remote the remote peer which will handle incoming messages
+       */
+      void SetRemoteEdge(QSharedPointer<SimEdge> remote);
+
+    protected:
+      virtual bool RequiresCleanup() { return true; }
+
+    private:
+      /**
+       * On the receiver side, handle an incoming message once the simulated
+       * network has delivered it, charging work done to the receiver
+       * @param data the data sent from the remote peer
+       */
+      void DelayedReceive(const QByteArray &data);
+
+      QSharedPointer<SimEdge> _remote_edge;
+      bool _rem_closing;
+      int _incoming;
+
+      /**
+       * Simulator ids of the two endpoints
+       */
+      int _local_id;
+      int _remote_id;
+
+      /**
+       * Time at which the link finishes serializing the last message
+       */
+      qint64 _link_free;
+
+      /**
+       * Arrival time of the last message, later messages never overtake it
+       */
+      qint64 _last_arrival;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include <QDebug>
+#include "SimEdgeListener.hpp"
+#include "Utils/Random.hpp"
+
+using Dissent::Utils::Random;
+
+namespace Dissent {
+namespace Transports {
+  QHash<int, SimEdgeListener *> SimEdgeListener::_el_map;
+
+  SimEdgeListener::SimEdgeListener(const BufferAddress &local_address) :
+    EdgeListener(local_address), _valid(false)
+  {
+  }
+
+  EdgeListener *SimEdgeListener::Create(const Address &local_address)
+  {
+    const BufferAddress &ba = static_cast<const BufferAddress &>(local_address);
+    return new SimEdgeListener(ba);
+  }
+
+  SimEdgeListener::~SimEdgeListener()
+  {
+    DestructorCheck();
+  }
+
+  bool SimEdgeListener::Start()
+  {
+    if(!EdgeListener::Start()) {
+      return false;
+    }
+
+    const BufferAddress addr = static_cast<const BufferAddress &>(GetAddress());
+    int id = addr.GetId();
+    if(id == 0) {
+      while(_el_map.contains(id = Random::GetInstance().GetInt(1)));
+      SetAddress(BufferAddress(id));
+    }
+
+    if(_el_map.contains(id)) {
+      qWarning() << "Attempting to create two SimEdgeListeners with the same" <<
+        " address: " << addr.ToString();
+      return true;
+    }
+
+    _valid = true;
+    _el_map[id] = this;
+    return true;
+  }
+
+  bool SimEdgeListener::Stop()
+  {
+    if(!EdgeListener::Stop()) {
+      return false;
+    }
+
+    if(!_valid) {
+      return true;
+    }
+
+    const BufferAddress &loc_ba = static_cast<const BufferAddress &>(GetAddress());
+    _el_map.remove(loc_ba.GetId());
+    return true;
+  }
+
+  void SimEdgeListener::CreateEdgeTo(const Address &to)
+  {
+    if(Stopped()) {
+      qWarning() << "Cannot CreateEdgeTo Stopped EL";
+      return;
+    }
+
+    if(!Started()) {
+      qWarning() << "Cannot CreateEdgeTo non-Started EL";
+      return;
+    }
+
+    const BufferAddress &rem_ba = static_cast<const BufferAddress &>(to);
+    SimEdgeListener *remote_el = _el_map.value(rem_ba.GetId());
+    if(remote_el == 0) {
+      qDebug() << "Attempting to create an Edge to an EL that doesn't exist from " <<
+        GetAddress().ToString() << " to " << to.ToString();
+      ProcessEdgeCreationFailure(to, "No such peer");
+      return;
+    }
+
+    SimEdge *local_edge(new SimEdge(GetAddress(), remote_el->GetAddress(), true));
+    SimEdge *remote_edge(new SimEdge(remote_el->GetAddress(), GetAddress(), false));
+
+    QSharedPointer<SimEdge> ledge(local_edge);
+    QSharedPointer<SimEdge> redge(remote_edge);
+
+    local_edge->SetRemoteEdge(redge);
+    remote_edge->SetRemoteEdge(ledge);
+
+    ProcessNewEdge(ledge);
+    remote_el->ProcessNewEdge(redge);
+  }
+}
+}
@@ -0,0 +1,39 @@
+#ifndef DISSENT_TRANSPORTS_SIM_EDGE_LISTENER_H_GUARD
+#define DISSENT_TRANSPORTS_SIM_EDGE_LISTENER_H_GUARD
+
+#include <QHash>
+
+#include "BufferAddress.hpp"
+#include "EdgeListener.hpp"
+#include "SimEdge.hpp"
+
+namespace Dissent {
+namespace Transports {
+  /**
+   * Creates SimEdges between endpoints of the network simulator.  Endpoints
+   * are named by BufferAddresses, whose ids the SimTopology uses to pick
+   * the link between two endpoints.  SimEdgeListeners only connect to
+   * other SimEdgeListeners.
+   */
+  class SimEdgeListener : public EdgeListener {
+    public:
+      explicit SimEdgeListener(const BufferAddress &local_address);
+      static EdgeListener *Create(const Address &local_address);
+
+      /**
+       * Destructor
+       */
+      virtual ~SimEdgeListener();
+
+      virtual bool Start();
+      virtual bool Stop();
+      virtual void CreateEdgeTo(const Address &to);
+
+    private:
+      static QHash<int, SimEdgeListener *> _el_map;
+      bool _valid;
+  };
+}
+}
+
+#endif
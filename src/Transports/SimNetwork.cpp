@@ -0,0 +1,117 @@
+#include "Utils/Time.hpp"
+
+#include "SimNetwork.hpp"
+
+using Dissent::Crypto::CryptoCost;
+using Dissent::Utils::Time;
+
+namespace Dissent {
+namespace Transports {
+  QAtomicInt SimNetwork::_current(-1);
+
+  SimNetwork &SimNetwork::GetInstance()
+  {
+    static SimNetwork network;
+    return network;
+  }
+
+  SimNetwork::SimNetwork() :
+    _topology(new UniformTopology()),
+    _seed(1),
+    _messages(0),
+    _bytes(0),
+    _retransmissions(0)
+  {
+    // Rough costs of 1024-bit RSA and DH on a current core
+    _costs[CryptoCost::Sign] = 1000;
+    _costs[CryptoCost::Verify] = 50;
+    _costs[CryptoCost::SharedSecret] = 500;
+    _costs[CryptoCost::Encrypt] = 50;
+    _costs[CryptoCost::Decrypt] = 1000;
+
+    CryptoCost::SetHandler(&SimNetwork::Charge);
+  }
+
+  qint64 SimNetwork::ScheduleDelivery(int from, int to, int bytes,
+      qint64 &link_free, qint64 &last_arrival)
+  {
+    qint64 now = Time::GetInstance().MSecsSinceEpoch();
+    SimLink link = _topology->GetLink(from, to);
+
+    // The sender cannot transmit before its CPU finishes the queued work
+    qint64 depart = qMax(now, (_cpu_busy.value(from) + 999) / 1000);
+    qint64 start = qMax(depart, link_free);
+    qint64 transmit = 0;
+    if(link.bandwidth > 0) {
+      transmit = (bytes + link.bandwidth - 1) / link.bandwidth;
+    }
+    link_free = start + transmit;
+
+    qint64 latency = link.latency;
+    if(link.jitter > 0) {
+      latency += NextRandom() % (link.jitter + 1);
+    }
+
+    if(link.loss > 0) {
+      qint64 timeout = qMax(MinRetransmitTimeout,
+          2 * (link.latency + link.jitter));
+      for(int attempt = 0; attempt < MaxRetransmissions; attempt++) {
+        if(NextRandom() / 4294967296.0 >= link.loss) {
+          break;
+        }
+        latency += timeout << attempt;
+        _retransmissions++;
+      }
+    }
+
+    qint64 arrival = qMax(link_free + latency, last_arrival);
+    last_arrival = arrival;
+
+    _messages++;
+    _bytes += bytes;
+    return arrival - now;
+  }
+
+  int SimNetwork::SetCurrentNode(int node)
+  {
+    return _current.fetchAndStoreOrdered(node);
+  }
+
+  void SimNetwork::Charge(CryptoCost::Operation op, int count)
+  {
+    int node = _current.fetchAndAddOrdered(0);
+    if(node != -1) {
+      GetInstance().ChargeNode(node, op, count);
+    }
+  }
+
+  void SimNetwork::ChargeNode(int node, CryptoCost::Operation op, int count)
+  {
+    // Work such as blame replay may charge from several threads
+    QMutexLocker locker(&_charge_lock);
+    qint64 cost = qint64(_costs[op]) * count;
+    qint64 now = Time::GetInstance().MSecsSinceEpoch() * 1000;
+    qint64 &busy = _cpu_busy[node];
+    busy = qMax(busy, now) + cost;
+    _cpu_total[node] += cost;
+  }
+
+  void SimNetwork::Reset()
+  {
+    _cpu_busy.clear();
+    _cpu_total.clear();
+    _messages = 0;
+    _bytes = 0;
+    _retransmissions = 0;
+    _current.fetchAndStoreOrdered(-1);
+  }
+
+  quint32 SimNetwork::NextRandom()
+  {
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+  }
+}
+}
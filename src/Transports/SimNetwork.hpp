@@ -0,0 +1,172 @@
+#ifndef DISSENT_TRANSPORTS_SIM_NETWORK_H_GUARD
+#define DISSENT_TRANSPORTS_SIM_NETWORK_H_GUARD
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "Crypto/CryptoCost.hpp"
+
+#include "SimTopology.hpp"
+
+namespace Dissent {
+namespace Transports {
+  /**
+   * Shared state of the discrete-event network simulator used by SimEdge.
+   * Each message is delayed by the time its sender's virtual CPU needs to
+   * finish queued work, the time to serialize it onto its link behind
+   * earlier messages, the link's latency and jitter, and a retransmission
+   * timeout, with exponential backoff, for each lost transmission.  Links
+   * deliver in order, like the TCP connections they stand in for.
+   *
+   * Every node has a virtual CPU clock.  While a SimEdge delivers a message
+   * the receiving node is current, and the crypto operations it performs
+   * are charged to its clock through the CryptoCost handler the simulator
+   * installs, delaying its subsequent messages.
+   * The simulator is deterministic for a given seed.
+   */
+  class SimNetwork {
+    public:
+      /**
+       * Minimum retransmission timeout in ms
+       */
+      static const int MinRetransmitTimeout = 200;
+
+      /**
+       * Maximum number of retransmissions of a single message
+       */
+      static const int MaxRetransmissions = 8;
+
+      /**
+       * Returns the SimNetwork singleton
+       */
+      static SimNetwork &GetInstance();
+
+      /**
+       * Sets the topology, by default a UniformTopology with 10 ms links
+       * @param topology the topology
+       */
+      inline void SetTopology(QSharedPointer<SimTopology> topology)
+      {
+        _topology = topology;
+      }
+
+      /**
+       * Returns the topology
+       */
+      inline QSharedPointer<SimTopology> GetTopology() const { return _topology; }
+
+      /**
+       * Seeds the generator used for jitter and loss
+       * @param seed the seed
+       */
+      inline void SetSeed(quint32 seed) { _seed = seed ? seed : 1; }
+
+      /**
+       * Sets the virtual CPU cost of an operation
+       * @param op the operation
+       * @param usecs cost in microseconds
+       */
+      inline void SetCost(Dissent::Crypto::CryptoCost::Operation op,
+          int usecs)
+      {
+        _costs[op] = usecs;
+      }
+
+      /**
+       * Returns the virtual CPU cost of an operation in microseconds
+       * @param op the operation
+       */
+      inline int GetCost(Dissent::Crypto::CryptoCost::Operation op) const
+      {
+        return _costs[op];
+      }
+
+      /**
+       * Computes when a message sent now arrives and updates the link state
+       * @param from the sender's id
+       * @param to the receiver's id
+       * @param bytes size of the message
+       * @param link_free time at which the link finishes its current
+       * transmission, updated
+       * @param last_arrival arrival time of the previous message on the
+       * link, updated
+       * @returns the delay in ms until the message arrives
+       */
+      qint64 ScheduleDelivery(int from, int to, int bytes, qint64 &link_free,
+          qint64 &last_arrival);
+
+      /**
+       * Makes a node current, so that crypto operations are charged to it
+       * @param node the node's id, -1 for none
+       * @returns the previously current node
+       */
+      int SetCurrentNode(int node);
+
+      /**
+       * Returns the total virtual CPU time charged to a node in microseconds
+       * @param node the node's id
+       */
+      inline qint64 GetCpuTime(int node) const { return _cpu_total.value(node); }
+
+      /**
+       * Returns the number of messages sent
+       */
+      inline qint64 GetMessagesSent() const { return _messages; }
+
+      /**
+       * Returns the number of bytes sent
+       */
+      inline qint64 GetBytesSent() const { return _bytes; }
+
+      /**
+       * Returns the number of retransmissions caused by loss
+       */
+      inline qint64 GetRetransmissions() const { return _retransmissions; }
+
+      /**
+       * Clears the CPU clocks and statistics, the topology, seed and costs
+       * are kept
+       */
+      void Reset();
+
+    private:
+      explicit SimNetwork();
+
+      /**
+       * The CryptoCost handler, charges operations to the node currently
+       * handling a simulated message, does nothing outside the simulator
+       * @param op the operation
+       * @param count the number of operations
+       */
+      static void Charge(Dissent::Crypto::CryptoCost::Operation op, int count);
+
+      void ChargeNode(int node, Dissent::Crypto::CryptoCost::Operation op,
+          int count);
+
+      /**
+       * Returns the next value of a xorshift generator
+       */
+      quint32 NextRandom();
+
+      QSharedPointer<SimTopology> _topology;
+      quint32 _seed;
+      int _costs[Dissent::Crypto::CryptoCost::OperationCount];
+      QHash<int, qint64> _cpu_busy;
+      QHash<int, qint64> _cpu_total;
+      qint64 _messages;
+      qint64 _bytes;
+      qint64 _retransmissions;
+      QMutex _charge_lock;
+
+      /**
+       * The current node, read by the pool threads that charge blame replay
+       * and onion work
+       */
+      static QAtomicInt _current;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef DISSENT_TRANSPORTS_SIM_TOPOLOGY_H_GUARD
+#define DISSENT_TRANSPORTS_SIM_TOPOLOGY_H_GUARD
+
+namespace Dissent {
+namespace Transports {
+  /**
+   * Properties of a simulated link in one direction
+   */
+  class SimLink {
+    public:
+      /**
+       * Constructor
+       * @param latency one way propagation delay in ms
+       * @param jitter maximum extra delay in ms, drawn uniformly per message
+       * @param bandwidth bytes per ms the link serializes, 0 for unlimited
+       * @param loss probability that a transmission is lost and resent
+       */
+      explicit SimLink(int latency = 10, int jitter = 0, int bandwidth = 0,
+          double loss = 0) :
+        latency(latency), jitter(jitter), bandwidth(bandwidth), loss(loss)
+      {
+      }
+
+      int latency;
+      int jitter;
+      int bandwidth;
+      double loss;
+  };
+
+  /**
+   * Maps a pair of simulated endpoints to the properties of the link
+   * between them, endpoints are identified by their BufferAddress id
+   */
+  class SimTopology {
+    public:
+      virtual ~SimTopology() {}
+
+      /**
+       * Returns the link used by messages from one endpoint to another
+       * @param from the sender's id
+       * @param to the receiver's id
+       */
+      virtual SimLink GetLink(int from, int to) const = 0;
+  };
+
+  /**
+   * Every pair of endpoints is connected by the same kind of link
+   */
+  class UniformTopology : public SimTopology {
+    public:
+      explicit UniformTopology(const SimLink &link = SimLink()) : _link(link) {}
+
+      virtual SimLink GetLink(int, int) const { return _link; }
+
+    private:
+      SimLink _link;
+  };
+
+  /**
+   * Endpoints are spread round-robin over a number of regions, links within
+   * a region differ from links between regions, e.g., a LAN versus a WAN
+   */
+  class RegionTopology : public SimTopology {
+    public:
+      /**
+       * Constructor
+       * @param regions the number of regions
+       * @param local the link between endpoints in the same region
+       * @param remote the link between endpoints in different regions
+       */
+      explicit RegionTopology(int regions, const SimLink &local,
+          const SimLink &remote) :
+        _regions(regions > 0 ? regions : 1), _local(local), _remote(remote)
+      {
+      }
+
+      virtual SimLink GetLink(int from, int to) const
+      {
+        return GetRegion(from) == GetRegion(to) ? _local : _remote;
+      }
+
+      /**
+       * Returns the region of an endpoint
+       * @param id the endpoint's id
+       */
+      inline int GetRegion(int id) const { return id % _regions; }
+
+    private:
+      int _regions;
+      SimLink _local;
+      SimLink _remote;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include <QtGlobal>
+
+#ifdef Q_OS_UNIX
+#include <dlfcn.h>
+#endif
+
+#include "AllocationCounter.hpp"
+
+namespace {
+  typedef int (*CountFunction)();
+
+  /**
+   * Finds the shim's counter, an LD_PRELOAD library is loaded before this
+   * runs during static initialization
+   */
+  CountFunction FindCountFunction()
+  {
+#ifdef Q_OS_UNIX
+    return reinterpret_cast<CountFunction>(
+        dlsym(RTLD_DEFAULT, "dissent_allocation_count"));
+#else
+    return 0;
+#endif
+  }
+
+  const CountFunction count_function = FindCountFunction();
+}
+
+namespace Dissent {
+namespace Utils {
+  bool AllocationCounter::Enabled()
+  {
+    return count_function != 0;
+  }
+
+  int AllocationCounter::Count()
+  {
+    return count_function ? count_function() : 0;
+  }
+}
+}
@@ -0,0 +1,31 @@
+#ifndef DISSENT_UTILS_ALLOCATION_COUNTER_H_GUARD
+#define DISSENT_UTILS_ALLOCATION_COUNTER_H_GUARD
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * Reports the heap allocations made by the whole process.  The counting
+   * itself lives in the allocation shim built by allocshim.pro
+   * (src/Benchmarks/AllocationShim.cpp), which interposes malloc, calloc,
+   * realloc, posix_memalign, memalign, aligned_alloc and valloc when
+   * preloaded, for example LD_PRELOAD=./liballocshim.so ./bench.  Without
+   * the shim Enabled is false and Count is always 0, so nothing else in the
+   * process pays for the counting.
+   */
+  class AllocationCounter {
+    public:
+      /**
+       * Returns true if the allocation shim is loaded
+       */
+      static bool Enabled();
+
+      /**
+       * Returns the number of allocations made so far, only differences
+       * between two calls are meaningful as the counter may wrap
+       */
+      static int Count();
+  };
+}
+}
+
+#endif
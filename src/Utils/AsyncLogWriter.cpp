@@ -0,0 +1,151 @@
+#include <QTime>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "AsyncLogWriter.hpp"
+
+namespace Dissent {
+namespace Utils {
+  namespace {
+    /**
+     * Signed distance between two ring positions, which wrap around
+     */
+    inline int Distance(int from, int to)
+    {
+      return static_cast<int>(static_cast<uint>(to) - static_cast<uint>(from));
+    }
+  }
+
+  AsyncLogWriter::AsyncLogWriter(const QString &filename) :
+    _cells(new Cell[Capacity]),
+    _enqueue_pos(0),
+    _dequeue_pos(0),
+    _synced_pos(0),
+    _sync_requested(0),
+    _stop(0),
+    _dropped(0),
+    _file(filename)
+  {
+    for(int idx = 0; idx < Capacity; idx++) {
+      _cells[idx].sequence = idx;
+    }
+
+    _file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Append);
+    start(QThread::LowPriority);
+  }
+
+  AsyncLogWriter::~AsyncLogWriter()
+  {
+    Stop();
+    delete[] _cells;
+  }
+
+  bool AsyncLogWriter::Push(const QByteArray &line)
+  {
+    int pos = _enqueue_pos;
+    Cell *cell;
+    while(true) {
+      cell = &_cells[pos & (Capacity - 1)];
+      int diff = Distance(pos, cell->sequence.fetchAndAddAcquire(0));
+      if(diff == 0) {
+        if(_enqueue_pos.testAndSetRelaxed(pos, pos + 1)) {
+          break;
+        }
+      } else if(diff < 0) {
+        _dropped.fetchAndAddRelaxed(1);
+        return false;
+      }
+      pos = _enqueue_pos;
+    }
+
+    cell->data = line;
+    cell->sequence.fetchAndStoreRelease(pos + 1);
+    return true;
+  }
+
+  bool AsyncLogWriter::Pop(QByteArray &line)
+  {
+    Cell *cell = &_cells[_dequeue_pos & (Capacity - 1)];
+    if(Distance(_dequeue_pos + 1, cell->sequence.fetchAndAddAcquire(0)) != 0) {
+      return false;
+    }
+
+    line = cell->data;
+    cell->data = QByteArray();
+    cell->sequence.fetchAndStoreRelease(_dequeue_pos + Capacity);
+    _dequeue_pos++;
+    return true;
+  }
+
+  void AsyncLogWriter::Flush()
+  {
+    int target = _enqueue_pos;
+    _sync_requested = 1;
+    while(isRunning() && Distance(_synced_pos, target) > 0) {
+      QThread::yieldCurrentThread();
+    }
+  }
+
+  void AsyncLogWriter::Stop()
+  {
+    _stop = 1;
+    wait();
+  }
+
+  int AsyncLogWriter::Drain()
+  {
+    int count = 0;
+    QByteArray line;
+    while(Pop(line)) {
+      if(_file.isOpen()) {
+        _file.write(line);
+      }
+      count++;
+    }
+    return count;
+  }
+
+  void AsyncLogWriter::Sync()
+  {
+    if(_file.isOpen()) {
+      _file.flush();
+#ifdef Q_OS_UNIX
+      ::fsync(_file.handle());
+#endif
+    }
+    _synced_pos.fetchAndStoreRelease(_dequeue_pos);
+  }
+
+  void AsyncLogWriter::run()
+  {
+    QTime last_sync;
+    last_sync.start();
+    bool dirty = false;
+
+    while(true) {
+      bool stopping = _stop;
+      dirty |= Drain() > 0;
+
+      if(_sync_requested.fetchAndStoreAcquire(0) || stopping ||
+          (dirty && last_sync.elapsed() >= SyncInterval))
+      {
+        Sync();
+        last_sync.restart();
+        dirty = false;
+      }
+
+      if(stopping) {
+        break;
+      }
+
+      if(!dirty) {
+        msleep(IdleInterval);
+      } else {
+        yieldCurrentThread();
+      }
+    }
+  }
+}
+}
@@ -0,0 +1,116 @@
+#ifndef DISSENT_UTILS_ASYNC_LOG_WRITER_H_GUARD
+#define DISSENT_UTILS_ASYNC_LOG_WRITER_H_GUARD
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThread>
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * Writes log lines to a file from a background thread.  Producers hand
+   * formatted lines to a bounded lock-free ring buffer and return
+   * immediately, the writer thread drains the ring in batches, writes them
+   * to a file that stays open, and fsyncs at most every SyncInterval ms.
+   * When the ring is full lines are dropped and counted rather than
+   * blocking the event loop.
+   */
+  class AsyncLogWriter : public QThread {
+    public:
+      /**
+       * Number of lines the ring buffer holds, a power of two
+       */
+      static const int Capacity = 8192;
+
+      /**
+       * Minimum time in ms between fsyncs of the log file
+       */
+      static const int SyncInterval = 250;
+
+      /**
+       * Time in ms the writer sleeps when the ring is empty
+       */
+      static const int IdleInterval = 5;
+
+      /**
+       * Constructor, opens the file for appending
+       * @param filename the log file
+       */
+      explicit AsyncLogWriter(const QString &filename);
+
+      /**
+       * Destructor, drains the ring and stops the writer thread
+       */
+      virtual ~AsyncLogWriter();
+
+      /**
+       * Returns true if the log file could be opened
+       */
+      inline bool IsOpen() const { return _file.isOpen(); }
+
+      /**
+       * Queues a line for writing, safe to call from any thread and never
+       * blocks
+       * @param line the formatted line
+       * @returns false if the ring was full and the line was dropped
+       */
+      bool Push(const QByteArray &line);
+
+      /**
+       * Blocks until every line pushed before the call has been written
+       * and synced to disk
+       */
+      void Flush();
+
+      /**
+       * Drains the ring, syncs the file, and joins the writer thread
+       */
+      void Stop();
+
+      /**
+       * Returns the number of lines dropped because the ring was full
+       */
+      inline int Dropped() const { return _dropped; }
+
+    protected:
+      virtual void run();
+
+    private:
+      /**
+       * Removes the oldest line from the ring, only called by the writer
+       * @param line returns the line
+       * @returns false if the ring was empty
+       */
+      bool Pop(QByteArray &line);
+
+      /**
+       * Writes every queued line to the file
+       * @returns the number of lines written
+       */
+      int Drain();
+
+      /**
+       * Flushes and fsyncs the file, publishing the written position
+       */
+      void Sync();
+
+      struct Cell {
+        QAtomicInt sequence;
+        QByteArray data;
+      };
+
+      Cell *_cells;
+      QAtomicInt _enqueue_pos;
+      int _dequeue_pos;
+      QAtomicInt _synced_pos;
+      QAtomicInt _sync_requested;
+      QAtomicInt _stop;
+      QAtomicInt _dropped;
+      QFile _file;
+  };
+}
+}
+
+#endif
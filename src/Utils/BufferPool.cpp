@@ -0,0 +1,42 @@
+#include "BufferPool.hpp"
+
+namespace Dissent {
+namespace Utils {
+  BufferPool::BufferPool() :
+    _next(0),
+    _misses(0)
+  {
+  }
+
+  BufferPool::~BufferPool()
+  {
+    qDeleteAll(_buffers);
+  }
+
+  QByteArray &BufferPool::Acquire(int size)
+  {
+    if(_next == _buffers.count()) {
+      _buffers.append(new QByteArray());
+    }
+
+    QByteArray &buffer = *_buffers[_next++];
+    if(size == 0) {
+      buffer.clear();
+      return buffer;
+    }
+
+    // QByteArray reallocates when shared, growing, or shrinking below half
+    // of its capacity, it otherwise resizes in place
+    if(!buffer.isDetached() || buffer.capacity() < size ||
+        size < buffer.capacity() / 2)
+    {
+      buffer = QByteArray(size, 0);
+      _misses++;
+    } else {
+      buffer.resize(size);
+    }
+
+    return buffer;
+  }
+}
+}
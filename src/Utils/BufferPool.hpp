@@ -0,0 +1,70 @@
+#ifndef DISSENT_UTILS_BUFFER_POOL_H_GUARD
+#define DISSENT_UTILS_BUFFER_POOL_H_GUARD
+
+#include <QByteArray>
+#include <QVector>
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * Hands out scratch buffers that live until the next Reset, typically one
+   * phase of a round.  Buffers are handed out in order and the n-th buffer
+   * requested after a Reset reuses the memory of the n-th buffer requested
+   * after the previous one.  A phase that requests the same sequence of
+   * sizes as the previous phase therefore allocates nothing.  A buffer that
+   * is still shared with a copy made by the caller, or is too small, is
+   * replaced instead.
+   */
+  class BufferPool {
+    public:
+      /**
+       * Constructor
+       */
+      explicit BufferPool();
+
+      /**
+       * Destructor
+       */
+      ~BufferPool();
+
+      /**
+       * Returns a buffer of exactly size bytes, its contents are undefined.
+       * The reference is valid until the next call to Reset.
+       * @param size the size of the buffer
+       */
+      QByteArray &Acquire(int size);
+
+      /**
+       * Makes every buffer available again
+       */
+      inline void Reset() { _next = 0; }
+
+      /**
+       * Returns the number of buffers the pool holds
+       */
+      inline int Count() const { return _buffers.count(); }
+
+      /**
+       * Returns the number of buffers handed out since the last Reset
+       */
+      inline int InUse() const { return _next; }
+
+      /**
+       * Returns the number of times a request could not reuse memory
+       */
+      inline int Misses() const { return _misses; }
+
+    private:
+      Q_DISABLE_COPY(BufferPool)
+
+      /**
+       * Held by pointer so that references survive the pool growing
+       */
+      QVector<QByteArray *> _buffers;
+      int _next;
+      int _misses;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include <QtConcurrentRun>
+
+#include "BufferedRandom.hpp"
+#include "Serialization.hpp"
+
+namespace Dissent {
+namespace Utils {
+  BufferedRandom::BufferedRandom(Random *rng) :
+    _rng(rng),
+    _offset(0),
+    _prefetch_size(0)
+  {
+  }
+
+  BufferedRandom::~BufferedRandom()
+  {
+    _prefetch.waitForFinished();
+  }
+
+  int BufferedRandom::GetInt(int min, int max)
+  {
+    if(max <= min) {
+      return min;
+    }
+
+    QByteArray data(4, 0);
+    GenerateBlock(data);
+    uint value = static_cast<uint>(Serialization::ReadInt(data, 0));
+    return min + static_cast<int>(value % static_cast<uint>(max - min));
+  }
+
+  void BufferedRandom::GenerateBlock(QByteArray &data)
+  {
+    if(data.isEmpty()) {
+      return;
+    }
+
+    GenerateBlock(data.data(), data.size());
+  }
+
+  void BufferedRandom::GenerateBlock(char *data, int length)
+  {
+    if(length <= 0) {
+      return;
+    }
+
+    if(Available() < length) {
+      CompletePrefetch();
+    }
+
+    if(Available() < length) {
+      Append(Generate(_rng.data(), length - Available()));
+    }
+
+    memcpy(data, _buffer.constData() + _offset, length);
+    _offset += length;
+    IncrementByteCount(length);
+  }
+
+  void BufferedRandom::Prefetch(uint count)
+  {
+    if(_prefetch_size) {
+      return;
+    }
+
+    int needed = static_cast<int>(count) - Available();
+    if(needed <= 0) {
+      return;
+    }
+
+    _prefetch_size = needed;
+    _prefetch = QtConcurrent::run(&BufferedRandom::Generate, _rng.data(), needed);
+  }
+
+  void BufferedRandom::CompletePrefetch()
+  {
+    if(!_prefetch_size) {
+      return;
+    }
+
+    _prefetch.waitForFinished();
+    _prefetch_size = 0;
+    Append(_prefetch.result());
+    _prefetch = QFuture<QByteArray>();
+  }
+
+  void BufferedRandom::Append(const QByteArray &data)
+  {
+    if(_offset) {
+      _buffer.remove(0, _offset);
+      _offset = 0;
+    }
+    _buffer.append(data);
+  }
+
+  QByteArray BufferedRandom::Generate(Random *rng, int count)
+  {
+    int blocks = (count + BlockSize - 1) / BlockSize;
+    QByteArray data(blocks * BlockSize, 0);
+    rng->GenerateBlock(data);
+    return data;
+  }
+}
+}
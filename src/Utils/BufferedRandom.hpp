@@ -0,0 +1,96 @@
+#ifndef DISSENT_UTILS_BUFFERED_RANDOM_H_GUARD
+#define DISSENT_UTILS_BUFFERED_RANDOM_H_GUARD
+
+#include <QByteArray>
+#include <QFuture>
+#include <QScopedPointer>
+
+#include "Random.hpp"
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * Wraps a Random so that its output can be generated ahead of time.
+   * Bytes are always requested from the underlying Random in multiples of
+   * BlockSize and handed out as one contiguous stream, so the bytes returned
+   * do not depend on how they are requested or prefetched.  Generating
+   * length n from a fresh Random yields the first n bytes of the stream.
+   */
+  class BufferedRandom : public Random {
+    public:
+      /**
+       * Granularity of requests made to the underlying Random, a multiple
+       * of common cipher block sizes
+       */
+      static const int BlockSize = 64;
+
+      /**
+       * Constructor
+       * @param rng the Random to buffer, takes ownership
+       */
+      explicit BufferedRandom(Random *rng);
+
+      /**
+       * Destructor, waits on any outstanding prefetch
+       */
+      virtual ~BufferedRandom();
+
+      /**
+       * Returns a random integer from min to max taken from the stream
+       * @param min the inclusive minimum value
+       * @param max the exclusive maximum value
+       */
+      virtual int GetInt(int min = 0, int max = RAND_MAX);
+
+      /**
+       * Fills data with the next bytes of the stream
+       * @param data QByteArray to generate random data inside
+       */
+      virtual void GenerateBlock(QByteArray &data);
+
+      /**
+       * Fills a region of memory with the next bytes of the stream
+       * @param data the start of the region
+       * @param length the length of the region
+       */
+      virtual void GenerateBlock(char *data, int length);
+
+      /**
+       * Generates count bytes in a background thread so that they are
+       * available for future calls to GenerateBlock
+       * @param count the number of bytes that should be buffered
+       */
+      virtual void Prefetch(uint count);
+
+      /**
+       * Returns the number of bytes buffered and not yet handed out,
+       * excluding an outstanding prefetch
+       */
+      inline int Available() const { return _buffer.size() - _offset; }
+
+    private:
+      /**
+       * Waits for an outstanding prefetch and adds its bytes to the buffer
+       */
+      void CompletePrefetch();
+
+      /**
+       * Appends bytes to the buffer, discarding those already handed out
+       */
+      void Append(const QByteArray &data);
+
+      /**
+       * Generates count bytes, rounded up to BlockSize, from rng
+       */
+      static QByteArray Generate(Random *rng, int count);
+
+      QScopedPointer<Random> _rng;
+      QByteArray _buffer;
+      int _offset;
+      QFuture<QByteArray> _prefetch;
+      int _prefetch_size;
+  };
+}
+}
+
+#endif
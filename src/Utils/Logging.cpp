@@ -1,19 +1,125 @@
 #include <QFile>
+#include "AsyncLogWriter.hpp"
 #include "Logging.hpp"
 #include "Time.hpp"
 
 namespace Dissent {
 namespace Utils {
   QString Logging::_filename;
+  QtMsgType Logging::_level = QtDebugMsg;
+  QHash<LogCategory, QtMsgType> Logging::_category_levels;
+  QList<QByteArray> Logging::_category_names;
+  QAtomicPointer<AsyncLogWriter> Logging::_async(0);
+  QAtomicInt Logging::_async_users(0);
+  QPointer<AsyncLogFinisher> Logging::_finisher;
+
+  AsyncLogFinisher::AsyncLogFinisher(QCoreApplication *app) :
+    QObject(app)
+  {
+    connect(app, SIGNAL(aboutToQuit()), this, SLOT(Finish()));
+  }
+
+  void AsyncLogFinisher::Finish()
+  {
+    Logging::FinishAsync();
+  }
 
   void Logging::UseFile(const QString &filename)
   {
+    StopAsync();
     _filename = filename;
     qInstallMsgHandler(File);
   }
 
+  void Logging::UseAsyncFile(const QString &filename)
+  {
+    StopAsync();
+    _filename = filename;
+    _async.fetchAndStoreOrdered(new AsyncLogWriter(filename));
+    qInstallMsgHandler(AsyncFile);
+
+    // The lines still queued would otherwise be lost on exit
+    QCoreApplication *app = QCoreApplication::instance();
+    if(app && !_finisher) {
+      _finisher = new AsyncLogFinisher(app);
+      qAddPostRoutine(FinishAsync);
+    }
+  }
+
+  void Logging::AsyncFile(QtMsgType type, const char *msg)
+  {
+    if(type < _level) {
+      return;
+    }
+
+    QByteArray line;
+    {
+      QTextStream stream(&line, QIODevice::WriteOnly);
+      Write(stream, type, msg);
+    }
+
+    // Registered before loading the writer, so StopAsync waits for us
+    _async_users.ref();
+    AsyncLogWriter *writer = _async.fetchAndAddOrdered(0);
+    if(writer) {
+      writer->Push(line);
+
+      // Qt aborts once the handler returns, so the fatal line must be on disk
+      if(type == QtFatalMsg) {
+        writer->Flush();
+      }
+    }
+    _async_users.deref();
+  }
+
+  void Logging::FlushAsync()
+  {
+    AsyncLogWriter *writer = _async.fetchAndAddOrdered(0);
+    if(writer) {
+      writer->Flush();
+    }
+  }
+
+  void Logging::FinishAsync()
+  {
+    if(!_async.fetchAndAddOrdered(0)) {
+      return;
+    }
+
+    StopAsync();
+    qInstallMsgHandler(File);
+  }
+
+  int Logging::AsyncDropped()
+  {
+    AsyncLogWriter *writer = _async.fetchAndAddOrdered(0);
+    return writer ? writer->Dropped() : 0;
+  }
+
+  void Logging::StopAsync()
+  {
+    AsyncLogWriter *writer = _async.fetchAndStoreOrdered(0);
+    if(!writer) {
+      return;
+    }
+
+    qInstallMsgHandler(0);
+
+    // Other threads may still be inside AsyncFile with the writer loaded
+    while(_async_users.fetchAndAddOrdered(0) != 0) {
+      QThread::yieldCurrentThread();
+    }
+
+    writer->Stop();
+    delete writer;
+  }
+
   void Logging::File(QtMsgType type, const char *msg)
   {
+    if(type < _level) {
+      return;
+    }
+
     QFile file(_filename);
     if(file.open(QFile::WriteOnly | QIODevice::Text | QIODevice::Append)) {
       QTextStream stream(&file);
@@ -23,22 +129,32 @@ namespace Utils {
 
   void Logging::UseStdout()
   {
+    StopAsync();
     qInstallMsgHandler(Stdout);
   }
 
   void Logging::Stdout(QtMsgType type, const char *msg)
   {
+    if(type < _level) {
+      return;
+    }
+
     QTextStream stream(stdout, QIODevice::WriteOnly);
     Write(stream, type, msg);
   }
 
   void Logging::UseStderr()
   {
+    StopAsync();
     qInstallMsgHandler(Stderr);
   }
 
   void Logging::Stderr(QtMsgType type, const char *msg)
   {
+    if(type < _level) {
+      return;
+    }
+
     QTextStream stream(stderr, QIODevice::WriteOnly);
     Write(stream, type, msg);
   }
@@ -69,16 +185,59 @@ namespace Utils {
 
   void Logging::UseDefault()
   {
+    StopAsync();
     qInstallMsgHandler(0);
   }
 
   void Logging::Disable()
   {
+    StopAsync();
     qInstallMsgHandler(Disabled);
   }
 
   void Logging::Disabled(QtMsgType, const char *)
   {
   }
+
+  void Logging::SetLevel(QtMsgType level)
+  {
+    _level = level;
+  }
+
+  void Logging::SetCategoryLevel(const QString &category, QtMsgType level)
+  {
+    QByteArray name = category.toLatin1();
+    QHash<LogCategory, QtMsgType>::iterator it =
+      _category_levels.find(LogCategory(name.constData()));
+    if(it != _category_levels.end()) {
+      it.value() = level;
+      return;
+    }
+
+    // The keys point into _category_names, which owns the strings
+    _category_names.append(name);
+    _category_levels.insert(LogCategory(_category_names.last().constData()),
+        level);
+  }
+
+  void Logging::ClearCategoryLevels()
+  {
+    _category_levels.clear();
+    _category_names.clear();
+  }
+
+  bool Logging::CategoryEnabled(const char *category, QtMsgType type)
+  {
+    if(_category_levels.isEmpty()) {
+      return type >= _level;
+    }
+
+    QHash<LogCategory, QtMsgType>::const_iterator it =
+      _category_levels.constFind(LogCategory(category));
+    if(it == _category_levels.constEnd()) {
+      return type >= _level;
+    }
+    return type >= it.value();
+  }
 }
 }
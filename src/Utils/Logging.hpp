@@ -2,11 +2,75 @@
 #define DISSENT_UTILS_LOGGING_H_GUARD
 
 #include <QtCore>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QCoreApplication>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
 #include <QString>
 #include <QTextStream>
 
+/**
+ * Debug output on hot paths (per message, per slot, per byte) goes through
+ * DISSENT_DEBUG(category) rather than qDebug(), so that it can be filtered
+ * per category at run time, without formatting its arguments, and removed
+ * entirely by building with DISSENT_NO_HOT_DEBUG.
+ */
+#ifdef DISSENT_NO_HOT_DEBUG
+#define DISSENT_DEBUG(category) while(false) qDebug()
+#else
+#define DISSENT_DEBUG(category) \
+  if(!Dissent::Utils::Logging::IsEnabled(category, QtDebugMsg)) {} else qDebug()
+#endif
+
 namespace Dissent {
 namespace Utils {
+  class AsyncLogWriter;
+
+  /**
+   * Refers to a category by its C string, so a category's level can be
+   * looked up on the hot path without copying the name
+   */
+  struct LogCategory {
+    explicit LogCategory(const char *name) : name(name) {}
+    const char *name;
+  };
+
+  inline bool operator==(const LogCategory &lhs, const LogCategory &rhs)
+  {
+    return qstrcmp(lhs.name, rhs.name) == 0;
+  }
+
+  inline uint qHash(const LogCategory &category)
+  {
+    uint hash = 0;
+    for(const char *ch = category.name; *ch; ch++) {
+      hash = 31 * hash + static_cast<uchar>(*ch);
+    }
+    return hash;
+  }
+
+  /**
+   * Drains the asynchronous log file when the application quits
+   */
+  class AsyncLogFinisher : public QObject {
+    Q_OBJECT
+
+    public:
+      /**
+       * Constructor
+       * @param app the application whose quitting finishes the log
+       */
+      explicit AsyncLogFinisher(QCoreApplication *app);
+
+    public slots:
+      /**
+       * Calls Logging::FinishAsync
+       */
+      void Finish();
+  };
+
   /**
    * Interface into Qt's logging system
    */
@@ -18,6 +82,34 @@ namespace Utils {
        */
       static void UseFile(const QString &filename);
 
+      /**
+       * Store all logs into the specified file, lines are queued and
+       * written by a background thread which keeps the file open and
+       * batches fsyncs
+       * @param filename the file in which to store logs
+       */
+      static void UseAsyncFile(const QString &filename);
+
+      /**
+       * Blocks until all queued log lines are written to disk, does nothing
+       * if the asynchronous file is not in use
+       */
+      static void FlushAsync();
+
+      /**
+       * Writes every queued log line and stops the asynchronous writer, later
+       * lines are appended to the same file directly.  Called when the
+       * application quits or exits, does nothing if the asynchronous file is
+       * not in use
+       */
+      static void FinishAsync();
+
+      /**
+       * Returns the number of log lines dropped because the asynchronous
+       * writer could not keep up
+       */
+      static int AsyncDropped();
+
       /**
        * Output logs to stdout
        */
@@ -38,9 +130,52 @@ namespace Utils {
        */
       static void Disable();
 
+      /**
+       * Sets the lowest message type that is logged, defaults to debug
+       * @param level the lowest message type logged
+       */
+      static void SetLevel(QtMsgType level);
+
+      /**
+       * Sets the lowest message type logged for a single category used by
+       * DISSENT_DEBUG, overriding the global level
+       * @param category the category
+       * @param level the lowest message type logged for the category
+       */
+      static void SetCategoryLevel(const QString &category, QtMsgType level);
+
+      /**
+       * Removes all per-category levels
+       */
+      static void ClearCategoryLevels();
+
+      /**
+       * Returns true if a message of the given type in the given category
+       * would be logged
+       * @param category the category
+       * @param type the message type
+       */
+      inline static bool IsEnabled(const char *category, QtMsgType type)
+      {
+        if(_category_levels.isEmpty()) {
+          return type >= _level;
+        }
+        return CategoryEnabled(category, type);
+      }
+
     private:
+      static bool CategoryEnabled(const char *category, QtMsgType type);
+      static void StopAsync();
+
       static QString _filename;
+      static QtMsgType _level;
+      static QHash<LogCategory, QtMsgType> _category_levels;
+      static QList<QByteArray> _category_names;
+      static QAtomicPointer<AsyncLogWriter> _async;
+      static QAtomicInt _async_users;
+      static QPointer<AsyncLogFinisher> _finisher;
       static void File(QtMsgType type, const char *msg);
+      static void AsyncFile(QtMsgType type, const char *msg);
       static void Stdout(QtMsgType type, const char *msg);
       static void Stderr(QtMsgType type, const char *msg);
       static void Write(QTextStream &stream, QtMsgType type, const char *msg);
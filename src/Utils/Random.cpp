@@ -69,7 +69,12 @@ namespace Utils {
 
   void Random::GenerateBlock(QByteArray &data)
   {
-    for(int idx = 0; idx < data.count(); idx++) {
+    GenerateBlock(data.data(), data.size());
+  }
+
+  void Random::GenerateBlock(char *data, int length)
+  {
+    for(int idx = 0; idx < length; idx++) {
       data[idx] = GetInt(0, 0x100);
     }
   }
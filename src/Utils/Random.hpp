@@ -44,6 +44,22 @@ namespace Utils {
        */
       virtual void GenerateBlock(QByteArray &data);
 
+      /**
+       * Generates random data into a region of memory, such as one slot of
+       * a larger buffer, taking the same bytes from the stream as
+       * GenerateBlock on a QByteArray of the same length
+       * @param data the start of the region
+       * @param length the length of the region
+       */
+      virtual void GenerateBlock(char *data, int length);
+
+      /**
+       * Hints that count bytes will soon be requested, a buffering Random
+       * may begin generating them ahead of time
+       * @param count the number of bytes expected
+       */
+      virtual void Prefetch(uint) {}
+
       /**
        * Returns the amount of bytes generated thus far
        */
@@ -3,9 +3,12 @@
 
 namespace Dissent {
 namespace Utils {
-  Timer::Timer() : _next_timer(-1)
+  Timer::Timer() :
+    _wheel(Time::GetInstance().MSecsSinceEpoch()),
+    _next_timer(-1),
+    _next_due(0),
+    _running(false)
   {
-    _queue = TimerQueue(&(TimerEvent::ReverseComparer));
     _real_time = true;
   }
 
@@ -22,15 +25,13 @@ namespace Utils {
 
   void Timer::QueueEvent(TimerEvent te)
   {
-    _queue.push(te);
-    if(_queue.top() == te && _real_time) {
-      if(_next_timer != -1) {
-        killTimer(_next_timer);
-      }
-      qint64 next = Run();
-      if(next > -1) {
-        _next_timer = startTimer(next);
-      }
+    _wheel.Add(te);
+    if(_running) {
+      return;
+    }
+
+    if(_real_time && (_next_timer == -1 || te.GetNextRun() < _next_due)) {
+      Arm(Run());
     }
   }
 
@@ -55,8 +56,8 @@ namespace Utils {
     }
 
     _real_time = false;
-    Clear();
     Time::GetInstance().UseVirtualTime();
+    Clear();
   }
 
   void Timer::UseRealTime()
@@ -66,44 +67,58 @@ namespace Utils {
     }
 
     _real_time = true;
-    Clear();
     Time::GetInstance().UseRealTime();
+    Clear();
   }
 
   void Timer::timerEvent(QTimerEvent *event)
   {
     killTimer(event->timerId());
-    qint64 next = Run();
+    _next_timer = -1;
+    Arm(Run());
+  }
+
+  void Timer::Arm(qint64 next)
+  {
+    if(_next_timer != -1) {
+      killTimer(_next_timer);
+      _next_timer = -1;
+    }
+
     if(next > -1) {
       _next_timer = startTimer(next);
+      _next_due = Time::GetInstance().MSecsSinceEpoch() + next;
     }
   }
 
   qint64 Timer::Run()
   {
-    int next = -1;
+    if(_running) {
+      return -1;
+    }
+
+    Time &time = Time::GetInstance();
+    qint64 delay = -1;
+    _running = true;
 
     while(true) {
-      if(_queue.empty()) {
-        next = -1;
+      int run = _wheel.Advance(time.MSecsSinceEpoch());
+      qint64 next = _wheel.NextExpiry();
+      if(next == -1) {
+        delay = -1;
         break;
       }
 
-      TimerEvent te = _queue.top();
-      if(te.GetNextRun() <= Time::GetInstance().MSecsSinceEpoch()) {
-        _queue.pop();
-        if(_real_time) {
-        }
-        te.Run();
-        if(te.GetPeriod() > 0) {
-          _queue.push(te);
-        }
-      } else {
-        next = te.GetNextRun() - Time::GetInstance().MSecsSinceEpoch();
+      // In real time, events may have come due while callbacks ran
+      delay = next - time.MSecsSinceEpoch();
+      if(delay > 0 || run == 0) {
+        delay = qMax(delay, Q_INT64_C(0));
         break;
       }
     }
-    return next;
+
+    _running = false;
+    return delay;
   }
 
   qint64 Timer::VirtualRun()
@@ -120,7 +135,7 @@ namespace Utils {
       killTimer(_next_timer);
     }
     _next_timer = -1;
-    _queue = TimerQueue(&(TimerEvent::ReverseComparer));
+    _wheel.Reset(Time::GetInstance().MSecsSinceEpoch());
   }
 }
 }
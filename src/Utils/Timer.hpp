@@ -1,9 +1,6 @@
 #ifndef DISSENT_UTILS_TIMER_H_GUARD
 #define DISSENT_UTILS_TIMER_H_GUARD
 
-#include <queue>
-#include <vector>
-
 #include <QObject>
 #include <QTimerEvent>
 #include <QThread>
@@ -11,6 +8,7 @@
 #include "TimerCallback.hpp"
 #include "Time.hpp"
 #include "TimerEvent.hpp"
+#include "TimerWheel.hpp"
 
 namespace Dissent {
 namespace Utils {
@@ -96,15 +94,9 @@ namespace Utils {
       void operator=(Timer const&);
 
       /**
-       * Convenient typedef for the TimerEvent comparator
-       */
-      typedef std::priority_queue<TimerEvent, std::vector<TimerEvent>,
-              TimerEvent::ComparerFuncPtr> TimerQueue;
-
-      /**
-       * Priority queue for storing the Timers
+       * Timer wheel storing the queued events
        */
-      TimerQueue _queue;
+      TimerWheel _wheel;
 
       /**
        * Currently using real time
@@ -127,7 +119,24 @@ namespace Utils {
        */
       virtual void timerEvent(QTimerEvent *event);
 
+      /**
+       * Arms the Qt timer for the next queued event
+       * @param next time in ms until the next event, -1 if none
+       */
+      void Arm(qint64 next);
+
       int _next_timer;
+
+      /**
+       * Time at which the Qt timer fires
+       */
+      qint64 _next_due;
+
+      /**
+       * Run is executing callbacks, events queued by them are picked up when
+       * it returns rather than by a nested Run
+       */
+      bool _running;
   };
 }
 }
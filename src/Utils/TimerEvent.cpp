@@ -1,4 +1,5 @@
 #include "TimerEvent.hpp"
+#include "TimerWheel.hpp"
 
 namespace Dissent {
 namespace Utils {
@@ -22,6 +23,9 @@ namespace Utils {
   void TimerEvent::Stop()
   {
     _state->stopped = true;
+    if(_state->node) {
+      _state->node->wheel->Remove(_state->node);
+    }
   }
 
   void TimerEvent::Run()
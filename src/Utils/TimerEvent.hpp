@@ -12,6 +12,8 @@
 
 namespace Dissent {
 namespace Utils {
+  class TimerWheelNode;
+
   /**
    * Private data for TimerEvent, so that Pointers for TimerEvents are not requried
    */
@@ -23,7 +25,8 @@ namespace Utils {
         next(next),
         period(period),
         stopped(callback == 0),
-        uid(_uid_count++)
+        uid(_uid_count++),
+        node(0)
       {
       }
 
@@ -35,6 +38,11 @@ namespace Utils {
       bool stopped;
       int uid;
 
+      /**
+       * The event's entry in a TimerWheel, null when not queued
+       */
+      TimerWheelNode *node;
+
       TimerEventData(const TimerEventData &other) : QSharedData(other)
       {
         throw std::logic_error("Not callable");
@@ -54,6 +62,7 @@ namespace Utils {
    */
   class TimerEvent {
     friend class Timer;
+    friend class TimerWheel;
 
     public:
       explicit TimerEvent();
@@ -63,9 +72,9 @@ namespace Utils {
       static bool ReverseComparer(const TimerEvent &lhs, const TimerEvent &rhs);
 
       void Stop();
-      inline qint64 GetNextRun() { return _state->next; }
-      inline int GetPeriod() { return _state->period; }
-      inline bool Stopped () { return _state->stopped; }
+      inline qint64 GetNextRun() const { return _state->next; }
+      inline int GetPeriod() const { return _state->period; }
+      inline bool Stopped () const { return _state->stopped; }
 
       bool operator<(const TimerEvent& other) const;
       bool operator>(const TimerEvent& other) const;
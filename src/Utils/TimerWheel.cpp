@@ -0,0 +1,283 @@
+#include "TimerWheel.hpp"
+
+namespace Dissent {
+namespace Utils {
+  TimerWheel::TimerWheel(qint64 now) :
+    _overflow(0),
+    _current(now),
+    _cascaded(now),
+    _count(0)
+  {
+    for(int level = 0; level < Levels; level++) {
+      for(int slot = 0; slot < Slots; slot++) {
+        _slots[level][slot] = 0;
+      }
+    }
+  }
+
+  TimerWheel::~TimerWheel()
+  {
+    Reset(0);
+  }
+
+  void TimerWheel::Add(const TimerEvent &event)
+  {
+    if(event._state->stopped) {
+      return;
+    }
+
+    if(event._state->node) {
+      event._state->node->wheel->Remove(event._state->node);
+    }
+
+    TimerWheelNode *node = new TimerWheelNode(this, event);
+    event._state->node = node;
+    Place(node);
+  }
+
+  void TimerWheel::Remove(TimerWheelNode *node)
+  {
+    Unlink(node);
+    node->event._state->node = 0;
+    delete node;
+  }
+
+  int TimerWheel::Advance(qint64 now)
+  {
+    if(_count == 0) {
+      _current = now;
+      _cascaded = now;
+      return 0;
+    }
+
+    int run = 0;
+    while(_current <= now) {
+      if(_cascaded != _current) {
+        for(int level = Levels - 1; level > 0; level--) {
+          int shift = SlotBits * level;
+          if((_current & ((Q_INT64_C(1) << shift) - 1)) != 0) {
+            continue;
+          }
+
+          if(level == Levels - 1) {
+            Cascade(&_overflow);
+          }
+          Cascade(&_slots[level][(_current >> shift) & (Slots - 1)]);
+        }
+        _cascaded = _current;
+      }
+
+      run += Fire();
+      if(_current == now) {
+        break;
+      }
+
+      qint64 tick = NextTick();
+      if(tick == -1 || tick > now) {
+        _current = now;
+      } else {
+        _current = qMax(tick, _current + 1);
+      }
+    }
+
+    return run;
+  }
+
+  qint64 TimerWheel::NextExpiry() const
+  {
+    qint64 next = -1;
+    for(int level = 0; level < Levels; level++) {
+      int offset = FirstSlot(level);
+      if(offset == -1) {
+        continue;
+      }
+
+      qint64 slot = ((_current >> (SlotBits * level)) + offset) & (Slots - 1);
+      qint64 due = MinimumNextRun(_slots[level][slot]);
+      if(next == -1 || due < next) {
+        next = due;
+      }
+    }
+
+    if(_overflow) {
+      qint64 due = MinimumNextRun(_overflow);
+      if(next == -1 || due < next) {
+        next = due;
+      }
+    }
+
+    return next;
+  }
+
+  void TimerWheel::Reset(qint64 now)
+  {
+    for(int level = 0; level < Levels; level++) {
+      for(int slot = 0; slot < Slots; slot++) {
+        Release(&_slots[level][slot]);
+      }
+    }
+    Release(&_overflow);
+
+    _count = 0;
+    _current = now;
+    _cascaded = now;
+  }
+
+  void TimerWheel::Link(TimerWheelNode **head, TimerWheelNode *node)
+  {
+    node->head = head;
+    node->prev = 0;
+    node->next = *head;
+    if(*head) {
+      (*head)->prev = node;
+    }
+    *head = node;
+    _count++;
+  }
+
+  void TimerWheel::Unlink(TimerWheelNode *node)
+  {
+    if(node->prev) {
+      node->prev->next = node->next;
+    } else {
+      *node->head = node->next;
+    }
+
+    if(node->next) {
+      node->next->prev = node->prev;
+    }
+
+    node->prev = 0;
+    node->next = 0;
+    node->head = 0;
+    _count--;
+  }
+
+  void TimerWheel::Place(TimerWheelNode *node)
+  {
+    qint64 due = qMax(node->event._state->next, _current);
+    qint64 delta = due - _current;
+
+    for(int level = 0; level < Levels; level++) {
+      int shift = SlotBits * level;
+      if(delta < (Q_INT64_C(1) << (shift + SlotBits))) {
+        Link(&_slots[level][(due >> shift) & (Slots - 1)], node);
+        return;
+      }
+    }
+
+    Link(&_overflow, node);
+  }
+
+  void TimerWheel::Cascade(TimerWheelNode **head)
+  {
+    // Detach the whole list first, nodes may land back in the same slot
+    TimerWheelNode *node = *head;
+    *head = 0;
+
+    while(node) {
+      TimerWheelNode *next = node->next;
+      node->prev = 0;
+      node->next = 0;
+      node->head = 0;
+      _count--;
+      Place(node);
+      node = next;
+    }
+  }
+
+  int TimerWheel::Fire()
+  {
+    TimerWheelNode **head = &_slots[0][_current & (Slots - 1)];
+    int run = 0;
+
+    // Callbacks may queue events that are already due, so loop until the
+    // slot stays empty
+    while(*head) {
+      QVector<TimerEvent> due;
+      while(*head) {
+        TimerWheelNode *node = *head;
+        due.append(node->event);
+        Remove(node);
+      }
+
+      qSort(due);
+
+      for(int idx = 0; idx < due.count(); idx++) {
+        TimerEvent &event = due[idx];
+        event.Run();
+        run++;
+        if(event.GetPeriod() > 0 && !event.Stopped()) {
+          Add(event);
+        }
+      }
+    }
+
+    return run;
+  }
+
+  int TimerWheel::FirstSlot(int level) const
+  {
+    qint64 position = _current >> (SlotBits * level);
+    // Level 0 starts at the current tick, higher levels at the slot after
+    // the current one, the current slot of a higher level holds events one
+    // full revolution away
+    int start = level == 0 ? 0 : 1;
+    for(int offset = start; offset < start + Slots; offset++) {
+      if(_slots[level][(position + offset) & (Slots - 1)]) {
+        return offset;
+      }
+    }
+    return -1;
+  }
+
+  qint64 TimerWheel::NextTick() const
+  {
+    qint64 next = -1;
+    for(int level = 0; level < Levels; level++) {
+      int offset = FirstSlot(level);
+      if(offset == -1) {
+        continue;
+      }
+
+      int shift = SlotBits * level;
+      qint64 tick = ((_current >> shift) + offset) << shift;
+      if(next == -1 || tick < next) {
+        next = tick;
+      }
+    }
+
+    if(_overflow) {
+      int shift = SlotBits * (Levels - 1);
+      qint64 tick = ((_current >> shift) + 1) << shift;
+      if(next == -1 || tick < next) {
+        next = tick;
+      }
+    }
+
+    return next;
+  }
+
+  qint64 TimerWheel::MinimumNextRun(const TimerWheelNode *head)
+  {
+    qint64 next = head->event._state->next;
+    for(head = head->next; head; head = head->next) {
+      next = qMin(next, head->event._state->next);
+    }
+    return next;
+  }
+
+  void TimerWheel::Release(TimerWheelNode **head)
+  {
+    TimerWheelNode *node = *head;
+    *head = 0;
+
+    while(node) {
+      TimerWheelNode *next = node->next;
+      node->event._state->node = 0;
+      delete node;
+      node = next;
+    }
+  }
+}
+}
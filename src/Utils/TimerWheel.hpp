@@ -0,0 +1,165 @@
+#ifndef DISSENT_UTILS_TIMER_WHEEL_H_GUARD
+#define DISSENT_UTILS_TIMER_WHEEL_H_GUARD
+
+#include <QtCore>
+
+#include "TimerEvent.hpp"
+
+namespace Dissent {
+namespace Utils {
+  class TimerWheel;
+
+  /**
+   * Entry in a TimerWheel slot, an intrusive doubly linked list node so
+   * that a stopped TimerEvent can unlink itself in constant time
+   */
+  class TimerWheelNode {
+    public:
+      TimerWheelNode(TimerWheel *wheel, const TimerEvent &event) :
+        wheel(wheel), event(event), prev(0), next(0), head(0)
+      {
+      }
+
+      TimerWheel *wheel;
+      TimerEvent event;
+      TimerWheelNode *prev;
+      TimerWheelNode *next;
+      TimerWheelNode **head;
+  };
+
+  /**
+   * Hierarchical timer wheel with millisecond ticks.  Level 0 holds events
+   * due within the next 256 ms in one slot per ms, each higher level covers
+   * 256 times the span of the one below it, and events further out than
+   * the top level are kept in an overflow list.  When the wheel reaches a
+   * slot boundary of a higher level, that slot is cascaded into the lower
+   * levels.  Insertion and cancellation are constant time, expiry touches
+   * only the slots that contain events, and advancing over empty spans of
+   * time skips directly to the next slot that needs work, so large jumps in
+   * virtual time stay cheap.
+   */
+  class TimerWheel {
+    public:
+      /**
+       * Number of levels in the wheel
+       */
+      static const int Levels = 4;
+
+      /**
+       * Bits of the due time consumed by each level
+       */
+      static const int SlotBits = 8;
+
+      /**
+       * Number of slots in each level
+       */
+      static const int Slots = 1 << SlotBits;
+
+      /**
+       * Constructor
+       * @param now the current time in ms
+       */
+      explicit TimerWheel(qint64 now = 0);
+
+      /**
+       * Destructor, releases all queued events
+       */
+      ~TimerWheel();
+
+      /**
+       * Queues an event by its next run time, events already due fire on
+       * the next call to Advance
+       * @param event the event
+       */
+      void Add(const TimerEvent &event);
+
+      /**
+       * Removes an event from the wheel, called by TimerEvent::Stop
+       * @param node the event's node
+       */
+      void Remove(TimerWheelNode *node);
+
+      /**
+       * Runs, in due time order, every event due at or before now, periodic
+       * events are queued again
+       * @param now the current time in ms
+       * @returns the number of events run
+       */
+      int Advance(qint64 now);
+
+      /**
+       * Returns the time in ms of the earliest queued event or -1 if the
+       * wheel is empty
+       */
+      qint64 NextExpiry() const;
+
+      /**
+       * Removes all events and moves the wheel to the given time
+       * @param now the current time in ms
+       */
+      void Reset(qint64 now);
+
+      /**
+       * Returns the number of queued events
+       */
+      inline int Count() const { return _count; }
+
+    private:
+      /**
+       * Prepends a node to a list
+       */
+      void Link(TimerWheelNode **head, TimerWheelNode *node);
+
+      /**
+       * Unlinks a node from its list without deleting it
+       */
+      void Unlink(TimerWheelNode *node);
+
+      /**
+       * Places a node in the slot matching its due time
+       */
+      void Place(TimerWheelNode *node);
+
+      /**
+       * Re-places every node in a list, used when the wheel reaches the
+       * boundary of a higher level slot
+       */
+      void Cascade(TimerWheelNode **head);
+
+      /**
+       * Runs every event in the level 0 slot for the current tick
+       */
+      int Fire();
+
+      /**
+       * Returns the index of the first non-empty slot in a level, relative
+       * to the current position, or -1 if the level is empty
+       */
+      int FirstSlot(int level) const;
+
+      /**
+       * Returns the next tick after the current one at which the wheel has
+       * work to do, either an expiry or a cascade, or -1 if empty
+       */
+      qint64 NextTick() const;
+
+      /**
+       * Returns the smallest due time in a list
+       */
+      static qint64 MinimumNextRun(const TimerWheelNode *head);
+
+      /**
+       * Deletes every node in a list
+       */
+      void Release(TimerWheelNode **head);
+
+      TimerWheelNode *_slots[Levels][Slots];
+      TimerWheelNode *_overflow;
+      qint64 _current;
+      qint64 _cascaded;
+      int _count;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include "Anonymity/RoundMetrics.hpp"
+
+#include "RoundMetricsService.hpp"
+
+namespace Dissent {
+namespace Web {
+namespace Services {
+  const QString RoundMetricsService::_format_field = "format";
+
+  void RoundMetricsService::Handle(QSharedPointer<WebRequest> wrp)
+  {
+    using Dissent::Anonymity::RoundMetrics;
+
+    QUrl url = wrp->GetRequest().GetUrl();
+    bool prometheus = url.queryItemValue(_format_field) == "prometheus";
+
+    wrp->SetStatus(HttpResponse::STATUS_OK);
+    if(prometheus) {
+      wrp->GetOutputData().setValue(RoundMetrics::GetInstance().ToPrometheus());
+      emit FinishedWebRequest(wrp, false);
+      return;
+    }
+
+    QVariantMap map;
+    map["enabled"] = RoundMetrics::Enabled();
+    map["rounds"] = RoundMetrics::GetInstance().ToVariant();
+    wrp->GetOutputData().setValue(map);
+    emit FinishedWebRequest(wrp, true);
+  }
+}
+}
+}
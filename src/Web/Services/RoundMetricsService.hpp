@@ -0,0 +1,35 @@
+#ifndef DISSENT_WEB_SERVICES_ROUND_METRICS_SERVICE_GUARD
+#define DISSENT_WEB_SERVICES_ROUND_METRICS_SERVICE_GUARD
+
+#include "WebService.hpp"
+
+namespace Dissent {
+namespace Web {
+namespace Services {
+  /**
+   * WebService that returns the per-round, per-state metrics collected by
+   * Anonymity::RoundMetrics.  By default the output is packaged as JSON,
+   * with "format=prometheus" in the query the Prometheus text format is
+   * returned instead.
+   */
+  class RoundMetricsService : public WebService {
+    public:
+      explicit RoundMetricsService() {}
+
+      virtual ~RoundMetricsService() {}
+
+    private:
+      /**
+       * The main method for the web service. If the status code wrp->status 
+       * is not STATUS_OK, then the output data might not be set.
+       * @param request to be handled
+       */
+      virtual void Handle(QSharedPointer<WebRequest> wrp);
+
+      static const QString _format_field;
+  };
+}
+}
+}
+
+#endif
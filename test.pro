@@ -45,6 +45,8 @@ HEADERS += ext/googletest/include/gtest/gtest-death-test.h \
 
 SOURCES += ext/googletest/src/gtest-all.cc \
            src/Tests/BlameUtilsTest.cpp \
+           src/Tests/BufferPoolTest.cpp \
+           src/Tests/EarlyArrivalQueueTest.cpp \
            src/Tests/MessageRandomizerTest.cpp \
            src/Tests/AddressTest.cpp \
            src/Tests/MainTest.cpp \
@@ -64,7 +66,9 @@ SOURCES += ext/googletest/src/gtest-all.cc \
            src/Tests/RoundTest.cpp \
            src/Tests/TestNode.cpp \
            src/Tests/LogTest.cpp \
+           src/Tests/LoggingTest.cpp \
            src/Tests/ShuffleRoundTest.cpp \
+           src/Tests/ShuffleBlamerTest.cpp \
            src/Tests/BasicGossipTest.cpp \
            src/Tests/TcpTest.cpp \
            src/Tests/IntegerTest.cpp \